@@ -15,7 +15,7 @@ test(HELLO, "hello world")
 //     #define HELLO "hello world"
 // #endif
 
-// C runnable supdef (unimplemented)
+// C runnable supdef
 #pragma supdef runnable C begin test2
     SUPDEF_RETURN($1);
 #pragma supdef end
@@ -28,7 +28,7 @@ test(HELLO, "hello world")
 // Dump some code passed to `supdef`
 #pragma supdef dump 0
 
-// conditionals (unimplemented)
+// conditionals
 #pragma supdef if test2(0) != 0
     #include <when_error.h>
 #pragma supdef else
@@ -38,7 +38,7 @@ test(HELLO, "hello world")
 
 test2(1) // (Expand to `1`)
 
-// C++ runnable supdef (unimplemented)
+// C++ runnable supdef
 #pragma supdef runnable CXX begin test3
 SUPDEF_INCLUDE(<string>)
 SUPDEF_INCLUDE("/my/cool/header/with/absolute/path.hpp")
@@ -1270,8 +1270,21 @@
 // then 'pragma' followed by any number of spaces > 0
 // then 'supdef' followed by any number of spaces > 0
 // then 'start' followed by any number of spaces > 0
-// then the name of the define followed by any number of spaces >= 0
-#define SUPDEF_PRAGMA_DEF_BEG_REGEX "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_DEFINE_BEGIN "\\s+(" SUPDEF_MACRO_ID_REGEX ")\\s*$"
+// then the name of the define, optionally followed by its comma-separated parameters between parentheses
+// then any number of spaces >= 0
+#define SUPDEF_PRAGMA_DEF_BEG_REGEX "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_DEFINE_BEGIN "\\s+(" SUPDEF_MACRO_ID_REGEX "(?:\\s*\\(\\s*(?:" SUPDEF_MACRO_ID_REGEX "(?:\\s*,\\s*" SUPDEF_MACRO_ID_REGEX ")*)?\\s*\\))?)\\s*$"
+
+#if defined(SUPDEF_PRAGMA_RUNNABLE)
+    #undef SUPDEF_PRAGMA_RUNNABLE
+#endif
+#define SUPDEF_PRAGMA_RUNNABLE "runnable"
+
+#if defined(SUPDEF_PRAGMA_RUNNABLE_DEF_BEG_REGEX)
+    #undef SUPDEF_PRAGMA_RUNNABLE_DEF_BEG_REGEX
+#endif
+// Same as `SUPDEF_PRAGMA_DEF_BEG_REGEX`, with 'runnable' and the language of the body ('C' or 'CXX') before 'begin'
+// (the first capture group being the language, and the second one the name and the parameters)
+#define SUPDEF_PRAGMA_RUNNABLE_DEF_BEG_REGEX "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_RUNNABLE "\\s+(C|CXX)\\s+" SUPDEF_PRAGMA_DEFINE_BEGIN "\\s+(" SUPDEF_MACRO_ID_REGEX "(?:\\s*\\(\\s*(?:" SUPDEF_MACRO_ID_REGEX "(?:\\s*,\\s*" SUPDEF_MACRO_ID_REGEX ")*)?\\s*\\))?)\\s*$"
 
 #if defined(SUPDEF_PRAGMA_DEF_END_REGEX)
     #undef SUPDEF_PRAGMA_DEF_END_REGEX
@@ -1310,6 +1323,135 @@
 #endif
 // This one is just invalid
 #define SUPDEF_PRAGMA_IMPORT_REGEX_NO_PATH "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_IMPORT "\\s+([^\\s]*)\\s*$"
+#ifdef SUPDEF_PRAGMA_IMPORT_REGEX_WITH_ANYTHING
+    #undef SUPDEF_PRAGMA_IMPORT_REGEX_WITH_ANYTHING
+#endif
+// Invalid too (anything following the `import` keyword)
+#define SUPDEF_PRAGMA_IMPORT_REGEX_WITH_ANYTHING "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_IMPORT ".*$"
+
+#if defined(SUPDEF_PRAGMA_IF)
+    #undef SUPDEF_PRAGMA_IF
+#endif
+#define SUPDEF_PRAGMA_IF "if"
+
+#if defined(SUPDEF_PRAGMA_ELSE)
+    #undef SUPDEF_PRAGMA_ELSE
+#endif
+#define SUPDEF_PRAGMA_ELSE "else"
+
+#if defined(SUPDEF_PRAGMA_IF_REGEX)
+    #undef SUPDEF_PRAGMA_IF_REGEX
+#endif
+// '#' at the beginning of the line, followed by any number of spaces >= 0
+// then 'pragma' followed by any number of spaces > 0
+// then 'supdef' followed by any number of spaces > 0
+// then 'if' followed by any number of spaces > 0
+// then the condition (up to its last non-space character) followed by any number of spaces >= 0
+#define SUPDEF_PRAGMA_IF_REGEX "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_IF "\\s+(.*[^\\s])\\s*$"
+#ifdef SUPDEF_PRAGMA_ELSE_REGEX
+    #undef SUPDEF_PRAGMA_ELSE_REGEX
+#endif
+#define SUPDEF_PRAGMA_ELSE_REGEX "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_ELSE "\\s*$"
+#ifdef SUPDEF_PRAGMA_IF_END_REGEX
+    #undef SUPDEF_PRAGMA_IF_END_REGEX
+#endif
+// The same keyword as `SUPDEF_PRAGMA_DEF_END_REGEX`, without any name
+#define SUPDEF_PRAGMA_IF_END_REGEX "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_DEFINE_END "\\s*$"
+
+#ifndef SUPDEF_PRAGMA_USE_REGEX
+// Set to 1 to recognize pragmas with the `SUPDEF_PRAGMA_*_REGEX` regexes above (compiled once per character type)
+// instead of `PragmaLexer`, e.g. when they are changed to something `PragmaLexer` does not implement.
+// Pragma lines must still contain a `#`
+#define SUPDEF_PRAGMA_USE_REGEX 0
+#endif
+
+#ifndef SUPDEF_PARSER_CHUNK_SIZE
+// Size (in code units) of the chunks a file is split into when parsed by several threads
+// (files smaller than this are parsed by a single thread)
+#define SUPDEF_PARSER_CHUNK_SIZE (4 * 1024 * 1024)
+#endif
+
+#ifndef SUPDEF_PIPELINE_QUEUE_CAPACITY
+// Maximum number of files waiting between two stages of the pipeline of an `Engine` (loading, comment stripping,
+// pragma scanning, expansion and writing), which bounds the number of files it holds in memory at once
+#define SUPDEF_PIPELINE_QUEUE_CAPACITY 16
+#endif
+
+#ifndef SUPDEF_EXPANSION_CACHE_SIZE
+// Memory (in bytes) the expansions cached by an `Engine` may take before the least recently used ones are evicted
+#define SUPDEF_EXPANSION_CACHE_SIZE (64 * 1024 * 1024)
+#endif
+
+#ifndef SUPDEF_EXPANDER_BUFFER_SIZE
+// Size (in code units) of the buffer the expanded content is written through
+#define SUPDEF_EXPANDER_BUFFER_SIZE (64 * 1024)
+#endif
+
+#ifndef SUPDEF_MAX_EXPANSION_DEPTH
+// Maximum number of nested expansions (a super define invoked by the expansion of another one, and so on)
+#define SUPDEF_MAX_EXPANSION_DEPTH 256
+#endif
+
+#ifndef SUPDEF_MAX_EXPANSION_SIZE
+// Maximum size (in code units) of all the expansions done for a single invocation (nested ones included)
+#define SUPDEF_MAX_EXPANSION_SIZE (256 * 1024 * 1024)
+#endif
+
+#ifndef SUPDEF_MAX_CONDITION_DEPTH
+// Maximum nesting of parentheses and unary operators in the condition of a `#pragma supdef if`
+#define SUPDEF_MAX_CONDITION_DEPTH 256
+#endif
+
+#ifndef SUPDEF_RUNNABLE_C_COMPILER
+// Compiler of the runnable super defines written in C (`#pragma supdef runnable C begin ...`)
+#define SUPDEF_RUNNABLE_C_COMPILER "cc"
+#endif
+
+#ifndef SUPDEF_RUNNABLE_CXX_COMPILER
+// Compiler of the runnable super defines written in C++ (`#pragma supdef runnable CXX begin ...`)
+#define SUPDEF_RUNNABLE_CXX_COMPILER "c++"
+#endif
+
+#ifndef SUPDEF_RUNNABLE_C_FLAGS
+// Flags given to `SUPDEF_RUNNABLE_C_COMPILER` (which must produce a shared library)
+#define SUPDEF_RUNNABLE_C_FLAGS "-std=c11 -O2 -fPIC -shared"
+#endif
+
+#ifndef SUPDEF_RUNNABLE_CXX_FLAGS
+// Flags given to `SUPDEF_RUNNABLE_CXX_COMPILER` (which must produce a shared library)
+#define SUPDEF_RUNNABLE_CXX_FLAGS "-std=c++20 -O2 -fPIC -shared"
+#endif
+
+#ifndef SUPDEF_RUNNABLE_CACHE_DIR_NAME
+// Directory (in the cache of the current user, see `Util::user_cache_dir`) where the compiled runnable super defines are kept
+#define SUPDEF_RUNNABLE_CACHE_DIR_NAME "supdef-runnables"
+#endif
+
+#ifndef SUPDEF_IMPORT_CACHE_DIR_NAME
+// Directory (in the cache of the current user, see `Util::user_cache_dir`) where the parsed imported files can be kept between runs
+#define SUPDEF_IMPORT_CACHE_DIR_NAME "supdef-imports"
+#endif
+
+#ifndef SUPDEF_IMPORT_CACHE_VERSION
+// Version of the format of the files of `SUPDEF_IMPORT_CACHE_DIR_NAME` (the files of other versions are ignored)
+#define SUPDEF_IMPORT_CACHE_VERSION 1
+#endif
+
+#ifndef SUPDEF_BUILD_RECORD_DIR_NAME
+// Directory (in the cache of the current user, see `Util::user_cache_dir`) where the engines keep what the outputs were made from, when asked to
+#define SUPDEF_BUILD_RECORD_DIR_NAME "supdef-builds"
+#endif
+
+#ifndef SUPDEF_BUILD_RECORD_VERSION
+// Version of the format of the files of `SUPDEF_BUILD_RECORD_DIR_NAME` (the outputs with a record of another version are made again)
+#define SUPDEF_BUILD_RECORD_VERSION 1
+#endif
+
+#ifndef SUPDEF_BUILD_RECORD_RACY_WINDOW
+// Files modified less than this many nanoseconds before the output made from them are hashed again instead of trusting their
+// modification time (which some file systems only keep to the second)
+#define SUPDEF_BUILD_RECORD_RACY_WINDOW 2000000000LL
+#endif
 
 #include <version>
 #if !defined( __cpp_lib_coroutine) || __cpp_lib_coroutine  != 201902L || \
@@ -33,7 +33,7 @@ namespace SupDef
 
     template <typename P1, typename P2>
         requires CharacterType<P1> && FilePath<P2>
-    Engine<P1, P2>::Engine() : EngineBase(), parser_pool(), thread_pool(), targets()
+    Engine<P1, P2>::Engine() : EngineBase(), parser_pool(), thread_pool(), targets(), units(), concurrency(this->thread_pool.size()), records_dir(), stats(), arena(), expansion_cache(), symbol_table(std::addressof(this->arena), std::addressof(this->expansion_cache))
     { }
 
 }
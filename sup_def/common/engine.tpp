@@ -30,23 +30,32 @@ template <typename P1, typename P2>
     requires CharacterType<P1> && FilePath<P2>
 template <typename T, typename U>
     requires FilePath<std::remove_cvref_t<T>> && FilePath<std::remove_cvref_t<U>>
-Engine<P1, P2>::Engine(T&& src, U&& dst) : EngineBase(), parser_pool(), thread_pool(), targets()
+Engine<P1, P2>::Engine(T&& src, U&& dst) : Engine()
 {
-    // TODO
+    this->add_target(std::forward<T>(src), std::forward<U>(dst));
 }
 
 template <typename P1, typename P2>
     requires CharacterType<P1> && FilePath<P2>
 Engine<P1, P2>::~Engine() noexcept
 {
-    // TODO
+    // `run` only returns once all the tasks it queued are done, so none of them can still use the engine
 }
 
 template <typename P1, typename P2>
     requires CharacterType<P1> && FilePath<P2>
 void Engine<P1, P2>::restart(void)
 {
-    // TODO
+    // Everything allocated for the previous translation units goes at once (the symbol table first, as it gets its memory
+    // from the arena, and its definitions were allocated in the arenas of the units)
+    this->symbol_table.clear();
+    this->expansion_cache.clear();
+    this->units.clear();
+    this->import_nodes.clear();
+    this->import_index.clear();
+    this->targets.clear();
+    this->stats.clear();
+    this->arena.release();
 }
 
 template <typename P1, typename P2>
@@ -55,5 +64,626 @@ template <typename T, typename U>
     requires FilePath<std::remove_cvref_t<T>> && FilePath<std::remove_cvref_t<U>>
 void Engine<P1, P2>::restart(T&& src, U&& dst)
 {
-    // TODO
-}
\ No newline at end of file
+    this->restart();
+    this->add_target(std::forward<T>(src), std::forward<U>(dst));
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+template <typename T, typename U>
+    requires FilePath<std::remove_cvref_t<T>> && FilePath<std::remove_cvref_t<U>>
+void Engine<P1, P2>::add_target(T&& src, U&& dst)
+{
+    this->targets.push_back(target_t{ std::filesystem::path(std::forward<T>(src)), std::filesystem::path(std::forward<U>(dst)) });
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::load(unit& u, const target_t& target)
+{
+    if (!std::filesystem::is_regular_file(target.src))
+        throw Exception<char, std::filesystem::path>(ExcType::NO_INPUT_FILE_ERROR, "Source file " + target.src.string() + " does not exist");
+    if (!this->records_dir.empty())
+    {
+        // (before it is read, so that a source changed in between doesn't look like the version which was hashed)
+        u.key = ImportCache<P1>::key_of(target.src);
+        u.content_hash = ImportCache<P1>::content_hash(target.src);
+    }
+    u.parser.emplace(target.src);
+    u.parser->slurp_file();
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::scan(unit& u)
+{
+    u.scope = this->symbol_table.add_scope();
+    u.import_names = this->find_imports(*u.parser);
+    std::vector<std::filesystem::path> paths;
+    for (const std::filesystem::path& name : u.import_names)
+        paths.push_back(this->resolve_import(name, u.parser->get_path()));
+    {
+        std::lock_guard<std::mutex> lock(this->imports_mtx);
+        for (const std::filesystem::path& path : paths)
+        {
+            const size_t node = this->import_file(path);
+            u.imports.push_back(node);
+            this->symbol_table.add_import(u.scope, this->import_nodes[node].scope);
+        }
+    }
+    this->define_all(*u.parser, u.scope, std::addressof(u.arena));
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+std::vector<std::filesystem::path> Engine<P1, P2>::find_imports(Parser<P1>& parser) const
+{
+    std::vector<std::filesystem::path> names;
+#if !SUPDEF_WORKAROUND_GCC_INTERNAL_ERROR
+    for (auto&& found : parser.search_imports())
+    {
+        if (found.is_null())
+            continue;
+        if (found.is_err())
+            throw found.error();
+        names.emplace_back(std::get<0>(found.unwrap()));
+    }
+#else
+    for (auto&& found : search_imports(parser))
+    {
+        if (found.is_null())
+            continue;
+        if (found.is_err())
+            throw found.error();
+        names.emplace_back(*found.unwrap());
+    }
+#endif
+    return names;
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+std::filesystem::path Engine<P1, P2>::resolve_import(const std::filesystem::path& name, const std::filesystem::path& importer) const
+{
+    std::filesystem::path path = ::SupDef::Util::get_normalized_path(name.is_absolute() ? name : importer.parent_path() / name);
+    if (path.empty())
+        path = ::SupDef::Util::get_normalized_path(::SupDef::Util::get_included_fpath(name).value_or(std::filesystem::path()));
+    if (path.empty())
+        throw Exception<char, std::filesystem::path>(ExcType::INVALID_PATH_ERROR, "Imported file " + name.string() + " not found (imported from " + importer.string() + ")");
+    return path;
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::define_all(Parser<P1>& parser, typename SymbolTable<P1>::scope_id scope, std::pmr::memory_resource* resource)
+{
+    for (auto&& found : parser.search_super_defines())
+    {
+        if (found.is_null())
+            continue;
+        if (found.is_err())
+            throw found.error();
+        this->symbol_table.define(scope, PragmaDef<P1>(found.unwrap(), resource));
+    }
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+size_t Engine<P1, P2>::import_file(const std::filesystem::path& path)
+{
+    auto [it, inserted] = this->import_index.try_emplace(path, this->import_nodes.size());
+    if (!inserted)
+        return it->second;
+    this->import_nodes.emplace_back(path, this->symbol_table.add_scope());
+    ++this->pending_imports;
+    std::ignore = this->thread_pool.enqueue([this, node = it->second]() { this->parse_import(node); });
+    return it->second;
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::parse_import(size_t node)
+{
+    // The nodes are never moved (nor their path changed) until `restart`, so this one can be used without the lock
+    import_node& n = this->import_nodes[node];
+    std::exception_ptr error = nullptr;
+    std::vector<std::filesystem::path> paths;
+    try
+    {
+        n.file = ImportCache<P1>::instance().get(n.path);
+        for (const std::filesystem::path& name : n.file->imports)
+            paths.push_back(this->resolve_import(name, n.path));
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->imports_mtx);
+        n.parsed = true;
+        n.error = error;
+        if (n.file != nullptr)
+        {
+            n.key = n.file->key;
+            n.content_hash = n.file->content_hash;
+            n.names = n.file->imports;
+        }
+        for (const std::filesystem::path& path : paths)
+        {
+            const size_t imported = this->import_file(path);
+            import_node& i = this->import_nodes[imported];
+            n.imports.push_back(imported);
+            i.importers.push_back(node);
+            this->symbol_table.add_import(n.scope, i.scope);
+            if (!i.complete)
+                ++n.waiting;
+            else if (n.error == nullptr)
+                n.error = i.error;
+        }
+        this->settle(node);
+    }
+    this->end_import_task();
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::define_import(size_t node)
+{
+    import_node& n = this->import_nodes[node];
+    std::exception_ptr error = nullptr;
+    try
+    {
+        // The definitions of the cache are shared, not copied
+        for (const PragmaDef<P1>& def : n.file->definitions)
+            this->symbol_table.define(n.scope, def);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->imports_mtx);
+        this->complete(node, error);
+    }
+    this->end_import_task();
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::settle(size_t node)
+{
+    import_node& n = this->import_nodes[node];
+    if (!n.parsed || n.defining || n.complete || n.waiting != 0)
+        return;
+    if (n.error != nullptr)
+    {
+        this->complete(node, n.error);
+        return;
+    }
+    n.defining = true;
+    ++this->pending_imports;
+    std::ignore = this->thread_pool.enqueue([this, node]() { this->define_import(node); });
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::complete(size_t node, std::exception_ptr error)
+{
+    import_node& n = this->import_nodes[node];
+    n.complete = true;
+    n.error = error;
+    n.file.reset();
+    for (size_t importer : n.importers)
+    {
+        import_node& i = this->import_nodes[importer];
+        if (i.complete)
+            continue;
+        if (i.error == nullptr)
+            i.error = error;
+        --i.waiting;
+        this->settle(importer);
+    }
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::fail_cycles(void)
+{
+    // With no task pending, each node which isn't complete waits for an import which isn't complete either: following
+    // them always ends up in a cycle
+    for (size_t start = 0; start < this->import_nodes.size(); ++start)
+    {
+        if (this->import_nodes[start].complete)
+            continue;
+        std::vector<size_t> path;
+        std::map<size_t, size_t> position;
+        size_t curr = start;
+        bool stuck = false;
+        while (!position.contains(curr))
+        {
+            position.emplace(curr, path.size());
+            path.push_back(curr);
+            const std::vector<size_t>& imports = this->import_nodes[curr].imports;
+            const auto next = std::ranges::find_if(imports, [this](size_t i) { return !this->import_nodes[i].complete; });
+            if (next == imports.end())
+            {
+                stuck = true;
+                break;
+            }
+            curr = *next;
+        }
+        // A node waiting for no import should have completed already: fail it rather than leave its importers waiting
+        if (stuck)
+        {
+            const std::string msg = "Import of " + this->import_nodes[curr].path.string() + " never completed, with all its imports complete";
+            this->complete(curr, std::make_exception_ptr(Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, msg)));
+            continue;
+        }
+        std::string msg = "Import cycle: ";
+        for (size_t i = position[curr]; i < path.size(); ++i)
+            msg += this->import_nodes[path[i]].path.string() + " -> ";
+        msg += this->import_nodes[curr].path.string();
+        const std::exception_ptr error = std::make_exception_ptr(Exception<char, std::filesystem::path>(ExcType::INVALID_PATH_ERROR, msg));
+        // The other nodes of the path only import the cycle, and fail when it completes
+        for (size_t i = position[curr]; i < path.size(); ++i)
+            if (!this->import_nodes[path[i]].complete)
+                this->complete(path[i], error);
+    }
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::end_import_task(void)
+{
+    Pipeline* pipeline;
+    {
+        std::lock_guard<std::mutex> lock(this->imports_mtx);
+        if (this->pending_imports == 1)
+            this->fail_cycles();
+        pipeline = this->pipeline;
+    }
+    // (without the lock of the graph, which the pipeline takes to know whether a target is ready)
+    if (pipeline != nullptr)
+        pipeline->wake();
+    std::lock_guard<std::mutex> lock(this->imports_mtx);
+    --this->pending_imports;
+    this->imports_cv.notify_all();
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::write(unit& u, const target_t& target)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->imports_mtx);
+        for (size_t node : u.imports)
+            if (this->import_nodes[node].error != nullptr)
+                std::rethrow_exception(this->import_nodes[node].error);
+    }
+    if (target.dst.has_parent_path())
+        std::filesystem::create_directories(target.dst.parent_path());
+    {
+        dst_file_t dst(target.dst);
+        if (!dst.is_open())
+            throw Exception<char, std::filesystem::path>(ExcType::INVALID_PATH_ERROR, "Could not open " + target.dst.string() + " for writing");
+        // Written as it is expanded, the output is never held in memory as a whole
+        // (the cache tells the definitions of a name in the scopes of different targets apart)
+        try
+        {
+            u.expansions = this->expand(*u.parser, u.scope, this->expansion_cache, dst);
+            dst.flush();
+            if (!dst.good())
+                throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Could not write " + target.dst.string());
+        }
+        catch (...)
+        {
+            // No half-written output is left behind
+            dst.close();
+            std::error_code ec;
+            std::filesystem::remove(target.dst, ec);
+            throw;
+        }
+    }
+    u.parser.reset();
+    if (!this->records_dir.empty())
+        this->record(u, target);
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+bool Engine<P1, P2>::up_to_date(const target_t& target, file_checks& checked) const
+{
+    try
+    {
+        const std::filesystem::path path = this->record_path(target.dst);
+        std::optional<build_record> record = read_record(path);
+        if (!record.has_value() || record->options != this->options_hash() || record->dependencies.empty() ||
+            record->dependencies.front().path != target.src)
+            return false;
+        // The output may have been changed (or removed) since it was written
+        if (ImportCache<P1>::key_of(target.dst) != record->output)
+            return false;
+
+        bool refreshed = false;
+        for (typename build_record::dependency& dep : record->dependencies)
+        {
+            auto key = checked.keys.find(dep.path);
+            if (key == checked.keys.end())
+                key = checked.keys.emplace(dep.path, ImportCache<P1>::key_of(dep.path)).first;
+            // A file modified about when the output was written may have changed again without its version showing it
+            if (key->second != dep.key || dep.key.mtime + SUPDEF_BUILD_RECORD_RACY_WINDOW >= record->output.mtime)
+            {
+                auto hash = checked.hashes.find(dep.path);
+                if (hash == checked.hashes.end())
+                    hash = checked.hashes.emplace(dep.path, ImportCache<P1>::content_hash(dep.path)).first;
+                if (hash->second != dep.content_hash)
+                    return false;
+                // Only its version changed: record the new one, so that it isn't hashed again next time
+                if (key->second != dep.key)
+                {
+                    dep.key = key->second;
+                    refreshed = true;
+                }
+            }
+            // A new file may now be found first for one of its imports
+            for (const auto& [name, resolved] : dep.imports)
+                if (this->resolve_import(name, dep.path) != resolved)
+                    return false;
+        }
+        if (refreshed)
+            write_record(path, *record);
+        return true;
+    }
+    catch (...)
+    {
+        // Whatever went wrong (a file which disappeared, ...) is found again, and reported, when the target is made
+        return false;
+    }
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::record(const unit& u, const target_t& target)
+{
+    build_record record;
+    record.options = this->options_hash();
+    record.output = ImportCache<P1>::key_of(target.dst);
+    record.dependencies.push_back(typename build_record::dependency{ target.src, u.key, u.content_hash });
+    {
+        // The import graph of the target is complete, as it was expanded
+        std::lock_guard<std::mutex> lock(this->imports_mtx);
+        for (size_t i = 0; i < u.imports.size(); ++i)
+            record.dependencies.front().imports.emplace_back(u.import_names[i], this->import_nodes[u.imports[i]].path);
+        std::vector<bool> seen(this->import_nodes.size(), false);
+        std::vector<size_t> todo(u.imports.begin(), u.imports.end());
+        while (!todo.empty())
+        {
+            const size_t node = todo.back();
+            todo.pop_back();
+            if (seen[node])
+                continue;
+            seen[node] = true;
+            const import_node& n = this->import_nodes[node];
+            typename build_record::dependency dep{ n.path, n.key, n.content_hash };
+            for (size_t i = 0; i < n.imports.size(); ++i)
+            {
+                dep.imports.emplace_back(n.names[i], this->import_nodes[n.imports[i]].path);
+                todo.push_back(n.imports[i]);
+            }
+            record.dependencies.push_back(std::move(dep));
+        }
+    }
+    write_record(this->record_path(target.dst), record);
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+std::uint64_t Engine<P1, P2>::options_hash(void) const
+{
+    std::uint64_t hash = Util::fnv1a({
+        std::to_string(sizeof(P1)),
+        SUPDEF_RUNNABLE_C_COMPILER, SUPDEF_RUNNABLE_C_FLAGS, SUPDEF_RUNNABLE_CXX_COMPILER, SUPDEF_RUNNABLE_CXX_FLAGS
+    });
+    for (const std::filesystem::path& include_path : EngineBase::get_include_paths())
+        hash = Util::fnv1a({ include_path.string() }, hash);
+    return hash;
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+std::filesystem::path Engine<P1, P2>::record_path(const std::filesystem::path& dst) const
+{
+    const std::string native = std::filesystem::absolute(dst).lexically_normal().string();
+    return this->records_dir / (Util::hex(Util::fnv1a({ native })) + Util::hex(Util::fnv1a({ native }, 0x84222325cbf29ce4ULL)) + ".sdb");
+}
+
+/*
+ * A build record is a text file made of:
+ *
+ * supdef-build-record <version>
+ * <options>
+ * <output>
+ * <number of dependencies>
+ * <dependency>*
+ *
+ * Where a version of a file (like <output>) is `"<path>" <mtime> <size> <inode>`, and a <dependency> is
+ * `"<path>" <version> <content hash> <number of imports>` followed by `"<name>" "<path>"` for each import
+ */
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+std::optional<typename Engine<P1, P2>::build_record> Engine<P1, P2>::read_record(const std::filesystem::path& path)
+{
+    // A record others could have written could make the engine skip any target
+    if (!Util::is_private_path(path, false))
+        return std::nullopt;
+    std::ifstream in(path);
+    auto read_path = [&in](std::filesystem::path& res) -> bool
+    {
+        std::string str;
+        if (!(in >> std::quoted(str)))
+            return false;
+        res = str;
+        return true;
+    };
+    auto read_key = [&](typename ImportCache<P1>::file_key& key) -> bool
+    {
+        return read_path(key.path) && (in >> key.mtime >> key.size >> key.inode);
+    };
+
+    std::string magic;
+    unsigned version = 0;
+    if (!(in >> magic >> version) || magic != "supdef-build-record" || version != SUPDEF_BUILD_RECORD_VERSION)
+        return std::nullopt;
+    build_record record;
+    size_t nb_dependencies = 0;
+    if (!(in >> record.options) || !read_key(record.output) || !(in >> nb_dependencies))
+        return std::nullopt;
+    for (size_t i = 0; i < nb_dependencies; ++i)
+    {
+        typename build_record::dependency dep;
+        size_t nb_imports = 0;
+        if (!read_path(dep.path) || !read_key(dep.key) || !(in >> dep.content_hash >> nb_imports))
+            return std::nullopt;
+        for (size_t j = 0; j < nb_imports; ++j)
+        {
+            std::filesystem::path name, resolved;
+            if (!read_path(name) || !read_path(resolved))
+                return std::nullopt;
+            dep.imports.emplace_back(std::move(name), std::move(resolved));
+        }
+        record.dependencies.push_back(std::move(dep));
+    }
+    return record;
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+void Engine<P1, P2>::write_record(const std::filesystem::path& path, const build_record& record)
+{
+    static std::atomic<size_t> writes = 0;
+    std::error_code ec;
+#if SUPDEF_ON_UNIX
+    const std::string unique = "." + std::to_string(::getpid()) + "." + std::to_string(writes++) + ".tmp";
+#else
+    const std::string unique = "." + std::to_string(writes++) + ".tmp";
+#endif
+    std::filesystem::path tmp = path;
+    tmp += unique;
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        auto write_key = [&out](const typename ImportCache<P1>::file_key& key) -> void
+        {
+            out << std::quoted(key.path.string()) << ' ' << key.mtime << ' ' << key.size << ' ' << key.inode;
+        };
+        out << "supdef-build-record " << SUPDEF_BUILD_RECORD_VERSION << '\n' << record.options << '\n';
+        write_key(record.output);
+        out << '\n' << record.dependencies.size() << '\n';
+        for (const typename build_record::dependency& dep : record.dependencies)
+        {
+            out << std::quoted(dep.path.string()) << ' ';
+            write_key(dep.key);
+            out << ' ' << dep.content_hash << ' ' << dep.imports.size() << '\n';
+            for (const auto& [name, resolved] : dep.imports)
+                out << "    " << std::quoted(name.string()) << ' ' << std::quoted(resolved.string()) << '\n';
+        }
+        if (!out.good())
+            ec = std::make_error_code(std::errc::io_error);
+    }
+    // (whatever the umask, as a record others can write to would never be read back)
+    if (!ec)
+        std::filesystem::permissions(tmp, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write, ec);
+    // Without a record the output is only made again: failing to write it is not an error
+    if (ec)
+        std::filesystem::remove(tmp, ec);
+    else
+        std::filesystem::rename(tmp, path, ec);
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+size_t Engine<P1, P2>::run(void)
+{
+    // The targets going through the pipeline: those which are up to date are done already
+    std::vector<size_t> items;
+    file_checks checked;
+    for (size_t i = this->units.size(); i < this->targets.size(); ++i)
+    {
+        this->units.emplace_back();
+        target_t& target = this->targets[i];
+        if (!this->records_dir.empty() && this->up_to_date(target, checked))
+        {
+            target.done = true;
+            target.skipped = true;
+            target.error = nullptr;
+        }
+        else
+            items.push_back(i);
+    }
+    const size_t count = items.size();
+    auto target_of = [this, &items](size_t item) -> target_t& { return this->targets[items[item]]; };
+    auto unit_of = [this, &items](size_t item) -> unit& { return this->units[items[item]]; };
+    // A target is expanded once all the files it imports are defined (the lock of the import graph is taken under the one
+    // of the pipeline, never the other way around)
+    auto imports_ready = [&](size_t item) -> bool
+    {
+        std::lock_guard<std::mutex> lock(this->imports_mtx);
+        return std::ranges::all_of(unit_of(item).imports, [this](size_t node) { return this->import_nodes[node].complete; });
+    };
+
+    Pipeline pipeline(this->thread_pool, {
+        { [&](size_t item) { this->load(unit_of(item), target_of(item)); }, this->concurrency },
+        { [&](size_t item) { unit_of(item).parser->strip_comments(); }, this->concurrency },
+        { [&](size_t item) { this->scan(unit_of(item)); }, this->concurrency },
+        { [&](size_t item) { this->write(unit_of(item), target_of(item)); }, this->concurrency, SUPDEF_PIPELINE_QUEUE_CAPACITY, imports_ready }
+    });
+    {
+        std::lock_guard<std::mutex> lock(this->imports_mtx);
+        this->pipeline = std::addressof(pipeline);
+    }
+    const std::vector<std::exception_ptr> errors = pipeline.run(count);
+    {
+        // The files imported by failed targets may still be parsed, and wake the pipeline up
+        std::unique_lock<std::mutex> lock(this->imports_mtx);
+        this->imports_cv.wait(lock, [this]() { return this->pending_imports == 0; });
+        this->pipeline = nullptr;
+    }
+    this->stats = pipeline.get_stats();
+
+    size_t failed = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        target_t& target = target_of(i);
+        target.done = true;
+        target.skipped = false;
+        target.error = errors[i];
+        if (errors[i] != nullptr)
+        {
+            ++failed;
+            // What a failing stage left behind
+            unit_of(i).parser.reset();
+        }
+    }
+    return failed;
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+size_t Engine<P1, P2>::expand(const Parser<P1>& parser, typename SymbolTable<P1>::scope_id scope, std::basic_ostream<P1>& dst)
+{
+    return this->expand(parser, scope, this->expansion_cache, dst);
+}
+
+template <typename P1, typename P2>
+    requires CharacterType<P1> && FilePath<P2>
+size_t Engine<P1, P2>::expand(const Parser<P1>& parser, typename SymbolTable<P1>::scope_id scope, ExpansionCache<P1>& cache, std::basic_ostream<P1>& dst)
+{
+    const ConditionalTree<P1> tree(parser.get_content());
+    InvocationExpander<P1> expander(this->symbol_table, scope, std::addressof(cache));
+    ConditionEvaluator<P1> evaluator(this->symbol_table, scope, std::addressof(cache), std::addressof(this->constant_conditions));
+    size_t count = 0;
+    tree.walk(
+        [&expander, &dst, &count](std::basic_string_view<P1> text) { count += expander.expand(text, dst); },
+        [&evaluator](std::basic_string_view<P1> condition, size_t line) { return evaluator.evaluate(condition, line); }
+    );
+    return count + evaluator.expansions();
+}
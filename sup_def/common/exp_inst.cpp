@@ -95,6 +95,22 @@ EXP_INST_CLASS(::SupDef::Parser,
     (char32_t)
 );
 
+EXP_INST_CLASS(::SupDef::PragmaLexer,
+    (char),
+    (wchar_t),
+    (char8_t),
+    (char16_t),
+    (char32_t)
+);
+
+EXP_INST_CLASS(::SupDef::PragmaGrammar,
+    (char),
+    (wchar_t),
+    (char8_t),
+    (char16_t),
+    (char32_t)
+);
+
 EXP_INST_STRUCT(::SupDef::PragmaDef,
     (char),
     (wchar_t),
@@ -187,6 +203,22 @@ DECL_EXP_INST_CLASS(::SupDef::Parser,
     (char32_t)
 );
 
+DECL_EXP_INST_CLASS(::SupDef::PragmaLexer,
+    (char),
+    (wchar_t),
+    (char8_t),
+    (char16_t),
+    (char32_t)
+);
+
+DECL_EXP_INST_CLASS(::SupDef::PragmaGrammar,
+    (char),
+    (wchar_t),
+    (char8_t),
+    (char16_t),
+    (char32_t)
+);
+
 DECL_EXP_INST_STRUCT(::SupDef::PragmaDef,
     (char),
     (wchar_t),
@@ -35,7 +35,6 @@
 #include <cassert>
 #include <cstring>
 #include <locale>
-#include <regex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -46,11 +45,6 @@ using namespace std::literals;
 namespace SupDef
 {
 
-#ifdef MK_CHAR
-    #undef MK_CHAR
-#endif
-#define MK_CHAR(ORIGINAL_LINE, ORIGINAL_COL, CHAR) ParsedChar<T>(std::forward<string_size_type<T>>(ORIGINAL_LINE), std::forward<string_size_type<T>>(ORIGINAL_COL), std::forward<T>(CHAR))
-
     template <typename T>
         requires CharacterType<T>
     Parser<T>::Parser()
@@ -58,8 +52,8 @@ namespace SupDef
         try
         {
             this->file = std::basic_ifstream<T>();
-            this->file_content_raw = std::basic_string<T>();
-            this->lines_raw.clear();
+            this->file_content_raw = std::basic_string_view<T>();
+            this->raw_line_starts.clear();
             this->file_content.clear();
             this->lines.clear();
         }
@@ -76,8 +70,8 @@ namespace SupDef
         try
         {
             this->file = std::basic_ifstream<T>(file_path);
-            this->file_content_raw = std::basic_string<T>();
-            this->lines_raw.clear();
+            this->file_content_raw = std::basic_string_view<T>();
+            this->raw_line_starts.clear();
             this->file_path = file_path;
             this->file_content.clear();
             this->lines.clear();
@@ -95,8 +89,8 @@ namespace SupDef
         try
         {
             this->file = std::ref(file_stream);
-            this->file_content_raw = std::basic_string<T>();
-            this->lines_raw.clear();
+            this->file_content_raw = std::basic_string_view<T>();
+            this->raw_line_starts.clear();
             this->file_path = file_path;
             this->file_content.clear();
             this->lines.clear();
@@ -121,189 +115,617 @@ namespace SupDef
 
     template <typename T>
         requires CharacterType<T>
-    std::basic_string<T> Parser<T>::slurp_file()
+    std::basic_string_view<T> Parser<T>::slurp_file()
     {
         if (!this->get_file_stream().is_open())
             throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "File is not open\n");
 
-        this->get_file_stream().seekg(0, std::basic_ios<T>::end);
-        try
+        this->file_content_raw = std::basic_string_view<T>();
+        this->file_content.clear();
+        this->file_content_storage.clear();
+        this->file_mapping = MappedFile();
+
+        // The bytes of the file are the code units of the content for `char` and `char8_t`, so just map the file
+        // (without copying anything) when possible
+        if constexpr (sizeof(T) == 1)
         {
-            this->file_content_raw.reserve(this->get_file_stream().tellg());
+            if (!this->file_path.empty())
+                this->file_mapping = MappedFile(this->file_path);
         }
-        catch (const std::exception& e)
+
+        if (this->file_mapping.is_mapped())
         {
-            throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Failed to reserve file content: " + std::string(e.what()) + "\n");
+            if constexpr (sizeof(T) == 1)
+                this->file_content_raw = this->file_mapping.template view<T>();
         }
-        this->get_file_stream().seekg(0, std::basic_ios<T>::beg);
+        else
+        {
+            this->get_file_stream().seekg(0, std::basic_ios<T>::end);
+            try
+            {
+                this->file_content_storage.reserve(this->get_file_stream().tellg());
+            }
+            catch (const std::exception& e)
+            {
+                throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Failed to reserve file content: " + std::string(e.what()) + "\n");
+            }
+            this->get_file_stream().seekg(0, std::basic_ios<T>::beg);
 
-        try
+            try
+            {
+                std::basic_ostringstream<T> sstr;
+                sstr << this->get_file_stream().rdbuf();
+                this->file_content_storage = std::move(sstr).str();
+            }
+            catch (const std::exception& e)
+            {
+                throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Failed to read file content: " + std::string(e.what()) + "\n");
+            }
+            this->file_content_raw = this->file_content_storage;
+        }
+        // Index the lines of the raw content (for error reporting), which are also the lines of the content to parse for now
+        Util::DelimiterFinder<T, '\n'> newlines(this->file_content_raw);
+        this->raw_line_starts.clear();
+        this->raw_line_starts.push_back(0);
+        this->lines.clear();
+        this->removed_lines = 0;
+        for (auto nl_pos = newlines.next(0); nl_pos < this->file_content_raw.size(); nl_pos = newlines.next(nl_pos + 1))
         {
-            this->file_content_raw.clear();
-            std::basic_ostringstream<T> sstr;
-            sstr << this->get_file_stream().rdbuf();
-            this->file_content_raw.assign(sstr.str());
+            this->lines.push_back(line_span{ this->raw_line_starts.back(), nl_pos - this->raw_line_starts.back() });
+            this->raw_line_starts.push_back(nl_pos + 1);
         }
-        catch (const std::exception& e)
+        if (this->raw_line_starts.back() < this->file_content_raw.size())
+            this->lines.push_back(line_span{ this->raw_line_starts.back(), this->file_content_raw.size() - this->raw_line_starts.back() });
+        // `file_content_raw` lives as long as the parser, and is only copied once actually edited
+        this->file_content = ParsedText<T>::borrow_source(this->file_content_raw);
+        this->pragma_candidates.clear();
+        this->has_pragma_candidates = false;
+        this->raw_line_states.clear();
+        this->imports.clear();
+        this->super_defines.clear();
+        this->imports_searched = false;
+        this->super_defines_searched = false;
+        this->open_super_define = 0;
+        // Reset file state to freshly opened
+        this->get_file_stream().seekg(0, std::basic_ios<T>::beg);
+
+        return this->file_content_raw;
+    }
+
+    template <typename T>
+        requires CharacterType<T>
+    std::basic_string<T> Parser<T>::get_raw_line(location_type line) const
+    {
+        const location_type start = this->raw_line_starts.at(line);
+        location_type end = (line + 1 < this->raw_line_starts.size()) ? this->raw_line_starts[line + 1] - 1 : this->file_content_raw.size();
+        return std::basic_string<T>(this->file_content_raw.substr(start, end - start));
+    }
+
+    // Index of the line of this->file_content_raw containing the code unit at @p pos
+    template <typename T>
+        requires CharacterType<T>
+    typename Parser<T>::location_type Parser<T>::raw_line_of(location_type pos) const
+    {
+        auto it = std::upper_bound(this->raw_line_starts.begin(), this->raw_line_starts.end(), pos);
+        return static_cast<location_type>(std::distance(this->raw_line_starts.begin(), it)) - 1;
+    }
+
+    // The code unit at @p pos in this->file_content_raw, with its original position
+    template <typename T>
+        requires CharacterType<T>
+    ParsedChar<T> Parser<T>::raw_char_at(location_type pos) const
+    {
+        const location_type line = this->raw_line_of(pos);
+        return ParsedChar<T>(line, pos - this->raw_line_starts[line], this->file_content_raw.at(pos));
+    }
+
+    // Append the code units of this->file_content_raw in [@p from, @p to) to @p out, with their original positions
+    template <typename T>
+        requires CharacterType<T>
+    void Parser<T>::append_raw(ParsedText<T>& out, location_type from, location_type to) const
+    {
+        for (location_type line = this->raw_line_of(from); from < to; ++line)
         {
-            throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Failed to read file content: " + std::string(e.what()) + "\n");
+            const location_type line_end = (line + 1 < this->raw_line_starts.size()) ? std::min(this->raw_line_starts[line + 1], to) : to;
+            out.append(this->file_content_raw.substr(from, line_end - from), line, from - this->raw_line_starts[line]);
+            from = line_end;
         }
-        this->lines_raw.clear();
-#if defined(__cpp_lib_containers_ranges) && __cpp_lib_containers_ranges >= 202202L && 0 // For now, disable this
-        // Not even sure this works
-        this->lines_raw.assign_range(split_string(this->file_content_raw, '\n'));
-#else
-        this->lines_raw = split_string(this->file_content_raw, CONVERT(T, '\n'));
-#endif
-        this->file_content.clear();
+    }
+
+    // Record in this->raw_line_states that the comment stripping scan went through the line start @p state.pos, the lines
+    // being looked at from @p line (which is moved to the line of @p state.pos)
+    template <typename T>
+        requires CharacterType<T>
+    void Parser<T>::record_line_start(location_type& line, const strip_state& state)
+    {
+        while (line < this->raw_line_starts.size() && this->raw_line_starts[line] < state.pos)
+            ++line;
+        if (line < this->raw_line_states.size())
+            this->raw_line_states[line] = state.in_str_lit ? line_start_state::IN_STR_LIT : line_start_state::IN_CODE;
+    }
+
+    // The first and last lines of this->file_content_raw (both included) a pragma found by a search comes from, i.e. from
+    // its start line to its end line, along with the lines of the comments the first and the last one start or end in
+    template <typename T>
+        requires CharacterType<T>
+    std::pair<typename Parser<T>::location_type, typename Parser<T>::location_type> Parser<T>::raw_lines_of(const pragma_loc_type& loc) const
+    {
+        const location_type line_count = this->raw_line_states.size();
+        location_type first = std::min<location_type>(std::get<1>(loc) - 1, line_count - 1);
+        location_type last = std::min<location_type>(std::get<2>(loc) - 1, line_count - 1);
+        while (first > 0 && this->raw_line_states[first] == line_start_state::IN_COMMENT)
+            --first;
+        while (last + 1 < line_count && this->raw_line_states[last + 1] == line_start_state::IN_COMMENT)
+            ++last;
+        return { first, last };
+    }
+
+    // Add @p loc to the pragmas @p found, keeping them sorted by start line
+    template <typename T>
+        requires CharacterType<T>
+    void Parser<T>::record_pragma(std::vector<pragma_loc_type>& found, const pragma_loc_type& loc)
+    {
+        auto it = std::upper_bound(
+            found.begin(), found.end(), std::get<1>(loc),
+            [](string_size_type<T> line, const pragma_loc_type& other) { return line < std::get<1>(other); }
+        );
+        found.insert(it, loc);
+    }
+
+    // Rebuild this->lines from the offsets of the `\n`s of this->file_content
+    template <typename T>
+        requires CharacterType<T>
+    void Parser<T>::index_lines(const std::vector<location_type>& newlines)
+    {
+        const location_type content_size = this->file_content.size();
         this->lines.clear();
-        string_size_type<T> linecount = 0;
-        string_size_type<T> colcount = 0;
-        std::vector<ParsedChar<T>> line;
-        for (auto&& c : this->file_content_raw)
+        this->lines.reserve(newlines.size() + 1);
+        this->removed_lines = 0;
+        location_type line_start = 0;
+        for (const location_type nl_pos : newlines)
         {
-            if (SAME(c, '\n'))
+            this->lines.push_back(line_span{ line_start, nl_pos - line_start });
+            line_start = nl_pos + 1;
+        }
+        if (line_start < content_size)
+            this->lines.push_back(line_span{ line_start, content_size - line_start });
+    }
+
+    // Remove the line at index @p line of this->lines, leaving a tombstone in its place
+    template <typename T>
+        requires CharacterType<T>
+    void Parser<T>::remove_line(location_type line)
+    {
+        line_span& span = this->lines.at(line);
+        if (span.removed)
+            return;
+        span.removed = true;
+        this->removed_lines++;
+    }
+
+    // Rebuild this->file_content (and this->lines) from the lines which haven't been removed (each of them followed by a `\n`),
+    // in a single pass
+    template <typename T>
+        requires CharacterType<T>
+    void Parser<T>::reassemble_lines(void)
+    {
+        // If no line was removed and the content already ends with a `\n`, there is nothing to rebuild (and to copy)
+        if (this->removed_lines == 0 && (this->file_content.empty() || SAME(this->file_content.back(), '\n')))
+            return;
+
+        ParsedText<T> reassembled;
+        reassembled.reserve(this->file_content.size());
+        std::vector<line_span> kept_lines;
+        kept_lines.reserve(this->lines.size() - this->removed_lines);
+        // The lines of the already lexed pragmas move too
+        std::vector<std::pair<location_type, PragmaToken<T>>> moved_candidates;
+        auto candidate = this->pragma_candidates.cbegin();
+        for (auto&& span : this->lines)
+        {
+            if (span.removed)
+                continue;
+            if (this->has_pragma_candidates)
             {
-                this->lines.push_back(line);
-                line.push_back(MK_CHAR(linecount, colcount, c));
-                this->file_content.insert(this->file_content.end(), line.begin(), line.end());
-                line.clear();
-                linecount++;
-                colcount = 0;
+                while (candidate != this->pragma_candidates.cend() && candidate->first < span.offset)
+                    ++candidate;
+                if (candidate != this->pragma_candidates.cend() && candidate->first == span.offset)
+                    moved_candidates.emplace_back(reassembled.size(), candidate->second);
             }
-            else
+            kept_lines.push_back(line_span{ reassembled.size(), span.size });
+            const bool has_newline = span.offset + span.size < this->file_content.size();
+            reassembled.append(this->file_content, span.offset, span.size + (has_newline ? 1 : 0));
+            if (!has_newline)
             {
-                line.push_back(MK_CHAR(linecount, colcount, c));
-                colcount++;
+                // Give the missing `\n` the position following the last code unit
+                const ParsedChar<T> last = reassembled.empty() ? ParsedChar<T>(0, 0, T()) : reassembled.at(reassembled.size() - 1);
+                for (auto&& c : CONVERT(T, '\n'))
+                    reassembled.push_back(c, last.line(), last.col() + 1);
             }
         }
-        // Reset file state to freshly opened
-        this->get_file_stream().seekg(0, std::basic_ios<T>::beg);
-
-        return this->file_content_raw;
+        this->file_content = std::move(reassembled);
+        this->lines = std::move(kept_lines);
+        this->removed_lines = 0;
+        this->pragma_candidates = std::move(moved_candidates);
     }
 
-    // Strip C and C++ style comments from this->file_content string.
+    // Scan this->file_content_raw for comments, starting from the state @p from and going up to @p until (or further if a
+    // comment goes on after it).
+    // If `Output` is true, the kept code units (along with their original positions) are appended to `res.out` as soon as a
+    // first comment is found, otherwise only the state of the scan is followed.
+    // @p on_line_start is given the state of the scan at each line start it goes through, and stops it by returning true.
+    // Nothing is thrown on an unterminated comment: the returned state is just marked as such.
     template <typename T>
         requires CharacterType<T>
-    Parser<T>& Parser<T>::strip_comments(void)
+    template <bool Output, typename OnLineStart>
+    typename Parser<T>::strip_state Parser<T>::scan_comments(strip_state from, location_type until, strip_result& res, OnLineStart&& on_line_start) const
     {
 #if defined(FILE_CONTENT)
     #undef FILE_CONTENT
 #endif
+#define FILE_CONTENT(POS) (this->file_content_raw[POS])
+
+        const location_type content_size = this->file_content_raw.size();
+        location_type i = from.pos;
+        bool in_str_lit = from.in_str_lit; // Are we in a string literal ?
+
+        // Start of the span of code units which are kept but not appended to `res.out` yet
+        location_type kept_from = i;
+        auto flush_kept = [&](location_type up_to) -> void
+        {
+            if constexpr (Output)
+            {
+                if (!res.stripped_any)
+                {
+                    res.out.reserve(until - from.pos);
+                    res.stripped_any = true;
+                }
+                if (up_to > kept_from)
+                    this->append_raw(res.out, kept_from, up_to);
+            }
+            kept_from = up_to;
+        };
+        // The last kept code unit when nothing is pending, for scans which don't output anything
+        // (which can only be `res.before`, or the space replacing a block comment)
+        bool has_last_kept = res.before.has_value();
+        bool last_kept_is_bsl = has_last_kept && SAME(res.before->val(), '\\');
+
+        // Only `"`, `/` and `\n` can change the state of the scan, everything in between is skipped a whole block at a time
+        Util::DelimiterFinder<T, '"', '/', '\n'> delimiters(this->file_content_raw);
+        Util::DelimiterFinder<T, '\\', '\n'> line_comment_delimiters(this->file_content_raw);
+        while (i < until)
+        {
+            i = std::min(delimiters.next(i), until);
+            if (i == until)
+                break;
+            if (SAME(FILE_CONTENT(i), '"'))
+            {
+                // Look at the last kept code unit
+                bool toggle = false;
+                if (i > kept_from)
+                    toggle = DIFFERENT(FILE_CONTENT(i - 1), '\\');
+                else if (Output && !res.out.empty())
+                    toggle = DIFFERENT(res.out.back(), '\\');
+                else
+                    toggle = has_last_kept && !last_kept_is_bsl;
+                if (toggle)
+                    in_str_lit = !in_str_lit;
+                ++i;
+            }
+            else if (!in_str_lit && SAME(FILE_CONTENT(i), '/') && i + 1 < content_size && SAME(FILE_CONTENT(i + 1), '/'))
+            {
+                // The comment goes on after its n-th newline as long as at least n + 1 `\\` have been seen since its start
+                // (and as long as this newline isn't the last character of the file)
+                location_type next_nl_pos = std::basic_string<T>::npos;
+                location_type nl_count = 0;
+                location_type bsl_count = 0;
+                for (location_type j = line_comment_delimiters.next(i + 2); j < content_size; j = line_comment_delimiters.next(j + 1))
+                {
+                    if (SAME(FILE_CONTENT(j), '\\'))
+                        bsl_count++;
+                    else if (SAME(FILE_CONTENT(j), '\n'))
+                    {
+                        if (bsl_count > nl_count && j + 1 < content_size)
+                        {
+                            nl_count++;
+                            continue;
+                        }
+                        next_nl_pos = j;
+                        break;
+                    }
+                }
+                flush_kept(i);
+                if (next_nl_pos != std::basic_string<T>::npos)
+                {
+                    if constexpr (Output)
+                    {
+                        // Erase the possible '\t' or ' ' before the erased content
+                        while (!res.out.empty() && (SAME(res.out.back(), '\t') || SAME(res.out.back(), ' ')))
+                            res.out.pop_back();
+                        // (and those kept before `res.out` too, if all of it is erased)
+                        if (res.out.empty())
+                            res.pops_before = true;
+                    }
+                    // The newline itself is kept
+                    i = kept_from = next_nl_pos;
+                }
+                else // erase until the end of the file
+                    i = kept_from = content_size;
+            }
+            else if (!in_str_lit && SAME(FILE_CONTENT(i), '/') && i + 1 < content_size && SAME(FILE_CONTENT(i + 1), '*'))
+            {
+                flush_kept(i);
+                auto to_find = ANY_STRING(T, "*/");
+                location_type end_comment_pos = this->file_content_raw.find(to_find.data(), i + 1);
+                if (end_comment_pos == std::basic_string<T>::npos)
+                    return strip_state{ i, in_str_lit, true };
+                if constexpr (Output)
+                {
+                    // Add a space instead, as specified in the standard, with the position of the character following
+                    // the comment (or of the comment itself if it ends the file, so that positions stay unique)
+                    const ParsedChar<T> good_pos = this->raw_char_at((end_comment_pos + 2 < content_size) ? end_comment_pos + 2 : i);
+                    for (auto&& cch : CONVERT(T, ' '))
+                        res.out.push_back(cch, good_pos.line(), good_pos.col());
+                }
+                has_last_kept = true;
+                last_kept_is_bsl = false;
+                i = kept_from = end_comment_pos + 2;
+            }
+            else if (SAME(FILE_CONTENT(i), '\n'))
+            {
+                // Its offset once kept
+                if constexpr (Output)
+                    res.newlines.push_back(res.out.size() + (i - kept_from));
+                ++i;
+                if (i < until && on_line_start(strip_state{ i, in_str_lit }))
+                    break;
+            }
+            else
+                ++i;
+        }
+        if constexpr (Output)
+        {
+            if (res.stripped_any)
+                flush_kept(i);
+        }
+        return strip_state{ i, in_str_lit };
+
+#undef FILE_CONTENT
 #define FILE_CONTENT(POS) (this->file_content_raw.at(POS))
+    }
 
+    template <typename T>
+        requires CharacterType<T>
+    void Parser<T>::throw_unterminated_comment(const ParsedText<T>& kept) const
+    {
+        // Put the line, column and line content in the exception
+        size_t line = 1;
+        size_t column = 1;
+        for (auto&& c : kept.view())
+        {
+            if (SAME(c, '\n'))
+            {
+                line++;
+                column = 1;
+            }
+            else
+                column++;
+        }
+        throw Exception<T, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Unterminated comment\n", this->file_path, line, column, this->get_raw_line(line - 1));
+    }
+
+    // Strip C and C++ style comments from this->file_content string.
+    // Everything is done in a single pass, appending the kept spans of code units (and their original positions) to a new buffer,
+    // so that the whole tail of the content is never shifted.
+    template <typename T>
+        requires CharacterType<T>
+    Parser<T>& Parser<T>::strip_comments(void)
+    {
         if (this->file_content_raw.empty() || this->file_content.empty())
             throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "File content is empty\n");
-        
-        [[maybe_unused]]
-        size_t pp_if_level = 0;
-        bool in_str_lit = false; // Are we in a string literal ?
-        std::basic_string<T> file_content_raw_copy{ this->file_content_raw };
 
-        typedef std::basic_string<T> local_string_type;
-        typedef typename local_string_type::size_type local_size_type;
-        
-#undef FILE_CONTENT
-#define FILE_CONTENT(POS) (file_content_raw_copy.at(POS))
+        const location_type content_size = this->file_content_raw.size();
+        // Every code unit of `this->file_content_raw` must have its original position in `this->file_content`
+        if (this->file_content.size() != content_size)
+            throw Exception<T, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Parsing failed");
+
+        this->pragma_candidates.clear();
+        this->has_pragma_candidates = false;
+        this->raw_line_states.assign(this->raw_line_starts.size(), line_start_state::IN_COMMENT);
+        this->raw_line_states.front() = line_start_state::IN_CODE;
+
+        // Nothing is copied until the first comment is found, so that a file without comments is left untouched
+        strip_result res;
+        try
+        {
+            location_type line = 0;
+            const strip_state end = this->template scan_comments<true>(strip_state{}, content_size, res, [this, &line](const strip_state& state) {
+                this->record_line_start(line, state);
+                return false;
+            });
+            if (end.unterminated)
+                this->throw_unterminated_comment(res.out);
+        }
+        catch (const Exception<T, std::filesystem::path>& e)
+        {
+            throw e;
+        }
+        catch (const std::exception& e)
+        {
+            throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Failed to strip comments: " + std::string(e.what()) + "\n");
+        }
+        catch (...)
+        {
+            throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Failed to strip comments: Unknown exception\n");
+        }
+        if (!res.stripped_any)
+            return *this;
+
+        if (!res.out.is_consistent())
+            throw Exception<T, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Parsing failed");
+        this->file_content = std::move(res.out);
+
+        // Also reindex the lines
+        this->index_lines(res.newlines);
+        return *this;
+    }
+
+    // Same as above, but with the content split in chunks (at line starts) scanned by the threads of @p pool.
+    // A chunk can only be stripped once the state of the scan at its start (where it is and whether it is in a string literal)
+    // is known, which depends on all the previous chunks. So:
+    //  1. Each chunk is first scanned (without keeping anything) from both states it can start in, recording some checkpoints
+    //  2. The actual state at the start of each chunk is deduced from these scans, in order. When a comment overlaps two chunks,
+    //     the second one is scanned again from the end of the comment, but only until it reaches a checkpoint in the same state
+    //  3. All the chunks are stripped at once, and the results are put back together
+    //  4. The pragmas of the resulting lines are lexed, so that `search_imports` and `search_super_defines` don't have to
+    // The result (and the errors) are the same as with the serial scan.
+    template <typename T>
+        requires CharacterType<T>
+    Parser<T>& Parser<T>::strip_comments(ThreadPool& pool, size_t chunk_size)
+    {
+        const location_type content_size = this->file_content_raw.size();
+        if (chunk_size == 0 || content_size <= chunk_size || pool.size() < 2 || this->file_content.size() != content_size)
+            return this->strip_comments();
+
+        // Checkpoints are recorded at the first line start after each `checkpoint_interval` code units
+        constexpr location_type checkpoint_interval = 4096;
+
+        // Wait for all the tasks to be done before getting their results (and so before throwing), since they use this frame
+        auto wait_all = [](std::vector<std::future<void>>& tasks) -> void
+        {
+            for (auto&& task : tasks)
+                task.wait();
+            for (auto&& task : tasks)
+                task.get();
+        };
+
+        const std::basic_string<T> newline = CONVERT(T, '\n');
+        std::vector<location_type> bounds{ 0 };
+        while (content_size - bounds.back() > chunk_size)
+        {
+            const location_type nl_pos = this->file_content_raw.find(newline, bounds.back() + chunk_size);
+            if (nl_pos == std::basic_string_view<T>::npos || nl_pos + 1 >= content_size)
+                break;
+            bounds.push_back(nl_pos + 1);
+        }
+        bounds.push_back(content_size);
+        const size_t chunk_count = bounds.size() - 1;
+        if (chunk_count < 2)
+            return this->strip_comments();
+
+        struct speculation
+        {
+            strip_result res;
+            strip_state end;
+            std::vector<strip_state> checkpoints;
+        };
+        std::vector<speculation> speculations(2 * chunk_count);
+        std::vector<strip_state> entries(chunk_count);
+        std::vector<strip_result> results(chunk_count);
+        std::vector<strip_state> ends(chunk_count);
+        bool serial_fallback = false;
         try
         {
-            #pragma GCC novector
-            for (local_size_type i = 0; i < file_content_raw_copy.size(); ++i)
+            // 1.
             {
-                if (SAME(FILE_CONTENT(i), '"'))
-                {
-                    if (i > 0 && DIFFERENT(FILE_CONTENT(i - 1), '\\'))
-                        in_str_lit = !in_str_lit;
-                }
-                else if (!in_str_lit)
+                std::vector<std::future<void>> tasks;
+                for (size_t c = 0; c < chunk_count; ++c)
                 {
-                    if (SAME(FILE_CONTENT(i), '/'))
+                    for (bool in_str_lit : { false, true })
                     {
-                        if (i + 1 < file_content_raw_copy.size())
-                        {
-                            if (SAME(FILE_CONTENT(i + 1), '/'))
-                            {
-                                // Check for `\\` and erase the following line if present
-                                local_size_type next_nl_pos = file_content_raw_copy.find(CONVERT(T, '\n'), i);
-                                local_size_type next_bsl_pos = file_content_raw_copy.find(CONVERT(T, '\\'), i);
-                                while ((next_bsl_pos != std::basic_string<T>::npos  || 
-                                        next_nl_pos  != std::basic_string<T>::npos) &&
-                                        next_bsl_pos < next_nl_pos                  &&
-                                        next_nl_pos + 1 < file_content_raw_copy.size())
-                                {
-                                    next_nl_pos = file_content_raw_copy.find(CONVERT(T, '\n'), next_nl_pos + 1);
-                                    next_bsl_pos = file_content_raw_copy.find(CONVERT(T, '\\'), next_bsl_pos + 1);
-                                }
-                                if (next_nl_pos != std::basic_string<T>::npos)
-                                {
-                                    file_content_raw_copy.erase(i, next_nl_pos - i);
-                                    this->file_content.erase(this->file_content.begin() + i, this->file_content.begin() + next_nl_pos);
-                                    // Erase the possible '\t' or ' ' before the erased content
-                                    while (i > 0 && (SAME(FILE_CONTENT(i - 1), '\t') || SAME(FILE_CONTENT(i - 1), ' ')))
+                        // The first chunk can only start outside of a string literal
+                        if (c == 0 && in_str_lit)
+                            continue;
+                        tasks.push_back(pool.enqueue([this, &bounds, &speculations, c, in_str_lit]() -> void {
+                            speculation& spec = speculations[2 * c + in_str_lit];
+                            // A chunk starting at its beginning always follows the `\n` ending the previous one
+                            if (c > 0)
+                                spec.res.before = this->file_content.at(bounds[c] - 1);
+                            location_type last_checkpoint = bounds[c];
+                            spec.end = this->template scan_comments<false>(
+                                strip_state{ bounds[c], in_str_lit }, bounds[c + 1], spec.res,
+                                [&spec, &last_checkpoint](const strip_state& state) -> bool {
+                                    if (state.pos - last_checkpoint >= checkpoint_interval)
                                     {
-                                        file_content_raw_copy.erase(i - 1, 1);
-                                        this->file_content.erase(this->file_content.begin() + i - 1);
-                                        i--;
+                                        spec.checkpoints.push_back(state);
+                                        last_checkpoint = state.pos;
                                     }
+                                    return false;
                                 }
-                                else // erase until the end of the file
-                                {
-                                    file_content_raw_copy.erase(i, file_content_raw_copy.size() - i);
-                                    this->file_content.erase(this->file_content.begin() + i, this->file_content.end());
-                                }
-                                i--;
-                            }
-                            else if (SAME(FILE_CONTENT(i + 1), '*'))
+                            );
+                        }));
+                    }
+                }
+                wait_all(tasks);
+            }
+
+            // 2.
+            strip_state state{};
+            for (size_t c = 0; c < chunk_count && !state.unterminated; ++c)
+            {
+                entries[c] = state;
+                if (state.pos >= bounds[c + 1]) // The whole chunk is in a comment
+                    continue;
+                if (state.pos == bounds[c])
+                {
+                    results[c].before = (c > 0) ? std::optional<ParsedChar<T>>(this->file_content.at(bounds[c] - 1)) : std::nullopt;
+                    state = speculations[2 * c + state.in_str_lit].end;
+                    continue;
+                }
+                // The previous chunk ends in a comment, which is either replaced by a space (for a block comment, in which case
+                // its position is the one of the following code unit), or followed by a `\n` (for a line comment)
+                const ParsedChar<T> after_comment = this->file_content.at(state.pos);
+                results[c].before = ParsedChar<T>(after_comment.line(), after_comment.col(), T(' '));
+
+                const speculation* synced = nullptr;
+                size_t next_checkpoint[2] = { 0, 0 };
+                strip_result rescan;
+                rescan.before = results[c].before;
+                const strip_state end = this->template scan_comments<false>(
+                    state, bounds[c + 1], rescan,
+                    [&](const strip_state& at) -> bool {
+                        for (bool in_str_lit : { false, true })
+                        {
+                            const auto& checkpoints = speculations[2 * c + in_str_lit].checkpoints;
+                            size_t& k = next_checkpoint[in_str_lit];
+                            while (k < checkpoints.size() && checkpoints[k].pos < at.pos)
+                                ++k;
+                            if (k < checkpoints.size() && checkpoints[k].pos == at.pos && checkpoints[k].in_str_lit == at.in_str_lit)
                             {
-                                auto to_find = ANY_STRING(T, "*/");
-                                local_size_type end_comment_pos = file_content_raw_copy.find(to_find.data(), i);
-                                if (end_comment_pos == std::basic_string<T>::npos)
-                                {
-                                    // Put the line, column and line content in the exception
-                                    size_t line = 1;
-                                    size_t column = 1;
-                                    for (size_t j = 0; j < i; j++)
-                                    {
-                                        if (SAME(FILE_CONTENT(j), '\n'))
-                                        {
-                                            line++;
-                                            column = 1;
-                                        }
-                                        else
-                                            column++;
-                                    }
-                                    throw Exception<T, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Unterminated comment\n", this->file_path, line, column, this->lines_raw.at(line - 1));
-                                }
-                                // If end_comment_pos == end of file, just delete until the end of the file and then add the space
-                                if (end_comment_pos + 2 >= file_content_raw_copy.size())
-                                {
-                                    file_content_raw_copy.erase(file_content_raw_copy.begin() + i, file_content_raw_copy.end());
-                                    this->file_content.erase(this->file_content.begin() + i, this->file_content.end());
-                                    
-                                    for (auto&& cch : CONVERT(T, ' '))
-                                        file_content_raw_copy.push_back(cch);
-                                    auto good_pos = [&]() -> string_size_type<T> { return i == this->file_content.size() ? i - 1 : i; };
-                                    for (auto&& cch : CONVERT(T, ' '))
-                                        this->file_content.push_back(MK_CHAR(std::get<0>(this->file_content.at(good_pos())), std::get<1>(this->file_content.at(good_pos())), cch));
-                                }
-                                else
-                                {
-                                    file_content_raw_copy.erase(i, end_comment_pos - i + 2);
-                                    this->file_content.erase(this->file_content.begin() + i, this->file_content.begin() + end_comment_pos + 2);
-                                    // Add a space instead, as specified in the standard
-                                    file_content_raw_copy.insert(i, ANY_STRING(T, " ").data());
-                                    std::vector<ParsedChar<T>> to_insert{};
-                                    auto good_pos = [&]() -> string_size_type<T> { return i == this->file_content.size() ? i - 1 : i; };
-                                    for (auto&& cch : CONVERT(T, ' '))
-                                        to_insert.push_back(MK_CHAR(std::get<0>(this->file_content.at(good_pos())), std::get<1>(this->file_content.at(good_pos())), cch));
-                                    this->file_content.insert(this->file_content.begin() + i, to_insert.begin(), to_insert.end());
-                                }
-                                i--;
+                                synced = &speculations[2 * c + in_str_lit];
+                                return true;
                             }
                         }
+                        return false;
                     }
+                );
+                state = (synced != nullptr) ? synced->end : end;
+            }
+            // Let the serial scan report the error with the right position
+            serial_fallback = state.unterminated;
+
+            // 3.
+            if (!serial_fallback)
+            {
+                // Each chunk records the states of the scan at its own line starts
+                this->raw_line_states.assign(this->raw_line_starts.size(), line_start_state::IN_COMMENT);
+                this->raw_line_states.front() = line_start_state::IN_CODE;
+                std::vector<std::future<void>> tasks;
+                for (size_t c = 0; c < chunk_count; ++c)
+                {
+                    if (entries[c].pos >= bounds[c + 1])
+                        continue;
+                    tasks.push_back(pool.enqueue([this, &bounds, &entries, &results, &ends, c]() -> void {
+                        location_type line = this->raw_line_of(bounds[c]);
+                        // (unless the line is empty, since a line comment going on until its `\n` stops there too)
+                        if (entries[c].pos == bounds[c] && DIFFERENT(this->file_content_raw[bounds[c]], '\n'))
+                            this->record_line_start(line, entries[c]);
+                        ends[c] = this->template scan_comments<true>(entries[c], bounds[c + 1], results[c], [this, &line](const strip_state& state) {
+                            this->record_line_start(line, state);
+                            return false;
+                        });
+                    }));
                 }
+                wait_all(tasks);
             }
         }
         catch (const Exception<T, std::filesystem::path>& e)
@@ -318,49 +740,112 @@ namespace SupDef
         {
             throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Failed to strip comments: Unknown exception\n");
         }
+        if (serial_fallback)
+            return this->strip_comments();
 
-        if (file_content_raw_copy.size() != this->file_content.size())
-            throw Exception<T, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Parsing failed");
-        for (string_size_type<T> i = 0; i < file_content_raw_copy.size(); ++i)
+        bool stripped_any = false;
+        for (size_t c = 0; c < chunk_count; ++c)
         {
-            if (DIFFERENT(FILE_CONTENT(i), std::get<2>(this->file_content.at(i))))
+            if (entries[c].pos >= bounds[c + 1])
+                continue;
+            // Each chunk must end where the next one starts
+            const location_type expected_end = (c + 1 < chunk_count) ? entries[c + 1].pos : content_size;
+            if (ends[c].unterminated || ends[c].pos != expected_end)
                 throw Exception<T, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Parsing failed");
+            stripped_any = stripped_any || results[c].stripped_any;
         }
-    
-#undef FILE_CONTENT
-#define FILE_CONTENT(POS) (this->file_content_raw.at(POS))
-/*
-        this->lines_raw.clear();
-#if defined(__cpp_lib_containers_ranges) && __cpp_lib_containers_ranges >= 202202L && 0 // For now, disable this
-        // Not even sure this works
-        this->lines_raw.assign_range(split_string(this->file_content_raw, '\n'));
-#else
-        this->lines_raw = split_string(this->file_content_raw, CONVERT(T, '\n'));
-#endif
-*/
-        // Also resplit the lines
-        this->lines.clear();
-        string_size_type<T> linecount = 0;
-        string_size_type<T> colcount = 0;
-        std::vector<ParsedChar<T>> line;
-        for (auto&& c : this->file_content)
+        if (stripped_any)
         {
-            if (SAME(std::get<2>(c), '\n'))
+            ParsedText<T> stripped_content;
+            stripped_content.reserve(content_size);
+            std::vector<location_type> newlines;
+            for (size_t c = 0; c < chunk_count; ++c)
             {
-                this->lines.push_back(line);
-                line.clear();
-                linecount++;
-                colcount = 0;
+                if (entries[c].pos >= bounds[c + 1])
+                    continue;
+                strip_result& res = results[c];
+                if (res.pops_before)
+                {
+                    while (!stripped_content.empty() && (SAME(stripped_content.back(), '\t') || SAME(stripped_content.back(), ' ')))
+                        stripped_content.pop_back();
+                }
+                for (const location_type nl_pos : res.newlines)
+                    newlines.push_back(stripped_content.size() + nl_pos);
+                if (res.stripped_any)
+                    stripped_content.append(res.out, 0);
+                else
+                    stripped_content.append(this->file_content, entries[c].pos, bounds[c + 1] - entries[c].pos);
+                res.out.clear();
             }
-            else
+            if (!stripped_content.is_consistent())
+                throw Exception<T, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Parsing failed");
+            this->file_content = std::move(stripped_content);
+            this->index_lines(newlines);
+        }
+
+        // 4.
+        const size_t line_count = this->lines.size();
+        const size_t lines_per_task = (line_count + chunk_count - 1) / chunk_count;
+        std::vector<std::vector<std::pair<location_type, PragmaToken<T>>>> found(chunk_count);
+        {
+            std::vector<std::future<void>> tasks;
+            for (size_t t = 0; t < chunk_count && t * lines_per_task < line_count; ++t)
             {
-                line.push_back(c);
-                colcount++;
+                tasks.push_back(pool.enqueue([this, &found, t, lines_per_task, line_count]() -> void {
+                    // Only the lines with a `#` can be pragmas
+                    const auto content = this->file_content.view();
+                    Util::DelimiterFinder<T, '#'> hashes(content);
+                    const size_t last = std::min(line_count, (t + 1) * lines_per_task);
+                    for (size_t i = t * lines_per_task; i < last; ++i)
+                    {
+                        const location_type hash_pos = hashes.next(this->lines[i].offset);
+                        while (i < last && hash_pos >= this->lines[i].offset + this->lines[i].size)
+                            ++i;
+                        if (i == last)
+                            break;
+                        const line_span span = this->lines[i];
+                        const PragmaToken<T> token = Parser<T>::lex_pragma(content.substr(span.offset, span.size));
+                        if (token)
+                            found[t].emplace_back(span.offset, token);
+                    }
+                }));
             }
+            wait_all(tasks);
         }
+        this->pragma_candidates.clear();
+        for (auto&& tokens : found)
+            this->pragma_candidates.insert(this->pragma_candidates.end(), tokens.begin(), tokens.end());
+        this->has_pragma_candidates = true;
         return *this;
     }
 
+    // Lex the line @p line with @class PragmaLexer, or with the shared @class PragmaGrammar if `SUPDEF_PRAGMA_USE_REGEX` is set
+    template <typename T>
+        requires CharacterType<T>
+    PragmaToken<T> Parser<T>::lex_pragma(std::basic_string_view<T> line)
+    {
+#if SUPDEF_PRAGMA_USE_REGEX
+        return PragmaGrammar<T>::get().lex_line(line);
+#else
+        return PragmaLexer<T>::lex_line(line);
+#endif
+    }
+
+    // Lex the line @p line (spanning @p span in this->file_content), using the pragmas already lexed by
+    // `strip_comments(ThreadPool&, size_t)` if any
+    template <typename T>
+        requires CharacterType<T>
+    PragmaToken<T> Parser<T>::lex_pragma_line(const line_span& span, std::basic_string_view<T> line) const
+    {
+        if (!this->has_pragma_candidates)
+            return Parser<T>::lex_pragma(line);
+        auto it = std::lower_bound(
+            this->pragma_candidates.begin(), this->pragma_candidates.end(), span.offset,
+            [](const std::pair<location_type, PragmaToken<T>>& candidate, location_type offset) { return candidate.first < offset; }
+        );
+        return (it != this->pragma_candidates.end() && it->first == span.offset) ? it->second : PragmaToken<T>{};
+    }
+
     /**
      * @brief Remove all string literals from the file content
      * @details Does not modify the content of the class, but returns a new string
@@ -375,34 +860,419 @@ namespace SupDef
         if (this->file_content_raw.empty() || this->file_content.empty())
             throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "File content is empty\n");
 
+        const std::basic_string_view<T> content = this->file_content_raw;
         std::basic_string<T> res;
-        res.reserve(this->file_content_raw.size());
+        res.reserve(content.size());
         bool in_str_lit = false;
-        for (size_t i = 0; i < this->file_content_raw.size(); ++i)
+        // Every `"` is removed, along with what is between two of them, so only append the spans between two `"` which are
+        // outside of string literals
+        Util::DelimiterFinder<T, '"'> quotes(content);
+        size_t span_start = 0;
+        for (size_t i = quotes.next(0); ; i = quotes.next(i + 1))
         {
-            if (SAME(FILE_CONTENT(i), '"'))
-            {
-                if (i > 0 && DIFFERENT(FILE_CONTENT(i - 1), '\\'))
-                    in_str_lit = !in_str_lit;
-            }
-            else if (!in_str_lit)
-                res += FILE_CONTENT(i);
+            if (!in_str_lit)
+                res.append(content.substr(span_start, i - span_start));
+            if (i >= content.size())
+                break;
+            if (i > 0 && DIFFERENT(FILE_CONTENT(i - 1), '\\'))
+                in_str_lit = !in_str_lit;
+            span_start = i + 1;
         }
         return res;
     }
 
-    /* template <typename T>
+
+
+    // Replace the @p removed_len code units of this->file_content_raw starting at @p offset with @p inserted_text, and bring
+    // the rest of the parser up to date without parsing everything again:
+    //  1. The raw content is edited (it is copied first if it was mapped), and its line index is updated around the edit
+    //  2. The comments are stripped again from the last line start before the edit which isn't in a comment (nor in one of the
+    //     pragmas found around the edit), until the scan goes through a line start after the edit in the same state as before
+    //  3. The stripped lines replace the ones they come from in this->file_content, this->lines and the lexed pragmas
+    //  4. If all the lines have already been searched for imports and / or super defines, only these lines are searched again,
+    //     and the pragmas found there replace the ones which were
+    // If the comments haven't been stripped yet, only 1. is done (and the parser is left as if the edited content was just read).
+    template <typename T>
         requires CharacterType<T>
-    std::shared_ptr<std::basic_string<T>> Parser<T>::reassemble_lines(void)
+    typename Parser<T>::edit_result Parser<T>::apply_edit(string_size_type<T> offset, string_size_type<T> removed_len, std::basic_string_view<T> inserted_text, ExpansionCache<T>* cache)
     {
-        if (this->lines_raw.empty())
-            throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Lines are empty\n");
-        std::basic_string<T> res;
-        res.reserve(this->file_content_raw.size());
-        for (auto& line : this->lines_raw)
-            res += line + CONVERT(T, '\n');
-        return std::make_shared<std::basic_string<T>>(res);
-    } */
+        typedef std::make_signed_t<location_type> delta_type;
+
+        const location_type old_size = this->file_content_raw.size();
+        if (this->raw_line_starts.empty() || offset > old_size || removed_len > old_size - offset)
+            throw Exception<char, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Edit out of the file content\n");
+        edit_result result;
+
+        // 1.
+        const location_type first_edited_line = this->raw_line_of(offset);
+        const location_type last_edited_line = this->raw_line_of(offset + removed_len);
+        const location_type old_last_edited_start = this->raw_line_starts[last_edited_line];
+        std::basic_string<T> edited;
+        edited.reserve(old_size - removed_len + inserted_text.size());
+        edited.append(this->file_content_raw.substr(0, offset));
+        edited.append(inserted_text);
+        edited.append(this->file_content_raw.substr(offset + removed_len));
+
+        std::vector<location_type> inserted_starts;
+        Util::DelimiterFinder<T, '\n'> newlines(inserted_text);
+        for (auto nl_pos = newlines.next(0); nl_pos < inserted_text.size(); nl_pos = newlines.next(nl_pos + 1))
+            inserted_starts.push_back(offset + nl_pos + 1);
+        auto starts_it = this->raw_line_starts.erase(
+            this->raw_line_starts.begin() + first_edited_line + 1,
+            this->raw_line_starts.begin() + last_edited_line + 1
+        );
+        starts_it = this->raw_line_starts.insert(starts_it, inserted_starts.begin(), inserted_starts.end());
+        for (starts_it += inserted_starts.size(); starts_it != this->raw_line_starts.end(); ++starts_it)
+            *starts_it = *starts_it + inserted_text.size() - removed_len;
+        const delta_type line_delta = static_cast<delta_type>(inserted_starts.size()) - static_cast<delta_type>(last_edited_line - first_edited_line);
+        // The last edited line, in the edited content
+        const location_type edit_end_line = first_edited_line + inserted_starts.size();
+        // Start of the line @p line of the content before the edit (which mustn't be strictly between the edited lines)
+        auto old_line_start = [&](location_type line) -> location_type
+        {
+            if (line <= first_edited_line)
+                return this->raw_line_starts[line];
+            if (line == last_edited_line)
+                return old_last_edited_start;
+            return this->raw_line_starts[static_cast<location_type>(static_cast<delta_type>(line) + line_delta)] - inserted_text.size() + removed_len;
+        };
+
+        // The old content may still be borrowed by this->file_content, so it is only replaced once it is not anymore
+        this->file_content_raw = edited;
+        auto commit_raw = [this, &edited]() -> void
+        {
+            this->file_content_storage = std::move(edited);
+            this->file_content_raw = this->file_content_storage;
+            this->file_mapping = MappedFile();
+        };
+        // Go back to the state the parser is in right after `slurp_file`
+        auto reset_to_raw = [this]() -> void
+        {
+            this->file_content = ParsedText<T>::borrow_source(this->file_content_raw);
+            std::vector<location_type> raw_newlines;
+            raw_newlines.reserve(this->raw_line_starts.size());
+            for (location_type line = 1; line < this->raw_line_starts.size(); ++line)
+                raw_newlines.push_back(this->raw_line_starts[line] - 1);
+            this->index_lines(raw_newlines);
+            this->pragma_candidates.clear();
+            this->has_pragma_candidates = false;
+            this->raw_line_states.clear();
+            this->imports.clear();
+            this->super_defines.clear();
+            this->imports_searched = false;
+            this->super_defines_searched = false;
+            this->open_super_define = 0;
+        };
+        if (this->raw_line_states.empty())
+        {
+            commit_raw();
+            reset_to_raw();
+            return result;
+        }
+
+        // 2.
+        const location_type old_line_count = this->raw_line_states.size();
+        const location_type new_line_count = this->raw_line_starts.size();
+        location_type first_line = first_edited_line;
+        location_type old_end_line = last_edited_line + 1; // The scan must at least go through the start of this (old) line
+        // A super define left open goes until the end of the file
+        const std::optional<pragma_loc_type> open_loc = (this->open_super_define != 0) ?
+            std::make_optional(pragma_loc_type{ string_type(), this->open_super_define, old_line_count }) :
+            std::nullopt;
+        for (bool moved = true; moved; )
+        {
+            moved = false;
+            while (first_line > 0 && this->raw_line_states[first_line] == line_start_state::IN_COMMENT)
+                --first_line;
+            auto stretch_to = [&](const pragma_loc_type& loc) -> void
+            {
+                const auto [first, last] = this->raw_lines_of(loc);
+                if (first >= old_end_line || last < first_line || (first >= first_line && last < old_end_line))
+                    return;
+                first_line = std::min(first_line, first);
+                old_end_line = std::max(old_end_line, last + 1);
+                moved = true;
+            };
+            for (const auto* found : { &this->imports, &this->super_defines })
+            {
+                for (auto&& loc : *found)
+                    stretch_to(loc);
+            }
+            if (open_loc.has_value())
+                stretch_to(*open_loc);
+        }
+        // Whether the (old) line @p line is in a super define, without being its first line
+        auto in_super_define = [this, &open_loc](location_type line) -> bool
+        {
+            if (open_loc.has_value() && this->raw_lines_of(*open_loc).first < line)
+                return true;
+            auto it = std::upper_bound(
+                this->super_defines.begin(), this->super_defines.end(), line,
+                [](location_type l, const pragma_loc_type& loc) { return l < std::get<1>(loc) - 1; }
+            );
+            if (it == this->super_defines.begin())
+                return false;
+            const auto [first, last] = this->raw_lines_of(*std::prev(it));
+            return first < line && line <= last;
+        };
+
+        // Where the content coming from the line following @p line (of the content before the edit) starts in this->file_content,
+        // i.e. right after the `\n` ending @p line: it is always kept when the scan goes through the start of the next line
+        // (unless it has been removed along with a pragma, and then the next line starts at the next code unit kept)
+        auto content_after_line = [&](location_type line) -> location_type
+        {
+            const location_type nl_col = old_line_start(line + 1) - 1 - old_line_start(line);
+            // (the space replacing a block comment has the position of the code unit following it)
+            for (location_type pos = this->file_content.first_from(line, nl_col); pos < this->file_content.size(); ++pos)
+            {
+                const ParsedChar<T> found = this->file_content.at(pos);
+                if (found.line() != line || found.col() != nl_col)
+                    return pos;
+                if (SAME(found.val(), '\n'))
+                    return pos + 1;
+            }
+            return this->file_content.size();
+        };
+        strip_result res;
+        if (first_line > 0)
+            res.before = this->raw_char_at(this->raw_line_starts[first_line] - 1);
+        std::vector<line_start_state> region_states{ this->raw_line_states[first_line] };
+        location_type stop_line = new_line_count;
+        location_type line = first_line;
+        const strip_state from{ this->raw_line_starts[first_line], this->raw_line_states[first_line] == line_start_state::IN_STR_LIT };
+        const strip_state end = this->template scan_comments<true>(from, edited.size(), res, [&](const strip_state& state) -> bool {
+            while (this->raw_line_starts[line] < state.pos)
+                ++line;
+            const line_start_state at = state.in_str_lit ? line_start_state::IN_STR_LIT : line_start_state::IN_CODE;
+            // After the edit, the lines are the same as before, so as soon as the scan is in the same state as before at the start
+            // of one of them, it would go on exactly as before
+            if (line > edit_end_line)
+            {
+                const location_type old_line = static_cast<location_type>(static_cast<delta_type>(line) - line_delta);
+                if (old_line >= old_end_line && this->raw_line_states[old_line] == at && !in_super_define(old_line))
+                {
+                    stop_line = line;
+                    return true;
+                }
+            }
+            region_states.resize(line - first_line + 1, line_start_state::IN_COMMENT);
+            region_states.back() = at;
+            return false;
+        });
+        if (end.unterminated)
+        {
+            const ParsedChar<T> comment_start = this->raw_char_at(end.pos);
+            commit_raw();
+            reset_to_raw();
+            throw Exception<T, std::filesystem::path>(
+                ExcType::SYNTAX_ERROR,
+                "Unterminated comment\n",
+                this->file_path,
+                comment_start.line() + 1,
+                comment_start.col() + 1,
+                this->get_raw_line(comment_start.line())
+            );
+        }
+        if (!res.stripped_any)
+            this->append_raw(res.out, from.pos, end.pos);
+        region_states.resize(stop_line - first_line, line_start_state::IN_COMMENT);
+        // (the scan never goes through the start of an empty last line)
+        if (stop_line == new_line_count && new_line_count > 1 && this->raw_line_starts.back() == edited.size())
+            region_states.back() = line_start_state::IN_COMMENT;
+        const location_type old_stop_line = (stop_line < new_line_count) ? static_cast<location_type>(static_cast<delta_type>(stop_line) - line_delta) : old_line_count;
+
+        // 3.
+        const location_type content_from = (first_line > 0) ? content_after_line(first_line - 1) : 0;
+        const location_type content_to = (old_stop_line < old_line_count) ? content_after_line(old_stop_line - 1) : this->file_content.size();
+        const location_type new_region_size = res.out.size();
+
+        std::vector<line_span> region_lines;
+        location_type line_start = 0;
+        for (const location_type nl_pos : res.newlines)
+        {
+            region_lines.push_back(line_span{ content_from + line_start, nl_pos - line_start });
+            line_start = nl_pos + 1;
+        }
+        if (line_start < new_region_size)
+            region_lines.push_back(line_span{ content_from + line_start, new_region_size - line_start });
+        auto span_at = [this](location_type pos) -> location_type
+        {
+            auto it = std::lower_bound(
+                this->lines.begin(), this->lines.end(), pos,
+                [](const line_span& span, location_type p) { return span.offset < p; }
+            );
+            return static_cast<location_type>(std::distance(this->lines.begin(), it));
+        };
+        const location_type first_span = span_at(content_from);
+        const location_type end_span = span_at(content_to);
+        for (location_type i = first_span; i < end_span; ++i)
+            this->removed_lines -= this->lines[i].removed ? 1 : 0;
+        for (location_type i = end_span; i < this->lines.size(); ++i)
+            this->lines[i].offset = this->lines[i].offset - (content_to - content_from) + new_region_size;
+        this->lines.erase(this->lines.begin() + first_span, this->lines.begin() + end_span);
+        this->lines.insert(this->lines.begin() + first_span, region_lines.begin(), region_lines.end());
+
+        if (this->has_pragma_candidates)
+        {
+            auto candidate_at = [this](location_type pos)
+            {
+                return std::lower_bound(
+                    this->pragma_candidates.begin(), this->pragma_candidates.end(), pos,
+                    [](const std::pair<location_type, PragmaToken<T>>& candidate, location_type p) { return candidate.first < p; }
+                );
+            };
+            for (auto it = candidate_at(content_to); it != this->pragma_candidates.end(); ++it)
+                it->first = it->first - (content_to - content_from) + new_region_size;
+            std::vector<std::pair<location_type, PragmaToken<T>>> region_candidates;
+            for (auto&& span : region_lines)
+            {
+                const PragmaToken<T> token = Parser<T>::lex_pragma(res.out.view().substr(span.offset - content_from, span.size));
+                if (token)
+                    region_candidates.emplace_back(span.offset, token);
+            }
+            auto erased = this->pragma_candidates.erase(candidate_at(content_from), candidate_at(content_to));
+            this->pragma_candidates.insert(erased, region_candidates.begin(), region_candidates.end());
+        }
+
+        this->file_content.splice(content_from, content_to - content_from, res.out, line_delta);
+        commit_raw();
+        if (!this->file_content.is_consistent())
+            throw Exception<T, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Parsing failed");
+        this->raw_line_states.erase(this->raw_line_states.begin() + first_line, this->raw_line_states.begin() + old_stop_line);
+        this->raw_line_states.insert(this->raw_line_states.begin() + first_line, region_states.begin(), region_states.end());
+
+        // 4.
+        // Take the pragmas found in the stripped lines out, and move the following ones
+        auto take_region = [first_line, old_stop_line, line_delta](std::vector<pragma_loc_type>& found) -> std::vector<pragma_loc_type>
+        {
+            std::vector<pragma_loc_type> taken;
+            std::vector<pragma_loc_type> kept;
+            kept.reserve(found.size());
+            for (auto&& loc : found)
+            {
+                const location_type start_line = std::get<1>(loc) - 1;
+                if (start_line < first_line)
+                    kept.push_back(std::move(loc));
+                else if (start_line < old_stop_line)
+                    taken.push_back(std::move(loc));
+                else
+                {
+                    std::get<1>(loc) = static_cast<location_type>(static_cast<delta_type>(std::get<1>(loc)) + line_delta);
+                    std::get<2>(loc) = static_cast<location_type>(static_cast<delta_type>(std::get<2>(loc)) + line_delta);
+                    kept.push_back(std::move(loc));
+                }
+            }
+            found = std::move(kept);
+            return taken;
+        };
+        auto found_in_region = [first_line, stop_line](const std::vector<pragma_loc_type>& found) -> std::vector<pragma_loc_type>
+        {
+            std::vector<pragma_loc_type> res;
+            std::copy_if(found.begin(), found.end(), std::back_inserter(res), [&](const pragma_loc_type& loc) {
+                return std::get<1>(loc) - 1 >= first_line && std::get<1>(loc) - 1 < stop_line;
+            });
+            return res;
+        };
+        // (a super define left open after these lines is not searched again, since its lines are already removed)
+        location_type open_after = 0;
+        if (this->open_super_define != 0 && this->open_super_define - 1 >= old_stop_line)
+            open_after = this->open_super_define = static_cast<location_type>(static_cast<delta_type>(this->open_super_define) + line_delta);
+        const std::vector<pragma_loc_type> old_imports = take_region(this->imports);
+        const std::vector<pragma_loc_type> old_super_defines = take_region(this->super_defines);
+
+        location_type region_line_count = region_lines.size();
+#if !SUPDEF_WORKAROUND_GCC_INTERNAL_ERROR
+        if (this->imports_searched)
+        {
+            const location_type line_count = this->lines.size();
+            for (auto&& found : this->search_imports_in(first_span, first_span + region_line_count))
+            {
+                if (found.is_err())
+                    result.errors.push_back(found.error());
+            }
+            // The import lines are gone
+            region_line_count -= line_count - this->lines.size();
+        }
+#endif
+        if (this->super_defines_searched)
+        {
+            // A super define opened in these lines without being closed there goes on after them, as it would in a full search
+            location_type search_end = first_span + region_line_count;
+            bool left_open = false;
+            for (location_type i = first_span; i < search_end; ++i)
+            {
+                const line_span& span = this->lines[i];
+                const PragmaToken<T> token = this->lex_pragma_line(span, this->file_content.view().substr(span.offset, span.size));
+                if (token.kind == PragmaKind::DEF_BEGIN || token.kind == PragmaKind::DEF_END)
+                    left_open = token.kind == PragmaKind::DEF_BEGIN;
+            }
+            if (left_open)
+                search_end = this->lines.size();
+            for (auto&& found : this->search_super_defines_in(first_span, search_end))
+            {
+                if (found.is_err())
+                    result.errors.push_back(found.error());
+            }
+            if (left_open && this->open_super_define != 0)
+            {
+                // The super define left open in these lines would have reached the next one
+                auto next = std::find_if(this->super_defines.begin(), this->super_defines.end(), [stop_line](const pragma_loc_type& loc) {
+                    return std::get<1>(loc) - 1 >= stop_line;
+                });
+                location_type next_start = open_after;
+                if (next != this->super_defines.end() && (next_start == 0 || std::get<1>(*next) < next_start))
+                    next_start = std::get<1>(*next);
+                if (next_start != 0)
+                {
+                    const std::basic_string<T> real_line = this->get_raw_line(next_start - 1);
+                    result.errors.push_back(Error<T, std::filesystem::path>(
+                        ExcType::SYNTAX_ERROR,
+                        "Pragma start found while already in a supdef block",
+                        this->file_path,
+                        next_start,
+                        Parser<T>::lex_pragma(real_line).keyword_pos + 1,
+                        real_line
+                    ));
+                }
+            }
+            else if (this->open_super_define == 0)
+                this->open_super_define = open_after;
+        }
+
+        // Report what changed
+        auto contents_of = [](const std::vector<pragma_loc_type>& found) -> std::vector<string_type>
+        {
+            std::vector<string_type> res;
+            for (auto&& loc : found)
+                res.push_back(std::get<0>(loc));
+            std::sort(res.begin(), res.end());
+            return res;
+        };
+        result.imports_changed = contents_of(old_imports) != contents_of(found_in_region(this->imports));
+        const std::vector<string_type> old_contents = contents_of(old_super_defines);
+        const std::vector<string_type> new_contents = contents_of(found_in_region(this->super_defines));
+        std::vector<string_type> changed_contents;
+        std::set_symmetric_difference(
+            old_contents.begin(), old_contents.end(),
+            new_contents.begin(), new_contents.end(),
+            std::back_inserter(changed_contents)
+        );
+        // The first line of a super define is its name, possibly followed by its parameters and by the language of a runnable one
+        const std::basic_string<T> name_ends = CONVERT(T, '(') + CONVERT(T, ' ') + CONVERT(T, '\n');
+        for (auto&& content : changed_contents)
+            result.changed_super_defines.push_back(content.substr(0, content.find_first_of(name_ends)));
+        std::sort(result.changed_super_defines.begin(), result.changed_super_defines.end());
+        result.changed_super_defines.erase(
+            std::unique(result.changed_super_defines.begin(), result.changed_super_defines.end()),
+            result.changed_super_defines.end()
+        );
+        if (cache != nullptr)
+        {
+            for (const auto& name : result.changed_super_defines)
+                cache->invalidate(name);
+        }
+        return result;
+    }
 
 
 #if SUPDEF_WORKAROUND_GCC_INTERNAL_ERROR
@@ -411,10 +1281,18 @@ namespace SupDef
         requires CharacterType<T>
     Coro<Result<std::shared_ptr<std::basic_string<T>>, Error<T, std::filesystem::path>>> search_imports(Parser<T>& parser);
 #else
-    // TODO: When parsing, verify that there is nothing appearing before the import pragma
     template <typename T>
         requires CharacterType<T>
     Coro<Result<typename Parser<T>::pragma_loc_type, Error<T, std::filesystem::path>>> Parser<T>::search_imports(void)
+    {
+        return this->search_imports_in(0, std::numeric_limits<location_type>::max());
+    }
+
+    // Search the lines [@p first_line, @p end_line) of this->lines for import pragmas
+    // TODO: When parsing, verify that there is nothing appearing before the import pragma
+    template <typename T>
+        requires CharacterType<T>
+    Coro<Result<typename Parser<T>::pragma_loc_type, Error<T, std::filesystem::path>>> Parser<T>::search_imports_in(location_type first_line, location_type end_line)
     {
         Result<Parser<T>::pragma_loc_type, Error<T, std::filesystem::path>> ret;
         string_size_type<T> curr_line = 0;
@@ -450,40 +1328,33 @@ namespace SupDef
             co_return ret;
         }
 
-        typedef typename std::basic_regex<T> regex_t;
-        typedef std::match_results<typename std::basic_string<T>::const_iterator> match_res_t;
         typedef typename decltype(this->lines)::size_type line_num_t;
         typedef string_size_type<T> pos_t;
 
-        for (line_num_t i = 0; i < this->lines.size(); ++i)
+        for (line_num_t i = first_line; i < std::min<line_num_t>(end_line, this->lines.size()); ++i)
         {
-            const std::vector<ParsedChar<T>>& line_ = this->lines.at(i);
-            std::basic_string<T> line;
-            line.reserve(line_.size());
-            if (line_.empty())
+            const line_span span = this->lines.at(i);
+            if (span.removed || span.size == 0)
                 continue;
-            else
-                curr_line = std::get<0>(line_.at(0)) + 1;
-            for (auto& c : line_)
-                line += std::get<2>(c);
-            const regex_t inc_regex(ANY_STRING(T, SUPDEF_PRAGMA_IMPORT_REGEX), std::regex_constants::ECMAScript);
-            const regex_t inc_regex_angle_brackets(ANY_STRING(T, SUPDEF_PRAGMA_IMPORT_REGEX_ANGLE_BRACKETS), std::regex_constants::ECMAScript);
-            const regex_t inc_regex_no_quotes(ANY_STRING(T, SUPDEF_PRAGMA_IMPORT_REGEX_NO_QUOTES), std::regex_constants::ECMAScript);
-            // This is invalid and must be reported as a syntax error
-            const regex_t inc_regex_no_path(ANY_STRING(T, SUPDEF_PRAGMA_IMPORT_REGEX_NO_PATH), std::regex_constants::ECMAScript);
-            // Invalid too
-            const regex_t inc_regex_with_anything(ANY_STRING(T, "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_IMPORT ".*$"), std::regex_constants::ECMAScript);
-            match_res_t match_res;
-            if (std::regex_match(line, match_res, inc_regex))
+            const std::basic_string_view<T> line = this->file_content.view().substr(span.offset, span.size);
+            auto char_at = [this, &span](pos_t where) -> ParsedChar<T> {
+                return this->file_content.at(span.offset + where);
+            };
+            curr_line = char_at(0).line() + 1;
+            // Same as matching, in order, `SUPDEF_PRAGMA_IMPORT_REGEX`, `SUPDEF_PRAGMA_IMPORT_REGEX_ANGLE_BRACKETS`,
+            // `SUPDEF_PRAGMA_IMPORT_REGEX_NO_QUOTES`, `SUPDEF_PRAGMA_IMPORT_REGEX_NO_PATH` (invalid) and
+            // `SUPDEF_PRAGMA_IMPORT_REGEX_WITH_ANYTHING` (invalid too)
+            const PragmaToken<T> token = this->lex_pragma_line(span, line);
+            if (token.kind == PragmaKind::IMPORT)
             {
                 pos_t l_bracket_pos = line.find(CONVERT(T, '<'));
                 pos_t r_bracket_pos = line.find(CONVERT(T, '>'));
                 if (l_bracket_pos != std::basic_string<T>::npos || r_bracket_pos != std::basic_string<T>::npos)
                 {
                     auto where = (l_bracket_pos != std::basic_string<T>::npos) ? l_bracket_pos : r_bracket_pos;
-                    pos_t err_line = line_.at(where).line();
-                    pos_t err_col = line_.at(where).col();
-                    auto real_line = this->lines_raw.at(err_line);
+                    pos_t err_line = char_at(where).line();
+                    pos_t err_col = char_at(where).col();
+                    auto real_line = this->get_raw_line(err_line);
                     ret = mk_unexpected_ret(Error<T, std::filesystem::path>(
                         ExcType::SYNTAX_ERROR,
                         "You cannot mix `<>` with `\"\"` in import pragmas",
@@ -496,16 +1367,16 @@ namespace SupDef
                     continue;
                 }
 #if SUPDEF_DEBUG
-                std::string converted = std::string(match_res[1].first, match_res[1].second);
+                std::string converted = std::string(token.arg(line).begin(), token.arg(line).end());
                 std::cerr << "[ DEBUG LOG ]  Found import: " << converted.c_str() << std::endl;
 #endif
-                std::basic_string<T> inc_path = remove_whitespaces(match_res[1].str());
+                std::basic_string<T> inc_path = remove_whitespaces(std::basic_string<T>(token.arg(line)));
                 if (inc_path.empty())
                 {
                     auto where = line.find(CONVERT(T, '"'));
-                    pos_t err_line = line_.at(where).line();
-                    pos_t err_col = line_.at(where).col();
-                    auto real_line = this->lines_raw.at(err_line);
+                    pos_t err_line = char_at(where).line();
+                    pos_t err_col = char_at(where).col();
+                    auto real_line = this->get_raw_line(err_line);
                     ret = mk_unexpected_ret(Error<T, std::filesystem::path>(
                         ExcType::SYNTAX_ERROR,
                         "Empty import path",
@@ -518,21 +1389,20 @@ namespace SupDef
                     continue;
                 }
                 ret = mk_expected_ret(inc_path, curr_line);
-                // Delete the full line from this->lines (since the pragma is supposed to take the full line)
-                /* this->lines_raw.erase(this->lines_raw.begin() + i); */
-                this->lines.erase(this->lines.begin() + i);
-                i--;
+                Parser<T>::record_pragma(this->imports, mk_valid_pragmaloc(inc_path, curr_line));
+                // Remove the full line (since the pragma is supposed to take the full line)
+                this->remove_line(i);
                 co_yield ret;
                 continue;
             }
-            else if (std::regex_match(line, match_res, inc_regex_angle_brackets))
+            else if (token.kind == PragmaKind::IMPORT_ANGLE_BRACKETS)
             {
                 pos_t quote_pos = line.find(CONVERT(T, '"'));
                 if (quote_pos != std::basic_string<T>::npos)
                 {
-                    pos_t err_line = line_.at(quote_pos).line();
-                    pos_t err_col = line_.at(quote_pos).col();
-                    auto real_line = this->lines_raw.at(err_line);
+                    pos_t err_line = char_at(quote_pos).line();
+                    pos_t err_col = char_at(quote_pos).col();
+                    auto real_line = this->get_raw_line(err_line);
                     ret = mk_unexpected_ret(Error<T, std::filesystem::path>(
                         ExcType::SYNTAX_ERROR,
                         "You cannot mix `\"\"` with `<>` in import pragmas",
@@ -545,16 +1415,17 @@ namespace SupDef
                     continue;
                 }
 #if SUPDEF_DEBUG
-                std::string converted = std::string(match_res[1].first, match_res[1].second);
+                std::string converted = std::string(token.arg(line).begin(), token.arg(line).end());
                 std::cerr << "[ DEBUG LOG ]  Found import: " << converted.c_str() << std::endl;
 #endif
-                std::basic_string<T> inc_path = remove_whitespaces(match_res[1].str());
+                std::basic_string<T> inc_path = remove_whitespaces(std::basic_string<T>(token.arg(line)));
                 if (inc_path.empty())
                 {
-                    auto where = line.find(CONVERT(T, '"'));
-                    pos_t err_line = line_.at(where).line();
-                    pos_t err_col = line_.at(where).col();
-                    auto real_line = this->lines_raw.at(err_line);
+                    // There is no `"` in the line at this point, so report the error on the `<`
+                    auto where = token.arg_pos - 1;
+                    pos_t err_line = char_at(where).line();
+                    pos_t err_col = char_at(where).col();
+                    auto real_line = this->get_raw_line(err_line);
                     ret = mk_unexpected_ret(Error<T, std::filesystem::path>(
                         ExcType::SYNTAX_ERROR,
                         "Empty import path",
@@ -567,14 +1438,13 @@ namespace SupDef
                     continue;
                 }
                 ret = mk_expected_ret(inc_path, curr_line);
-                // Delete the full line from this->lines (since the pragma is supposed to take the full line)
-                /* this->lines_raw.erase(this->lines_raw.begin() + i); */
-                this->lines.erase(this->lines.begin() + i);
-                i--;
+                Parser<T>::record_pragma(this->imports, mk_valid_pragmaloc(inc_path, curr_line));
+                // Remove the full line (since the pragma is supposed to take the full line)
+                this->remove_line(i);
                 co_yield ret;
                 continue;
             }
-            else if (std::regex_match(line, match_res, inc_regex_no_quotes))
+            else if (token.kind == PragmaKind::IMPORT_NO_QUOTES)
             {
                 // Error if there are some `<>"` in the line
                 if (line.find(CONVERT(T, '"')) != std::basic_string<T>::npos ||
@@ -584,9 +1454,9 @@ namespace SupDef
                     auto where = (line.find(CONVERT(T, '"')) != std::basic_string<T>::npos) ? line.find(CONVERT(T, '"')) :
                                  (line.find(CONVERT(T, '<')) != std::basic_string<T>::npos) ? line.find(CONVERT(T, '<')) :
                                  line.find(CONVERT(T, '>'));
-                    pos_t err_line = line_.at(where).line();
-                    pos_t err_col = line_.at(where).col();
-                    auto real_line = this->lines_raw.at(err_line);
+                    pos_t err_line = char_at(where).line();
+                    pos_t err_col = char_at(where).col();
+                    auto real_line = this->get_raw_line(err_line);
                     ret = mk_unexpected_ret(Error<T, std::filesystem::path>(
                         ExcType::SYNTAX_ERROR,
                         "Invalid import path",
@@ -599,28 +1469,25 @@ namespace SupDef
                     continue;
                 }
 #if SUPDEF_DEBUG
-                std::string converted = std::string(match_res[1].first, match_res[1].second);
+                std::string converted = std::string(token.arg(line).begin(), token.arg(line).end());
                 std::cerr << "[ DEBUG LOG ]  Found import: " << converted.c_str() << std::endl;
 #endif
-                std::basic_string<T> inc_path = remove_whitespaces(match_res[1].str());
+                std::basic_string<T> inc_path = remove_whitespaces(std::basic_string<T>(token.arg(line)));
                 if (inc_path.empty())
                     SupDef::Util::unreachable();
                 ret = mk_expected_ret(inc_path, curr_line);
-                // Delete the full line from this->lines (since the pragma is supposed to take the full line)
-                /* this->lines_raw.erase(this->lines_raw.begin() + i); */
-                this->lines.erase(this->lines.begin() + i);
-                i--;
+                Parser<T>::record_pragma(this->imports, mk_valid_pragmaloc(inc_path, curr_line));
+                // Remove the full line (since the pragma is supposed to take the full line)
+                this->remove_line(i);
                 co_yield ret;
                 continue;
             }
-            else if (std::regex_match(line, match_res, inc_regex_no_path))
+            else if (token.kind == PragmaKind::IMPORT_NO_PATH)
             {
-                auto include_keyword_pos = line.find(ANY_STRING(T, SUPDEF_PRAGMA_IMPORT));
-                if (include_keyword_pos == std::basic_string<T>::npos)
-                    SupDef::Util::unreachable();
-                pos_t err_line = line_.at(include_keyword_pos).line();
-                pos_t err_col = line_.at(include_keyword_pos).col();
-                auto real_line = this->lines_raw.at(err_line);
+                auto include_keyword_pos = token.keyword_pos;
+                pos_t err_line = char_at(include_keyword_pos).line();
+                pos_t err_col = char_at(include_keyword_pos).col();
+                auto real_line = this->get_raw_line(err_line);
                 ret = mk_unexpected_ret(Error<T, std::filesystem::path>(
                     ExcType::SYNTAX_ERROR,
                     "Include pragmas must have a path",
@@ -632,14 +1499,12 @@ namespace SupDef
                 co_yield ret;
                 continue;
             }
-            else if (std::regex_match(line, match_res, inc_regex_with_anything))
+            else if (token.kind == PragmaKind::IMPORT_WITH_ANYTHING)
             {
-                auto include_keyword_pos = line.find(ANY_STRING(T, SUPDEF_PRAGMA_IMPORT));
-                if (include_keyword_pos == std::basic_string<T>::npos)
-                    SupDef::Util::unreachable();
-                pos_t err_line = line_.at(include_keyword_pos).line();
-                pos_t err_col = line_.at(include_keyword_pos).col();
-                auto real_line = this->lines_raw.at(err_line);
+                auto include_keyword_pos = token.keyword_pos;
+                pos_t err_line = char_at(include_keyword_pos).line();
+                pos_t err_col = char_at(include_keyword_pos).col();
+                auto real_line = this->get_raw_line(err_line);
                 ret = mk_unexpected_ret(Error<T, std::filesystem::path>(
                     ExcType::SYNTAX_ERROR,
                     "Include pragmas must have a path",
@@ -652,46 +1517,31 @@ namespace SupDef
                 continue;
             }
         }
-        /* this->file_content_raw = this->reassemble_lines(); */
-        // Do the same for this->file_content
-
-        this->file_content.clear();
-        for (size_t counter = 0; counter < this->lines.size(); ++counter)
-        {
-            auto& line = this->lines[counter];
-            for (auto& c : line)
-                this->file_content.push_back(c);
-            if (!this->file_content.empty())
-            {
-                for (auto& c : CONVERT(T, '\n'))
-                    this->file_content.push_back(MK_CHAR(std::get<0>(
-                        this->file_content.at(this->file_content.size() - 1)),
-                        std::get<1>(this->file_content.at(this->file_content.size() - 1)),
-                        c
-                    ));
-            }
-            else
-            {
-                for (auto& c : CONVERT(T, '\n'))
-                    this->file_content.push_back(MK_CHAR(0, 0, c));
-            }
-        }
+        // Rebuild this->file_content without the import lines
+        this->reassemble_lines();
+        if (first_line == 0 && end_line >= this->lines.size())
+            this->imports_searched = true;
         ret = mk_null_ret();
         co_return ret;
     }
 #endif
 
 #undef FILE_CONTENT
-#undef MK_CHAR
 
+    template <typename T>
+        requires CharacterType<T>
+    Coro<Result<typename Parser<T>::pragma_loc_type, Error<T, std::filesystem::path>>> Parser<T>::search_super_defines(void)
+    {
+        return this->search_super_defines_in(0, std::numeric_limits<location_type>::max());
+    }
+
+    // Search the lines [@p first_line, @p end_line) of this->lines for super defines
     // TODO: Verify that supdef name doesn't start with a number
     // TODO: Verify that the pragma end is the end of the previously started supdef
     template <typename T>
         requires CharacterType<T>
-    Coro<Result<typename Parser<T>::pragma_loc_type, Error<T, std::filesystem::path>>> Parser<T>::search_super_defines(void)
+    Coro<Result<typename Parser<T>::pragma_loc_type, Error<T, std::filesystem::path>>> Parser<T>::search_super_defines_in(location_type first_line, location_type end_line)
     {
-        typedef typename std::basic_regex<T> regex_t;
-        typedef std::match_results<typename std::basic_string<T>::const_iterator> match_res_t;
         typedef typename decltype(this->lines)::size_type line_num_t;
         typedef string_size_type<T> pos_t;
 
@@ -734,37 +1584,35 @@ namespace SupDef
         std::basic_string<T> pragma_content; // Pragma name will be prepended as the first line of the pragma content
         std::basic_string<T> supdef_name;
         bool in_supdef_body = false;
-        for (line_num_t i = 0; i < this->lines.size(); ++i)
+        for (line_num_t i = first_line; i < std::min<line_num_t>(end_line, this->lines.size()); ++i)
         {
-            const std::vector<ParsedChar<T>>& line_ = this->lines.at(i);
-            std::basic_string<T> line;
-            line.reserve(line_.size());
-            if (line_.empty())
+            const line_span span = this->lines.at(i);
+            if (span.removed || span.size == 0)
                 continue;
-            else
-                curr_line = std::get<0>(line_.at(0)) + 1;
-            for (auto& c : line_)
-                line += std::get<2>(c);
-            // With `SUPDEF_PRAGMA_DEF_BEG_REGEX` expanding to:
-            //    "^\\s*#\\s*pragma\\s+" "supdef" "\\s+" "begin" "\\s+(" "\\w+" ")\\s*$"
-            regex_t pragma_start_regex(ANY_STRING(T, SUPDEF_PRAGMA_DEF_BEG_REGEX), std::regex_constants::ECMAScript);
-            // With `SUPDEF_PRAGMA_DEF_END_REGEX` expanding to:
+            const std::basic_string_view<T> line = this->file_content.view().substr(span.offset, span.size);
+            auto char_at = [this, &span](pos_t where) -> ParsedChar<T> {
+                return this->file_content.at(span.offset + where);
+            };
+            curr_line = char_at(0).line() + 1;
+            // Same as matching `SUPDEF_PRAGMA_DEF_BEG_REGEX`, expanding to:
+            //    "^\\s*#\\s*pragma\\s+" "supdef" "\\s+" "begin" "\\s+(" "\\w+" "(?:\\s*\\(\\s*(?:" "\\w+" "(?:\\s*,\\s*" "\\w+" ")*)?\\s*\\))?)\\s*$"
+            // (or `SUPDEF_PRAGMA_RUNNABLE_DEF_BEG_REGEX`, with "runnable" "\\s+(C|CXX)\\s+" before "begin")
+            // and then `SUPDEF_PRAGMA_DEF_END_REGEX`, expanding to:
             //    "^\\s*#\\s*pragma\\s+" "supdef" "\\s+" "end" "\\s+(" "\\w+" ")\\s*$"
-            regex_t pragma_end_regex(ANY_STRING(T, SUPDEF_PRAGMA_DEF_END_REGEX), std::regex_constants::ECMAScript);
-            match_res_t match_res;
+            const PragmaToken<T> token = this->lex_pragma_line(span, line);
             try
             {
-                if (std::regex_match(line, match_res, pragma_start_regex))
+                if (token.kind == PragmaKind::DEF_BEGIN)
                 {
 #if 0
                     std::cout << "Matched line: " << CONVERT(char, line) << std::endl;
 #endif
                     if (in_supdef_body)
                     {
-                        string_size_type<T> begin_kwd_pos = line.find(ANY_STRING(T, SUPDEF_PRAGMA_DEFINE_BEGIN));
-                        auto err_line = line_.at(begin_kwd_pos).line();
-                        auto err_col = line_.at(begin_kwd_pos).col();
-                        auto real_line = this->lines_raw.at(err_line);
+                        string_size_type<T> begin_kwd_pos = token.keyword_pos;
+                        auto err_line = char_at(begin_kwd_pos).line();
+                        auto err_col = char_at(begin_kwd_pos).col();
+                        auto real_line = this->get_raw_line(err_line);
                         ret = mk_unexpected_ret(Error<T, std::filesystem::path>(
                             ExcType::SYNTAX_ERROR,
                             "Pragma start found while already in a supdef block",
@@ -779,38 +1627,31 @@ namespace SupDef
                     }
                     pragma_start_pos = curr_line;
                     in_supdef_body = true;
-                    supdef_name = remove_whitespaces(match_res[1].str(), true);
+                    // The argument is the name, possibly followed by its parameters as in `NAME(a, b)`
+                    const std::basic_string_view<T> def_arg = token.arg(line);
+                    const auto params_start = std::find_if(def_arg.begin(), def_arg.end(), [](const T& c) { return SAME(c, '('); });
+                    supdef_name = remove_whitespaces(std::basic_string<T>(def_arg.begin(), params_start), true);
                     pragma_content.clear();
                     pragma_content += supdef_name;
+                    pragma_content.append(params_start, def_arg.end());
+                    // And then, for a runnable super define, by the language of its body
+                    if (token.lang_len != 0)
+                    {
+                        pragma_content += CONVERT(T, ' ');
+                        pragma_content += token.lang(line);
+                    }
                     pragma_content += CONVERT(T, '\n');
-                    // Remove the line from this->lines
-                    this->lines.erase(this->lines.begin() + i);
-                    /* this->lines_raw.erase(this->lines_raw.begin() + i); */
-                    i--;
+                    // Remove the line
+                    this->remove_line(i);
                 }
-                else if (std::regex_match(line, match_res, pragma_end_regex))
+                else if (token.kind == PragmaKind::DEF_END)
                 {
-                    if (match_res[0].first != line.begin())
-                    {
-                        auto err_line = line_.at(0).line();
-                        auto err_col = line_.at(0).col();
-                        auto real_line = this->lines_raw.at(err_line);
-                        ret = mk_unexpected_ret(Error<T, std::filesystem::path>(
-                            ExcType::SYNTAX_ERROR,
-                            "Pragma end found not at start of line",
-                            this->file_path,
-                            err_line + 1,
-                            err_col + 1,
-                            real_line
-                        ));
-                        co_return ret;
-                    }
                     if (!in_supdef_body)
                     {
-                        string_size_type<T> end_kwd_pos = line.find(ANY_STRING(T, SUPDEF_PRAGMA_DEFINE_END));
-                        auto err_line = line_.at(end_kwd_pos).line();
-                        auto err_col = line_.at(end_kwd_pos).col();
-                        auto real_line = this->lines_raw.at(err_line);
+                        string_size_type<T> end_kwd_pos = token.keyword_pos;
+                        auto err_line = char_at(end_kwd_pos).line();
+                        auto err_col = char_at(end_kwd_pos).col();
+                        auto real_line = this->get_raw_line(err_line);
                         ret = mk_unexpected_ret(Error<T, std::filesystem::path>(
                             ExcType::SYNTAX_ERROR,
                             "Pragma end found while not in a supdef block",
@@ -821,27 +1662,16 @@ namespace SupDef
                         ));
                         co_return ret; // (same comment as above)
                     }
-                    if (remove_whitespaces(match_res[1].str(), true) != supdef_name)
+                    if (remove_whitespaces(std::basic_string<T>(token.arg(line)), true) != supdef_name)
                     {
-                        // Find position of `remove_whitespaces(match_res[1].str(), true)`, after the `end` keyword
-                        string_size_type<T> supdef_name_pos = line.rfind(remove_whitespaces(match_res[1].str(), true));
-                        auto err_line = line_.at(supdef_name_pos).line();
-                        auto err_col = line_.at(supdef_name_pos).col();
-                        auto real_line = this->lines_raw.at(err_line);
-                        auto get_first_line = [ ](const std::basic_string<T>& str) -> std::basic_string<T> {
-                            std::basic_string<T> res;
-                            res.reserve(str.size());
-                            for (auto& c : str)
-                            {
-                                if (SAME(c, '\n'))
-                                    break;
-                                res += c;
-                            }
-                            return res;
-                        };
+                        // Position of the supdef name, after the `end` keyword
+                        string_size_type<T> supdef_name_pos = token.arg_pos;
+                        auto err_line = char_at(supdef_name_pos).line();
+                        auto err_col = char_at(supdef_name_pos).col();
+                        auto real_line = this->get_raw_line(err_line);
                         ret = mk_unexpected_ret(Error<T, std::filesystem::path>(
                             ExcType::SYNTAX_ERROR,
-                            "Pragma end found with a different supdef name than the start (should be `"s + CONVERT(char, remove_whitespaces(get_first_line(pragma_content), true)) + "` instead)"s,
+                            "Pragma end found with a different supdef name than the start (should be `"s + CONVERT(char, supdef_name) + "` instead)"s,
                             this->file_path,
                             err_line + 1,
                             err_col + 1,
@@ -850,12 +1680,11 @@ namespace SupDef
                         co_return ret;
                     }
                     pragma_end_pos = curr_line;
-                    // Remove the line from this->lines
-                    this->lines.erase(this->lines.begin() + i);
-                    /* this->lines_raw.erase(this->lines_raw.begin() + i); */
-                    i--;
+                    // Remove the line
+                    this->remove_line(i);
                     // Add pragma start and end to location vector
                     ret = mk_expected_ret(pragma_content, pragma_start_pos, pragma_end_pos);
+                    Parser<T>::record_pragma(this->super_defines, mk_valid_pragmaloc(pragma_content, pragma_start_pos, pragma_end_pos));
                     co_yield ret;
                     in_supdef_body = false;
                 }
@@ -863,10 +1692,8 @@ namespace SupDef
                 {
                     pragma_content += line;
                     pragma_content += CONVERT(T, '\n');
-                    // Remove the line from this->lines
-                    this->lines.erase(this->lines.begin() + i);
-                    /* this->lines_raw.erase(this->lines_raw.begin() + i); */
-                    i--;
+                    // Remove the line
+                    this->remove_line(i);
                 }
             }
             catch (const std::exception& e)
@@ -885,37 +1712,14 @@ namespace SupDef
                 );
             }
         }
-#ifdef MK_CHAR
-    #undef MK_CHAR
-#endif
-#define MK_CHAR(ORIGINAL_LINE, ORIGINAL_COL, CHAR) ParsedChar<T>(std::forward<string_size_type<T>>(ORIGINAL_LINE), std::forward<string_size_type<T>>(ORIGINAL_COL), std::forward<T>(CHAR))
-
-        /* this->file_content_raw = this->reassemble_lines(); */
-        // Do the same for this->file_content
-
-        this->file_content.clear();
-        for (size_t counter = 0; counter < this->lines.size(); ++counter)
-        {
-            auto& line = this->lines[counter];
-            for (auto& c : line)
-                this->file_content.push_back(c);
-            if (!this->file_content.empty())
-            {
-                for (auto& c : CONVERT(T, '\n'))
-                    this->file_content.push_back(MK_CHAR(std::get<0>(
-                        this->file_content.at(this->file_content.size() - 1)),
-                        std::get<1>(this->file_content.at(this->file_content.size() - 1)),
-                        c
-                    ));
-            }
-            else
-            {
-                for (auto& c : CONVERT(T, '\n'))
-                    this->file_content.push_back(MK_CHAR(0, 0, c));
-            }
-        }
+        const bool reached_end = end_line >= this->lines.size();
+        // Rebuild this->file_content without the supdef blocks
+        this->reassemble_lines();
+        if (reached_end)
+            this->open_super_define = in_supdef_body ? pragma_start_pos : 0;
+        if (first_line == 0 && end_line >= this->lines.size())
+            this->super_defines_searched = true;
         ret = mk_null_ret();
-#undef MK_CHAR
         co_return ret;
     }
 
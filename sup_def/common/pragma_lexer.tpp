@@ -0,0 +1,444 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef INCLUDED_FROM_SUPDEF_SOURCE
+    #error "This file may only be included from a C++ SupDef source file, and may not be compiled directly."
+#endif
+
+#if !SUPDEF_PRAGMA_USE_REGEX
+// `PragmaLexer` is a compile-time translation of the `SUPDEF_PRAGMA_*_REGEX` regexes: make sure they still are
+// what it implements, so that changing one of them either fails here or requires `SUPDEF_PRAGMA_USE_REGEX`
+static_assert(
+    []() {
+        for (std::string_view kwd : { SUPDEF_PRAGMA_NAME, SUPDEF_PRAGMA_DEFINE_BEGIN, SUPDEF_PRAGMA_DEFINE_END, SUPDEF_PRAGMA_RUNNABLE, SUPDEF_PRAGMA_IMPORT, SUPDEF_PRAGMA_IF, SUPDEF_PRAGMA_ELSE })
+        {
+            const bool is_word = !kwd.empty() && std::ranges::all_of(kwd, [](char c) {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+            });
+            if (!is_word)
+                return false;
+        }
+        return true;
+    }(),
+    "`PragmaLexer` only knows how to match keywords made of `\\w` characters"
+);
+static_assert(
+    std::string_view(SUPDEF_MACRO_ID_REGEX) == "\\w+",
+    "`PragmaLexer` only knows how to match super define names of the form `\\w+`"
+);
+static_assert(
+    std::string_view(SUPDEF_PRAGMA_DEF_BEG_REGEX) == "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_DEFINE_BEGIN "\\s+(\\w+(?:\\s*\\(\\s*(?:\\w+(?:\\s*,\\s*\\w+)*)?\\s*\\))?)\\s*$" &&
+    std::string_view(SUPDEF_PRAGMA_DEF_END_REGEX) == "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_DEFINE_END "\\s+(\\w+)\\s*$" &&
+    std::string_view(SUPDEF_PRAGMA_RUNNABLE_DEF_BEG_REGEX) == "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_RUNNABLE "\\s+(C|CXX)\\s+" SUPDEF_PRAGMA_DEFINE_BEGIN "\\s+(\\w+(?:\\s*\\(\\s*(?:\\w+(?:\\s*,\\s*\\w+)*)?\\s*\\))?)\\s*$",
+    "`SUPDEF_PRAGMA_DEF_*_REGEX` differ from what `PragmaLexer` implements, define `SUPDEF_PRAGMA_USE_REGEX` to 1"
+);
+static_assert(
+    std::string_view(SUPDEF_PRAGMA_IMPORT_REGEX) == "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_IMPORT "\\s+[<>]*\"([^\"]*)\"[<>]*\\s*$" &&
+    std::string_view(SUPDEF_PRAGMA_IMPORT_REGEX_ANGLE_BRACKETS) == "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_IMPORT "\\s+[\"]*<([^>]*)>[\"]*\\s*$" &&
+    std::string_view(SUPDEF_PRAGMA_IMPORT_REGEX_NO_QUOTES) == "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_IMPORT "\\s+([^\\s]+)\\s*$" &&
+    std::string_view(SUPDEF_PRAGMA_IMPORT_REGEX_NO_PATH) == "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_IMPORT "\\s+([^\\s]*)\\s*$" &&
+    std::string_view(SUPDEF_PRAGMA_IMPORT_REGEX_WITH_ANYTHING) == "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_IMPORT ".*$",
+    "`SUPDEF_PRAGMA_IMPORT_REGEX*` differ from what `PragmaLexer` implements, define `SUPDEF_PRAGMA_USE_REGEX` to 1"
+);
+static_assert(
+    std::string_view(SUPDEF_PRAGMA_IF_REGEX) == "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_IF "\\s+(.*[^\\s])\\s*$" &&
+    std::string_view(SUPDEF_PRAGMA_ELSE_REGEX) == "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_ELSE "\\s*$" &&
+    std::string_view(SUPDEF_PRAGMA_IF_END_REGEX) == "^\\s*#\\s*pragma\\s+" SUPDEF_PRAGMA_NAME "\\s+" SUPDEF_PRAGMA_DEFINE_END "\\s*$",
+    "`SUPDEF_PRAGMA_IF*_REGEX` and `SUPDEF_PRAGMA_ELSE_REGEX` differ from what `PragmaLexer` implements, define `SUPDEF_PRAGMA_USE_REGEX` to 1"
+);
+#endif
+
+template <typename T>
+    requires CharacterType<T>
+constexpr inline uint8_t PragmaLexer<T>::classify(T c) noexcept
+{
+    using unsigned_type = std::make_unsigned_t<T>;
+    const auto code_unit = static_cast<unsigned_type>(c);
+    if (code_unit < PragmaLexer<T>::char_classes.size())
+        return PragmaLexer<T>::char_classes[code_unit];
+    // U+2028 and U+2029 are line terminators too for ECMAScript regexes (when they fit in a code unit)
+    if constexpr (sizeof(T) > 1)
+    {
+        if (code_unit == 0x2028 || code_unit == 0x2029)
+            return LINE_TERM;
+    }
+    return OTHER;
+}
+
+template <typename T>
+    requires CharacterType<T>
+constexpr inline bool PragmaLexer<T>::is(T c, char ascii) noexcept
+{
+    return static_cast<std::make_unsigned_t<T>>(c) == static_cast<unsigned char>(ascii);
+}
+
+template <typename T>
+    requires CharacterType<T>
+constexpr inline typename PragmaLexer<T>::size_type PragmaLexer<T>::skip_class(string_view_type line, size_type pos, uint8_t cls) noexcept
+{
+    while (pos < line.size() && (PragmaLexer<T>::classify(line[pos]) & cls))
+        ++pos;
+    return pos;
+}
+
+template <typename T>
+    requires CharacterType<T>
+constexpr inline typename PragmaLexer<T>::size_type PragmaLexer<T>::skip_not_class(string_view_type line, size_type pos, uint8_t cls) noexcept
+{
+    while (pos < line.size() && !(PragmaLexer<T>::classify(line[pos]) & cls))
+        ++pos;
+    return pos;
+}
+
+template <typename T>
+    requires CharacterType<T>
+constexpr inline typename PragmaLexer<T>::size_type PragmaLexer<T>::skip_chars(string_view_type line, size_type pos, std::string_view ascii_set) noexcept
+{
+    while (pos < line.size() && std::ranges::any_of(ascii_set, [&](char c) { return PragmaLexer<T>::is(line[pos], c); }))
+        ++pos;
+    return pos;
+}
+
+template <typename T>
+    requires CharacterType<T>
+constexpr inline typename PragmaLexer<T>::size_type PragmaLexer<T>::find_char(string_view_type line, size_type pos, char ascii) noexcept
+{
+    while (pos < line.size() && !PragmaLexer<T>::is(line[pos], ascii))
+        ++pos;
+    return pos;
+}
+
+template <typename T>
+    requires CharacterType<T>
+constexpr inline bool PragmaLexer<T>::match_keyword(string_view_type line, size_type pos, std::string_view kwd) noexcept
+{
+    if (line.size() - pos < kwd.size())
+        return false;
+    for (size_type i = 0; i < kwd.size(); ++i)
+    {
+        if (!PragmaLexer<T>::is(line[pos + i], kwd[i]))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Lex the part of a line following a `begin` or `end` keyword
+ * @details Matches `\s+(\w+)\s*$`, or for `begin`, `\s+(\w+(?:\s*\(\s*(?:\w+(?:\s*,\s*\w+)*)?\s*\))?)\s*$`
+ * (i.e. the name may be followed by its parameters, which are then part of the argument)
+ */
+template <typename T>
+    requires CharacterType<T>
+typename PragmaLexer<T>::token_type PragmaLexer<T>::lex_def(string_view_type line, size_type kwd_pos, size_type kwd_len, PragmaKind kind) noexcept
+{
+    const size_type after_kwd = kwd_pos + kwd_len;
+    const size_type name_start = PragmaLexer<T>::skip_class(line, after_kwd, SPACE);
+    if (name_start == after_kwd)
+        return token_type{};
+    size_type name_end = PragmaLexer<T>::skip_class(line, name_start, WORD);
+    if (name_end == name_start)
+        return token_type{};
+    size_type pos = PragmaLexer<T>::skip_class(line, name_end, SPACE);
+    if (kind == PragmaKind::DEF_BEGIN && pos < line.size() && PragmaLexer<T>::is(line[pos], '('))
+    {
+        pos = PragmaLexer<T>::skip_class(line, pos + 1, SPACE);
+        // Either `)` right away, or `\w+` separated by `,` then `)`
+        if (pos < line.size() && !PragmaLexer<T>::is(line[pos], ')'))
+        {
+            while (true)
+            {
+                const size_type param_end = PragmaLexer<T>::skip_class(line, pos, WORD);
+                if (param_end == pos)
+                    return token_type{};
+                pos = PragmaLexer<T>::skip_class(line, param_end, SPACE);
+                if (pos < line.size() && PragmaLexer<T>::is(line[pos], ','))
+                    pos = PragmaLexer<T>::skip_class(line, pos + 1, SPACE);
+                else
+                    break;
+            }
+        }
+        if (pos >= line.size() || !PragmaLexer<T>::is(line[pos], ')'))
+            return token_type{};
+        name_end = pos + 1;
+        pos = PragmaLexer<T>::skip_class(line, name_end, SPACE);
+    }
+    if (pos != line.size())
+        return token_type{};
+    return token_type{ kind, kwd_pos, name_start, name_end - name_start };
+}
+
+/**
+ * @brief Lex the part of a line following a `runnable` keyword
+ * @details Matches `\s+(C|CXX)\s+begin`, then the same as @fn lex_def after `begin` (the argument being the name and
+ * the parameters, and the keyword the `runnable` one)
+ */
+template <typename T>
+    requires CharacterType<T>
+typename PragmaLexer<T>::token_type PragmaLexer<T>::lex_runnable(string_view_type line, size_type kwd_pos) noexcept
+{
+    const size_type after_kwd = kwd_pos + std::string_view(SUPDEF_PRAGMA_RUNNABLE).size();
+    const size_type lang_start = PragmaLexer<T>::skip_class(line, after_kwd, SPACE);
+    if (lang_start == after_kwd)
+        return token_type{};
+    // `(C|CXX)\s+` can only match a whole word
+    const size_type lang_end = PragmaLexer<T>::skip_class(line, lang_start, WORD);
+    const std::string_view lang = lang_end - lang_start == 1 ? "C" : "CXX";
+    if (lang_end - lang_start != lang.size() || !PragmaLexer<T>::match_keyword(line, lang_start, lang))
+        return token_type{};
+    const size_type begin_pos = PragmaLexer<T>::skip_class(line, lang_end, SPACE);
+    const std::string_view begin_kwd = SUPDEF_PRAGMA_DEFINE_BEGIN;
+    if (begin_pos == lang_end || !PragmaLexer<T>::match_keyword(line, begin_pos, begin_kwd))
+        return token_type{};
+    token_type res = PragmaLexer<T>::lex_def(line, begin_pos, begin_kwd.size(), PragmaKind::DEF_BEGIN);
+    if (!res)
+        return token_type{};
+    res.keyword_pos = kwd_pos;
+    res.lang_pos = lang_start;
+    res.lang_len = lang_end - lang_start;
+    return res;
+}
+
+/**
+ * @brief Lex the part of a line following an `if`, `else` or `end` keyword (the latter once @fn lex_def rejected it)
+ * @details Matches `\s+(.*[^\s])\s*$` for `if`, and `\s*$` otherwise
+ */
+template <typename T>
+    requires CharacterType<T>
+typename PragmaLexer<T>::token_type PragmaLexer<T>::lex_cond(string_view_type line, size_type kwd_pos, size_type kwd_len, PragmaKind kind) noexcept
+{
+    const size_type after_kwd = kwd_pos + kwd_len;
+    const size_type arg_start = PragmaLexer<T>::skip_class(line, after_kwd, SPACE);
+    if (kind != PragmaKind::IF)
+        return arg_start == line.size() ? token_type{ kind, kwd_pos, 0, 0 } : token_type{};
+    if (arg_start == after_kwd || arg_start == line.size())
+        return token_type{};
+    size_type arg_end = line.size();
+    while (PragmaLexer<T>::classify(line[arg_end - 1]) & SPACE)
+        --arg_end;
+    // `.` matches anything but a line terminator, unlike the `[^\s]` matching the last code unit
+    if (PragmaLexer<T>::skip_not_class(line, arg_start, LINE_TERM) < arg_end - 1)
+        return token_type{};
+    return token_type{ kind, kwd_pos, arg_start, arg_end - arg_start };
+}
+
+/**
+ * @brief Lex the part of a line following an `import` keyword
+ * @details Tries each import regex in the same order as @fn Parser<T>::search_imports used to, i.e.
+ * `IMPORT`, `IMPORT_ANGLE_BRACKETS`, `IMPORT_NO_QUOTES`, `IMPORT_NO_PATH` and finally `IMPORT_WITH_ANYTHING`.
+ * None of them need any backtracking, since every quantified class is disjoint from what follows it.
+ */
+template <typename T>
+    requires CharacterType<T>
+typename PragmaLexer<T>::token_type PragmaLexer<T>::lex_import(string_view_type line, size_type kwd_pos) noexcept
+{
+    const size_type after_kwd = kwd_pos + std::string_view(SUPDEF_PRAGMA_IMPORT).size();
+    const size_type path_start = PragmaLexer<T>::skip_class(line, after_kwd, SPACE);
+
+    if (path_start != after_kwd)
+    {
+        // `[<>]*"([^"]*)"[<>]*\s*$`
+        {
+            size_type pos = PragmaLexer<T>::skip_chars(line, path_start, "<>");
+            if (pos < line.size() && PragmaLexer<T>::is(line[pos], '"'))
+            {
+                const size_type arg_start = pos + 1;
+                const size_type arg_end = PragmaLexer<T>::find_char(line, arg_start, '"');
+                if (arg_end < line.size())
+                {
+                    pos = PragmaLexer<T>::skip_chars(line, arg_end + 1, "<>");
+                    if (PragmaLexer<T>::skip_class(line, pos, SPACE) == line.size())
+                        return token_type{ PragmaKind::IMPORT, kwd_pos, arg_start, arg_end - arg_start };
+                }
+            }
+        }
+        // `["]*<([^>]*)>["]*\s*$`
+        {
+            size_type pos = PragmaLexer<T>::skip_chars(line, path_start, "\"");
+            if (pos < line.size() && PragmaLexer<T>::is(line[pos], '<'))
+            {
+                const size_type arg_start = pos + 1;
+                const size_type arg_end = PragmaLexer<T>::find_char(line, arg_start, '>');
+                if (arg_end < line.size())
+                {
+                    pos = PragmaLexer<T>::skip_chars(line, arg_end + 1, "\"");
+                    if (PragmaLexer<T>::skip_class(line, pos, SPACE) == line.size())
+                        return token_type{ PragmaKind::IMPORT_ANGLE_BRACKETS, kwd_pos, arg_start, arg_end - arg_start };
+                }
+            }
+        }
+        // `([^\s]+)\s*$`
+        const size_type path_end = PragmaLexer<T>::skip_not_class(line, path_start, SPACE);
+        if (path_end != path_start && PragmaLexer<T>::skip_class(line, path_end, SPACE) == line.size())
+            return token_type{ PragmaKind::IMPORT_NO_QUOTES, kwd_pos, path_start, path_end - path_start };
+        // `([^\s]*)\s*$`, which can only match an empty path at this point
+        if (path_start == line.size())
+            return token_type{ PragmaKind::IMPORT_NO_PATH, kwd_pos, path_start, 0 };
+    }
+    // `.*$`
+    if (PragmaLexer<T>::skip_not_class(line, after_kwd, LINE_TERM) == line.size())
+        return token_type{ PragmaKind::IMPORT_WITH_ANYTHING, kwd_pos, after_kwd, line.size() - after_kwd };
+    return token_type{};
+}
+
+/**
+ * @brief Lex one line (without its trailing newline)
+ * @details Matches the common `^\s*#\s*pragma\s+supdef\s+` prefix of all SupDef pragmas, then dispatches
+ * on the keyword following it. Most lines are rejected on their first non-space character.
+ * 
+ * @param line The line to lex
+ * @return A @struct PragmaToken whose `kind` is `PragmaKind::NONE` if the line is not a SupDef pragma
+ */
+template <typename T>
+    requires CharacterType<T>
+typename PragmaLexer<T>::token_type PragmaLexer<T>::lex_line(string_view_type line) noexcept
+{
+    size_type pos = PragmaLexer<T>::skip_class(line, 0, SPACE);
+    if (pos == line.size() || !PragmaLexer<T>::is(line[pos], '#'))
+        return token_type{};
+    pos = PragmaLexer<T>::skip_class(line, pos + 1, SPACE);
+
+    auto expect_keyword = [&line, &pos](std::string_view kwd) -> bool
+    {
+        if (!PragmaLexer<T>::match_keyword(line, pos, kwd))
+            return false;
+        const size_type after_kwd = pos + kwd.size();
+        pos = PragmaLexer<T>::skip_class(line, after_kwd, SPACE);
+        return pos != after_kwd;
+    };
+    if (!expect_keyword("pragma") || !expect_keyword(SUPDEF_PRAGMA_NAME))
+        return token_type{};
+
+    const std::string_view begin_kwd = SUPDEF_PRAGMA_DEFINE_BEGIN;
+    const std::string_view end_kwd = SUPDEF_PRAGMA_DEFINE_END;
+    const std::string_view runnable_kwd = SUPDEF_PRAGMA_RUNNABLE;
+    const std::string_view import_kwd = SUPDEF_PRAGMA_IMPORT;
+    const std::string_view if_kwd = SUPDEF_PRAGMA_IF;
+    const std::string_view else_kwd = SUPDEF_PRAGMA_ELSE;
+    token_type res{};
+    if (PragmaLexer<T>::match_keyword(line, pos, begin_kwd))
+        res = PragmaLexer<T>::lex_def(line, pos, begin_kwd.size(), PragmaKind::DEF_BEGIN);
+    if (!res && PragmaLexer<T>::match_keyword(line, pos, runnable_kwd))
+        res = PragmaLexer<T>::lex_runnable(line, pos);
+    if (!res && PragmaLexer<T>::match_keyword(line, pos, end_kwd))
+        res = PragmaLexer<T>::lex_def(line, pos, end_kwd.size(), PragmaKind::DEF_END);
+    if (!res && PragmaLexer<T>::match_keyword(line, pos, end_kwd))
+        res = PragmaLexer<T>::lex_cond(line, pos, end_kwd.size(), PragmaKind::IF_END);
+    if (!res && PragmaLexer<T>::match_keyword(line, pos, import_kwd))
+        res = PragmaLexer<T>::lex_import(line, pos);
+    if (!res && PragmaLexer<T>::match_keyword(line, pos, if_kwd))
+        res = PragmaLexer<T>::lex_cond(line, pos, if_kwd.size(), PragmaKind::IF);
+    if (!res && PragmaLexer<T>::match_keyword(line, pos, else_kwd))
+        res = PragmaLexer<T>::lex_cond(line, pos, else_kwd.size(), PragmaKind::ELSE);
+    return res;
+}
+
+template <typename T>
+    requires CharacterType<T>
+PragmaGrammar<T>::PragmaGrammar()
+{
+    constexpr auto flags = std::regex_constants::ECMAScript | std::regex_constants::optimize;
+    auto add = [this, flags]<size_t K, size_t R>(PragmaKind kind, const char (&kwd)[K], const char (&re)[R], size_t arg_group = 1, size_t lang_group = 0)
+    {
+        this->rules.push_back(rule{ kind, ANY_STRING(regex_char_type, kwd), regex_type(ANY_STRING(regex_char_type, re), flags), arg_group, lang_group });
+    };
+    add(PragmaKind::DEF_BEGIN, SUPDEF_PRAGMA_DEFINE_BEGIN, SUPDEF_PRAGMA_DEF_BEG_REGEX);
+    add(PragmaKind::DEF_BEGIN, SUPDEF_PRAGMA_RUNNABLE, SUPDEF_PRAGMA_RUNNABLE_DEF_BEG_REGEX, 2, 1);
+    add(PragmaKind::DEF_END, SUPDEF_PRAGMA_DEFINE_END, SUPDEF_PRAGMA_DEF_END_REGEX);
+    add(PragmaKind::IMPORT, SUPDEF_PRAGMA_IMPORT, SUPDEF_PRAGMA_IMPORT_REGEX);
+    add(PragmaKind::IMPORT_ANGLE_BRACKETS, SUPDEF_PRAGMA_IMPORT, SUPDEF_PRAGMA_IMPORT_REGEX_ANGLE_BRACKETS);
+    add(PragmaKind::IMPORT_NO_QUOTES, SUPDEF_PRAGMA_IMPORT, SUPDEF_PRAGMA_IMPORT_REGEX_NO_QUOTES);
+    add(PragmaKind::IMPORT_NO_PATH, SUPDEF_PRAGMA_IMPORT, SUPDEF_PRAGMA_IMPORT_REGEX_NO_PATH);
+    add(PragmaKind::IMPORT_WITH_ANYTHING, SUPDEF_PRAGMA_IMPORT, SUPDEF_PRAGMA_IMPORT_REGEX_WITH_ANYTHING);
+    add(PragmaKind::IF, SUPDEF_PRAGMA_IF, SUPDEF_PRAGMA_IF_REGEX);
+    add(PragmaKind::ELSE, SUPDEF_PRAGMA_ELSE, SUPDEF_PRAGMA_ELSE_REGEX);
+    add(PragmaKind::IF_END, SUPDEF_PRAGMA_DEFINE_END, SUPDEF_PRAGMA_IF_END_REGEX);
+}
+
+/**
+ * @brief Get the instance for the character type @p T
+ * @details It is built (i.e. every regex is compiled) on first use only, in a thread-safe way.
+ * Matching against a `const std::basic_regex` is thread-safe too, so the instance can be used by any thread.
+ */
+template <typename T>
+    requires CharacterType<T>
+const PragmaGrammar<T>& PragmaGrammar<T>::get()
+{
+    static const PragmaGrammar<T> instance;
+    return instance;
+}
+
+/**
+ * @brief Lex a line by matching it against each regex, in the same order as @fn PragmaLexer<T>::lex_line
+ * @details `keyword_pos` is the position of the first occurrence of the keyword in the line, as regexes do not
+ * give it (and 0 if the keyword does not appear literally in the line).
+ * Lines of a character type without `std::regex_traits` are widened one code unit at a time (so that positions
+ * stay the same), code units which do not fit in a `wchar_t` becoming U+FFFD.
+ * 
+ * @param line The line to lex
+ * @return A @struct PragmaToken whose `kind` is `PragmaKind::NONE` if the line is not a SupDef pragma
+ */
+template <typename T>
+    requires CharacterType<T>
+typename PragmaGrammar<T>::token_type PragmaGrammar<T>::lex_line(string_view_type line) const
+{
+    std::basic_string<regex_char_type> widened;
+    std::basic_string_view<regex_char_type> regex_line;
+    if constexpr (std::is_same_v<T, regex_char_type>)
+        regex_line = line;
+    else
+    {
+        using unsigned_type = std::make_unsigned_t<T>;
+        widened.resize(line.size());
+        std::ranges::transform(line, widened.begin(), [](T c) -> regex_char_type {
+            const auto code_unit = static_cast<unsigned_type>(c);
+            if (code_unit > std::numeric_limits<std::make_unsigned_t<regex_char_type>>::max())
+                return static_cast<regex_char_type>(0xFFFD);
+            return static_cast<regex_char_type>(code_unit);
+        });
+        regex_line = widened;
+    }
+
+    std::match_results<typename std::basic_string_view<regex_char_type>::const_iterator> match_res;
+    for (auto&& rule : this->rules)
+    {
+        if (!std::regex_match(regex_line.begin(), regex_line.end(), match_res, rule.regex))
+            continue;
+        token_type res{};
+        res.kind = rule.kind;
+        const auto kwd_pos = regex_line.find(rule.keyword);
+        res.keyword_pos = kwd_pos == regex_line.npos ? 0 : kwd_pos;
+        if (match_res.size() > rule.arg_group && match_res[rule.arg_group].matched)
+        {
+            res.arg_pos = match_res.position(rule.arg_group);
+            res.arg_len = match_res.length(rule.arg_group);
+        }
+        if (rule.lang_group != 0 && match_res[rule.lang_group].matched)
+        {
+            res.lang_pos = match_res.position(rule.lang_group);
+            res.lang_len = match_res.length(rule.lang_group);
+        }
+        return res;
+    }
+    return token_type{};
+}
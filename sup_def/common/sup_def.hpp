@@ -57,11 +57,13 @@ STATIC_TODO(
 #include <optional>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <filesystem>
 #include <concepts>
 #include <type_traits>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <array>
 #include <algorithm>
@@ -69,12 +71,31 @@ STATIC_TODO(
 #include <locale>
 #include <memory>
 #include <cstdlib>
+#include <cstring>
 #include <unordered_map>
 #include <map>
+#include <list>
+#include <deque>
+#include <shared_mutex>
+#include <memory_resource>
+#include <span>
 #include <variant>
 #include <regex>
+#include <limits>
+#include <future>
 #include <functional>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <version>
+
+#if SUPDEF_ON_UNIX
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <dlfcn.h>
+#endif
 #endif
 
 
@@ -533,6 +554,341 @@ namespace SupDef
             }
     };
 
+    /**
+     * @class ParsedText
+     * @brief A string of code units which remembers the original position (line and column) of each of them
+     * @details The code units are stored in one contiguous buffer, and their positions in a run-length table next to it:
+     * a run covers consecutive code units whose original columns follow each other on the same original line.
+     * An untouched file thus only needs one run per line, instead of one @class ParsedChar per code unit, and each
+     * edit made by the parser (comment stripping, pragma removal, ...) only adds a few runs.
+     * The buffer can also be borrowed (see @ref borrow_source, e.g. from a memory mapped file), in which case the code units
+     * are only copied on the first edit.
+     * @tparam T The character type of the text (char, wchar_t, char8_t, char16_t, char32_t)
+     */
+    template <typename T>
+        requires CharacterType<T>
+    class ParsedText
+    {
+        public:
+            typedef ParsedChar<T> value_type;
+            typedef string_size_type<T> size_type;
+            typedef std::basic_string<T> string_type;
+            typedef std::basic_string_view<T> string_view_type;
+
+            static constexpr size_type npos = string_type::npos;
+
+        private:
+            struct Run
+            {
+                size_type offset; // Offset of the first code unit of the run in `text`
+                size_type line;   // Original line of this first code unit
+                size_type col;    // Original column of this first code unit
+            };
+
+            string_type text;
+            // Code units borrowed from a buffer owned by someone else (when `borrowed` is true), until the first edit
+            string_view_type borrowed_text;
+            bool borrowed = false;
+            std::vector<Run> runs;
+
+            // Take a copy of the borrowed code units before editing them
+            inline void own()
+            {
+                if (!this->borrowed)
+                    return;
+                this->text.assign(this->borrowed_text.begin(), this->borrowed_text.end());
+                this->borrowed_text = string_view_type();
+                this->borrowed = false;
+            }
+
+            // Index of the run containing the code unit at `pos`
+            inline size_type run_index(size_type pos) const noexcept
+            {
+                auto it = std::upper_bound(
+                    this->runs.begin(), this->runs.end(), pos,
+                    [](size_type p, const Run& run) { return p < run.offset; }
+                );
+                return static_cast<size_type>(std::distance(this->runs.begin(), it)) - 1;
+            }
+
+            // Record that the next appended code unit comes from (`line`, `col`)
+            inline void mark_position(size_type line, size_type col)
+            {
+                if (!this->runs.empty())
+                {
+                    const Run& last = this->runs.back();
+                    if (last.line == line && last.col + (this->size() - last.offset) == col)
+                        return;
+                }
+                this->runs.push_back(Run{ this->size(), line, col });
+            }
+
+        public:
+            class const_iterator
+            {
+                private:
+                    const ParsedText* parent = nullptr;
+                    size_type pos = 0;
+                    size_type run = 0;
+
+                public:
+                    typedef std::input_iterator_tag iterator_category;
+                    typedef ParsedChar<T> value_type;
+                    typedef std::ptrdiff_t difference_type;
+                    typedef ParsedChar<T> reference;
+                    typedef void pointer;
+
+                    const_iterator() = default;
+                    const_iterator(const ParsedText* parent, size_type pos) noexcept
+                        : parent(parent), pos(pos), run(pos < parent->size() ? parent->run_index(pos) : 0)
+                    { }
+
+                    inline reference operator*() const noexcept
+                    {
+                        const Run& r = this->parent->runs[this->run];
+                        return ParsedChar<T>(r.line, r.col + (this->pos - r.offset), (*this->parent)[this->pos]);
+                    }
+
+                    inline const_iterator& operator++() noexcept
+                    {
+                        ++this->pos;
+                        if (this->run + 1 < this->parent->runs.size() && this->parent->runs[this->run + 1].offset == this->pos)
+                            ++this->run;
+                        return *this;
+                    }
+
+                    inline const_iterator operator++(int) noexcept
+                    {
+                        const_iterator tmp = *this;
+                        ++*this;
+                        return tmp;
+                    }
+
+                    inline bool operator==(const const_iterator& other) const noexcept
+                    {
+                        return this->pos == other.pos;
+                    }
+            };
+            typedef const_iterator iterator;
+
+            ParsedText() = default;
+            ParsedText(const ParsedText&) = default;
+            ParsedText(ParsedText&&) = default;
+            ParsedText& operator=(const ParsedText&) = default;
+            ParsedText& operator=(ParsedText&&) = default;
+            ~ParsedText() = default;
+
+            /**
+             * @brief Build a @class ParsedText from the raw content of a file, each code unit getting its own position in it
+             * @details A `\n` belongs to the line it ends, right after its last code unit
+             */
+            static ParsedText from_source(string_view_type source)
+            {
+                ParsedText res = borrow_source(source);
+                res.own();
+                return res;
+            }
+
+            /**
+             * @brief Same as @ref from_source, but without copying the code units of @p source until the text is edited
+             * @details @p source must outlive the returned @class ParsedText, as well as all its copies which are not edited
+             */
+            static ParsedText borrow_source(string_view_type source)
+            {
+                ParsedText res;
+                res.borrowed_text = source;
+                res.borrowed = true;
+                size_type line = 0;
+                size_type line_start = 0;
+                while (line_start < source.size())
+                {
+                    res.runs.push_back(Run{ line_start, line++, 0 });
+                    auto nl_pos = source.find(T('\n'), line_start);
+                    if (nl_pos == string_view_type::npos)
+                        break;
+                    line_start = nl_pos + 1;
+                }
+                return res;
+            }
+
+            inline size_type size() const noexcept { return this->view().size(); }
+            inline bool empty() const noexcept { return this->view().empty(); }
+            // Whether the code units are still borrowed, i.e. whether the text hasn't been copied
+            inline bool is_borrowed() const noexcept { return this->borrowed; }
+            // Number of runs in the position table
+            inline size_type run_count() const noexcept { return this->runs.size(); }
+
+            inline string_view_type view() const noexcept { return this->borrowed ? this->borrowed_text : string_view_type(this->text); }
+            inline string_type str() const { return string_type(this->view()); }
+
+            inline T operator[](size_type pos) const noexcept { return this->view()[pos]; }
+            inline T back() const noexcept { return this->view().back(); }
+
+            /**
+             * @brief Get the code unit at @p pos along with its original position
+             * @throws std::out_of_range If @p pos is out of range
+             */
+            inline ParsedChar<T> at(size_type pos) const
+            {
+                if (pos >= this->size())
+                    throw std::out_of_range("ParsedText::at: position out of range");
+                const Run& r = this->runs[this->run_index(pos)];
+                return ParsedChar<T>(r.line, r.col + (pos - r.offset), (*this)[pos]);
+            }
+
+            inline const_iterator begin() const noexcept { return const_iterator(this, 0); }
+            inline const_iterator end() const noexcept { return const_iterator(this, this->size()); }
+
+            inline void clear() noexcept
+            {
+                this->text.clear();
+                this->borrowed_text = string_view_type();
+                this->borrowed = false;
+                this->runs.clear();
+            }
+
+            inline void reserve(size_type n)
+            {
+                this->own();
+                this->text.reserve(n);
+            }
+
+            inline void push_back(T c, size_type line, size_type col)
+            {
+                this->own();
+                this->mark_position(line, col);
+                this->text.push_back(c);
+            }
+
+            inline void push_back(const ParsedChar<T>& c)
+            {
+                this->push_back(c.val(), c.line(), c.col());
+            }
+
+            inline void pop_back()
+            {
+                this->own();
+                this->text.pop_back();
+                if (!this->runs.empty() && this->runs.back().offset == this->text.size())
+                    this->runs.pop_back();
+            }
+
+            /**
+             * @brief Append @p count code units of @p other, starting at @p pos, keeping their original positions
+             */
+            void append(const ParsedText& other, size_type pos, size_type count = npos)
+            {
+                count = std::min(count, other.size() - pos);
+                if (count == 0)
+                    return;
+                this->own();
+                const size_type end_pos = pos + count;
+                for (size_type run = other.run_index(pos); run < other.runs.size() && other.runs[run].offset < end_pos; ++run)
+                {
+                    const Run& r = other.runs[run];
+                    const size_type seg_start = std::max(pos, r.offset);
+                    const size_type seg_end = (run + 1 < other.runs.size()) ? std::min(end_pos, other.runs[run + 1].offset) : end_pos;
+                    this->mark_position(r.line, r.col + (seg_start - r.offset));
+                    this->text.append(other.view().substr(seg_start, seg_end - seg_start));
+                }
+            }
+
+            /**
+             * @brief Append @p units, which follow each other on the original line @p line, starting at the original column @p col
+             */
+            void append(string_view_type units, size_type line, size_type col)
+            {
+                if (units.empty())
+                    return;
+                this->own();
+                this->mark_position(line, col);
+                this->text.append(units);
+            }
+
+            /**
+             * @brief Get the offset of the first code unit whose original position is (@p line, @p col) or a later one
+             * @details Original positions never go backwards in a text built by the parser, so this is a binary search
+             * @return The size of the text if there is no such code unit
+             */
+            size_type first_from(size_type line, size_type col) const noexcept
+            {
+                // First run whose last code unit comes from there or from later
+                auto it = std::partition_point(
+                    this->runs.begin(), this->runs.end(),
+                    [this, line, col](const Run& run) {
+                        const size_type next_offset = (&run + 1 != this->runs.data() + this->runs.size()) ? (&run + 1)->offset : this->size();
+                        return run.line < line || (run.line == line && run.col + (next_offset - run.offset) <= col);
+                    }
+                );
+                if (it == this->runs.end())
+                    return this->size();
+                return (it->line == line && it->col < col) ? it->offset + (col - it->col) : it->offset;
+            }
+
+            /**
+             * @brief Replace the @p count code units starting at @p pos with the ones of @p with (and their original positions),
+             * and move the original lines of the code units following them by @p line_delta
+             */
+            void splice(size_type pos, size_type count, const ParsedText& with, std::make_signed_t<size_type> line_delta)
+            {
+                count = std::min(count, this->size() - pos);
+                this->own();
+                std::vector<Run> spliced;
+                spliced.reserve(this->runs.size() + with.runs.size() + 1);
+                const size_type end_pos = pos + count;
+                size_type run = 0;
+                for (; run < this->runs.size() && this->runs[run].offset < pos; ++run)
+                    spliced.push_back(this->runs[run]);
+                for (const Run& r : with.runs)
+                    spliced.push_back(Run{ pos + r.offset, r.line, r.col });
+                if (end_pos < this->size())
+                {
+                    // The run containing the first code unit after the replaced ones now starts with it
+                    run = this->run_index(end_pos);
+                    const Run& first = this->runs[run];
+                    spliced.push_back(Run{ pos + with.size(), first.line + line_delta, first.col + (end_pos - first.offset) });
+                    for (++run; run < this->runs.size(); ++run)
+                    {
+                        const Run& r = this->runs[run];
+                        spliced.push_back(Run{ r.offset - count + with.size(), r.line + line_delta, r.col });
+                    }
+                }
+                this->text.replace(pos, count, with.view());
+                this->runs = std::move(spliced);
+            }
+
+            /**
+             * @brief Check that the position table covers the whole text
+             */
+            bool is_consistent() const noexcept
+            {
+                if (this->empty())
+                    return this->runs.empty();
+                if (this->runs.empty() || this->runs.front().offset != 0)
+                    return false;
+                for (size_type i = 1; i < this->runs.size(); ++i)
+                {
+                    if (this->runs[i].offset <= this->runs[i - 1].offset || this->runs[i].offset >= this->size())
+                        return false;
+                }
+                return true;
+            }
+
+            /**
+             * @brief Adapter for @class ParsedCharString consumers
+             * @return A @class ParsedCharString holding @p count code units starting at @p pos, with their original positions
+             */
+            ParsedCharString<T> parsed_substr(size_type pos = 0, size_type count = npos) const
+            {
+                count = std::min(count, this->size() - std::min(pos, this->size()));
+                ParsedCharString<T> res;
+                res.reserve(count);
+                for (auto it = const_iterator(this, pos); count > 0; ++it, --count)
+                    res.push_back(*it);
+                return res;
+            }
+    };
+
 #if defined(ESC)
     #undef ESC
 #endif
@@ -2384,6 +2740,192 @@ POP_MACRO(DECLARE_FRIENDS3)
 #define NEED_ThreadPool_TEMPLATES 1
 #include <sup_def/common/thread_pool.cpp>
 
+    /**
+     * @class Pipeline
+     * @brief A fixed sequence of stages run on a number of items, with the stages of different items running concurrently on
+     *        a @class ThreadPool
+     * @details Between two stages, the items wait in a bounded queue: a stage only starts on an item once the queue after it
+     *          has room for it, so that a slow stage holds back the ones before it (down to the first one, which takes the items
+     *          in order) instead of letting the items pile up in memory. Each run of a stage on an item is a separate task of the
+     *          pool, and no thread of the pool ever waits for room in a queue.
+     *          A stage may also wait for something outside of the pipeline before running on an item: its items wait in its
+     *          queue until they are ready (the ready ones passing the others), and @ref wake must be called when some may have
+     *          become ready.
+     *          An item on which a stage throws is dropped from the pipeline, and the exception is returned by @ref run
+     */
+    class Pipeline
+    {
+        public:
+            struct stage
+            {
+                std::function<void(size_t)> run;                        // Run the stage on the item of the given index
+                size_t concurrency = 1;                                 // Maximum number of items the stage runs on at once
+                size_t capacity = SUPDEF_PIPELINE_QUEUE_CAPACITY;       // Maximum number of items waiting for the stage
+                std::function<bool(size_t)> ready = nullptr;            // Whether the stage can run on the item yet (always, if empty),
+                                                                        // called with the lock of the pipeline held (ignored for the first stage)
+            };
+
+            // How a stage went during the last @ref run
+            struct stage_stats
+            {
+                std::chrono::nanoseconds busy{};    // Time spent running it, summed over the items
+                size_t max_waiting = 0;             // Maximum number of items waiting for it at once
+                size_t max_running = 0;             // Maximum number of items it ran on at once
+            };
+
+        private:
+            struct stage_state
+            {
+                stage desc;
+                std::deque<size_t> waiting;
+                size_t running = 0;
+                stage_stats stats;
+            };
+
+            ThreadPool& pool;
+            std::vector<stage_state> stages;
+
+            std::mutex mtx{};
+            std::condition_variable done_cv{};
+            std::vector<std::exception_ptr> errors;
+            size_t next_item = 0;       // Next item to go through the first stage
+            size_t finished = 0;        // Items which went through all the stages, or were dropped
+
+            // Take the next item the stage @p index can run on, if any
+            bool take_input(size_t index, size_t& item)
+            {
+                if (index == 0)
+                {
+                    if (this->next_item == this->errors.size())
+                        return false;
+                    item = this->next_item++;
+                    return true;
+                }
+                stage_state& st = this->stages[index];
+                auto it = st.desc.ready == nullptr ? st.waiting.begin() : std::ranges::find_if(st.waiting, st.desc.ready);
+                if (it == st.waiting.end())
+                    return false;
+                item = *it;
+                st.waiting.erase(it);
+                return true;
+            }
+
+            // Whether the queue after the stage @p index has room for one more item (counting the ones being run on)
+            bool has_room_after(size_t index) const noexcept
+            {
+                if (index + 1 == this->stages.size())
+                    return true;
+                const stage_state& next = this->stages[index + 1];
+                return next.waiting.size() + this->stages[index].running < next.desc.capacity;
+            }
+
+            // Start all the stages which can be, the last ones first (so that they make room for the previous ones)
+            // The lock must be held
+            void pump(void)
+            {
+                for (size_t i = this->stages.size(); i-- > 0; )
+                {
+                    stage_state& st = this->stages[i];
+                    size_t item;
+                    while (st.running < st.desc.concurrency && this->has_room_after(i) && this->take_input(i, item))
+                    {
+                        st.stats.max_running = std::max(st.stats.max_running, ++st.running);
+                        std::ignore = this->pool.enqueue([this, i, item]() { this->run_stage(i, item); });
+                    }
+                }
+            }
+
+            void run_stage(size_t index, size_t item)
+            {
+                std::exception_ptr error = nullptr;
+                const auto start = std::chrono::steady_clock::now();
+                try
+                {
+                    this->stages[index].desc.run(item);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+
+                std::lock_guard<std::mutex> lock(this->mtx);
+                stage_state& st = this->stages[index];
+                --st.running;
+                st.stats.busy += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+                if (error != nullptr || index + 1 == this->stages.size())
+                {
+                    this->errors[item] = error;
+                    ++this->finished;
+                }
+                else
+                {
+                    stage_state& next = this->stages[index + 1];
+                    next.waiting.push_back(item);
+                    next.stats.max_waiting = std::max(next.stats.max_waiting, next.waiting.size());
+                }
+                this->pump();
+                // (notified with the lock held, since the pipeline may be gone as soon as `run` sees it is done)
+                if (this->finished == this->errors.size())
+                    this->done_cv.notify_all();
+            }
+
+        public:
+            Pipeline(ThreadPool& pool, std::vector<stage> stages) : pool(pool)
+            {
+                if (stages.empty())
+                    throw InternalError("Cannot create a pipeline without any stage");
+                for (stage& s : stages)
+                {
+                    if (s.concurrency == 0 || s.capacity == 0)
+                        throw InternalError("The stages of a pipeline must have a non-zero concurrency and capacity");
+                    this->stages.push_back(stage_state{ std::move(s), {}, 0, {} });
+                }
+            }
+
+            Pipeline(const Pipeline&) = delete;
+            Pipeline(Pipeline&&) = delete;
+            Pipeline& operator=(const Pipeline&) = delete;
+            Pipeline& operator=(Pipeline&&) = delete;
+
+            ~Pipeline() = default;
+
+            /**
+             * @brief Run all the stages on @p count items (of indexes `0` to `count - 1`), and wait until they are done
+             * @details Must not be called from a task of the pool (which would wait for the tasks queued after it)
+             * @return The exception thrown for each item by the stage which dropped it, if any
+             */
+            std::vector<std::exception_ptr> run(size_t count)
+            {
+                std::unique_lock<std::mutex> lock(this->mtx);
+                this->errors.assign(count, nullptr);
+                this->next_item = 0;
+                this->finished = 0;
+                for (stage_state& st : this->stages)
+                    st.stats = stage_stats();
+                this->pump();
+                this->done_cv.wait(lock, [this]() { return this->finished == this->errors.size(); });
+                return std::move(this->errors);
+            }
+
+            // Start the stages on the items which became ready since they were queued (see `stage::ready`)
+            void wake(void)
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                this->pump();
+            }
+
+            // How each stage went during the last @ref run
+            std::vector<stage_stats> get_stats(void)
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                std::vector<stage_stats> stats;
+                for (const stage_state& st : this->stages)
+                    stats.push_back(st.stats);
+                return stats;
+            }
+    };
+
     class TmpFile
     {
         private:
@@ -2403,6 +2945,92 @@ POP_MACRO(DECLARE_FRIENDS3)
             }
     };
 
+    /**
+     * @class MappedFile
+     * @brief A read-only memory mapping of a whole file
+     * @details Only non-empty regular files are mapped, and only on platforms supporting it: @ref is_mapped is `false`
+     * otherwise (or if anything failed), in which case the caller is expected to read the file the usual way
+     */
+    class MappedFile
+    {
+        private:
+            const char* ptr = nullptr;
+            size_t len = 0;
+
+            inline void unmap(void) noexcept
+            {
+#if SUPDEF_ON_UNIX
+                if (this->ptr != nullptr)
+                    ::munmap(const_cast<char*>(this->ptr), this->len);
+#endif
+                this->ptr = nullptr;
+                this->len = 0;
+            }
+
+        public:
+            MappedFile() = default;
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            MappedFile(MappedFile&& other) noexcept
+                : ptr(std::exchange(other.ptr, nullptr)), len(std::exchange(other.len, 0))
+            { }
+
+            MappedFile& operator=(MappedFile&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    this->unmap();
+                    this->ptr = std::exchange(other.ptr, nullptr);
+                    this->len = std::exchange(other.len, 0);
+                }
+                return *this;
+            }
+
+            explicit MappedFile(const std::filesystem::path& path) noexcept
+            {
+#if SUPDEF_ON_UNIX
+                const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0)
+                    return;
+                struct stat st{};
+                if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+                {
+                    void* mapped = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (mapped != MAP_FAILED)
+                    {
+                        // The parser reads the file from start to end
+                        ::madvise(mapped, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+                        this->ptr = static_cast<const char*>(mapped);
+                        this->len = static_cast<size_t>(st.st_size);
+                    }
+                }
+                ::close(fd);
+#else
+                (void)path;
+#endif
+            }
+
+            ~MappedFile() noexcept
+            {
+                this->unmap();
+            }
+
+            inline bool is_mapped(void) const noexcept { return this->ptr != nullptr; }
+            inline size_t size(void) const noexcept { return this->len; }
+
+            /**
+             * @brief View the mapped bytes as code units of type @p T
+             * @tparam T A character type whose code units are bytes (char or char8_t)
+             */
+            template <typename T>
+                requires CharacterType<T> && (sizeof(T) == 1)
+            inline std::basic_string_view<T> view(void) const noexcept
+            {
+                return std::basic_string_view<T>(reinterpret_cast<const T*>(this->ptr), this->len);
+            }
+    };
+
     /*
      * A SupDef pragma has the form:
      *
@@ -2579,6 +3207,10 @@ POP_MACRO(DECLARE_FRIENDS3)
     };
 #endif
 
+    template <typename CharType>
+        requires CharacterType<CharType>
+    class RunnableLibrary;
+
     // TODO: Modify PragmaDef
     /**
      * @class PragmaDef
@@ -2589,128 +3221,108 @@ POP_MACRO(DECLARE_FRIENDS3)
         requires CharacterType<CharType>
     struct PragmaDef
     {
+        public:
+            typedef Util::pragma_loc_type<CharType> pragma_loc_type;
+            // The strings of a super define (their characters included) come from its memory resource
+            typedef std::pmr::basic_string<CharType> string_type;
+            typedef std::pmr::vector<string_type> params_type;
+
         private:
-            std::shared_ptr<std::basic_string<CharType>> id;
-            std::shared_ptr<std::basic_string<CharType>> body;
+            std::shared_ptr<string_type> id;
+            std::shared_ptr<string_type> body;
             std::shared_ptr<std::tuple<string_size_type<CharType>, string_size_type<CharType>>> pos;
+            std::shared_ptr<const params_type> params;                                  // Names of the parameters, if declared
+            std::shared_ptr<const string_type> language;                                // Language of the body of a runnable super define
+            // Where a runnable super define runs from, only made by the first call to @ref get_runnable (and shared by the copies)
+            struct lazy_runnable
+            {
+                std::once_flag made;
+                std::shared_ptr<const RunnableLibrary<CharType>> library;
+            };
+            std::shared_ptr<lazy_runnable> runnable;
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource();     // Where the fields are allocated, setters included
 
         public:
-            typedef Util::pragma_loc_type<CharType> pragma_loc_type;
-
             PragmaDef() = default;
             PragmaDef(const PragmaDef&) = default;
             PragmaDef(PragmaDef&&) = default;
             ~PragmaDef() = default;
 
+            /**
+             * @brief Construct a super define from what `Parser::search_super_defines` found
+             * @param pragma_loc The name of the super define (and its parameters, as in `NAME(a, b)`, then the language of the body
+             *                   of a runnable one, as in `NAME(a, b) CXX`) on the first line and its body on the next ones, then
+             *                   its start and end lines
+             * @param resource Where to allocate the name, the body and the position (e.g. the arena of an engine)
+             */
             template <typename PragLocType>
                 requires std::same_as<std::remove_cvref_t<PragLocType>, pragma_loc_type>
-            PragmaDef(PragLocType&& pragma_loc)
-            {
-                if constexpr (std::is_rvalue_reference_v<PragLocType&&>)
+            PragmaDef(PragLocType&& pragma_loc, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+                : resource(resource)
+            {
+                const std::pmr::polymorphic_allocator<std::byte> alloc(resource);
+                this->pos = std::allocate_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(
+                    alloc,
+                    std::get<1>(pragma_loc),
+                    std::get<2>(pragma_loc)
+                );
+                const std::basic_string<CharType>& content = std::get<0>(pragma_loc);
+                const auto name_end = std::find_if(content.begin(), content.end(), [](const CharType& c) { return SAME(c, '\n'); });
+                const auto params_start = std::find_if(content.begin(), name_end, [](const CharType& c) { return SAME(c, '('); });
+                const auto params_end = std::find_if(params_start, name_end, [](const CharType& c) { return SAME(c, ')'); });
+                auto is_space = [](const CharType& c) { return SAME(c, ' ') || SAME(c, '\t') || SAME(c, '\r'); };
+                const auto lang_start = std::find_if(params_start == name_end ? std::find_if_not(content.begin(), name_end, is_space) : params_end, name_end, is_space);
+                this->id = std::allocate_shared<string_type>(
+                    alloc,
+                    remove_whitespaces(std::basic_string<CharType>(content.begin(), std::min(params_start, lang_start)), true)
+                );
+                const auto lang_begin = std::find_if_not(lang_start, name_end, is_space);
+                const auto lang_end = std::find_if(lang_begin, name_end, is_space);
+                if (lang_begin != lang_end)
+                    this->language = std::allocate_shared<const string_type>(alloc, lang_begin, lang_end);
+                if (params_start != name_end)
                 {
-                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(
-                        std::make_tuple(
-                            std::get<1>(std::move(pragma_loc)),
-                            std::get<2>(std::move(pragma_loc))
-                        )
-                    );
-                    auto first_line = [](const std::basic_string<CharType>& str) -> std::basic_string<CharType>
+                    params_type names(alloc);
+                    auto param_start = std::next(params_start);
+                    for (auto it = param_start; it != name_end; ++it)
                     {
-                        std::basic_string<CharType> result;
-                        for (const CharType& c : str)
+                        if (SAME(*it, ',') || SAME(*it, ')'))
                         {
-                            if (SAME(c, '\n'))
-                                break;
-                            result += c;
+                            names.emplace_back(remove_whitespaces(std::basic_string<CharType>(param_start, it), true));
+                            param_start = std::next(it);
                         }
-                        return result;
-                    }(std::get<0>(std::move(pragma_loc)));
-                    this->id = std::make_shared<std::basic_string<CharType>>(
-                        remove_whitespaces(first_line, true)
-                    );
-                    auto remaining_lines = [](const std::basic_string<CharType>& str) -> std::basic_string<CharType>
-                    {
-                        std::basic_string<CharType> result;
-                        bool is_first_line = true;
-                        for (const CharType& c : str)
-                        {
-                            if (is_first_line)
-                            {
-                                if (SAME(c, '\n'))
-                                    is_first_line = false;
-                            }
-                            else
-                                result += c;
-                        }
-                        return result;
-                    }(std::get<0>(std::move(pragma_loc)));
-                    this->body = std::make_shared<std::basic_string<CharType>>(
-                        remove_whitespaces(remaining_lines, true, true)
-                    );
-                }
-                else
-                {
-                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(
-                        std::make_tuple(
-                            std::get<1>(pragma_loc),
-                            std::get<2>(pragma_loc)
-                        )
-                    );
-                    auto first_line = [](const std::basic_string<CharType>& str) -> std::basic_string<CharType>
-                    {
-                        std::basic_string<CharType> result;
-                        for (const CharType& c : str)
-                        {
-                            if (SAME(c, '\n'))
-                                break;
-                            result += c;
-                        }
-                        return result;
-                    }(std::get<0>(pragma_loc));
-                    this->id = std::make_shared<std::basic_string<CharType>>(
-                        remove_whitespaces(first_line, true)
-                    );
-                    auto remaining_lines = [](const std::basic_string<CharType>& str) -> std::basic_string<CharType>
-                    {
-                        std::basic_string<CharType> result;
-                        bool is_first_line = true;
-                        for (const CharType& c : str)
-                        {
-                            if (is_first_line)
-                            {
-                                if (SAME(c, '\n'))
-                                    is_first_line = false;
-                            }
-                            else
-                                result += c;
-                        }
-                        return result;
-                    }(std::get<0>(pragma_loc));
-                    this->body = std::make_shared<std::basic_string<CharType>>(
-                        remove_whitespaces(remaining_lines, true, true)
-                    );
+                    }
+                    // `NAME()` has no parameters
+                    if (names.size() == 1 && names.front().empty())
+                        names.clear();
+                    this->params = std::allocate_shared<const params_type>(alloc, std::move(names));
                 }
+                this->body = std::allocate_shared<string_type>(
+                    alloc,
+                    name_end == content.end() || std::next(name_end) == content.end() ?
+                        std::basic_string<CharType>() :
+                        remove_whitespaces(std::basic_string<CharType>(std::next(name_end), content.end()), true, true)
+                );
+                this->recompile();
             }
             template <typename StdStringType1, typename StdStringType2, typename PosType>
                 requires std::same_as<std::remove_cvref_t<StdStringType1>, std::basic_string<CharType>> &&
                          std::same_as<std::remove_cvref_t<StdStringType2>, std::basic_string<CharType>> &&
                          std::same_as<std::remove_cvref_t<PosType>, std::tuple<string_size_type<CharType>, string_size_type<CharType>>>
-            PragmaDef(StdStringType1&& id, StdStringType2&& body, PosType&& pos = std::tuple<string_size_type<CharType>, string_size_type<CharType>>(0, 0))
+            PragmaDef(
+                StdStringType1&& id,
+                StdStringType2&& body,
+                PosType&& pos = std::tuple<string_size_type<CharType>, string_size_type<CharType>>(0, 0),
+                std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+            )
+                : resource(resource)
             {
-                if constexpr (std::is_rvalue_reference_v<StdStringType1&&>)
-                    this->id = std::make_shared<std::basic_string<CharType>>(std::move(id));
-                else
-                    this->id = std::make_shared<std::basic_string<CharType>>(id);
-             
-                if constexpr (std::is_rvalue_reference_v<StdStringType2&&>)
-                    this->body = std::make_shared<std::basic_string<CharType>>(std::move(body));
-                else
-                    this->body = std::make_shared<std::basic_string<CharType>>(body);
-             
-                if constexpr (std::is_rvalue_reference_v<PosType&&>)
-                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(std::move(pos));
-                else
-                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(pos);
+                const std::pmr::polymorphic_allocator<std::byte> alloc(resource);
+                this->id = std::allocate_shared<string_type>(alloc, std::forward<StdStringType1>(id));
+                this->body = std::allocate_shared<string_type>(alloc, std::forward<StdStringType2>(body));
+                this->pos = std::allocate_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(alloc, std::forward<PosType>(pos));
+
+                this->recompile();
             }
 
             PragmaDef& operator=(const PragmaDef&) = default;
@@ -2721,6 +3333,12 @@ POP_MACRO(DECLARE_FRIENDS3)
                 return this->pos;
             }
 
+            // Allocator of the fields of the super define
+            inline std::pmr::polymorphic_allocator<std::byte> get_allocator() const noexcept
+            {
+                return std::pmr::polymorphic_allocator<std::byte>(this->resource);
+            }
+
             inline auto get_id() const noexcept
             {
                 return this->id;
@@ -2731,6 +3349,33 @@ POP_MACRO(DECLARE_FRIENDS3)
                 return this->body;
             }
 
+            inline auto get_params() const noexcept
+            {
+                return this->params;
+            }
+
+            // The language of the body of a runnable super define (`C` or `CXX`), `nullptr` for any other super define
+            inline auto get_language() const noexcept
+            {
+                return this->language;
+            }
+
+            inline bool is_runnable() const noexcept
+            {
+                return this->language != nullptr;
+            }
+
+            // The library a runnable super define is compiled to (`nullptr` for any other super define), made on the first call
+            std::shared_ptr<const RunnableLibrary<CharType>> get_runnable() const
+            {
+                if (!this->runnable)
+                    return nullptr;
+                std::call_once(this->runnable->made, [this]() -> void {
+                    this->runnable->library = std::make_shared<const RunnableLibrary<CharType>>(*this);
+                });
+                return this->runnable->library;
+            }
+
             inline string_size_type<CharType> get_start() const noexcept
             {
                 return std::get<0>(*this->pos);
@@ -2748,1163 +3393,3622 @@ POP_MACRO(DECLARE_FRIENDS3)
                 this->pos = pos;
             }
 
-            inline void set_id(std::shared_ptr<std::basic_string<CharType>> id) noexcept
+            inline void set_id(std::shared_ptr<string_type> id) noexcept
             {
                 this->id = id;
             }
 
-            inline void set_body(std::shared_ptr<std::basic_string<CharType>> body) noexcept
+            inline void set_body(std::shared_ptr<string_type> body)
             {
                 this->body = body;
+                this->recompile();
             }
 
             template <typename StdStringType>
                 requires std::same_as<std::remove_cvref_t<StdStringType>, std::basic_string<CharType>>
             inline void set_id(StdStringType&& id) noexcept
             {
-                if constexpr (std::is_rvalue_reference_v<StdStringType&&>)
-                    this->id = std::make_shared<std::basic_string<CharType>>(std::move(id));
-                else
-                    this->id = std::make_shared<std::basic_string<CharType>>(id);
+                this->id = std::allocate_shared<string_type>(this->get_allocator(), std::forward<StdStringType>(id));
             }
 
             template <typename StdStringType>
                 requires std::same_as<std::remove_cvref_t<StdStringType>, std::basic_string<CharType>>
-            inline void set_body(StdStringType&& body) noexcept
+            inline void set_body(StdStringType&& body)
             {
-                if constexpr (std::is_rvalue_reference_v<StdStringType&&>)
-                    this->body = std::make_shared<std::basic_string<CharType>>(std::move(body));
-                else
-                    this->body = std::make_shared<std::basic_string<CharType>>(body);
+                this->body = std::allocate_shared<string_type>(this->get_allocator(), std::forward<StdStringType>(body));
+                this->recompile();
             }
 
             inline void set_id(const CharType* id) noexcept
             {
-                this->id = std::make_shared<std::basic_string<CharType>>(id);
+                this->id = std::allocate_shared<string_type>(this->get_allocator(), id);
             }
 
-            inline void set_body(const CharType* body) noexcept
+            // Name the parameters, so that `$<name>` can be used in the body
+            inline void set_params(std::vector<std::basic_string<CharType>> params)
             {
-                this->body = std::make_shared<std::basic_string<CharType>>(body);
+                this->params = std::allocate_shared<const params_type>(this->get_allocator(), params.begin(), params.end());
+                this->recompile();
+            }
+
+            inline void set_body(const CharType* body)
+            {
+                this->body = std::allocate_shared<string_type>(this->get_allocator(), body);
+                this->recompile();
+            }
+
+            /**
+             * @brief Get the number of arguments the super define takes
+             * @details That is, its number of named parameters, or the greatest `$<n>` found in its body if greater.
+             *          Computed once when the body is set (see @ref compile_body)
+             */
+            inline size_t get_argc(void) const noexcept
+            {
+                return this->compiled ? this->compiled->argc : 0;
+            }
+
+            /**
+             * @brief Expand the super define with the arguments @p args
+             * @details That is, run it for a runnable super define (see @class RunnableLibrary), and @ref substitute_body otherwise
+             *
+             * @param args The arguments of the invocation (at least @ref get_argc of them)
+             * @return The expansion
+             */
+            std::basic_string<CharType> substitute(std::span<const std::basic_string_view<CharType>> args) const
+            {
+                if (this->runnable)
+                    return this->get_runnable()->run(args);
+                return this->substitute_body(args);
             }
 
-            size_t get_argc(void) const noexcept
+            /**
+             * @brief Replace the placeholders of the body with the arguments @p args
+             * @details The placeholders of the body are replaced as follows:
+             *          - `$0` by the name of the super define, and `$<n>` by the n-th argument
+             *          - `$<name>` by the argument of the parameter `<name>` (and kept as is if there is no such parameter)
+             *          - `$@` by all the arguments, separated by `, `
+             *          - `$#` by the number of arguments
+             *          A `$` preceded by an odd number of backslashes is kept as is (without the last backslash).
+             *          Since the body is compiled once, this is only a `reserve()` followed by the concatenation of its
+             *          segments, straight from @p args.
+             * 
+             * @param args The arguments of the invocation (at least @ref get_argc of them)
+             * @return The expanded body
+             */
+            std::basic_string<CharType> substitute_body(std::span<const std::basic_string_view<CharType>> args) const
             {
-                size_t result = 0;
-                std::vector<uint8_t> curr_num(1);
-                bool in_arg = false;
-                bool reached_first_num = false;
-                string_size_type<CharType> curr_pos = 0;
-                for (const CharType& c : *this->body)
+                if (!this->compiled)
+                    return std::basic_string<CharType>();
+                const substitution_template& tmpl = *this->compiled;
+                if (tmpl.argc > args.size())
+                    throw Exception<CharType, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Invalid argument number in super define " + CONVERT(std::string, std::basic_string<CharType>(*this->id)) + " (expected: " + std::to_string(args.size()) + ", got: " + std::to_string(tmpl.argc) + ")");
+
+                const std::basic_string<CharType> argc_str = CONVERT(CharType, std::to_string(args.size()));
+                auto arg = [this, &args](size_t index) -> std::basic_string_view<CharType>
                 {
-                    if (SAME(c, '$'))
-                    {
-                        if (in_arg)
-                            continue;
-                        size_t backslash_count = 0;
-                        for (string_size_type<CharType> i = curr_pos - 1; i >= 0; --i)
-                        {
-                            if (SAME((*this->body)[i], '\\'))
-                                ++backslash_count;
-                            else
-                                break;
-                        }
-                        if (backslash_count % 2 == 0)
-                            in_arg = true;
-                    }
-                    else if (in_arg)
+                    return index == 0 ? std::basic_string_view<CharType>(*this->id) : args[index - 1];
+                };
+                auto for_each_part = [&](auto&& fn) -> void
+                {
+                    for (const auto& seg : tmpl.segments)
                     {
-                        auto is_number = [](const CharType& c) -> bool
+                        if (seg.arg == substitution_template::no_arg)
+                            fn(std::basic_string_view<CharType>(tmpl.literals).substr(seg.offset, seg.size));
+                        else if (seg.arg == substitution_template::arg_count)
+                            fn(std::basic_string_view<CharType>(argc_str));
+                        else if (seg.arg == substitution_template::all_args)
                         {
-                            return SAME(c, '0') || SAME(c, '1') || SAME(c, '2') || SAME(c, '3') || SAME(c, '4') || SAME(c, '5') || SAME(c, '6') || SAME(c, '7') || SAME(c, '8') || SAME(c, '9');
-                        };
-                        if (is_number(c))
-                        {
-                            if (!reached_first_num)
-                                reached_first_num = true;
-                            curr_num.push_back(static_cast<uint8_t>(CONVERT_NUM(unsigned short, c)));
+                            for (size_t i = 0; i < args.size(); ++i)
+                            {
+                                if (i != 0)
+                                    fn(std::basic_string_view<CharType>(substitution_template::separator()));
+                                fn(args[i]);
+                            }
                         }
                         else
-                        {
-                            if (!reached_first_num)
-                                continue;
-                            curr_num.insert(curr_num.begin(), 0);
-                            result = std::max(result, size_t(std::accumulate(curr_num.begin(), curr_num.end(), 0, [](const uint8_t& a, const uint8_t& b) -> uint8_t { return a * 10 + b; })));
-                            curr_num.clear();
-                            in_arg = false;
-                            reached_first_num = false;
-                        }
+                            fn(arg(seg.arg));
                     }
-                    ++curr_pos;
-                }
-                if (in_arg && reached_first_num)
-                {
-                    curr_num.insert(curr_num.begin(), 0);
-                    result = std::max(result, size_t(std::accumulate(curr_num.begin(), curr_num.end(), 0, [](const uint8_t& a, const uint8_t& b) -> uint8_t { return a * 10 + b; })));
-                }
+                };
+
+                string_size_type<CharType> size = 0;
+                for_each_part([&size](std::basic_string_view<CharType> part) { size += part.size(); });
+                std::basic_string<CharType> result;
+                result.reserve(size);
+                for_each_part([&result](std::basic_string_view<CharType> part) { result.append(part); });
                 return result;
             }
 
             template <typename... Args>
-                requires (std::same_as<std::remove_cvref_t<Args>, std::basic_string<CharType>> && ...)
-            std::basic_string<CharType> substitute(Args&&... args) const
+                requires (std::convertible_to<const Args&, std::basic_string_view<CharType>> && ...)
+            std::basic_string<CharType> substitute(const Args&... args) const
             {
-                std::basic_string<CharType> result;
-                std::vector<std::basic_string<CharType>> args_vec{ std::forward<Args>(args)... };
-                std::vector<uint8_t> curr_num(1);
-                bool in_arg = false;
-                bool reached_first_num = false;
-                string_size_type<CharType> curr_pos = 0;
-                for (const CharType& c : *this->body)
-                {
-                    if (SAME(c, '$'))
+                const std::array<std::basic_string_view<CharType>, sizeof...(Args)> views{ std::basic_string_view<CharType>(args)... };
+                return this->substitute(std::span<const std::basic_string_view<CharType>>(views));
+            }
+
+            std::basic_string<CharType> substitute(const std::vector<std::basic_string<CharType>>& args) const
+            {
+                std::vector<std::basic_string_view<CharType>> views(args.begin(), args.end());
+                return this->substitute(std::span<const std::basic_string_view<CharType>>(views));
+            }
+
+            std::basic_string<CharType> substitute_body(const std::vector<std::basic_string<CharType>>& args) const
+            {
+                std::vector<std::basic_string_view<CharType>> views(args.begin(), args.end());
+                return this->substitute_body(std::span<const std::basic_string_view<CharType>>(views));
+            }
+
+            template <typename... Args>
+                requires (std::convertible_to<const Args&, std::basic_string_view<CharType>> && ...)
+            std::basic_string<CharType> operator()(const Args&... args) const
+            {
+                return this->substitute(args...);
+            }
+
+        private:
+            // A body split once into literal text and argument references
+            struct substitution_template
+            {
+                static constexpr size_t no_arg = std::numeric_limits<size_t>::max();
+                static constexpr size_t all_args = no_arg - 1;      // `$@`
+                static constexpr size_t arg_count = no_arg - 2;     // `$#`
+
+                // `literals.substr(offset, size)` if `arg` is `no_arg`, the argument `$<arg>` or one of the above otherwise
+                struct segment
+                {
+                    string_size_type<CharType> offset;
+                    string_size_type<CharType> size;
+                    size_t arg;
+                };
+
+                std::basic_string<CharType> literals;
+                std::vector<segment> segments;
+                size_t argc = 0;
+
+                static const std::basic_string<CharType>& separator(void)
+                {
+                    static const std::basic_string<CharType> sep = CONVERT(CharType, std::string(", "));
+                    return sep;
+                }
+            };
+
+            std::shared_ptr<const substitution_template> compiled;
+
+            static bool is_ident_char(const CharType& c) noexcept
+            {
+                const uint32_t v = ::SupDef::Util::code_unit_value(c);
+                return (v >= 'a' && v <= 'z') || (v >= 'A' && v <= 'Z') || (v >= '0' && v <= '9') || v == '_';
+            }
+
+            // Split @p body in literal segments and placeholders, the names of @p params being resolved to their index
+            static std::shared_ptr<const substitution_template> compile_body(
+                std::basic_string_view<CharType> id,
+                std::basic_string_view<CharType> body,
+                const params_type& params
+            )
+            {
+                auto result = std::make_shared<substitution_template>();
+                result->argc = params.size();
+                result->literals.reserve(body.size());
+                string_size_type<CharType> literal_start = 0;
+                auto end_literal = [&result, &literal_start]() -> void
+                {
+                    if (result->literals.size() > literal_start)
+                        result->segments.push_back({ literal_start, result->literals.size() - literal_start, substitution_template::no_arg });
+                    literal_start = result->literals.size();
+                };
+                auto add_placeholder = [&result, &end_literal](size_t arg) -> void
+                {
+                    end_literal();
+                    result->segments.push_back({ 0, 0, arg });
+                };
+                auto digit_of = [](const CharType& c) -> uint32_t
+                {
+                    return ::SupDef::Util::code_unit_value(c) - ::SupDef::Util::code_unit_value('0');
+                };
+
+                size_t backslash_count = 0;
+                for (string_size_type<CharType> i = 0; i < body.size(); ++i)
+                {
+                    const CharType& c = body[i];
+                    if (DIFFERENT(c, '$'))
                     {
-                        if (in_arg)
-                            continue;
-                        size_t backslash_count = 0;
-                        for (string_size_type<CharType> i = curr_pos - 1; i >= 0; --i)
-                        {
-                            if (SAME((*this->body)[i], '\\'))
-                                ++backslash_count;
-                            else
-                                break;
-                        }
-                        if (backslash_count % 2 == 0)
-                            in_arg = true;
+                        backslash_count = SAME(c, '\\') ? backslash_count + 1 : 0;
+                        result->literals += c;
+                        continue;
                     }
-                    else if (in_arg)
+                    // An escaped `$` replaces the backslash escaping it
+                    if (backslash_count % 2 != 0)
                     {
-                        auto is_number = [](const CharType& c) -> bool
-                        {
-                            return SAME(c, '0') || SAME(c, '1') || SAME(c, '2') || SAME(c, '3') || SAME(c, '4') || SAME(c, '5') || SAME(c, '6') || SAME(c, '7') || SAME(c, '8') || SAME(c, '9');
-                        };
-                        if (is_number(c))
+                        result->literals.back() = c;
+                        backslash_count = 0;
+                        continue;
+                    }
+                    backslash_count = 0;
+                    if (i + 1 < body.size() && (SAME(body[i + 1], '@') || SAME(body[i + 1], '#')))
+                    {
+                        add_placeholder(SAME(body[i + 1], '@') ? substitution_template::all_args : substitution_template::arg_count);
+                        ++i;
+                        continue;
+                    }
+                    string_size_type<CharType> name_end = i + 1;
+                    while (name_end < body.size() && is_ident_char(body[name_end]))
+                        ++name_end;
+                    if (name_end == i + 1)
+                    {
+                        result->literals += c;
+                        continue;
+                    }
+
+                    if (digit_of(body[i + 1]) < 10)
+                    {
+                        // `$<n>` stops at the first non-digit
+                        name_end = i + 1;
+                        while (name_end < body.size() && digit_of(body[name_end]) < 10)
+                            ++name_end;
+                        size_t arg = 0;
+                        for (string_size_type<CharType> j = i + 1; j < name_end; ++j)
                         {
-                            if (!reached_first_num)
-                                reached_first_num = true;
-                            curr_num.push_back(static_cast<uint8_t>(CONVERT_NUM(unsigned short, c)));
+                            if (arg > (std::numeric_limits<size_t>::max() - 3 - digit_of(body[j])) / 10)
+                                throw Exception<CharType, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Argument number too large in super define " + CONVERT(std::string, std::basic_string<CharType>(id)));
+                            arg = arg * 10 + digit_of(body[j]);
                         }
-                        else
+                        add_placeholder(arg);
+                        result->argc = std::max(result->argc, arg);
+                    }
+                    else
+                    {
+                        const auto param = std::find(params.begin(), params.end(), body.substr(i + 1, name_end - i - 1));
+                        if (param == params.end())
                         {
-                            if (!reached_first_num)
-                                continue;
-                            curr_num.insert(curr_num.begin(), 0);
-                            size_t arg_num = std::accumulate(curr_num.begin(), curr_num.end(), 0, [](const uint8_t& a, const uint8_t& b) -> uint8_t { return a * 10 + b; });
-                            if (arg_num > args_vec.size())
-                                throw Exception<CharType, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Invalid argument number in super define " + CONVERT(std::string, *this->id) + " (expected: " + std::to_string(args_vec.size()) + ", got: " + std::to_string(arg_num) + ")");
-                            result += args_vec[arg_num - 1];
-                            curr_num.clear();
-                            in_arg = false;
-                            reached_first_num = false;
+                            result->literals.append(body, i, name_end - i);
+                            i = name_end - 1;
+                            continue;
                         }
+                        add_placeholder(static_cast<size_t>(param - params.begin()) + 1);
                     }
-                    else
-                        result += c;
-                    ++curr_pos;
-                }
-                if (in_arg && reached_first_num)
-                {
-                    curr_num.insert(curr_num.begin(), 0);
-                    size_t arg_num = std::accumulate(curr_num.begin(), curr_num.end(), 0, [](const uint8_t& a, const uint8_t& b) -> uint8_t { return a * 10 + b; });
-                    if (arg_num > args_vec.size())
-                        throw Exception<CharType, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Invalid argument number in super define " + CONVERT(std::string, *this->id) + " (expected: " + std::to_string(args_vec.size()) + ", got: " + std::to_string(arg_num) + ")");
-                    result += args_vec[arg_num - 1];
+                    i = name_end - 1;
                 }
+                end_literal();
                 return result;
             }
 
-            template <typename... Args>
-                requires (std::same_as<std::remove_cvref_t<Args>, std::basic_string<CharType>> && ...)
-            std::basic_string<CharType> operator()(Args&&... args) const
+            inline void recompile(void)
             {
-                return this->substitute(std::forward<Args>(args)...);
+                this->compiled = this->body ?
+                    compile_body(this->id ? std::basic_string_view<CharType>(*this->id) : std::basic_string_view<CharType>(), *this->body, this->params ? *this->params : params_type()) :
+                    nullptr;
+                // Only generated (then compiled into a library) when first invoked, but an unknown language is reported right away
+                this->runnable = nullptr;
+                if (this->language)
+                {
+                    const std::string language = CONVERT(char, std::basic_string<CharType>(*this->language));
+                    if (language != "C" && language != "CXX")
+                        throw Exception<CharType, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Unknown language `" + language + "` of the runnable super define " + CONVERT(std::string, std::basic_string<CharType>(*this->id)) + " (expected `C` or `CXX`)");
+                    this->runnable = std::allocate_shared<lazy_runnable>(this->get_allocator());
+                }
             }
     };
 
-    template <typename T, typename U>
-        requires CharacterType<T> && FilePath<U>
-    class SrcFile;
-
-    // TODO: Modify PragmaInc
-    template <typename CharType, typename FilePathType>
-        requires CharacterType<CharType> && FilePath<FilePathType>
-    struct PragmaInc
+    /**
+     * @class RunnableLibrary
+     * @brief The shared library a runnable super define is compiled to, and run from
+     * @details The body of a runnable super define (`#pragma supdef runnable C|CXX begin NAME(a, b)`) is the body of a C or
+     *          C++ function writing the expansion with `SUPDEF_WRITE(value)`, or with `SUPDEF_RETURN(value)` which returns
+     *          afterwards (a value being a string or an integer in C, and anything that can be written to a `std::ostream` in
+     *          C++). `$<n>` and `$<name>` are its arguments (as `const char*` in C, and as `std::string` in C++), `$@` all
+     *          of them and `$#` the number of parameters, while `SUPDEF_ARGC` is the number of arguments actually given.
+     *          The `SUPDEF_INCLUDE(<header>)` lines are moved out of the function, as `#include <header>`.
+     *          The generated source is compiled once into a shared library named after a hash of the source, of the compiler
+     *          and of its flags, in a cache directory shared by the processes of the current user (and refused if anyone
+     *          else could write to it): a library already there is only loaded (in which case the cache is warm). Nothing happens before the first invocation, and each one is then a call into
+     *          the loaded library, in-process (@ref run running one invocation, and @ref run_batch many of them with a single call).
+     * @tparam CharType The character type of the super define
+     */
+    template <typename CharType>
+        requires CharacterType<CharType>
+    class RunnableLibrary
     {
-        private:
-            std::shared_ptr<std::tuple<string_size_type<CharType>, string_size_type<CharType>>> pos;
-            std::shared_ptr<SrcFile<CharType, FilePathType>> included;
-
         public:
-            typedef Util::pragma_loc_type<CharType> pragma_loc_type;
-            PragmaInc() = default;
-            ~PragmaInc() noexcept;
-            
-            template <typename PragLocType>
-                requires std::same_as<std::remove_cvref_t<PragLocType>, pragma_loc_type>
-            PragmaInc(PragLocType&& pragma_loc)
+            typedef std::basic_string<CharType> string_type;
+            typedef std::basic_string_view<CharType> string_view_type;
+            typedef std::span<const string_view_type> args_type;
+
+            // How a runnable super define is compiled (the flags must make the compiler produce a shared library)
+            struct toolchain
             {
-                if constexpr (std::is_rvalue_reference_v<PragLocType&&>)
+                std::string compiler;
+                std::string flags;
+
+                static toolchain of(std::string_view language)
                 {
-                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(
-                        std::make_tuple(
-                            std::get<1>(std::move(pragma_loc)),
-                            std::get<2>(std::move(pragma_loc))
-                        )
-                    );
-                    this->included = std::make_shared<SrcFile<CharType, FilePathType>>(CONVERT(FilePathType, remove_whitespaces(std::get<0>(std::move(pragma_loc)))));
+                    if (language == "C")
+                        return toolchain{ SUPDEF_RUNNABLE_C_COMPILER, SUPDEF_RUNNABLE_C_FLAGS };
+                    return toolchain{ SUPDEF_RUNNABLE_CXX_COMPILER, SUPDEF_RUNNABLE_CXX_FLAGS };
                 }
-                else
+            };
+
+            // How long getting the library ready took
+            struct timings
+            {
+                bool compiled = false;                          // Whether it was compiled (or only loaded from the cache)
+                std::chrono::nanoseconds compile_time{ 0 };     // Zero if it was only loaded
+                std::chrono::nanoseconds load_time{ 0 };        // Looking for it in the cache included
+            };
+
+        private:
+            // `void supdef_runnable_batch(size_t count, const size_t* argc, const char* const* const* argv, emit_type emit, void* ctx)`,
+            // `emit(ctx, i, data, size)` appending to the expansion of the i-th invocation
+            typedef void (*emit_type)(void*, size_t, const char*, size_t);
+            typedef void (*entry_type)(size_t, const size_t*, const char* const* const*, emit_type, void*);
+            // `void supdef_runnable_call(size_t argc, const char* const* argv, emit_type emit, void* ctx)`, for a single invocation
+            typedef void (*call_type)(size_t, const char* const*, emit_type, void*);
+
+            static constexpr std::string_view entry_name = "supdef_runnable_batch";
+            static constexpr std::string_view call_name = "supdef_runnable_call";
+
+            static constexpr std::string_view c_prelude =
+                "#include <stddef.h>\n"
+                "#include <stdio.h>\n"
+                "#include <string.h>\n"
+                "\n"
+                "typedef void (*supdef_emit_fn)(void*, size_t, const char*, size_t);\n"
+                "struct supdef_call { supdef_emit_fn emit; void* ctx; size_t index; size_t argc; const char* const* argv; };\n"
+                "\n"
+                "static void supdef_write_str(const struct supdef_call* call, const char* str)\n"
+                "{\n"
+                "    call->emit(call->ctx, call->index, str, strlen(str));\n"
+                "}\n"
+                "\n"
+                "static void supdef_write_int(const struct supdef_call* call, long long value)\n"
+                "{\n"
+                "    char buf[32];\n"
+                "    const int size = snprintf(buf, sizeof(buf), \"%lld\", value);\n"
+                "    call->emit(call->ctx, call->index, buf, (size_t)size);\n"
+                "}\n"
+                "\n"
+                "#define SUPDEF_ARGC (supdef_call->argc)\n"
+                "#define SUPDEF_ARG(n) ((size_t)(n) <= supdef_call->argc ? supdef_call->argv[(n) - 1] : \"\")\n"
+                "#define SUPDEF_WRITE(value) _Generic((value), char*: supdef_write_str, const char*: supdef_write_str, default: supdef_write_int)(supdef_call, (value))\n"
+                "#define SUPDEF_RETURN(value) do { SUPDEF_WRITE(value); return; } while (0)\n"
+                "#define SUPDEF_EXPORT\n";
+
+            static constexpr std::string_view cxx_prelude =
+                "#include <cstddef>\n"
+                "#include <sstream>\n"
+                "#include <string>\n"
+                "#include <string_view>\n"
+                "#include <type_traits>\n"
+                "\n"
+                "using std::size_t;\n"
+                "typedef void (*supdef_emit_fn)(void*, std::size_t, const char*, std::size_t);\n"
+                "struct supdef_call { supdef_emit_fn emit; void* ctx; std::size_t index; std::size_t argc; const char* const* argv; };\n"
+                "\n"
+                "template <typename T>\n"
+                "static void supdef_write(const supdef_call* call, const T& value)\n"
+                "{\n"
+                "    if constexpr (std::is_convertible_v<const T&, std::string_view>)\n"
+                "    {\n"
+                "        const std::string_view str(value);\n"
+                "        call->emit(call->ctx, call->index, str.data(), str.size());\n"
+                "    }\n"
+                "    else\n"
+                "    {\n"
+                "        std::ostringstream out;\n"
+                "        out << value;\n"
+                "        const std::string str = std::move(out).str();\n"
+                "        call->emit(call->ctx, call->index, str.data(), str.size());\n"
+                "    }\n"
+                "}\n"
+                "\n"
+                "#define SUPDEF_ARGC (supdef_call->argc)\n"
+                "#define SUPDEF_ARG(n) std::string(static_cast<std::size_t>(n) <= supdef_call->argc ? supdef_call->argv[(n) - 1] : \"\")\n"
+                "#define SUPDEF_WRITE(value) supdef_write(supdef_call, (value))\n"
+                "#define SUPDEF_RETURN(value) do { SUPDEF_WRITE(value); return; } while (0)\n"
+                "#define SUPDEF_EXPORT extern \"C\"\n";
+
+            static constexpr std::string_view entry_source =
+                "SUPDEF_EXPORT void supdef_runnable_batch(size_t count, const size_t* argc, const char* const* const* argv, supdef_emit_fn emit, void* ctx)\n"
+                "{\n"
+                "    for (size_t i = 0; i < count; ++i)\n"
+                "    {\n"
+                "        const struct supdef_call call = { emit, ctx, i, argc[i], argv[i] };\n"
+                "        supdef_body(&call);\n"
+                "    }\n"
+                "}\n"
+                "\n"
+                "SUPDEF_EXPORT void supdef_runnable_call(size_t argc, const char* const* argv, supdef_emit_fn emit, void* ctx)\n"
+                "{\n"
+                "    const struct supdef_call call = { emit, ctx, 0, argc, argv };\n"
+                "    supdef_body(&call);\n"
+                "}\n";
+
+            string_type name;
+            size_t argc;
+            bool is_cxx;
+            std::string source;
+            toolchain tools;
+            std::filesystem::path cache_dir;
+            std::string key;
+
+            mutable std::once_flag loaded;
+            mutable void* handle = nullptr;
+            mutable entry_type entry = nullptr;
+            mutable call_type call = nullptr;
+            mutable timings load_timings;
+
+            static std::string shell_quote(const std::string& str)
+            {
+                std::string res = "'";
+                for (char c : str)
+                    res += c == '\'' ? std::string("'\\''") : std::string(1, c);
+                return res + "'";
+            }
+
+            // The function of the runnable super define @p def, and everything it needs
+            static std::string generate_source(const PragmaDef<CharType>& def, bool is_cxx)
+            {
+                std::vector<string_type> placeholders;
+                for (size_t i = 1; i <= def.get_argc(); ++i)
+                    placeholders.push_back(CONVERT(CharType, "SUPDEF_ARG(" + std::to_string(i) + ")"));
+                const std::string body = CONVERT(char, def.substitute_body(placeholders));
+
+                std::string includes;
+                std::string function_body;
+                for (size_t start = 0; start < body.size();)
                 {
-                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(
-                        std::make_tuple(
-                            std::get<1>(pragma_loc),
-                            std::get<2>(pragma_loc)
-                        )
-                    );
-                    this->included = std::make_shared<SrcFile<CharType, FilePathType>>(CONVERT(FilePathType, remove_whitespaces(std::get<0>(pragma_loc))));
+                    const size_t end = std::min(body.find('\n', start), body.size());
+                    const std::string_view line = std::string_view(body).substr(start, end - start);
+                    const size_t first = line.find_first_not_of(" \t\r");
+                    const size_t last = line.find_last_not_of(" \t\r;");
+                    constexpr std::string_view include_macro = "SUPDEF_INCLUDE(";
+                    if (first != std::string_view::npos && line.substr(first).starts_with(include_macro) && last != std::string_view::npos && line[last] == ')')
+                        includes.append("#include ").append(line.substr(first + include_macro.size(), last - first - include_macro.size())).append("\n");
+                    else
+                        function_body.append(line);
+                    // Keep the line, so that the line numbers of the errors are the ones of the body
+                    function_body += '\n';
+                    start = end + 1;
                 }
+
+                std::string res(is_cxx ? cxx_prelude : c_prelude);
+                res += "\n" + includes + "\n";
+                res += "static void supdef_body(const struct supdef_call* supdef_call)\n{\n";
+                res += "#line " + std::to_string(def.get_start() + 1) + " \"" + CONVERT(char, string_type(*def.get_id())) + "\"\n";
+                res += function_body;
+                res += "}\n\n";
+                res += entry_source;
+                return res;
             }
-            template <typename StdStringType, typename PosType>
-                requires std::same_as<std::remove_cvref_t<StdStringType>, std::basic_string<CharType>> &&
-                         std::same_as<std::remove_cvref_t<PosType>, std::tuple<string_size_type<CharType>, string_size_type<CharType>>>
-            PragmaInc(StdStringType&& path, PosType&& pos)
+
+            void compile(const std::filesystem::path& library) const
             {
-                if constexpr (std::is_rvalue_reference_v<StdStringType&&>)
-                    this->included = std::make_shared<SrcFile<CharType, FilePathType>>(std::move(path));
-                else
-                    this->included = std::make_shared<SrcFile<CharType, FilePathType>>(path);
-                if constexpr (std::is_rvalue_reference_v<PosType&&>)
-                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(std::move(pos));
-                else
-                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(pos);
+                static std::atomic<size_t> compilations = 0;
+                // Only renamed to `library` once complete, so that a library in the cache is always a whole one (even if
+                // other processes compile it at the same time)
+#if SUPDEF_ON_UNIX
+                const std::string unique = this->key + "." + std::to_string(::getpid()) + "." + std::to_string(compilations++);
+#else
+                const std::string unique = this->key + "." + std::to_string(compilations++);
+#endif
+                const std::filesystem::path src = this->cache_dir / (unique + (this->is_cxx ? ".cpp" : ".c"));
+                const std::filesystem::path tmp = this->cache_dir / (unique + ".tmp");
+                const std::filesystem::path log = this->cache_dir / (unique + ".log");
+                {
+                    std::ofstream out(src, std::ios::binary);
+                    out << this->source;
+                    if (!out)
+                        throw Exception<CharType, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Could not write the source of the runnable super define " + CONVERT(std::string, this->name) + " to " + src.string());
+                }
+                const std::string command = this->tools.compiler + " " + this->tools.flags + " -o " + RunnableLibrary::shell_quote(tmp.string()) + " " +
+                                            RunnableLibrary::shell_quote(src.string()) + " > " + RunnableLibrary::shell_quote(log.string()) + " 2>&1";
+                const int status = std::system(command.c_str());
+                std::error_code ec;
+                std::filesystem::remove(src, ec);
+                if (status != 0)
+                {
+                    std::ifstream in(log, std::ios::binary);
+                    const std::string output((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                    in.close();
+                    std::filesystem::remove(log, ec);
+                    std::filesystem::remove(tmp, ec);
+                    throw Exception<CharType, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Could not compile the runnable super define " + CONVERT(std::string, this->name) + " (`" + command + "`):\n" + output);
+                }
+                std::filesystem::remove(log, ec);
+                std::filesystem::rename(tmp, library);
             }
 
-            PragmaInc(const PragmaInc&) = default;
-            PragmaInc(PragmaInc&&) = default;
-
-            PragmaInc& operator=(const PragmaInc&) = default;
-            PragmaInc& operator=(PragmaInc&&) = default;
+            static void emit(void* ctx, size_t index, const char* data, size_t size)
+            {
+                (*static_cast<std::vector<std::string>*>(ctx))[index].append(data, size);
+            }
 
-            inline auto get_pos() const noexcept
+            static void emit_one(void* ctx, size_t, const char* data, size_t size)
             {
-                return this->pos;
+                static_cast<std::string*>(ctx)->append(data, size);
             }
-            
-            inline auto get_included() const noexcept
+
+            void check_argc(args_type args) const
             {
-                return this->included;
+                if (args.size() < this->argc)
+                    throw Exception<CharType, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Invalid argument number in super define " + CONVERT(std::string, this->name) + " (expected: " + std::to_string(this->argc) + ", got: " + std::to_string(args.size()) + ")");
             }
 
-            inline auto get_path() const noexcept
+        public:
+            /**
+             * @param def The runnable super define (whose language is `C` or `CXX`)
+             * @param tools How to compile it (the default one of its language if empty)
+             * @param cache_dir Where to keep the compiled libraries (@ref default_cache_dir if empty), created with mode 0700
+             */
+            RunnableLibrary(const PragmaDef<CharType>& def, toolchain tools = toolchain(), std::filesystem::path cache_dir = std::filesystem::path())
+                : name(*def.get_id()), argc(def.get_argc()), tools(std::move(tools)), cache_dir(std::move(cache_dir))
+            {
+                const std::string language = def.get_language() ? CONVERT(char, string_type(*def.get_language())) : std::string();
+                if (language != "C" && language != "CXX")
+                    throw Exception<CharType, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Unknown language `" + language + "` of the runnable super define " + CONVERT(std::string, this->name) + " (expected `C` or `CXX`)");
+                this->is_cxx = language == "CXX";
+                if (this->tools.compiler.empty())
+                    this->tools = toolchain::of(language);
+                if (this->cache_dir.empty())
+                    this->cache_dir = RunnableLibrary::default_cache_dir();
+                this->source = RunnableLibrary::generate_source(def, this->is_cxx);
+                this->key = Util::hex(Util::fnv1a({ this->source, this->tools.compiler, this->tools.flags }, 0xcbf29ce484222325ULL)) +
+                            Util::hex(Util::fnv1a({ this->source, this->tools.compiler, this->tools.flags }, 0x84222325cbf29ce4ULL));
+            }
+
+            RunnableLibrary(const RunnableLibrary&) = delete;
+            RunnableLibrary& operator=(const RunnableLibrary&) = delete;
+
+            ~RunnableLibrary() noexcept
+            {
+#if SUPDEF_ON_UNIX
+                if (this->handle != nullptr)
+                    ::dlclose(this->handle);
+#endif
+            }
+
+            // `SUPDEF_RUNNABLE_CACHE_DIR_NAME` in the cache of the current user (empty if there is no private one)
+            static std::filesystem::path default_cache_dir(void)
             {
-                return this->included->get_path();
+                return Util::user_cache_dir(SUPDEF_RUNNABLE_CACHE_DIR_NAME);
             }
 
-            inline string_size_type<CharType> get_start() const noexcept
+            inline const std::string& get_source(void) const noexcept
             {
-                return std::get<0>(*this->pos);
+                return this->source;
             }
-            
-            inline string_size_type<CharType> get_end() const noexcept
+
+            inline std::filesystem::path get_library_path(void) const
             {
-                return std::get<1>(*this->pos);
+                return this->cache_dir / (this->key + ".so");
             }
 
-            inline void set_pos(std::shared_ptr<std::tuple<string_size_type<CharType>, string_size_type<CharType>>> pos) noexcept
+            // How long @ref load took (all zero before it is called)
+            inline timings get_timings(void) const noexcept
             {
-                this->pos = pos;
+                return this->load_timings;
             }
-    };
 
-    template <typename T>
-        requires CharacterType<T>
-    class Parser;
+            /**
+             * @brief Load the library, compiling it first if it isn't in the cache yet
+             * @details Done once (by the first invocation if not before), whatever the number of threads calling it
+             */
+            void load(void) const
+            {
+                std::call_once(this->loaded, [this]() -> void {
+#if SUPDEF_ON_UNIX
+                    const std::filesystem::path library = this->get_library_path();
+                    timings res;
+                    const auto start = std::chrono::steady_clock::now();
+                    // What is loaded runs in-process, so it must come from the current user only
+                    if (this->cache_dir.empty() || !Util::make_private_dir(this->cache_dir))
+                        throw Exception<CharType, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Could not compile the runnable super define " + CONVERT(std::string, this->name) + ": its cache directory `" + this->cache_dir.string() + "` is missing, not owned by the current user or writable by others");
+                    if (!std::filesystem::exists(std::filesystem::symlink_status(library)))
+                    {
+                        this->compile(library);
+                        res.compiled = true;
+                    }
+                    if (!Util::is_private_path(library, false))
+                        throw Exception<CharType, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Refusing to load the runnable super define " + CONVERT(std::string, this->name) + " from " + library.string() + ", which is not a file owned by the current user or is writable by others");
+                    const auto compiled = std::chrono::steady_clock::now();
+                    void* lib = ::dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+                    if (lib == nullptr)
+                        throw Exception<CharType, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Could not load the runnable super define " + CONVERT(std::string, this->name) + ": " + ::dlerror());
+                    void* sym = ::dlsym(lib, entry_name.data());
+                    void* call_sym = ::dlsym(lib, call_name.data());
+                    if (sym == nullptr || call_sym == nullptr)
+                    {
+                        ::dlclose(lib);
+                        throw Exception<CharType, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Invalid library for the runnable super define " + CONVERT(std::string, this->name) + ": " + library.string());
+                    }
+                    this->handle = lib;
+                    this->entry = reinterpret_cast<entry_type>(sym);
+                    this->call = reinterpret_cast<call_type>(call_sym);
+                    if (res.compiled)
+                        res.compile_time = compiled - start;
+                    res.load_time = std::chrono::steady_clock::now() - (res.compiled ? compiled : start);
+                    this->load_timings = res;
+#else
+                    throw Exception<CharType, std::filesystem::path>(ExcType::INTERNAL_ERROR, "Runnable super defines are not supported on this platform");
+#endif
+                });
+            }
 
-    template <typename T>
-    concept OutputFileStream = std::same_as<std::remove_cvref_t<T>, std::ofstream>                  ||
-                               std::same_as<std::remove_cvref_t<T>, std::wofstream>                 ||
-                               std::same_as<std::remove_cvref_t<T>, std::basic_ofstream<char8_t>>   ||
-                               std::same_as<std::remove_cvref_t<T>, std::basic_ofstream<char16_t>>  ||
-                               std::same_as<std::remove_cvref_t<T>, std::basic_ofstream<char32_t>>  ||
-                               std::same_as<std::remove_cvref_t<T>, std::basic_ofstream<std::byte>>;
+            /**
+             * @brief Run the super define once per element of @p batch, with a single call into the library
+             * @param batch The arguments of each invocation (at least as many as the super define has parameters)
+             * @return The expansion of each invocation
+             */
+            std::vector<string_type> run_batch(std::span<const args_type> batch) const
+            {
+                size_t total = 0;
+                for (const args_type& args : batch)
+                {
+                    this->check_argc(args);
+                    total += args.size();
+                }
+                this->load();
 
-    template <typename T>
-    concept InputFileStream = std::same_as<std::remove_cvref_t<T>, std::ifstream>                  ||
-                              std::same_as<std::remove_cvref_t<T>, std::wifstream>                 ||
-                              std::same_as<std::remove_cvref_t<T>, std::basic_ifstream<char8_t>>   ||
-                              std::same_as<std::remove_cvref_t<T>, std::basic_ifstream<char16_t>>  ||
-                              std::same_as<std::remove_cvref_t<T>, std::basic_ifstream<char32_t>>  ||
-                              std::same_as<std::remove_cvref_t<T>, std::basic_ifstream<std::byte>>;
+                std::vector<std::string> converted;
+                converted.reserve(total);
+                std::vector<size_t> argc;
+                argc.reserve(batch.size());
+                for (const args_type& args : batch)
+                {
+                    for (string_view_type arg : args)
+                        converted.push_back(CONVERT(char, string_type(arg)));
+                    argc.push_back(args.size());
+                }
+                std::vector<const char*> flat(total);
+                std::ranges::transform(converted, flat.begin(), [](const std::string& arg) { return arg.c_str(); });
+                std::vector<const char* const*> argv(batch.size());
+                for (size_t i = 0, offset = 0; i < batch.size(); offset += argc[i], ++i)
+                    argv[i] = flat.data() + offset;
 
-    template <typename T>
-    concept InputOutputStream = std::same_as<std::remove_cvref_t<T>, std::fstream>                  ||
-                                std::same_as<std::remove_cvref_t<T>, std::wfstream>                 ||
-                                std::same_as<std::remove_cvref_t<T>, std::basic_fstream<char8_t>>   ||
-                                std::same_as<std::remove_cvref_t<T>, std::basic_fstream<char16_t>>  ||
-                                std::same_as<std::remove_cvref_t<T>, std::basic_fstream<char32_t>>  ||
-                                std::same_as<std::remove_cvref_t<T>, std::basic_fstream<std::byte>>;
+                std::vector<std::string> outputs(batch.size());
+                this->entry(batch.size(), argc.data(), argv.data(), &RunnableLibrary::emit, std::addressof(outputs));
 
-    template <typename T>
-    concept FileStream = OutputFileStream<T> || InputFileStream<T> || InputOutputStream<T>;
+                std::vector<string_type> res;
+                res.reserve(outputs.size());
+                for (const std::string& output : outputs)
+                    res.push_back(CONVERT(CharType, output));
+                return res;
+            }
 
-#if 0
-    template <typename T, typename... Args>
-    concept HasGetlineMethod = requires(T&& t, Args&&... args)
-    {
-        { t.getline(std::forward<Args>(args)...) };
+            // Run the super define once, with the arguments @p args (what the expander does for each invocation)
+            string_type run(args_type args) const
+            {
+                this->check_argc(args);
+                this->load();
+
+                std::vector<std::string> converted;
+                converted.reserve(args.size());
+                for (string_view_type arg : args)
+                    converted.push_back(CONVERT(char, string_type(arg)));
+                std::vector<const char*> argv(args.size());
+                std::ranges::transform(converted, argv.begin(), [](const std::string& arg) { return arg.c_str(); });
+
+                std::string output;
+                this->call(args.size(), argv.data(), &RunnableLibrary::emit_one, std::addressof(output));
+                return CONVERT(CharType, output);
+            }
     };
 
-    template <typename T, typename... Args>
-    concept HasGetlineFunction = requires(T&& t, Args&&... args)
+    /**
+     * @class ExpansionCache
+     * @brief A cache of the expansions of super defines, keyed on the definition (its address) and the arguments of the invocation
+     * @details Once the memory taken by the cached expansions goes above a bound, the least recently used ones are evicted.
+     *          As definitions are told apart by their address, one cache serves all the scopes of a @class SymbolTable, where
+     *          the same name may have different definitions. Since an expansion is only valid as long as its definition is
+     *          neither modified nor destroyed, the expansions of a definition have to be dropped with @ref invalidate when it
+     *          is (which the symbol table does when it replaces a definition, and `Parser::apply_edit` for the super defines
+     *          an edit changes).
+     *          All the methods can be called from several threads at once.
+     * @tparam CharType The character type of the super defines
+     */
+    template <typename CharType>
+        requires CharacterType<CharType>
+    class ExpansionCache
     {
-        { std::getline(std::forward<T>(t), std::forward<Args>(args)...) };
-    };
+        public:
+            typedef std::basic_string<CharType> string_type;
+            typedef std::basic_string_view<CharType> string_view_type;
+            typedef std::span<const string_view_type> args_type;
 
-    // TODO: Fix bugs in File and File_StreamMethodsImpl
-    template <typename T>
-        requires FileStream<T>
-    struct File;
+        private:
+            struct entry
+            {
+                size_t hash;
+                const PragmaDef<CharType>* def;
+                string_type id;                     // The name of `def`, to invalidate its expansions by name
+                std::vector<string_type> args;
+                string_type expansion;
+                size_t memory;
+            };
+            typedef std::list<entry> entry_list;
+
+            mutable std::mutex mtx{};
+            entry_list entries;                                                     // Most recently used first
+            std::unordered_multimap<size_t, typename entry_list::iterator> index;   // Hash of the key -> entry
+            size_t max_memory;
+            size_t memory = 0;
+            size_t hit_count = 0;
+            size_t miss_count = 0;
+
+            static size_t hash_of(const PragmaDef<CharType>* def, args_type args) noexcept
+            {
+                std::hash<string_view_type> hasher{};
+                size_t result = std::hash<const PragmaDef<CharType>*>{}(def);
+                for (const string_view_type& arg : args)
+                    result ^= hasher(arg) + 0x9e3779b97f4a7c15ULL + (result << 6) + (result >> 2);
+                return result;
+            }
 
-    template <typename T, typename... Args>
-    struct File_StreamMethodsImplHelper {};
+            typename entry_list::iterator find(size_t hash, const PragmaDef<CharType>* def, args_type args)
+            {
+                auto [first, last] = this->index.equal_range(hash);
+                for (; first != last; ++first)
+                {
+                    const entry& e = *first->second;
+                    if (e.def == def && std::equal(args.begin(), args.end(), e.args.begin(), e.args.end()))
+                        return first->second;
+                }
+                return this->entries.end();
+            }
 
-    template <FileStream StreamType, typename... Args>
-        requires (!HasGetlineMethod<StreamType, Args...> && !HasGetlineFunction<StreamType, Args...>)
-    struct File_StreamMethodsImplHelper<StreamType, Args...>
-    {
-        // Return type of invoking std::getline(StreamType&, Args...)
-        using ResultOfGetline = void;
-    };
+        public:
+            /**
+             * @brief Construct an empty cache
+             * @param max_memory The memory (in bytes) the cached expansions may take before the least recently used ones are evicted
+             */
+            explicit ExpansionCache(size_t max_memory = SUPDEF_EXPANSION_CACHE_SIZE) : max_memory(max_memory)
+            { }
 
-    template <FileStream StreamType, typename... Args>
-        requires HasGetlineMethod<StreamType, Args...>
-    struct File_StreamMethodsImplHelper<StreamType, Args...>
-    {
-        // Return type of invoking std::getline(StreamType&, Args...)
-        using ResultOfGetline = decltype(std::declval<StreamType&>().getline(std::declval<Args>()...));
-    };
+            ExpansionCache(const ExpansionCache&) = delete;
+            ExpansionCache(ExpansionCache&&) = delete;
+            ExpansionCache& operator=(const ExpansionCache&) = delete;
+            ExpansionCache& operator=(ExpansionCache&&) = delete;
 
-    template <FileStream StreamType, typename... Args>
-        requires HasGetlineFunction<StreamType, Args...>
-    struct File_StreamMethodsImplHelper<StreamType, Args...>
-    {
-        // Return type of invoking std::getline(StreamType&, Args...)
-        using ResultOfGetline = decltype(std::getline(std::declval<StreamType&>(), std::declval<Args>()...));
-    };
+            ~ExpansionCache() = default;
 
-    template <typename T>
-    struct File_StreamMethodsImpl {};
+            /**
+             * @brief Get the expansion of @p def with the arguments @p args, substituting and caching it if it isn't cached yet
+             * @details The substitution itself is done without holding the lock of the cache, and @p args are only copied
+             *          when a new expansion is cached
+             */
+            string_type get(const PragmaDef<CharType>& def, args_type args)
+            {
+                const string_view_type id = *def.get_id();
+                const size_t hash = hash_of(std::addressof(def), args);
+                {
+                    std::lock_guard<std::mutex> lock(this->mtx);
+                    auto it = this->find(hash, std::addressof(def), args);
+                    if (it != this->entries.end())
+                    {
+                        ++this->hit_count;
+                        this->entries.splice(this->entries.begin(), this->entries, it);
+                        return it->expansion;
+                    }
+                    ++this->miss_count;
+                }
 
-    template <OutputFileStream StreamType>
-    struct File_StreamMethodsImpl<StreamType>
-    {
-        protected:
-            std::optional<StreamType>* stream_ptr;
-            typedef typename StreamType::char_type char_type;
+                string_type expansion = def.substitute(args);
+                size_t entry_memory = sizeof(entry) + (id.size() + expansion.size()) * sizeof(CharType);
+                for (const string_view_type& arg : args)
+                    entry_memory += arg.size() * sizeof(CharType);
 
-        public:
-            File_StreamMethodsImpl() = default;
-            File_StreamMethodsImpl(std::optional<StreamType>& stream_ref) : stream_ptr(std::addressof(stream_ref)) {}
-            File_StreamMethodsImpl(File<StreamType>& file) : stream_ptr(std::addressof(file.get_stream())) {}
-            File_StreamMethodsImpl(const File_StreamMethodsImpl&) = default;
-            File_StreamMethodsImpl(File_StreamMethodsImpl&&) = default;
-            ~File_StreamMethodsImpl() = default;
+                std::lock_guard<std::mutex> lock(this->mtx);
+                // Another thread may have expanded it in the meantime
+                if (entry_memory > this->max_memory || this->find(hash, std::addressof(def), args) != this->entries.end())
+                    return expansion;
+                this->entries.push_front(entry{ hash, std::addressof(def), string_type(id), std::vector<string_type>(args.begin(), args.end()), expansion, entry_memory });
+                this->index.emplace(hash, this->entries.begin());
+                this->memory += entry_memory;
+                this->evict();
+                return expansion;
+            }
 
-        protected:
-            inline StreamType& operator<<(const char_type* str)
+            template <typename... Args>
+                requires (std::convertible_to<const Args&, string_view_type> && ...)
+            string_type get(const PragmaDef<CharType>& def, const Args&... args)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) << str;
-                return *(*this->stream_ptr);
+                const std::array<string_view_type, sizeof...(Args)> views{ string_view_type(args)... };
+                return this->get(def, args_type(views));
             }
-            inline StreamType& operator<<(const std::basic_string<char_type>& str)
+
+            string_type get(const PragmaDef<CharType>& def, const std::vector<string_type>& args)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) << str;
-                return *(*this->stream_ptr);
+                const std::vector<string_view_type> views(args.begin(), args.end());
+                return this->get(def, args_type(views));
             }
-            inline StreamType& operator<<(const char_type& c)
+
+        private:
+            void erase(typename entry_list::iterator it)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) << c;
-                return *(*this->stream_ptr);
+                auto [first, last] = this->index.equal_range(it->hash);
+                for (; first != last; ++first)
+                {
+                    if (first->second == it)
+                    {
+                        this->index.erase(first);
+                        break;
+                    }
+                }
+                this->memory -= it->memory;
+                this->entries.erase(it);
             }
-            inline StreamType& operator<<(const std::basic_string_view<char_type>& str)
+
+            void evict(void)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) << str;
-                return *(*this->stream_ptr);
+                while (this->memory > this->max_memory && !this->entries.empty())
+                    this->erase(std::prev(this->entries.end()));
             }
 
-            // Delete operator>> and getline
-            template <typename U>
-            StreamType& operator>>(U&&) = delete;
-
-            template <typename U>
-            StreamType& getline(U&&) = delete;
-    };
-
-    template <InputFileStream StreamType>
-    struct File_StreamMethodsImpl<StreamType>
-    {
-        protected:
-            std::optional<StreamType>* stream_ptr;
-            typedef typename StreamType::char_type char_type;
-
         public:
-            File_StreamMethodsImpl() = default;
-            File_StreamMethodsImpl(std::optional<StreamType>& stream_ref) : stream_ptr(std::addressof(stream_ref)) {}
-            File_StreamMethodsImpl(File<StreamType>& file) : stream_ptr(std::addressof(file.get_stream())) {}
-            File_StreamMethodsImpl(const File_StreamMethodsImpl&) = default;
-            File_StreamMethodsImpl(File_StreamMethodsImpl&&) = default;
-            ~File_StreamMethodsImpl() = default;
+            // Drop the cached expansions of all the super defines named @p id
+            void invalidate(string_view_type id)
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                for (auto it = this->entries.begin(); it != this->entries.end(); )
+                {
+                    auto next = std::next(it);
+                    if (it->id == id)
+                        this->erase(it);
+                    it = next;
+                }
+            }
 
-        protected:
-            inline StreamType& operator>>(char_type* str)
+            // Drop the cached expansions of @p def
+            void invalidate(const PragmaDef<CharType>& def)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) >> str;
-                return *(*this->stream_ptr);
+                std::lock_guard<std::mutex> lock(this->mtx);
+                for (auto it = this->entries.begin(); it != this->entries.end(); )
+                {
+                    auto next = std::next(it);
+                    if (it->def == std::addressof(def))
+                        this->erase(it);
+                    it = next;
+                }
             }
-            inline StreamType& operator>>(std::basic_string<char_type>& str)
+
+            void clear(void)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) >> str;
-                return *(*this->stream_ptr);
+                std::lock_guard<std::mutex> lock(this->mtx);
+                this->entries.clear();
+                this->index.clear();
+                this->memory = 0;
             }
-            inline StreamType& operator>>(char_type& c)
+
+            void set_max_memory(size_t max_memory)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) >> c;
-                return *(*this->stream_ptr);
+                std::lock_guard<std::mutex> lock(this->mtx);
+                this->max_memory = max_memory;
+                this->evict();
             }
 
-            // Same as std::getline
-            inline typename File_StreamMethodsImplHelper<StreamType, char_type*, std::streamsize, char_type>::ResultOfGetline getline(char_type* str, std::streamsize count, char_type delim)
+            inline size_t get_max_memory(void) const
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use getline on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to getline on a File_StreamMethodsImpl object which has a closed stream");
-                return (*this->stream_ptr)->getline(str, count, delim);
+                std::lock_guard<std::mutex> lock(this->mtx);
+                return this->max_memory;
             }
-            inline typename File_StreamMethodsImplHelper<StreamType, std::basic_string<char_type>&, char_type>::ResultOfGetline getline(std::basic_string<char_type>& str, char_type delim)
+
+            // Memory (in bytes) taken by the cached expansions
+            inline size_t memory_usage(void) const
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to getline on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to getline on a File_StreamMethodsImpl object which has a closed stream");
-                return std::getline(*(*this->stream_ptr), str, delim);
+                std::lock_guard<std::mutex> lock(this->mtx);
+                return this->memory;
             }
-            inline typename File_StreamMethodsImplHelper<StreamType, std::basic_string<char_type>&>::ResultOfGetline getline(std::basic_string<char_type>& str)
+
+            inline size_t size(void) const
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to getline on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to getline on a File_StreamMethodsImpl object which has a closed stream");
-                return std::getline(*(*this->stream_ptr), str);
+                std::lock_guard<std::mutex> lock(this->mtx);
+                return this->entries.size();
             }
 
+            inline size_t hits(void) const
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                return this->hit_count;
+            }
 
-            // Delete operator<<
-            template <typename U>
-            StreamType& operator<<(U&&) = delete;
+            inline size_t misses(void) const
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                return this->miss_count;
+            }
     };
 
-    template <InputOutputStream StreamType>
-    struct File_StreamMethodsImpl<StreamType>
+    /**
+     * @class SymbolTable
+     * @brief The super defines known by an engine, indexed by name
+     * @details Names are interned once in an open-addressing hash table (with linear probing), and each of them maps to
+     *          the definitions of this name in every scope. A scope is the set of super defines of a source file, and
+     *          the scopes it imports are only referenced, not copied: a name is looked up in the scope itself, then in
+     *          its imports (depth first, in import order), then in the global scope.
+     *          The interned names and the definitions are allocated from an arena of the table, and stay at the same address
+     *          until @ref clear releases it at once, so the views and pointers returned by the table can be kept as long as
+     *          the table isn't cleared.
+     * @tparam CharType The character type of the super defines
+     */
+    template <typename CharType>
+        requires CharacterType<CharType>
+    class SymbolTable
     {
-        protected:
-            std::optional<StreamType>* stream_ptr;
-            typedef typename StreamType::char_type char_type;
-
         public:
-            File_StreamMethodsImpl() = default;
-            File_StreamMethodsImpl(std::optional<StreamType>& stream_ref) : stream_ptr(std::addressof(stream_ref)) {}
-            File_StreamMethodsImpl(File<StreamType>& file) : stream_ptr(std::addressof(file.get_stream())) {}
-            File_StreamMethodsImpl(const File_StreamMethodsImpl&) = default;
-            File_StreamMethodsImpl(File_StreamMethodsImpl&&) = default;
-            ~File_StreamMethodsImpl() = default;
+            typedef std::basic_string<CharType> string_type;
+            typedef std::basic_string_view<CharType> string_view_type;
+            typedef uint32_t scope_id;
 
-        protected:
-            inline StreamType& operator<<(const char_type* str)
+            static constexpr scope_id global_scope = 0;
+
+        private:
+            static constexpr uint32_t no_symbol = std::numeric_limits<uint32_t>::max();
+
+            struct slot
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) << str;
-                return *(*this->stream_ptr);
+                size_t hash = 0;
+                uint32_t symbol = no_symbol;
+            };
+
+            struct symbol
+            {
+                string_view_type name;
+                // Usually only one of them
+                std::vector<std::pair<scope_id, const PragmaDef<CharType>*>> defs;
+            };
+
+            mutable std::shared_mutex mtx{};
+            std::pmr::monotonic_buffer_resource arena;          // Storage of the interned names and of the definitions
+            std::vector<slot> slots;                            // Always a power of two of them
+            std::vector<symbol> symbols;
+            // Only made by the first definition, as even an empty deque holds memory from the arena
+            std::optional<std::pmr::deque<PragmaDef<CharType>>> definitions;
+            std::vector<std::vector<scope_id>> scope_imports;
+            ExpansionCache<CharType>* cache;                    // Where the expansions of the definitions it replaces are dropped from
+
+            // Index of the slot of @p name, or of the empty slot where it would be inserted
+            size_t probe(string_view_type name, size_t hash) const noexcept
+            {
+                const size_t mask = this->slots.size() - 1;
+                size_t i = hash & mask;
+                while (this->slots[i].symbol != no_symbol &&
+                       (this->slots[i].hash != hash || this->symbols[this->slots[i].symbol].name != name))
+                    i = (i + 1) & mask;
+                return i;
             }
-            inline StreamType& operator<<(const std::basic_string<char_type>& str)
+
+            void grow(void)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) << str;
-                return *(*this->stream_ptr);
+                std::vector<slot> old(this->slots.empty() ? 16 : 2 * this->slots.size());
+                old.swap(this->slots);
+                const size_t mask = this->slots.size() - 1;
+                for (const slot& s : old)
+                {
+                    if (s.symbol == no_symbol)
+                        continue;
+                    size_t i = s.hash & mask;
+                    while (this->slots[i].symbol != no_symbol)
+                        i = (i + 1) & mask;
+                    this->slots[i] = s;
+                }
             }
-            inline StreamType& operator<<(const char_type& c)
+
+            uint32_t index_of(string_view_type name) const noexcept
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) << c;
-                return *(*this->stream_ptr);
+                if (this->slots.empty())
+                    return no_symbol;
+                return this->slots[this->probe(name, std::hash<string_view_type>{}(name))].symbol;
             }
-            inline StreamType& operator<<(const std::basic_string_view<char_type>& str)
+
+            uint32_t intern_symbol(string_view_type name)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) << str;
-                return *(*this->stream_ptr);
+                // Keep the load factor under 0.75
+                if (4 * (this->symbols.size() + 1) > 3 * this->slots.size())
+                    this->grow();
+                const size_t hash = std::hash<string_view_type>{}(name);
+                slot& s = this->slots[this->probe(name, hash)];
+                if (s.symbol == no_symbol)
+                {
+                    s.hash = hash;
+                    s.symbol = static_cast<uint32_t>(this->symbols.size());
+                    CharType* stored = std::pmr::polymorphic_allocator<CharType>(std::addressof(this->arena)).allocate(name.size());
+                    std::copy(name.begin(), name.end(), stored);
+                    this->symbols.push_back(symbol{ string_view_type(stored, name.size()), {} });
+                }
+                return s.symbol;
             }
 
-            inline StreamType& operator>>(char_type* str)
+            const PragmaDef<CharType>* find_in(const symbol& sym, scope_id scope) const noexcept
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) >> str;
-                return *(*this->stream_ptr);
+                for (const auto& [def_scope, def] : sym.defs)
+                {
+                    if (def_scope == scope)
+                        return def;
+                }
+                return nullptr;
             }
-            inline StreamType& operator>>(std::basic_string<char_type>& str)
+
+        public:
+            /**
+             * @brief Construct an empty table
+             * @param upstream Where the arena of the table gets its memory from
+             * @param cache The cache of the expansions of its definitions, if any
+             */
+            explicit SymbolTable(std::pmr::memory_resource* upstream = std::pmr::get_default_resource(), ExpansionCache<CharType>* cache = nullptr)
+                : arena(upstream), definitions(), scope_imports(1), cache(cache)
+            { }
+
+            SymbolTable(const SymbolTable&) = delete;
+            SymbolTable(SymbolTable&&) = delete;
+            SymbolTable& operator=(const SymbolTable&) = delete;
+            SymbolTable& operator=(SymbolTable&&) = delete;
+
+            ~SymbolTable() = default;
+
+            /**
+             * @brief Intern @p name
+             * @return A view of the interned name, which is the same for all the names equal to @p name
+             */
+            string_view_type intern(string_view_type name)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) >> str;
-                return *(*this->stream_ptr);
+                std::unique_lock<std::shared_mutex> lock(this->mtx);
+                return this->symbols[this->intern_symbol(name)].name;
             }
-            inline StreamType& operator>>(char_type& c)
+
+            // Create a new scope (without any definition nor import)
+            scope_id add_scope(void)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
-                *(*this->stream_ptr) >> c;
-                return *(*this->stream_ptr);
+                std::unique_lock<std::shared_mutex> lock(this->mtx);
+                this->scope_imports.emplace_back();
+                return static_cast<scope_id>(this->scope_imports.size() - 1);
             }
 
-            // Same as std::getline()
-            inline typename File_StreamMethodsImplHelper<StreamType, char_type*, std::streamsize, char_type>::ResultOfGetline getline(char_type* str, std::streamsize count, char_type delim)
+            // Make the definitions of @p imported visible from @p scope, after the ones of its previous imports
+            void add_import(scope_id scope, scope_id imported)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has a closed stream");
-                return (*this->stream_ptr)->getline(str, count, delim);
+                std::unique_lock<std::shared_mutex> lock(this->mtx);
+                if (scope >= this->scope_imports.size() || imported >= this->scope_imports.size())
+                    throw InternalError("Invalid scope in symbol table");
+                this->scope_imports[scope].push_back(imported);
             }
-            inline typename File_StreamMethodsImplHelper<StreamType, std::basic_string<char_type>&, char_type>::ResultOfGetline getline(std::basic_string<char_type>& str, char_type delim)
+
+            /**
+             * @brief Define @p def in @p scope, replacing the super define of the same name in this scope if any
+             * @return Whether a previous definition was replaced (its expansions are then dropped from the cache of the table)
+             */
+            bool define(scope_id scope, const PragmaDef<CharType>& def)
+            {
+                std::unique_lock<std::shared_mutex> lock(this->mtx);
+                if (scope >= this->scope_imports.size())
+                    throw InternalError("Invalid scope in symbol table");
+                symbol& sym = this->symbols[this->intern_symbol(*def.get_id())];
+                if (!this->definitions)
+                    this->definitions.emplace(std::addressof(this->arena));
+                const PragmaDef<CharType>* stored = std::addressof(this->definitions->emplace_back(def));
+                for (auto& [def_scope, prev] : sym.defs)
+                {
+                    if (def_scope == scope)
+                    {
+                        if (this->cache != nullptr)
+                            this->cache->invalidate(*prev);
+                        prev = stored;
+                        return true;
+                    }
+                }
+                sym.defs.emplace_back(scope, stored);
+                return false;
+            }
+
+            // Remove the definition of @p name from @p scope, returning whether there was one
+            bool undefine(scope_id scope, string_view_type name)
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has a closed stream");
-                return std::getline(*(*this->stream_ptr), str, delim);
+                std::unique_lock<std::shared_mutex> lock(this->mtx);
+                const uint32_t index = this->index_of(name);
+                if (index == no_symbol)
+                    return false;
+                auto& defs = this->symbols[index].defs;
+                auto it = std::find_if(defs.begin(), defs.end(), [scope](const auto& d) { return d.first == scope; });
+                if (it == defs.end())
+                    return false;
+                if (this->cache != nullptr)
+                    this->cache->invalidate(*it->second);
+                defs.erase(it);
+                return true;
             }
-            inline typename File_StreamMethodsImplHelper<StreamType, std::basic_string<char_type>&>::ResultOfGetline getline(std::basic_string<char_type>& str)
+
+            // What `lookup` found
+            struct lookup_result
             {
-                if (!(*this->stream_ptr).has_value())
-                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has no stream");
-                if (!(*this->stream_ptr)->is_open())
-                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has a closed stream");
-                return std::getline(*(*this->stream_ptr), str);
+                const PragmaDef<CharType>* def = nullptr;
+                uint32_t id = 0;        // Index of the interned name, lower than `size()` (if `def` isn't `nullptr`)
+            };
+
+            /**
+             * @brief Find the super define named @p name visible from @p scope
+             * @return The definition (`nullptr` if there is none) and the index of its name
+             */
+            lookup_result lookup(scope_id scope, string_view_type name) const
+            {
+                std::shared_lock<std::shared_mutex> lock(this->mtx);
+                const uint32_t index = this->index_of(name);
+                if (index == no_symbol || scope >= this->scope_imports.size())
+                    return {};
+                const symbol& sym = this->symbols[index];
+                if (sym.defs.empty())
+                    return {};
+                if (const auto* def = this->find_in(sym, scope))
+                    return { def, index };
+
+                // Imports, depth first (an import cycle is only walked once)
+                std::vector<bool> visited(this->scope_imports.size(), false);
+                std::vector<std::pair<scope_id, size_t>> stack{ { scope, 0 } };
+                visited[scope] = true;
+                while (!stack.empty())
+                {
+                    auto& [curr, next_import] = stack.back();
+                    if (next_import == this->scope_imports[curr].size())
+                    {
+                        stack.pop_back();
+                        continue;
+                    }
+                    const scope_id imported = this->scope_imports[curr][next_import++];
+                    if (visited[imported])
+                        continue;
+                    visited[imported] = true;
+                    if (const auto* def = this->find_in(sym, imported))
+                        return { def, index };
+                    stack.emplace_back(imported, 0);
+                }
+                return { this->find_in(sym, global_scope), index };
+            }
+
+            // Same as `lookup`, without the index
+            inline const PragmaDef<CharType>* find(scope_id scope, string_view_type name) const
+            {
+                return this->lookup(scope, name).def;
+            }
+
+            /**
+             * @brief Drop all the names, definitions and scopes (invalidating the views and pointers returned so far)
+             * @details The table doesn't hold any memory of its upstream resource afterwards, so the upstream can be released too
+             */
+            void clear(void)
+            {
+                std::unique_lock<std::shared_mutex> lock(this->mtx);
+                this->slots.clear();
+                this->symbols.clear();
+                this->scope_imports.assign(1, {});
+                this->definitions.reset();
+                this->arena.release();
+            }
+
+            // Number of interned names
+            inline size_t size(void) const
+            {
+                std::shared_lock<std::shared_mutex> lock(this->mtx);
+                return this->symbols.size();
             }
     };
 
-    template <typename T>
-        requires FileStream<T>
-    struct File : private File_StreamMethodsImpl<T>
+    /**
+     * @class InvocationExpander
+     * @brief Write the content left by the parser to a stream, with the invocations of super defines expanded
+     * @details The content is scanned once. An identifier outside of string and character literals, naming a super define
+     *          visible from the scope and followed by a parenthesized list of arguments, is an invocation. Its arguments are
+     *          split on the commas outside of nested parentheses and literals, then trimmed.
+     *          An expansion is scanned for invocations in turn, with an explicit stack of the expansions being scanned (so
+     *          that deep nesting doesn't overflow the native stack). A super define invoked from its own expansion is a cycle,
+     *          found with one bit per interned name, and the nesting depth and the size of the expansions of a single
+     *          invocation of the content are bounded, so that every code unit is scanned once and the time taken is linear
+     *          in the size of the output.
+     *          The text between invocations is written straight from the content and the expansions, through a buffer of
+     *          `SUPDEF_EXPANDER_BUFFER_SIZE` code units (bypassed by larger spans), so the memory used is bounded by the
+     *          expansions being scanned rather than by the size of the output.
+     * @tparam CharType The character type of the content
+     */
+    template <typename CharType>
+        requires CharacterType<CharType>
+    class InvocationExpander
     {
         public:
-            typedef T stream_type;
-            typedef typename T::char_type char_type;
+            typedef std::basic_string<CharType> string_type;
+            typedef std::basic_string_view<CharType> string_view_type;
+            typedef typename SymbolTable<CharType>::scope_id scope_id;
 
         private:
-            std::filesystem::path path;
-            std::optional<stream_type> stream;
+            // Some text being scanned: the content itself (borrowed), or an expansion (owned)
+            struct frame
+            {
+                string_type storage;
+                string_view_type borrowed;
+                bool owned;
+                uint32_t id;                                // Index of the name of the super define expanded (if owned)
+                string_size_type<CharType> pos = 0;         // Where to scan from
+                string_size_type<CharType> written = 0;     // What is already written
 
-        public:
-            File() : File_StreamMethodsImpl<T>(*this), path(), stream(std::nullopt) {}
-            
-            File(std::filesystem::path&& p, std::ios_base::openmode mode) : File_StreamMethodsImpl<T>(*this), path(std::move(p)), stream(std::in_place, this->path, mode)
+                inline string_view_type text(void) const noexcept
+                {
+                    return this->owned ? string_view_type(this->storage) : this->borrowed;
+                }
+            };
+
+            // An invocation found by `find_invocation`
+            struct invocation
             {
-                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
-                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
-            }
-            File(std::filesystem::path& p, std::ios_base::openmode mode) : File_StreamMethodsImpl<T>(*this), path(p), stream(std::in_place, this->path, mode)
+                string_size_type<CharType> start;
+                string_size_type<CharType> end;
+                typename SymbolTable<CharType>::lookup_result found;
+            };
+
+            const SymbolTable<CharType>& symbols;
+            scope_id scope;
+            ExpansionCache<CharType>* cache;
+            size_t max_depth = SUPDEF_MAX_EXPANSION_DEPTH;
+            size_t max_size = SUPDEF_MAX_EXPANSION_SIZE;
+            std::basic_ostream<CharType>* out = nullptr;
+            string_type buffer;
+            std::vector<string_view_type> args;             // Views of the arguments of the last invocation found, in its text
+            std::vector<bool> expanding;                    // Whether each interned name is being expanded
+
+            static bool is_ident_char(const CharType& c) noexcept
             {
-                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
-                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
+                const uint32_t v = ::SupDef::Util::code_unit_value(c);
+                return (v >= 'a' && v <= 'z') || (v >= 'A' && v <= 'Z') || (v >= '0' && v <= '9') || v == '_' || v >= 0x80;
             }
-            
-            File(const File& other) = delete;
-            File(File&& other) : File_StreamMethodsImpl<T>(*this), path(std::move(other.path)), stream(std::move(other.stream))
+
+            static bool is_space(const CharType& c) noexcept
             {
-                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
-                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
+                return SAME(c, ' ') || SAME(c, '\t') || SAME(c, '\n') || SAME(c, '\r') || SAME(c, '\v') || SAME(c, '\f');
             }
 
-            File& operator=(const File& other) = delete;
-            File& operator=(File&& other)
+            // Position following the string or character literal starting at @p pos
+            static string_size_type<CharType> skip_literal(string_view_type content, string_size_type<CharType> pos) noexcept
             {
-                this->path = std::move(other.path);
-                this->stream = std::move(other.stream);
-                this->stream_ptr = std::addressof(this->stream);
-                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
-                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
-                return *this;
+                const CharType quote = content[pos];
+                for (++pos; pos < content.size(); ++pos)
+                {
+                    if (SAME(content[pos], '\\'))
+                        ++pos;
+                    else if (content[pos] == quote)
+                        return pos + 1;
+                }
+                return content.size();
             }
 
-            ~File() noexcept
+            static string_view_type trim(string_view_type str) noexcept
             {
-                if (this->stream.has_value() && this->stream->is_open())
-                    this->stream->close();
-                this->stream.reset();
+                while (!str.empty() && is_space(str.front()))
+                    str.remove_prefix(1);
+                while (!str.empty() && is_space(str.back()))
+                    str.remove_suffix(1);
+                return str;
             }
-            
-            constexpr inline std::filesystem::path& get_path() noexcept
+
+            /**
+             * @brief Parse the arguments of the invocation whose `(` is at @p pos
+             * @return The position following the matching `)`, or `npos` if there is none
+             */
+            static string_size_type<CharType> parse_args(string_view_type content, string_size_type<CharType> pos, std::vector<string_view_type>& args)
             {
-                return this->path;
+                size_t depth = 0;
+                string_size_type<CharType> arg_start = pos + 1;
+                while (pos < content.size())
+                {
+                    const CharType& c = content[pos];
+                    if (SAME(c, '"') || SAME(c, '\''))
+                    {
+                        pos = skip_literal(content, pos);
+                        continue;
+                    }
+                    if (SAME(c, '('))
+                        ++depth;
+                    else if (SAME(c, ')') || (SAME(c, ',') && depth == 1))
+                    {
+                        if (SAME(c, ')') && --depth != 0)
+                        {
+                            ++pos;
+                            continue;
+                        }
+                        args.push_back(trim(content.substr(arg_start, pos - arg_start)));
+                        arg_start = pos + 1;
+                        if (depth == 0)
+                        {
+                            // `NAME()` has no arguments
+                            if (args.size() == 1 && args.front().empty())
+                                args.clear();
+                            return pos + 1;
+                        }
+                    }
+                    ++pos;
+                }
+                return string_view_type::npos;
             }
 
-            constexpr inline std::optional<stream_type>& get_stream() noexcept
+            // Find the next invocation in @p text from @p pos, and parse its arguments into `args`
+            bool find_invocation(string_view_type text, string_size_type<CharType> pos, invocation& found)
             {
-                return this->stream;
+                while (pos < text.size())
+                {
+                    const CharType& c = text[pos];
+                    if (SAME(c, '"') || SAME(c, '\''))
+                    {
+                        pos = skip_literal(text, pos);
+                        continue;
+                    }
+                    if (!is_ident_char(c))
+                    {
+                        ++pos;
+                        continue;
+                    }
+                    const string_size_type<CharType> ident_start = pos;
+                    while (pos < text.size() && is_ident_char(text[pos]))
+                        ++pos;
+                    // A number
+                    if (::SupDef::Util::code_unit_value(text[ident_start]) - ::SupDef::Util::code_unit_value('0') < 10)
+                        continue;
+                    string_size_type<CharType> paren = pos;
+                    while (paren < text.size() && is_space(text[paren]))
+                        ++paren;
+                    if (paren == text.size() || DIFFERENT(text[paren], '('))
+                        continue;
+                    const string_view_type name = text.substr(ident_start, pos - ident_start);
+                    found.found = this->symbols.lookup(this->scope, name);
+                    if (found.found.def == nullptr)
+                        continue;
+
+                    this->args.clear();
+                    found.start = ident_start;
+                    found.end = parse_args(text, paren, this->args);
+                    if (found.end == string_view_type::npos)
+                        throw Exception<CharType, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Unterminated invocation of super define " + CONVERT(std::string, string_type(name)));
+                    return true;
+                }
+                return false;
             }
 
-            inline bool is_open() const noexcept
+            void flush(void)
             {
-                return this->stream.has_value() && this->stream->is_open();
+                this->out->write(this->buffer.data(), this->buffer.size());
+                this->buffer.clear();
             }
 
-            void restart()
+            void write(string_view_type str)
             {
-                this->path.clear();
-                if (this->stream.has_value() && this->stream->is_open())
-                    this->stream->close();
-                this->stream.reset();
-                this->stream_ptr = std::addressof(this->stream);
-                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
-                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
+                if (this->buffer.size() + str.size() > SUPDEF_EXPANDER_BUFFER_SIZE)
+                    this->flush();
+                if (str.size() >= SUPDEF_EXPANDER_BUFFER_SIZE)
+                    this->out->write(str.data(), str.size());
+                else
+                    this->buffer.append(str);
             }
 
-            void restart(std::filesystem::path&& p, std::ios_base::openmode mode)
+        public:
+            /**
+             * @param symbols The super defines that can be invoked
+             * @param scope The scope the invocations are looked up from
+             * @param cache Where to cache the expansions (none if `nullptr`)
+             */
+            InvocationExpander(const SymbolTable<CharType>& symbols, scope_id scope, ExpansionCache<CharType>* cache = nullptr)
+                : symbols(symbols), scope(scope), cache(cache)
+            { }
+
+            // Maximum number of nested expansions
+            inline void set_max_depth(size_t max_depth) noexcept
             {
-                this->restart();
-                this->path = std::move(p);
-                this->stream.emplace(this->path, mode);
-                this->stream_ptr = std::addressof(this->stream);
-                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
-                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
+                this->max_depth = max_depth;
             }
 
-            void close()
+            // Maximum size (in code units) of all the expansions done for a single invocation of the content
+            inline void set_max_size(size_t max_size) noexcept
             {
-                restart();
+                this->max_size = max_size;
             }
 
-            using File_StreamMethodsImpl<T>::operator<<;
-            using File_StreamMethodsImpl<T>::operator>>;
-            using File_StreamMethodsImpl<T>::getline;
+            /**
+             * @brief Write @p content to @p out, with the invocations of super defines expanded
+             * @return The number of invocations expanded (including the ones found in expansions)
+             */
+            size_t expand(string_view_type content, std::basic_ostream<CharType>& out)
+            {
+                this->out = std::addressof(out);
+                this->buffer.clear();
+                this->buffer.reserve(SUPDEF_EXPANDER_BUFFER_SIZE);
+                this->expanding.assign(this->symbols.size(), false);
+
+                size_t count = 0;
+                size_t expanded_size = 0;
+                std::vector<frame> stack;
+                stack.push_back(frame{ string_type(), content, false, 0 });
+                invocation found;
+                while (!stack.empty())
+                {
+                    frame& curr = stack.back();
+                    const string_view_type text = curr.text();
+                    if (!this->find_invocation(text, curr.pos, found))
+                    {
+                        this->write(text.substr(curr.written));
+                        if (curr.owned)
+                            this->expanding[curr.id] = false;
+                        stack.pop_back();
+                        continue;
+                    }
+                    this->write(text.substr(curr.written, found.start - curr.written));
+                    curr.pos = curr.written = found.end;
+
+                    const string_view_type name = *found.found.def->get_id();
+                    if (found.found.id >= this->expanding.size())
+                        this->expanding.resize(found.found.id + 1, false);
+                    if (this->expanding[found.found.id])
+                        throw Exception<CharType, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Super define " + CONVERT(std::string, string_type(name)) + " is invoked by its own expansion");
+                    if (stack.size() > this->max_depth)
+                        throw Exception<CharType, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Too many nested expansions (more than " + std::to_string(this->max_depth) + ") when expanding super define " + CONVERT(std::string, string_type(name)));
+
+                    const std::span<const string_view_type> args_span(this->args);
+                    string_type expansion = this->cache != nullptr ? this->cache->get(*found.found.def, args_span) : found.found.def->substitute(args_span);
+                    if (stack.size() == 1)
+                        expanded_size = 0;
+                    expanded_size += expansion.size();
+                    if (expanded_size > this->max_size)
+                        throw Exception<CharType, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Expansion too large (more than " + std::to_string(this->max_size) + " code units) when expanding super define " + CONVERT(std::string, string_type(name)));
+                    this->expanding[found.found.id] = true;
+                    ++count;
+                    stack.push_back(frame{ std::move(expansion), string_view_type(), true, found.found.id });
+                }
+                this->flush();
+                return count;
+            }
     };
-#else
-    template <typename StreamType, typename FilePathType = std::filesystem::path>
+
+    template <typename T, typename U>
+        requires CharacterType<T> && FilePath<U>
+    class SrcFile;
+
+    // TODO: Modify PragmaInc
+    template <typename CharType, typename FilePathType>
+        requires CharacterType<CharType> && FilePath<FilePathType>
+    struct PragmaInc
+    {
+        private:
+            std::shared_ptr<std::tuple<string_size_type<CharType>, string_size_type<CharType>>> pos;
+            std::shared_ptr<SrcFile<CharType, FilePathType>> included;
+
+        public:
+            typedef Util::pragma_loc_type<CharType> pragma_loc_type;
+            PragmaInc() = default;
+            ~PragmaInc() noexcept;
+            
+            template <typename PragLocType>
+                requires std::same_as<std::remove_cvref_t<PragLocType>, pragma_loc_type>
+            PragmaInc(PragLocType&& pragma_loc)
+            {
+                if constexpr (std::is_rvalue_reference_v<PragLocType&&>)
+                {
+                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(
+                        std::make_tuple(
+                            std::get<1>(std::move(pragma_loc)),
+                            std::get<2>(std::move(pragma_loc))
+                        )
+                    );
+                    this->included = std::make_shared<SrcFile<CharType, FilePathType>>(CONVERT(FilePathType, remove_whitespaces(std::get<0>(std::move(pragma_loc)))));
+                }
+                else
+                {
+                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(
+                        std::make_tuple(
+                            std::get<1>(pragma_loc),
+                            std::get<2>(pragma_loc)
+                        )
+                    );
+                    this->included = std::make_shared<SrcFile<CharType, FilePathType>>(CONVERT(FilePathType, remove_whitespaces(std::get<0>(pragma_loc))));
+                }
+            }
+            template <typename StdStringType, typename PosType>
+                requires std::same_as<std::remove_cvref_t<StdStringType>, std::basic_string<CharType>> &&
+                         std::same_as<std::remove_cvref_t<PosType>, std::tuple<string_size_type<CharType>, string_size_type<CharType>>>
+            PragmaInc(StdStringType&& path, PosType&& pos)
+            {
+                if constexpr (std::is_rvalue_reference_v<StdStringType&&>)
+                    this->included = std::make_shared<SrcFile<CharType, FilePathType>>(std::move(path));
+                else
+                    this->included = std::make_shared<SrcFile<CharType, FilePathType>>(path);
+                if constexpr (std::is_rvalue_reference_v<PosType&&>)
+                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(std::move(pos));
+                else
+                    this->pos = std::make_shared< std::tuple< string_size_type<CharType>, string_size_type<CharType> > >(pos);
+            }
+
+            PragmaInc(const PragmaInc&) = default;
+            PragmaInc(PragmaInc&&) = default;
+
+            PragmaInc& operator=(const PragmaInc&) = default;
+            PragmaInc& operator=(PragmaInc&&) = default;
+
+            inline auto get_pos() const noexcept
+            {
+                return this->pos;
+            }
+            
+            inline auto get_included() const noexcept
+            {
+                return this->included;
+            }
+
+            inline auto get_path() const noexcept
+            {
+                return this->included->get_path();
+            }
+
+            inline string_size_type<CharType> get_start() const noexcept
+            {
+                return std::get<0>(*this->pos);
+            }
+            
+            inline string_size_type<CharType> get_end() const noexcept
+            {
+                return std::get<1>(*this->pos);
+            }
+
+            inline void set_pos(std::shared_ptr<std::tuple<string_size_type<CharType>, string_size_type<CharType>>> pos) noexcept
+            {
+                this->pos = pos;
+            }
+    };
+
+    template <typename T>
+        requires CharacterType<T>
+    class Parser;
+
+    template <typename T>
+    concept OutputFileStream = std::same_as<std::remove_cvref_t<T>, std::ofstream>                  ||
+                               std::same_as<std::remove_cvref_t<T>, std::wofstream>                 ||
+                               std::same_as<std::remove_cvref_t<T>, std::basic_ofstream<char8_t>>   ||
+                               std::same_as<std::remove_cvref_t<T>, std::basic_ofstream<char16_t>>  ||
+                               std::same_as<std::remove_cvref_t<T>, std::basic_ofstream<char32_t>>  ||
+                               std::same_as<std::remove_cvref_t<T>, std::basic_ofstream<std::byte>>;
+
+    template <typename T>
+    concept InputFileStream = std::same_as<std::remove_cvref_t<T>, std::ifstream>                  ||
+                              std::same_as<std::remove_cvref_t<T>, std::wifstream>                 ||
+                              std::same_as<std::remove_cvref_t<T>, std::basic_ifstream<char8_t>>   ||
+                              std::same_as<std::remove_cvref_t<T>, std::basic_ifstream<char16_t>>  ||
+                              std::same_as<std::remove_cvref_t<T>, std::basic_ifstream<char32_t>>  ||
+                              std::same_as<std::remove_cvref_t<T>, std::basic_ifstream<std::byte>>;
+
+    template <typename T>
+    concept InputOutputStream = std::same_as<std::remove_cvref_t<T>, std::fstream>                  ||
+                                std::same_as<std::remove_cvref_t<T>, std::wfstream>                 ||
+                                std::same_as<std::remove_cvref_t<T>, std::basic_fstream<char8_t>>   ||
+                                std::same_as<std::remove_cvref_t<T>, std::basic_fstream<char16_t>>  ||
+                                std::same_as<std::remove_cvref_t<T>, std::basic_fstream<char32_t>>  ||
+                                std::same_as<std::remove_cvref_t<T>, std::basic_fstream<std::byte>>;
+
+    template <typename T>
+    concept FileStream = OutputFileStream<T> || InputFileStream<T> || InputOutputStream<T>;
+
+#if 0
+    template <typename T, typename... Args>
+    concept HasGetlineMethod = requires(T&& t, Args&&... args)
+    {
+        { t.getline(std::forward<Args>(args)...) };
+    };
+
+    template <typename T, typename... Args>
+    concept HasGetlineFunction = requires(T&& t, Args&&... args)
+    {
+        { std::getline(std::forward<T>(t), std::forward<Args>(args)...) };
+    };
+
+    // TODO: Fix bugs in File and File_StreamMethodsImpl
+    template <typename T>
+        requires FileStream<T>
+    struct File;
+
+    template <typename T, typename... Args>
+    struct File_StreamMethodsImplHelper {};
+
+    template <FileStream StreamType, typename... Args>
+        requires (!HasGetlineMethod<StreamType, Args...> && !HasGetlineFunction<StreamType, Args...>)
+    struct File_StreamMethodsImplHelper<StreamType, Args...>
+    {
+        // Return type of invoking std::getline(StreamType&, Args...)
+        using ResultOfGetline = void;
+    };
+
+    template <FileStream StreamType, typename... Args>
+        requires HasGetlineMethod<StreamType, Args...>
+    struct File_StreamMethodsImplHelper<StreamType, Args...>
+    {
+        // Return type of invoking std::getline(StreamType&, Args...)
+        using ResultOfGetline = decltype(std::declval<StreamType&>().getline(std::declval<Args>()...));
+    };
+
+    template <FileStream StreamType, typename... Args>
+        requires HasGetlineFunction<StreamType, Args...>
+    struct File_StreamMethodsImplHelper<StreamType, Args...>
+    {
+        // Return type of invoking std::getline(StreamType&, Args...)
+        using ResultOfGetline = decltype(std::getline(std::declval<StreamType&>(), std::declval<Args>()...));
+    };
+
+    template <typename T>
+    struct File_StreamMethodsImpl {};
+
+    template <OutputFileStream StreamType>
+    struct File_StreamMethodsImpl<StreamType>
+    {
+        protected:
+            std::optional<StreamType>* stream_ptr;
+            typedef typename StreamType::char_type char_type;
+
+        public:
+            File_StreamMethodsImpl() = default;
+            File_StreamMethodsImpl(std::optional<StreamType>& stream_ref) : stream_ptr(std::addressof(stream_ref)) {}
+            File_StreamMethodsImpl(File<StreamType>& file) : stream_ptr(std::addressof(file.get_stream())) {}
+            File_StreamMethodsImpl(const File_StreamMethodsImpl&) = default;
+            File_StreamMethodsImpl(File_StreamMethodsImpl&&) = default;
+            ~File_StreamMethodsImpl() = default;
+
+        protected:
+            inline StreamType& operator<<(const char_type* str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) << str;
+                return *(*this->stream_ptr);
+            }
+            inline StreamType& operator<<(const std::basic_string<char_type>& str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) << str;
+                return *(*this->stream_ptr);
+            }
+            inline StreamType& operator<<(const char_type& c)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) << c;
+                return *(*this->stream_ptr);
+            }
+            inline StreamType& operator<<(const std::basic_string_view<char_type>& str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) << str;
+                return *(*this->stream_ptr);
+            }
+
+            // Delete operator>> and getline
+            template <typename U>
+            StreamType& operator>>(U&&) = delete;
+
+            template <typename U>
+            StreamType& getline(U&&) = delete;
+    };
+
+    template <InputFileStream StreamType>
+    struct File_StreamMethodsImpl<StreamType>
+    {
+        protected:
+            std::optional<StreamType>* stream_ptr;
+            typedef typename StreamType::char_type char_type;
+
+        public:
+            File_StreamMethodsImpl() = default;
+            File_StreamMethodsImpl(std::optional<StreamType>& stream_ref) : stream_ptr(std::addressof(stream_ref)) {}
+            File_StreamMethodsImpl(File<StreamType>& file) : stream_ptr(std::addressof(file.get_stream())) {}
+            File_StreamMethodsImpl(const File_StreamMethodsImpl&) = default;
+            File_StreamMethodsImpl(File_StreamMethodsImpl&&) = default;
+            ~File_StreamMethodsImpl() = default;
+
+        protected:
+            inline StreamType& operator>>(char_type* str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) >> str;
+                return *(*this->stream_ptr);
+            }
+            inline StreamType& operator>>(std::basic_string<char_type>& str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) >> str;
+                return *(*this->stream_ptr);
+            }
+            inline StreamType& operator>>(char_type& c)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) >> c;
+                return *(*this->stream_ptr);
+            }
+
+            // Same as std::getline
+            inline typename File_StreamMethodsImplHelper<StreamType, char_type*, std::streamsize, char_type>::ResultOfGetline getline(char_type* str, std::streamsize count, char_type delim)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use getline on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to getline on a File_StreamMethodsImpl object which has a closed stream");
+                return (*this->stream_ptr)->getline(str, count, delim);
+            }
+            inline typename File_StreamMethodsImplHelper<StreamType, std::basic_string<char_type>&, char_type>::ResultOfGetline getline(std::basic_string<char_type>& str, char_type delim)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to getline on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to getline on a File_StreamMethodsImpl object which has a closed stream");
+                return std::getline(*(*this->stream_ptr), str, delim);
+            }
+            inline typename File_StreamMethodsImplHelper<StreamType, std::basic_string<char_type>&>::ResultOfGetline getline(std::basic_string<char_type>& str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to getline on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to getline on a File_StreamMethodsImpl object which has a closed stream");
+                return std::getline(*(*this->stream_ptr), str);
+            }
+
+
+            // Delete operator<<
+            template <typename U>
+            StreamType& operator<<(U&&) = delete;
+    };
+
+    template <InputOutputStream StreamType>
+    struct File_StreamMethodsImpl<StreamType>
+    {
+        protected:
+            std::optional<StreamType>* stream_ptr;
+            typedef typename StreamType::char_type char_type;
+
+        public:
+            File_StreamMethodsImpl() = default;
+            File_StreamMethodsImpl(std::optional<StreamType>& stream_ref) : stream_ptr(std::addressof(stream_ref)) {}
+            File_StreamMethodsImpl(File<StreamType>& file) : stream_ptr(std::addressof(file.get_stream())) {}
+            File_StreamMethodsImpl(const File_StreamMethodsImpl&) = default;
+            File_StreamMethodsImpl(File_StreamMethodsImpl&&) = default;
+            ~File_StreamMethodsImpl() = default;
+
+        protected:
+            inline StreamType& operator<<(const char_type* str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) << str;
+                return *(*this->stream_ptr);
+            }
+            inline StreamType& operator<<(const std::basic_string<char_type>& str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) << str;
+                return *(*this->stream_ptr);
+            }
+            inline StreamType& operator<<(const char_type& c)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) << c;
+                return *(*this->stream_ptr);
+            }
+            inline StreamType& operator<<(const std::basic_string_view<char_type>& str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator<< on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) << str;
+                return *(*this->stream_ptr);
+            }
+
+            inline StreamType& operator>>(char_type* str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) >> str;
+                return *(*this->stream_ptr);
+            }
+            inline StreamType& operator>>(std::basic_string<char_type>& str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) >> str;
+                return *(*this->stream_ptr);
+            }
+            inline StreamType& operator>>(char_type& c)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt to use operator>> on a File_StreamMethodsImpl object which has a closed stream");
+                *(*this->stream_ptr) >> c;
+                return *(*this->stream_ptr);
+            }
+
+            // Same as std::getline()
+            inline typename File_StreamMethodsImplHelper<StreamType, char_type*, std::streamsize, char_type>::ResultOfGetline getline(char_type* str, std::streamsize count, char_type delim)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has a closed stream");
+                return (*this->stream_ptr)->getline(str, count, delim);
+            }
+            inline typename File_StreamMethodsImplHelper<StreamType, std::basic_string<char_type>&, char_type>::ResultOfGetline getline(std::basic_string<char_type>& str, char_type delim)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has a closed stream");
+                return std::getline(*(*this->stream_ptr), str, delim);
+            }
+            inline typename File_StreamMethodsImplHelper<StreamType, std::basic_string<char_type>&>::ResultOfGetline getline(std::basic_string<char_type>& str)
+            {
+                if (!(*this->stream_ptr).has_value())
+                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has no stream");
+                if (!(*this->stream_ptr)->is_open())
+                    throw InternalError("Attempt getline on a File_StreamMethodsImpl object which has a closed stream");
+                return std::getline(*(*this->stream_ptr), str);
+            }
+    };
+
+    template <typename T>
+        requires FileStream<T>
+    struct File : private File_StreamMethodsImpl<T>
+    {
+        public:
+            typedef T stream_type;
+            typedef typename T::char_type char_type;
+
+        private:
+            std::filesystem::path path;
+            std::optional<stream_type> stream;
+
+        public:
+            File() : File_StreamMethodsImpl<T>(*this), path(), stream(std::nullopt) {}
+            
+            File(std::filesystem::path&& p, std::ios_base::openmode mode) : File_StreamMethodsImpl<T>(*this), path(std::move(p)), stream(std::in_place, this->path, mode)
+            {
+                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
+                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
+            }
+            File(std::filesystem::path& p, std::ios_base::openmode mode) : File_StreamMethodsImpl<T>(*this), path(p), stream(std::in_place, this->path, mode)
+            {
+                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
+                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
+            }
+            
+            File(const File& other) = delete;
+            File(File&& other) : File_StreamMethodsImpl<T>(*this), path(std::move(other.path)), stream(std::move(other.stream))
+            {
+                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
+                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
+            }
+
+            File& operator=(const File& other) = delete;
+            File& operator=(File&& other)
+            {
+                this->path = std::move(other.path);
+                this->stream = std::move(other.stream);
+                this->stream_ptr = std::addressof(this->stream);
+                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
+                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
+                return *this;
+            }
+
+            ~File() noexcept
+            {
+                if (this->stream.has_value() && this->stream->is_open())
+                    this->stream->close();
+                this->stream.reset();
+            }
+            
+            constexpr inline std::filesystem::path& get_path() noexcept
+            {
+                return this->path;
+            }
+
+            constexpr inline std::optional<stream_type>& get_stream() noexcept
+            {
+                return this->stream;
+            }
+
+            inline bool is_open() const noexcept
+            {
+                return this->stream.has_value() && this->stream->is_open();
+            }
+
+            void restart()
+            {
+                this->path.clear();
+                if (this->stream.has_value() && this->stream->is_open())
+                    this->stream->close();
+                this->stream.reset();
+                this->stream_ptr = std::addressof(this->stream);
+                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
+                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
+            }
+
+            void restart(std::filesystem::path&& p, std::ios_base::openmode mode)
+            {
+                this->restart();
+                this->path = std::move(p);
+                this->stream.emplace(this->path, mode);
+                this->stream_ptr = std::addressof(this->stream);
+                if (DIFFERENT_ANY(this->stream, (*this->stream_ptr)))
+                    throw InternalError("File_StreamMethodsImpl base class has a reference to a different stream than the one in the File class");
+            }
+
+            void close()
+            {
+                restart();
+            }
+
+            using File_StreamMethodsImpl<T>::operator<<;
+            using File_StreamMethodsImpl<T>::operator>>;
+            using File_StreamMethodsImpl<T>::getline;
+    };
+#else
+    template <typename StreamType, typename FilePathType = std::filesystem::path>
         requires FileStream<StreamType> && FilePath<FilePathType>
     class File : public StreamType
     {
         private:
-            FilePathType path;
+            FilePathType path;
+
+        public:
+            static constexpr bool output_filestream_p = OutputFileStream<StreamType> || InputOutputStream<StreamType>;
+            static constexpr bool input_filestream_p = InputFileStream<StreamType> || InputOutputStream<StreamType>;
+            static constexpr bool inputoutput_filestream_p = InputOutputStream<StreamType>;
+
+            File() : StreamType(), path() {}
+            
+            File(
+                FilePathType&& p,
+                std::ios_base::openmode mode = 
+                    std::conditional_t<
+                        bool(inputoutput_filestream_p),
+                        std::integral_constant<std::ios_base::openmode, std::ios_base::in | std::ios_base::out | std::ios_base::binary>,
+                        std::conditional_t<
+                            bool(output_filestream_p),
+                            std::integral_constant<std::ios_base::openmode, std::ios_base::out | std::ios_base::binary>,
+                            std::integral_constant<std::ios_base::openmode, std::ios_base::in | std::ios_base::binary>
+                        >
+                    >::value
+            ) : StreamType(std::move(p), mode), path(std::move(p))
+            { }
+            File(
+                const FilePathType& p,
+                std::ios_base::openmode mode = 
+                    std::conditional_t<
+                        bool(inputoutput_filestream_p),
+                        std::integral_constant<std::ios_base::openmode, std::ios_base::in | std::ios_base::out | std::ios_base::binary>,
+                        std::conditional_t<
+                            bool(output_filestream_p),
+                            std::integral_constant<std::ios_base::openmode, std::ios_base::out | std::ios_base::binary>,
+                            std::integral_constant<std::ios_base::openmode, std::ios_base::in | std::ios_base::binary>
+                        >
+                    >::value
+            ) : StreamType(p, mode), path(p)
+            { }
+
+            File(const File& other) = delete;
+            File(File&& other) : StreamType(std::move(other)), path(std::move(other.path))
+            { }
+
+            File& operator=(const File& other) = delete;
+            File& operator=(File&& other)
+            {
+                this->path = std::move(other.path);
+                return *this;
+            }
+
+            ~File() noexcept
+            {
+                this->restart();
+            }
+
+        protected:
+            virtual constexpr inline FilePathType& get_path() noexcept
+            {
+                return this->path;
+            }
+
+            virtual constexpr inline StreamType& get_stream() noexcept
+            {
+                return *this;
+            }
+
+        public:
+            virtual void restart()
+            {
+                this->path.clear();
+                if (this->is_open())
+                    this->StreamType::close();
+            }
+
+            virtual void restart(FilePathType&& p, std::ios_base::openmode mode)
+            {
+                this->restart();
+                FilePathType unconverted = p;
+                this->path = std::move(p);
+                this->open(CONVERT(std::filesystem::path, std::move(unconverted)), mode);
+            }
+
+            virtual void restart(const FilePathType& p, std::ios_base::openmode mode)
+            {
+                this->restart();
+                auto unconverted = p;
+                this->path = p;
+                this->open(CONVERT(std::filesystem::path, unconverted), mode);
+            }
+    };
+#endif
+
+    // TODO: Modify whole SrcFile implementation to use File as a base class
+#if 0
+    template <typename T, typename U>
+        requires CharacterType<T> && FilePath<U>
+    class SrcFile
+    {
+        private:
+            std::shared_ptr<U> path;
+            std::vector<PragmaDef<T>> super_defines;
+            std::vector<PragmaInc<T, U>> imports;
+
+        public:
+            std::unique_ptr<Parser<T>> parser;
+            std::unique_ptr<File<std::basic_ifstream<T>>> file;
+
+            SrcFile() = default;
+            SrcFile(U path) : path(std::make_shared<U>(path)),
+                              parser(std::make_unique<Parser<T>>(path)),
+                              file(std::make_unique<File<std::basic_ifstream<T>>>(path))
+            { }
+            SrcFile(SrcFile&& other) noexcept = default;
+            SrcFile(SrcFile& other) : path(other->get_path),
+                                      super_defines(other->get_super_defines()),
+                                      imports(other->get_imports()),
+                                      parser(std::make_unique<Parser<T>>(*(other->get_path()))),
+                                      file(std::make_unique<File<std::basic_ifstream<T>>>(*(other->get_path())))
+            { }
+            ~SrcFile() noexcept
+            {
+                if (this->file->is_open())
+                    this->file->get_stream()->close();
+            }
+
+            inline std::shared_ptr<U> get_path() const noexcept
+            {
+                return this->path;
+            }
+
+            inline std::vector<PragmaDef<T>> get_super_defines() const noexcept
+            {
+                return this->super_defines;
+            }
+
+            inline std::vector<PragmaInc<T, U>> get_imports() const noexcept
+            {
+                return this->imports;
+            }
+
+            inline void add_super_define(const PragmaDef<T>& super_define) noexcept
+            {
+                this->super_defines.push_back(super_define);
+            }
+
+            inline void add_include(const PragmaInc<T, U>& import) noexcept
+            {
+                this->imports.push_back(import);
+            }
+
+            inline void restart() noexcept
+            {
+                this->path.reset();
+                this->super_defines.clear();
+                this->imports.clear();
+                this->parser.reset();
+                this->file.reset();
+            }
+
+            inline void restart(U path) noexcept
+            {
+                this->restart();
+                this->path = std::make_shared<U>(path);
+                this->super_defines.clear();
+                this->imports.clear();
+                this->parser = std::make_unique<Parser<T>>(path);
+                this->file = std::make_unique<File<std::basic_ifstream<T>>>(path);
+            }
+
+            inline auto operator=(SrcFile&& other) noexcept
+            {
+                this->path = other.path;
+                this->super_defines = other.super_defines;
+                this->imports = other.imports;
+                this->parser = std::move(other.parser);
+                this->file = std::move(other.file);
+                return *this;
+            }
+    };
+#else
+    template <typename T = char, typename U = std::filesystem::path>
+        requires CharacterType<T> && FilePath<U>
+    class SrcFile : public File<std::basic_ifstream<T>, U>
+    {
+        private:
+            std::vector<PragmaDef<T>> super_defines;
+            std::vector<PragmaInc<T, U>> imports;
+
+            using Base = File<std::basic_ifstream<T>, U>;
+        public:
+            SrcFile() : Base(), super_defines(), imports() {}
+
+            template <typename PathType>
+                requires FilePath<PathType> && std::constructible_from<Base, PathType&&, std::ios_base::openmode>
+            SrcFile(
+                PathType&& p,
+                std::ios_base::openmode mode = (std::ios_base::in | std::ios_base::binary)
+            ) : Base(std::forward<PathType>(p), mode), super_defines(), imports()
+            { }
+            
+            SrcFile(SrcFile& other) = delete;
+            SrcFile(SrcFile&& other) noexcept = default;
+            
+            ~SrcFile() noexcept = default;
+            
+            inline std::vector<PragmaDef<T>>& get_super_defines() noexcept
+            {
+                return this->super_defines;
+            }
+            inline std::vector<PragmaInc<T, U>>& get_imports() noexcept
+            {
+                return this->imports;
+            }
+
+            inline void add_super_define(const PragmaDef<T>& super_define) noexcept
+            {
+                this->super_defines.push_back(super_define);
+            }
+            inline void add_include(const PragmaInc<T, U>& import) noexcept
+            {
+                this->imports.push_back(import);
+            }
+
+            inline void restart() override
+            {
+                this->Base::restart();
+                this->super_defines.clear();
+                this->imports.clear();
+            }
+
+            inline void restart(
+                U&& p,
+                std::ios_base::openmode mode = (std::ios_base::in | std::ios_base::binary)
+            ) override
+            {
+                if (mode & std::ios_base::out)
+                    throw InternalError("Attempt to open a SrcFile in write mode");
+                this->Base::restart(std::forward<U>(p), mode);
+                this->super_defines.clear();
+                this->imports.clear();
+            }
+
+            inline void restart(
+                const U& p,
+                std::ios_base::openmode mode = (std::ios_base::in | std::ios_base::binary)
+            ) override
+            {
+                if (mode & std::ios_base::out)
+                    throw InternalError("Attempt to open a SrcFile in write mode");
+                this->Base::restart(p, mode);
+                this->super_defines.clear();
+                this->imports.clear();
+            }
+
+            inline SrcFile& operator=(SrcFile&& other) noexcept
+            {
+                this->super_defines = std::move(other.super_defines);
+                this->imports = std::move(other.imports);
+                this->Base::operator=(std::move(other));
+                return *this;
+            }
+            inline SrcFile& operator=(SrcFile& other) = delete;
+
+#if 0
+            inline void close() override
+            {
+                this->restart();
+            }
+#endif
+    };
+#endif
+
+    // Must have the same behavior as std::less
+    template <typename T>
+        requires CharacterType<T>
+    class PragmaLocCompare
+    {
+        public:
+            using tuple_type = std::tuple<string_size_type<T>, string_size_type<T>>;
+
+            // Are the two tupled types in U convertible to string_size_type<T>?
+            template <typename U>
+                requires SPECIALIZATION_OF(U, std::tuple)
+            using convertible_tuple = std::conjunction<
+                std::is_convertible<std::tuple_element_t<0, std::remove_cvref_t<U>>, string_size_type<T>>,
+                std::is_convertible<std::tuple_element_t<1, std::remove_cvref_t<U>>, string_size_type<T>>
+            >;
+
+            static_assert(convertible_tuple<std::tuple<string_size_type<char>, string_size_type<char>>>::value);
+            static_assert(convertible_tuple<std::tuple<int, int>>::value);
+            static_assert(convertible_tuple<std::tuple<int, string_size_type<char>>>::value);
+            static_assert(convertible_tuple<std::tuple<string_size_type<char>, int>>::value);
+
+            template <typename U>
+                requires SPECIALIZATION_OF(U, std::tuple)
+            static constexpr bool convertible_tuple_v = convertible_tuple<U>::value;
+            
+            enum : uint8_t
+            {
+                START = 1 << 0,
+                END = 1 << 1,
+                BOTH = START | END
+            };
+
+            template <typename U>
+                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
+            static constexpr inline bool eq(const U&& lhs, const U&& rhs, uint8_t flags = BOTH) noexcept
+            {
+                if (flags & BOTH)
+                    return std::get<0>(lhs) == std::get<0>(rhs) && std::get<1>(lhs) == std::get<1>(rhs);
+                else if (flags & START)
+                    return std::get<0>(lhs) == std::get<0>(rhs);
+                else if (flags & END)
+                    return std::get<1>(lhs) == std::get<1>(rhs);
+                else
+                    return false;
+            }
+
+            template <typename U>
+                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
+            static constexpr inline bool lt(const U&& lhs, const U&& rhs, uint8_t flags = BOTH) noexcept
+            {
+                if (flags & BOTH)
+                    return std::get<0>(lhs) < std::get<0>(rhs) && std::get<1>(lhs) < std::get<1>(rhs);
+                else if (flags & START)
+                    return std::get<0>(lhs) < std::get<0>(rhs);
+                else if (flags & END)
+                    return std::get<1>(lhs) < std::get<1>(rhs);
+                else
+                    return false;
+            }
+
+            template <typename U>
+                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
+            static constexpr inline bool gt(const U&& lhs, const U&& rhs, uint8_t flags = BOTH) noexcept
+            {
+                if (flags & BOTH)
+                    return std::get<0>(lhs) > std::get<0>(rhs) && std::get<1>(lhs) > std::get<1>(rhs);
+                else if (flags & START)
+                    return std::get<0>(lhs) > std::get<0>(rhs);
+                else if (flags & END)
+                    return std::get<1>(lhs) > std::get<1>(rhs);
+                else
+                    return false;
+            }
+
+            template <typename U>
+                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
+            static constexpr inline bool le(const U&& lhs, const U&& rhs, uint8_t flags = BOTH) noexcept
+            {
+                if (flags & BOTH)
+                    return std::get<0>(lhs) <= std::get<0>(rhs) && std::get<1>(lhs) <= std::get<1>(rhs);
+                else if (flags & START)
+                    return std::get<0>(lhs) <= std::get<0>(rhs);
+                else if (flags & END)
+                    return std::get<1>(lhs) <= std::get<1>(rhs);
+                else
+                    return false;
+            }
+
+            template <typename U>
+                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
+            static constexpr inline bool ge(const U&& lhs, const U&& rhs, uint8_t flags = BOTH) noexcept
+            {
+                if (flags & BOTH)
+                    return std::get<0>(lhs) >= std::get<0>(rhs) && std::get<1>(lhs) >= std::get<1>(rhs);
+                else if (flags & START)
+                    return std::get<0>(lhs) >= std::get<0>(rhs);
+                else if (flags & END)
+                    return std::get<1>(lhs) >= std::get<1>(rhs);
+                else
+                    return false;
+            }
+
+#if 0
+            template <typename U>
+                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
+            using helper_func_type1 = bool (*)(const U&&, const U&&, uint8_t);
+
+            template <typename U>
+                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
+            using helper_func_type2 = std::function<bool(const U&&, const U&&, uint8_t)>;
+#endif
+
+            template <typename U, typename Fn>
+                requires (std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>) && std::invocable<Fn, const U&&, const U&&, uint8_t>
+            constexpr inline bool operator()(Fn&& func, const U&& lhs, const U&& rhs, uint8_t flags = BOTH) const
+                noexcept(
+                    noexcept(func(std::forward<const U>(lhs), std::forward<const U>(rhs), flags))
+                )
+            {
+                return func(std::forward<const U>(lhs), std::forward<const U>(rhs), flags);
+            }
+
+            template <typename U, typename Fn>
+                requires (std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>) && std::invocable<Fn, const U&&, const U&&, uint8_t>
+            struct Comparator
+            {
+                Fn func;
+                uint8_t flags;
+
+                Comparator(Fn&& func, uint8_t flags = BOTH) : func(std::forward<Fn>(func)), flags(flags) {}
+                Comparator(const Fn& func, uint8_t flags = BOTH) : func(func), flags(flags) {}
+
+                constexpr inline bool operator()(const U&& lhs, const U&& rhs) const
+                    noexcept(
+                        noexcept(func(std::forward<const U>(lhs), std::forward<const U>(rhs), flags))
+                    )
+                {
+                    return func(std::forward<const U>(lhs), std::forward<const U>(rhs), flags);
+                }
+            };
+
+            template <typename U, typename Fn>
+                requires (std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>) && std::invocable<Fn, const U&&, const U&&, uint8_t>
+            static constexpr inline Comparator<U, Fn> make_comparator(Fn&& func, uint8_t flags = BOTH)
+            {
+                return Comparator<U, Fn>(std::forward<Fn>(func), flags);
+            }
+    };
+
+    static_assert(PragmaLocCompare<char>::eq(std::make_tuple(0, 0), std::make_tuple(0, 0)));
+    static_assert(PragmaLocCompare<char>::lt(std::make_tuple(0, 0), std::make_tuple(2, 3)));
+    static_assert(!PragmaLocCompare<char>::gt(std::make_tuple(0, 1), std::make_tuple(0, 0)));
+    static_assert(PragmaLocCompare<char>()([](auto&& lhs, auto&& rhs, uint8_t flags) { return PragmaLocCompare<char>::eq(std::forward<decltype(lhs)>(lhs), std::forward<decltype(rhs)>(rhs), flags); }, std::make_tuple(0, 0), std::make_tuple(0, 0)));
+
+#ifdef PRAGLOC_COMPARE_REL
+    #undef PRAGLOC_COMPARE_REL
+#endif
+#define PRAGLOC_COMPARE_REL(TP, OP, TUPLE1, TUPLE2, ...) (::SupDef::PragmaLocCompare<TP>::OP((TUPLE1), (TUPLE2) __VA_OPT__(,) __VA_ARGS__))
+
+    static_assert(PRAGLOC_COMPARE_REL(char, eq, std::make_tuple(0, 0), std::make_tuple(0, 0)));
+    static_assert(PRAGLOC_COMPARE_REL(char, lt, std::make_tuple(0, 0), std::make_tuple(2, 3)));
+    static_assert(!PRAGLOC_COMPARE_REL(char, gt, std::make_tuple(0, 1), std::make_tuple(0, 0)));
+
+#ifdef PRAGLOC_COMPARE_FN
+    #undef PRAGLOC_COMPARE_FN
+#endif
+#define PRAGLOC_COMPARE_FN(TP, FN, TUPLE1, TUPLE2, ...) (::SupDef::PragmaLocCompare<TP>()((FN), (TUPLE1), (TUPLE2) __VA_OPT__(,) __VA_ARGS__))
+    
+    static_assert(PRAGLOC_COMPARE_FN(char, [](auto&& lhs, auto&& rhs, uint8_t flags) { return PRAGLOC_COMPARE_REL(char, eq, std::forward<decltype(lhs)>(lhs), std::forward<decltype(rhs)>(rhs), flags); }, std::make_tuple(0, 0), std::make_tuple(0, 0)));
+
+#ifdef PRAGLOC_COMPARATOR_FN
+    #undef PRAGLOC_COMPARATOR_FN
+#endif
+#define PRAGLOC_COMPARATOR_FN(TP_CHAR, TP_TUPLED, FN, ...) (::SupDef::PragmaLocCompare<TP_CHAR>::template make_comparator<std::tuple<TP_TUPLED, TP_TUPLED>>((FN) __VA_OPT__(,) __VA_ARGS__))
+
+#ifdef PRAGLOC_COMPARATOR_REL
+    #undef PRAGLOC_COMPARATOR_REL
+#endif
+#define PRAGLOC_COMPARATOR_REL(TP_CHAR, TP_TUPLED, OP, ...) (PRAGLOC_COMPARATOR_FN(TP_CHAR, TP_TUPLED, [](auto&& lhs, auto&& rhs, uint8_t flags) { return PRAGLOC_COMPARE_REL(TP_CHAR, OP, std::forward<decltype(lhs)>(lhs), std::forward<decltype(rhs)>(rhs), flags); } __VA_OPT__(,) __VA_ARGS__))
+
+    /**
+     * @enum PragmaKind
+     * @brief The kind of SupDef pragma found on a line by a @class PragmaLexer
+     * @details Each kind (except `NONE`) corresponds to one of the `SUPDEF_PRAGMA_*_REGEX` regexes of `config.h`
+     */
+    enum class PragmaKind : uint8_t
+    {
+        NONE = 0,
+        DEF_BEGIN,                  // `SUPDEF_PRAGMA_DEF_BEG_REGEX` or `SUPDEF_PRAGMA_RUNNABLE_DEF_BEG_REGEX`
+        DEF_END,                    // `SUPDEF_PRAGMA_DEF_END_REGEX`
+        IMPORT,                     // `SUPDEF_PRAGMA_IMPORT_REGEX`
+        IMPORT_ANGLE_BRACKETS,      // `SUPDEF_PRAGMA_IMPORT_REGEX_ANGLE_BRACKETS`
+        IMPORT_NO_QUOTES,           // `SUPDEF_PRAGMA_IMPORT_REGEX_NO_QUOTES`
+        IMPORT_NO_PATH,             // `SUPDEF_PRAGMA_IMPORT_REGEX_NO_PATH`
+        IMPORT_WITH_ANYTHING,       // `SUPDEF_PRAGMA_IMPORT_REGEX_WITH_ANYTHING`
+        IF,                         // `SUPDEF_PRAGMA_IF_REGEX`
+        ELSE,                       // `SUPDEF_PRAGMA_ELSE_REGEX`
+        IF_END                      // `SUPDEF_PRAGMA_IF_END_REGEX`
+    };
+
+    /**
+     * @struct PragmaToken
+     * @brief The result of lexing one line with a @class PragmaLexer
+     * @tparam T The character type of the lexed line
+     */
+    template <typename T>
+        requires CharacterType<T>
+    struct PragmaToken
+    {
+        PragmaKind kind = PragmaKind::NONE;
+        string_size_type<T> keyword_pos = 0; // Position of the `begin` / `end` / `import` keyword in the line
+        string_size_type<T> arg_pos = 0;     // Position of what the first capture group of the equivalent regex would have matched
+        string_size_type<T> arg_len = 0;     // Length of what the first capture group of the equivalent regex would have matched
+        string_size_type<T> lang_pos = 0;    // Position of the language of a runnable super define (`C` or `CXX`)
+        string_size_type<T> lang_len = 0;    // Length of the language of a runnable super define (0 for any other pragma)
+
+        constexpr inline explicit operator bool() const noexcept
+        {
+            return this->kind != PragmaKind::NONE;
+        }
+
+        constexpr inline std::basic_string_view<T> arg(std::basic_string_view<T> line) const noexcept
+        {
+            return line.substr(this->arg_pos, this->arg_len);
+        }
+
+        constexpr inline std::basic_string_view<T> lang(std::basic_string_view<T> line) const noexcept
+        {
+            return line.substr(this->lang_pos, this->lang_len);
+        }
+    };
+
+    /**
+     * @class PragmaLexer
+     * @brief A hand-written, table-driven lexer recognizing SupDef pragmas
+     * @tparam T The character type of the lexed lines (char, wchar_t, char8_t, char16_t, char32_t)
+     * @details Recognizes exactly the same lines as the `SUPDEF_PRAGMA_*_REGEX` regexes of `config.h` (with the same
+     * priority as the one used by @class Parser), in a single forward pass and without any allocation.
+     * `\s` and `\w` are matched as in the classic "C" locale, i.e. only ASCII code units belong to them.
+     */
+    template <typename T>
+        requires CharacterType<T>
+    class PragmaLexer
+    {
+        public:
+            typedef std::basic_string_view<T> string_view_type;
+            typedef string_size_type<T> size_type;
+            typedef PragmaToken<T> token_type;
+
+            static token_type lex_line(string_view_type line) noexcept;
+
+        private:
+            enum CharClass : uint8_t
+            {
+                OTHER       = 0,
+                SPACE       = 1 << 0, // `\s`
+                WORD        = 1 << 1, // `\w`
+                LINE_TERM   = 1 << 2  // What `.` does not match
+            };
+
+            static constexpr std::array<uint8_t, 128> char_classes = []() consteval {
+                std::array<uint8_t, 128> res{};
+                for (char c : { ' ', '\t', '\n', '\v', '\f', '\r' })
+                    res[static_cast<size_t>(c)] |= SPACE;
+                for (char c = 'a'; c <= 'z'; ++c)
+                    res[static_cast<size_t>(c)] |= WORD;
+                for (char c = 'A'; c <= 'Z'; ++c)
+                    res[static_cast<size_t>(c)] |= WORD;
+                for (char c = '0'; c <= '9'; ++c)
+                    res[static_cast<size_t>(c)] |= WORD;
+                res[static_cast<size_t>('_')] |= WORD;
+                res[static_cast<size_t>('\n')] |= LINE_TERM;
+                res[static_cast<size_t>('\r')] |= LINE_TERM;
+                return res;
+            }();
+
+            static constexpr inline uint8_t classify(T c) noexcept;
+            static constexpr inline bool is(T c, char ascii) noexcept;
+            static constexpr inline size_type skip_class(string_view_type line, size_type pos, uint8_t cls) noexcept;
+            static constexpr inline size_type skip_not_class(string_view_type line, size_type pos, uint8_t cls) noexcept;
+            static constexpr inline size_type skip_chars(string_view_type line, size_type pos, std::string_view ascii_set) noexcept;
+            static constexpr inline size_type find_char(string_view_type line, size_type pos, char ascii) noexcept;
+            static constexpr inline bool match_keyword(string_view_type line, size_type pos, std::string_view kwd) noexcept;
+
+            static token_type lex_def(string_view_type line, size_type kwd_pos, size_type kwd_len, PragmaKind kind) noexcept;
+            static token_type lex_runnable(string_view_type line, size_type kwd_pos) noexcept;
+            static token_type lex_import(string_view_type line, size_type kwd_pos) noexcept;
+            static token_type lex_cond(string_view_type line, size_type kwd_pos, size_type kwd_len, PragmaKind kind) noexcept;
+    };
 
+    /**
+     * @class PragmaGrammar
+     * @brief The `SUPDEF_PRAGMA_*_REGEX` regexes of `config.h`, compiled once per character type
+     * @tparam T The character type of the lexed lines (char, wchar_t, char8_t, char16_t, char32_t)
+     * @details There is a single (immutable) instance per character type, shared by every @class Parser
+     * and every thread. It is only used to lex lines when `SUPDEF_PRAGMA_USE_REGEX` is set, since otherwise
+     * @class PragmaLexer implements the exact same grammar without any regex.
+     */
+    template <typename T>
+        requires CharacterType<T>
+    class PragmaGrammar
+    {
         public:
-            static constexpr bool output_filestream_p = OutputFileStream<StreamType> || InputOutputStream<StreamType>;
-            static constexpr bool input_filestream_p = InputFileStream<StreamType> || InputOutputStream<StreamType>;
-            static constexpr bool inputoutput_filestream_p = InputOutputStream<StreamType>;
+            typedef std::basic_string_view<T> string_view_type;
+            // The standard library only provides the `std::regex_traits` of `char` and `wchar_t`
+            typedef std::conditional_t<sizeof(T) == 1, char, wchar_t> regex_char_type;
+            typedef std::basic_regex<regex_char_type> regex_type;
+            typedef PragmaToken<T> token_type;
+
+            PragmaGrammar(const PragmaGrammar&) = delete;
+            PragmaGrammar& operator=(const PragmaGrammar&) = delete;
+
+            static const PragmaGrammar& get();
+
+            token_type lex_line(string_view_type line) const;
+
+        private:
+            struct rule
+            {
+                PragmaKind kind;
+                std::basic_string<regex_char_type> keyword;
+                regex_type regex;
+                size_t arg_group = 1;       // Capture group of the argument
+                size_t lang_group = 0;      // Capture group of the language of a runnable super define (none if 0)
+            };
+
+            // Same order as the one @class PragmaLexer gives them priority in
+            std::vector<rule> rules;
+
+            PragmaGrammar();
+    };
+
+#undef NEED_PragmaLexer_TEMPLATES
+#define NEED_PragmaLexer_TEMPLATES 1
+#include <sup_def/common/pragma_lexer.cpp>
+
+#if SUPDEF_WORKAROUND_GCC_INTERNAL_ERROR
+    template <typename T>
+        requires CharacterType<T>
+    Coro<Result<std::shared_ptr<std::basic_string<T>>, Error<T, std::filesystem::path>>> search_imports(Parser<T>& parser);
+#endif
+    /**
+     * @class ConditionalTree
+     * @brief The `#pragma supdef if` / `else` / `end` structure of the content left by the parser, parsed once
+     * @details The nodes are stored in pre-order: a condition is followed by the nodes of its `if` branch, then by the nodes
+     *          of its `else` branch, and knows where both end. Consecutive lines without any conditional pragma form a single
+     *          text node (so content without any conditional is a single node), and the conditional pragma lines themselves
+     *          are dropped. Walking the tree only visits the branches taken, so the lines of the others are never scanned
+     *          for invocations.
+     * @tparam CharType The character type of the content
+     */
+    template <typename CharType>
+        requires CharacterType<CharType>
+    class ConditionalTree
+    {
+        public:
+            typedef std::basic_string_view<CharType> string_view_type;
+
+            enum class node_kind : uint8_t
+            {
+                TEXT = 0,
+                CONDITION
+            };
 
-            File() : StreamType(), path() {}
-            
-            File(
-                FilePathType&& p,
-                std::ios_base::openmode mode = 
-                    std::conditional_t<
-                        bool(inputoutput_filestream_p),
-                        std::integral_constant<std::ios_base::openmode, std::ios_base::in | std::ios_base::out | std::ios_base::binary>,
-                        std::conditional_t<
-                            bool(output_filestream_p),
-                            std::integral_constant<std::ios_base::openmode, std::ios_base::out | std::ios_base::binary>,
-                            std::integral_constant<std::ios_base::openmode, std::ios_base::in | std::ios_base::binary>
-                        >
-                    >::value
-            ) : StreamType(std::move(p), mode), path(std::move(p))
-            { }
-            File(
-                const FilePathType& p,
-                std::ios_base::openmode mode = 
-                    std::conditional_t<
-                        bool(inputoutput_filestream_p),
-                        std::integral_constant<std::ios_base::openmode, std::ios_base::in | std::ios_base::out | std::ios_base::binary>,
-                        std::conditional_t<
-                            bool(output_filestream_p),
-                            std::integral_constant<std::ios_base::openmode, std::ios_base::out | std::ios_base::binary>,
-                            std::integral_constant<std::ios_base::openmode, std::ios_base::in | std::ios_base::binary>
-                        >
-                    >::value
-            ) : StreamType(p, mode), path(p)
-            { }
+            struct node
+            {
+                node_kind kind;
+                string_size_type<CharType> offset;      // Of the text (with its `\n`s), or of the condition, in the content
+                string_size_type<CharType> size;
+                size_t line;                            // Line of the node in the content (from 1)
+                size_t else_begin = 0;                  // Index of the first node of the `else` branch (if a condition)
+                size_t end = 0;                         // Index following the last node of the `else` branch (if a condition)
+            };
 
-            File(const File& other) = delete;
-            File(File&& other) : StreamType(std::move(other)), path(std::move(other.path))
-            { }
+        private:
+            string_view_type content;
+            std::vector<node> nodes;
 
-            File& operator=(const File& other) = delete;
-            File& operator=(File&& other)
+            static PragmaToken<CharType> lex(string_view_type line)
             {
-                this->path = std::move(other.path);
-                return *this;
+#if SUPDEF_PRAGMA_USE_REGEX
+                return PragmaGrammar<CharType>::get().lex_line(line);
+#else
+                return PragmaLexer<CharType>::lex_line(line);
+#endif
             }
 
-            ~File() noexcept
+            [[noreturn]] static void fail(const std::string& msg, size_t line, string_view_type context)
             {
-                this->restart();
+                throw Exception<CharType, std::filesystem::path>(ExcType::SYNTAX_ERROR, msg, line, 1, std::basic_string<CharType>(context));
             }
 
-        protected:
-            virtual constexpr inline FilePathType& get_path() noexcept
+        public:
+            ConditionalTree() = default;
+
+            // The nodes keep views of @p content, which must outlive the tree
+            explicit ConditionalTree(string_view_type content)
             {
-                return this->path;
+                this->parse(content);
             }
 
-            virtual constexpr inline StreamType& get_stream() noexcept
+            /**
+             * @brief Build the tree of @p content
+             * @details Throws a syntax error on an `else` or an `end` without a matching `if`, on a second `else` for the same
+             *          `if`, and on an `if` left open at the end of @p content
+             */
+            void parse(string_view_type content)
+            {
+                this->content = content;
+                this->nodes.clear();
+                std::vector<size_t> open;               // The conditions whose `end` is not found yet
+                size_t line_num = 0;
+                string_size_type<CharType> pos = 0;
+                while (pos < content.size())
+                {
+                    const auto nl = std::find_if(content.begin() + pos, content.end(), [](const CharType& c) { return SAME(c, '\n'); });
+                    const string_size_type<CharType> line_end = nl - content.begin();
+                    const string_size_type<CharType> next = nl == content.end() ? line_end : line_end + 1;
+                    const string_view_type line = content.substr(pos, line_end - pos);
+                    ++line_num;
+
+                    const PragmaToken<CharType> token = ConditionalTree::lex(line);
+                    if (token.kind == PragmaKind::IF)
+                    {
+                        open.push_back(this->nodes.size());
+                        this->nodes.push_back(node{ node_kind::CONDITION, pos + token.arg_pos, token.arg_len, line_num });
+                    }
+                    else if (token.kind == PragmaKind::ELSE)
+                    {
+                        if (open.empty())
+                            ConditionalTree::fail("`else` pragma found without any `if` pragma before it", line_num, line);
+                        if (this->nodes[open.back()].else_begin != 0)
+                            ConditionalTree::fail("Second `else` pragma found for the same `if` pragma", line_num, line);
+                        this->nodes[open.back()].else_begin = this->nodes.size();
+                    }
+                    else if (token.kind == PragmaKind::IF_END)
+                    {
+                        if (open.empty())
+                            ConditionalTree::fail("`end` pragma found without any `if` pragma before it", line_num, line);
+                        node& cond = this->nodes[open.back()];
+                        if (cond.else_begin == 0)
+                            cond.else_begin = this->nodes.size();
+                        cond.end = this->nodes.size();
+                        open.pop_back();
+                    }
+                    // Lines following each other without any conditional pragma between them are a single text
+                    else if (!this->nodes.empty() && this->nodes.back().kind == node_kind::TEXT && this->nodes.back().offset + this->nodes.back().size == pos)
+                        this->nodes.back().size += next - pos;
+                    else
+                        this->nodes.push_back(node{ node_kind::TEXT, pos, next - pos, line_num });
+                    pos = next;
+                }
+                if (!open.empty())
+                    ConditionalTree::fail("`if` pragma without any matching `end` pragma", this->nodes[open.back()].line, this->condition_of(this->nodes[open.back()]));
+            }
+
+            inline const std::vector<node>& get_nodes(void) const noexcept
             {
-                return *this;
+                return this->nodes;
             }
 
-        public:
-            virtual void restart()
+            inline string_view_type text_of(const node& n) const noexcept
             {
-                this->path.clear();
-                if (this->is_open())
-                    this->StreamType::close();
+                return this->content.substr(n.offset, n.size);
             }
 
-            virtual void restart(FilePathType&& p, std::ios_base::openmode mode)
+            inline string_view_type condition_of(const node& n) const noexcept
             {
-                this->restart();
-                FilePathType unconverted = p;
-                this->path = std::move(p);
-                this->open(CONVERT(std::filesystem::path, std::move(unconverted)), mode);
+                return this->content.substr(n.offset, n.size);
             }
 
-            virtual void restart(const FilePathType& p, std::ios_base::openmode mode)
+            /**
+             * @brief Call @p on_text with the texts of the branches taken, in order
+             * @details @p on_condition is called with the condition and the line of each `if` reached, and decides which
+             *          branch is taken. The branches not taken are skipped at once.
+             */
+            template <typename OnText, typename OnCondition>
+            void walk(OnText&& on_text, OnCondition&& on_condition) const
             {
-                this->restart();
-                auto unconverted = p;
-                this->path = p;
-                this->open(CONVERT(std::filesystem::path, unconverted), mode);
+                // Where each `if` branch being walked ends, and where to go from there (its end)
+                std::vector<std::pair<size_t, size_t>> jumps;
+                size_t i = 0;
+                while (i < this->nodes.size())
+                {
+                    if (!jumps.empty() && jumps.back().first == i)
+                    {
+                        i = jumps.back().second;
+                        jumps.pop_back();
+                        continue;
+                    }
+                    const node& n = this->nodes[i];
+                    if (n.kind == node_kind::TEXT)
+                    {
+                        on_text(this->text_of(n));
+                        ++i;
+                    }
+                    else if (on_condition(this->condition_of(n), n.line))
+                    {
+                        if (n.else_begin != n.end)
+                            jumps.emplace_back(n.else_begin, n.end);
+                        ++i;
+                    }
+                    else
+                        i = n.else_begin;
+                }
             }
     };
-#endif
 
-    // TODO: Modify whole SrcFile implementation to use File as a base class
-#if 0
-    template <typename T, typename U>
-        requires CharacterType<T> && FilePath<U>
-    class SrcFile
+    /**
+     * @class ConditionProgram
+     * @brief A condition of a `#pragma supdef if`, compiled to the bytecode of a small register machine
+     * @details A condition is an expression made of integers (decimal, hexadecimal or character literals), string literals,
+     *          parentheses, the unary operators `!`, `-` and `+`, the binary operators `*`, `/`, `%`, `+`, `-`, `<`, `<=`, `>`,
+     *          `>=`, `==`, `!=`, `&&` and `||` (with the same precedence as in C), and invocations of super defines. Any other
+     *          identifier is 0, as in a `#if`. Integers are 64-bit and wrap around, strings compare lexicographically and `+`
+     *          concatenates them. A value is true if it is a non-zero integer or a non-empty string.
+     *          Each instruction writes one register from others (or from the pools of constants), so an operand is never
+     *          copied around. The operators applied to constants are applied once, when compiling (unless they fail, e.g. on
+     *          a division by zero, which is then only an error if reached). `&&` and `||` are conditional jumps, and the code
+     *          of an operand which a constant operand makes useless is dropped, invocations included.
+     *          An invocation is only expanded when its `INVOKE` instruction runs, by the caller of @ref run.
+     * @tparam CharType The character type of the condition
+     */
+    template <typename CharType>
+        requires CharacterType<CharType>
+    class ConditionProgram
     {
+        public:
+            typedef std::basic_string<CharType> string_type;
+            typedef std::basic_string_view<CharType> string_view_type;
+            typedef uint16_t reg_type;
+
+            // The value of a register (a string being a view of a constant of the program, or of the strings built by the caller)
+            struct value
+            {
+                bool is_string = false;
+                int64_t integer = 0;
+                string_view_type string;
+
+                static inline value of(int64_t integer) noexcept
+                {
+                    value res;
+                    res.integer = integer;
+                    return res;
+                }
+
+                static inline value of_string(string_view_type string) noexcept
+                {
+                    value res;
+                    res.is_string = true;
+                    res.string = string;
+                    return res;
+                }
+
+                inline bool truthy(void) const noexcept
+                {
+                    return this->is_string ? !this->string.empty() : this->integer != 0;
+                }
+            };
+
+            enum class opcode : uint8_t
+            {
+                LOAD_INT = 0,       // dst = integers[a]
+                LOAD_STR,           // dst = strings[a]
+                INVOKE,             // dst = the value of invocations[a]
+                NOT,                // dst = !a
+                NEG,                // dst = -a
+                POS,                // dst = +a
+                TRUTH,              // dst = !!a
+                ADD,                // dst = a + b
+                SUB,                // dst = a - b
+                MUL,                // dst = a * b
+                DIV,                // dst = a / b
+                MOD,                // dst = a % b
+                EQ,                 // dst = a == b
+                NE,                 // dst = a != b
+                LT,                 // dst = a < b
+                LE,                 // dst = a <= b
+                GT,                 // dst = a > b
+                GE,                 // dst = a >= b
+                JUMP,               // Go to a
+                JUMP_IF_FALSE,      // Go to b if a is false
+                JUMP_IF_TRUE,       // Go to b if a is true
+                RETURN              // Return a
+            };
+
+            struct instruction
+            {
+                opcode op;
+                reg_type dst;
+                uint32_t a;
+                uint32_t b;
+            };
+
+            struct invocation
+            {
+                string_type name;
+                string_type text;       // The whole invocation, as found in the condition
+            };
+
         private:
-            std::shared_ptr<U> path;
-            std::vector<PragmaDef<T>> super_defines;
-            std::vector<PragmaInc<T, U>> imports;
+            string_type source;
+            std::vector<instruction> code;
+            std::vector<string_size_type<CharType>> positions;  // Where the operation of each instruction is in `source`
+            std::vector<int64_t> integers;
+            std::vector<string_type> strings;
+            std::vector<invocation> invocations;
+            size_t registers = 1;
+
+            // What is known of a sub-expression when compiling it: its value, or the register it is computed in
+            struct operand
+            {
+                bool is_const = false;
+                bool is_string = false;
+                int64_t integer = 0;
+                string_type string;
+                reg_type reg = 0;
+
+                static inline operand of(int64_t integer)
+                {
+                    operand res;
+                    res.is_const = true;
+                    res.integer = integer;
+                    return res;
+                }
 
-        public:
-            std::unique_ptr<Parser<T>> parser;
-            std::unique_ptr<File<std::basic_ifstream<T>>> file;
+                static inline operand in(reg_type reg)
+                {
+                    operand res;
+                    res.reg = reg;
+                    return res;
+                }
 
-            SrcFile() = default;
-            SrcFile(U path) : path(std::make_shared<U>(path)),
-                              parser(std::make_unique<Parser<T>>(path)),
-                              file(std::make_unique<File<std::basic_ifstream<T>>>(path))
-            { }
-            SrcFile(SrcFile&& other) noexcept = default;
-            SrcFile(SrcFile& other) : path(other->get_path),
-                                      super_defines(other->get_super_defines()),
-                                      imports(other->get_imports()),
-                                      parser(std::make_unique<Parser<T>>(*(other->get_path()))),
-                                      file(std::make_unique<File<std::basic_ifstream<T>>>(*(other->get_path())))
-            { }
-            ~SrcFile() noexcept
+                inline value as_value(void) const noexcept
+                {
+                    return this->is_string ? value::of_string(this->string) : value::of(this->integer);
+                }
+
+                inline bool truthy(void) const noexcept
+                {
+                    return this->is_string ? !this->string.empty() : this->integer != 0;
+                }
+            };
+
+            // Where the compiler is in `source`
+            struct cursor
             {
-                if (this->file->is_open())
-                    this->file->get_stream()->close();
+                string_size_type<CharType> pos = 0;
+                size_t line = 0;
+                size_t depth = 0;
+            };
+
+            static bool is_ident_char(const CharType& c) noexcept
+            {
+                const uint32_t v = ::SupDef::Util::code_unit_value(c);
+                return (v >= 'a' && v <= 'z') || (v >= 'A' && v <= 'Z') || (v >= '0' && v <= '9') || v == '_' || v >= 0x80;
             }
 
-            inline std::shared_ptr<U> get_path() const noexcept
+            static uint32_t digit_value(const CharType& c) noexcept
             {
-                return this->path;
+                const uint32_t v = ::SupDef::Util::code_unit_value(c);
+                if (v >= '0' && v <= '9')
+                    return v - '0';
+                if (v >= 'a' && v <= 'f')
+                    return v - 'a' + 10;
+                if (v >= 'A' && v <= 'F')
+                    return v - 'A' + 10;
+                return std::numeric_limits<uint32_t>::max();
             }
 
-            inline std::vector<PragmaDef<T>> get_super_defines() const noexcept
+            // Position following the string or character literal starting at @p pos (`npos` if it is unterminated)
+            static string_size_type<CharType> skip_literal(string_view_type text, string_size_type<CharType> pos) noexcept
             {
-                return this->super_defines;
+                const CharType quote = text[pos];
+                for (++pos; pos < text.size(); ++pos)
+                {
+                    if (SAME(text[pos], '\\'))
+                        ++pos;
+                    else if (text[pos] == quote)
+                        return pos + 1;
+                }
+                return string_view_type::npos;
             }
 
-            inline std::vector<PragmaInc<T, U>> get_imports() const noexcept
+            [[noreturn]] void fail(string_size_type<CharType> pos, size_t line, const std::string& msg) const
             {
-                return this->imports;
+                throw Exception<CharType, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Invalid condition: " + msg, line, pos + 1, this->source);
             }
 
-            inline void add_super_define(const PragmaDef<T>& super_define) noexcept
+            /**
+             * @brief Apply the binary operator @p op to @p lhs and @p rhs (the concatenation of strings going to @p strings)
+             * @return An error message if the operator can't be applied to them (@p res being left as is), `nullptr` otherwise
+             */
+            static const char* apply(opcode op, const value& lhs, const value& rhs, value& res, std::deque<string_type>& strings)
             {
-                this->super_defines.push_back(super_define);
+                switch (op)
+                {
+                    case opcode::EQ:
+                    case opcode::NE:
+                    case opcode::LT:
+                    case opcode::LE:
+                    case opcode::GT:
+                    case opcode::GE:
+                    {
+                        if (lhs.is_string != rhs.is_string)
+                            return "cannot compare a string with an integer";
+                        const int cmp = lhs.is_string ? lhs.string.compare(rhs.string) : (lhs.integer < rhs.integer ? -1 : lhs.integer > rhs.integer);
+                        const bool results[] = { cmp == 0, cmp != 0, cmp < 0, cmp <= 0, cmp > 0, cmp >= 0 };
+                        res = value::of(results[static_cast<size_t>(op) - static_cast<size_t>(opcode::EQ)]);
+                        return nullptr;
+                    }
+                    case opcode::ADD:
+                        if (lhs.is_string && rhs.is_string)
+                        {
+                            strings.emplace_back(lhs.string).append(rhs.string);
+                            res = value::of_string(strings.back());
+                            return nullptr;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                if (lhs.is_string || rhs.is_string)
+                    return "arithmetic operators need integer operands";
+                const uint64_t a = static_cast<uint64_t>(lhs.integer), b = static_cast<uint64_t>(rhs.integer);
+                switch (op)
+                {
+                    case opcode::ADD:
+                        res = value::of(static_cast<int64_t>(a + b));
+                        return nullptr;
+                    case opcode::SUB:
+                        res = value::of(static_cast<int64_t>(a - b));
+                        return nullptr;
+                    case opcode::MUL:
+                        res = value::of(static_cast<int64_t>(a * b));
+                        return nullptr;
+                    default:
+                        break;
+                }
+                if (rhs.integer == 0)
+                    return "division by zero";
+                // The only quotient which doesn't fit
+                if (rhs.integer == -1)
+                    res = value::of(op == opcode::DIV ? static_cast<int64_t>(0 - a) : 0);
+                else
+                    res = value::of(op == opcode::DIV ? lhs.integer / rhs.integer : lhs.integer % rhs.integer);
+                return nullptr;
             }
 
-            inline void add_include(const PragmaInc<T, U>& import) noexcept
+            // Same as above, with the unary operators
+            static const char* apply(opcode op, const value& operand, value& res) noexcept
             {
-                this->imports.push_back(import);
+                if (op == opcode::NOT || op == opcode::TRUTH)
+                {
+                    res = value::of(operand.truthy() == (op == opcode::TRUTH));
+                    return nullptr;
+                }
+                if (operand.is_string)
+                    return op == opcode::NEG ? "`-` needs an integer operand" : "`+` needs an integer operand";
+                res = value::of(op == opcode::NEG ? static_cast<int64_t>(0 - static_cast<uint64_t>(operand.integer)) : operand.integer);
+                return nullptr;
             }
 
-            inline void restart() noexcept
+            size_t emit(opcode op, reg_type dst, uint32_t a, uint32_t b, string_size_type<CharType> pos)
             {
-                this->path.reset();
-                this->super_defines.clear();
-                this->imports.clear();
-                this->parser.reset();
-                this->file.reset();
+                this->code.push_back(instruction{ op, dst, a, b });
+                this->positions.push_back(pos);
+                return this->code.size() - 1;
             }
 
-            inline void restart(U path) noexcept
+            // Make @p op be computed in the register @p dst
+            void materialize(operand& op, reg_type dst, string_size_type<CharType> pos)
             {
-                this->restart();
-                this->path = std::make_shared<U>(path);
-                this->super_defines.clear();
-                this->imports.clear();
-                this->parser = std::make_unique<Parser<T>>(path);
-                this->file = std::make_unique<File<std::basic_ifstream<T>>>(path);
+                if (!op.is_const)
+                    return;
+                if (op.is_string)
+                {
+                    this->strings.push_back(std::move(op.string));
+                    this->emit(opcode::LOAD_STR, dst, this->strings.size() - 1, 0, pos);
+                }
+                else
+                {
+                    this->integers.push_back(op.integer);
+                    this->emit(opcode::LOAD_INT, dst, this->integers.size() - 1, 0, pos);
+                }
+                op = operand::in(dst);
             }
 
-            inline auto operator=(SrcFile&& other) noexcept
+            reg_type use_register(const cursor& cur, size_t reg)
             {
-                this->path = other.path;
-                this->super_defines = other.super_defines;
-                this->imports = other.imports;
-                this->parser = std::move(other.parser);
-                this->file = std::move(other.file);
-                return *this;
+                if (reg >= std::numeric_limits<reg_type>::max())
+                    this->fail(cur.pos, cur.line, "too complex");
+                this->registers = std::max(this->registers, reg + 1);
+                return static_cast<reg_type>(reg);
             }
-    };
-#else
-    template <typename T = char, typename U = std::filesystem::path>
-        requires CharacterType<T> && FilePath<U>
-    class SrcFile : public File<std::basic_ifstream<T>, U>
-    {
-        private:
-            std::vector<PragmaDef<T>> super_defines;
-            std::vector<PragmaInc<T, U>> imports;
 
-            using Base = File<std::basic_ifstream<T>, U>;
-        public:
-            SrcFile() : Base(), super_defines(), imports() {}
+            void enter(cursor& cur)
+            {
+                if (++cur.depth > SUPDEF_MAX_CONDITION_DEPTH)
+                    this->fail(cur.pos, cur.line, "too deeply nested (more than " + std::to_string(SUPDEF_MAX_CONDITION_DEPTH) + " levels)");
+            }
 
-            template <typename PathType>
-                requires FilePath<PathType> && std::constructible_from<Base, PathType&&, std::ios_base::openmode>
-            SrcFile(
-                PathType&& p,
-                std::ios_base::openmode mode = (std::ios_base::in | std::ios_base::binary)
-            ) : Base(std::forward<PathType>(p), mode), super_defines(), imports()
-            { }
-            
-            SrcFile(SrcFile& other) = delete;
-            SrcFile(SrcFile&& other) noexcept = default;
-            
-            ~SrcFile() noexcept = default;
-            
-            inline std::vector<PragmaDef<T>>& get_super_defines() noexcept
+            void skip_spaces(cursor& cur) const noexcept
             {
-                return this->super_defines;
+                while (cur.pos < this->source.size() && (SAME(this->source[cur.pos], ' ') || SAME(this->source[cur.pos], '\t') || SAME(this->source[cur.pos], '\r') ||
+                                                         SAME(this->source[cur.pos], '\n') || SAME(this->source[cur.pos], '\v') || SAME(this->source[cur.pos], '\f')))
+                    ++cur.pos;
             }
-            inline std::vector<PragmaInc<T, U>>& get_imports() noexcept
+
+            // Consume the operator @p op if it comes next (and isn't the start of a longer one, continued by one of @p longer)
+            bool accept(cursor& cur, std::string_view op, std::string_view longer = std::string_view()) const noexcept
+            {
+                this->skip_spaces(cur);
+                if (this->source.size() - cur.pos < op.size())
+                    return false;
+                for (size_t i = 0; i < op.size(); ++i)
+                {
+                    if (DIFFERENT(this->source[cur.pos + i], op[i]))
+                        return false;
+                }
+                if (cur.pos + op.size() < this->source.size())
+                {
+                    for (char c : longer)
+                    {
+                        if (SAME(this->source[cur.pos + op.size()], c))
+                            return false;
+                    }
+                }
+                cur.pos += op.size();
+                return true;
+            }
+
+            // Compile `lhs op rhs`, folding it if both are constants
+            operand binary(const cursor& cur, opcode op, operand lhs, operand rhs, reg_type base, string_size_type<CharType> pos)
             {
-                return this->imports;
+                if (lhs.is_const && rhs.is_const)
+                {
+                    std::deque<string_type> concatenated;
+                    value res;
+                    if (ConditionProgram::apply(op, lhs.as_value(), rhs.as_value(), res, concatenated) == nullptr)
+                    {
+                        operand folded = operand::of(res.integer);
+                        if (res.is_string)
+                        {
+                            folded.is_string = true;
+                            folded.string = string_type(res.string);
+                        }
+                        return folded;
+                    }
+                }
+                const reg_type rhs_reg = this->use_register(cur, base + 1);
+                this->materialize(lhs, base, pos);
+                this->materialize(rhs, rhs_reg, pos);
+                this->emit(op, base, base, rhs_reg, pos);
+                return operand::in(base);
             }
 
-            inline void add_super_define(const PragmaDef<T>& super_define) noexcept
+            // `&&` (if @p is_and) or `||`, whose operands are compiled by @p compile_operand
+            template <typename CompileOperand>
+            operand logical(cursor& cur, bool is_and, reg_type base, CompileOperand&& compile_operand)
             {
-                this->super_defines.push_back(super_define);
+                operand lhs = compile_operand(cur, base);
+                while (this->accept(cur, is_and ? "&&" : "||"))
+                {
+                    const string_size_type<CharType> pos = cur.pos;
+                    if (lhs.is_const && lhs.truthy() != is_and)
+                    {
+                        // Decided by the left operand: the right one is only checked
+                        const size_t code_size = this->code.size();
+                        const size_t invocations_count = this->invocations.size();
+                        compile_operand(cur, base);
+                        this->code.resize(code_size);
+                        this->positions.resize(code_size);
+                        this->invocations.resize(invocations_count);
+                        lhs = operand::of(!is_and);
+                        continue;
+                    }
+                    if (lhs.is_const)
+                    {
+                        operand rhs = compile_operand(cur, base);
+                        if (rhs.is_const)
+                            lhs = operand::of(rhs.truthy());
+                        else
+                        {
+                            this->emit(opcode::TRUTH, base, base, 0, pos);
+                            lhs = operand::in(base);
+                        }
+                        continue;
+                    }
+                    this->emit(opcode::TRUTH, base, base, 0, pos);
+                    const size_t jump = this->emit(is_and ? opcode::JUMP_IF_FALSE : opcode::JUMP_IF_TRUE, base, base, 0, pos);
+                    operand rhs = compile_operand(cur, base);
+                    if (rhs.is_const)
+                    {
+                        rhs = operand::of(rhs.truthy());
+                        this->materialize(rhs, base, pos);
+                    }
+                    else
+                        this->emit(opcode::TRUTH, base, base, 0, pos);
+                    this->code[jump].b = this->code.size();
+                }
+                return lhs;
             }
-            inline void add_include(const PragmaInc<T, U>& import) noexcept
+
+            operand compile_or(cursor& cur, reg_type base)
             {
-                this->imports.push_back(import);
+                return this->logical(cur, false, base, [this](cursor& c, reg_type b) { return this->compile_and(c, b); });
             }
 
-            inline void restart() override
+            operand compile_and(cursor& cur, reg_type base)
             {
-                this->Base::restart();
-                this->super_defines.clear();
-                this->imports.clear();
+                return this->logical(cur, true, base, [this](cursor& c, reg_type b) { return this->compile_comparison(c, b); });
             }
 
-            inline void restart(
-                U&& p,
-                std::ios_base::openmode mode = (std::ios_base::in | std::ios_base::binary)
-            ) override
+            operand compile_comparison(cursor& cur, reg_type base)
             {
-                if (mode & std::ios_base::out)
-                    throw InternalError("Attempt to open a SrcFile in write mode");
-                this->Base::restart(std::forward<U>(p), mode);
-                this->super_defines.clear();
-                this->imports.clear();
+                operand lhs = this->compile_additive(cur, base);
+                while (true)
+                {
+                    const string_size_type<CharType> pos = cur.pos;
+                    opcode op;
+                    if (this->accept(cur, "=="))
+                        op = opcode::EQ;
+                    else if (this->accept(cur, "!="))
+                        op = opcode::NE;
+                    else if (this->accept(cur, "<="))
+                        op = opcode::LE;
+                    else if (this->accept(cur, ">="))
+                        op = opcode::GE;
+                    else if (this->accept(cur, "<"))
+                        op = opcode::LT;
+                    else if (this->accept(cur, ">"))
+                        op = opcode::GT;
+                    else
+                        return lhs;
+                    operand rhs = this->compile_additive(cur, this->use_register(cur, base + 1));
+                    lhs = this->binary(cur, op, std::move(lhs), std::move(rhs), base, pos);
+                }
             }
 
-            inline void restart(
-                const U& p,
-                std::ios_base::openmode mode = (std::ios_base::in | std::ios_base::binary)
-            ) override
+            operand compile_additive(cursor& cur, reg_type base)
             {
-                if (mode & std::ios_base::out)
-                    throw InternalError("Attempt to open a SrcFile in write mode");
-                this->Base::restart(p, mode);
-                this->super_defines.clear();
-                this->imports.clear();
+                operand lhs = this->compile_multiplicative(cur, base);
+                while (true)
+                {
+                    const string_size_type<CharType> pos = cur.pos;
+                    opcode op;
+                    if (this->accept(cur, "+"))
+                        op = opcode::ADD;
+                    else if (this->accept(cur, "-"))
+                        op = opcode::SUB;
+                    else
+                        return lhs;
+                    operand rhs = this->compile_multiplicative(cur, this->use_register(cur, base + 1));
+                    lhs = this->binary(cur, op, std::move(lhs), std::move(rhs), base, pos);
+                }
             }
 
-            inline SrcFile& operator=(SrcFile&& other) noexcept
+            operand compile_multiplicative(cursor& cur, reg_type base)
             {
-                this->super_defines = std::move(other.super_defines);
-                this->imports = std::move(other.imports);
-                this->Base::operator=(std::move(other));
-                return *this;
+                operand lhs = this->compile_unary(cur, base);
+                while (true)
+                {
+                    const string_size_type<CharType> pos = cur.pos;
+                    opcode op;
+                    if (this->accept(cur, "*"))
+                        op = opcode::MUL;
+                    else if (this->accept(cur, "/"))
+                        op = opcode::DIV;
+                    else if (this->accept(cur, "%"))
+                        op = opcode::MOD;
+                    else
+                        return lhs;
+                    operand rhs = this->compile_unary(cur, this->use_register(cur, base + 1));
+                    lhs = this->binary(cur, op, std::move(lhs), std::move(rhs), base, pos);
+                }
             }
-            inline SrcFile& operator=(SrcFile& other) = delete;
 
-#if 0
-            inline void close() override
+            operand compile_unary(cursor& cur, reg_type base)
             {
-                this->restart();
+                const string_size_type<CharType> pos = cur.pos;
+                opcode op;
+                if (this->accept(cur, "!", "="))
+                    op = opcode::NOT;
+                else if (this->accept(cur, "-"))
+                    op = opcode::NEG;
+                else if (this->accept(cur, "+"))
+                    op = opcode::POS;
+                else
+                    return this->compile_primary(cur, base);
+
+                this->enter(cur);
+                operand arg = this->compile_unary(cur, base);
+                --cur.depth;
+                if (arg.is_const)
+                {
+                    value res;
+                    if (ConditionProgram::apply(op, arg.as_value(), res) == nullptr)
+                        return operand::of(res.integer);
+                }
+                this->materialize(arg, base, pos);
+                this->emit(op, base, base, 0, pos);
+                return operand::in(base);
             }
-#endif
-    };
-#endif
 
-    // Must have the same behavior as std::less
-    template <typename T>
-        requires CharacterType<T>
-    class PragmaLocCompare
-    {
-        public:
-            using tuple_type = std::tuple<string_size_type<T>, string_size_type<T>>;
+            operand compile_primary(cursor& cur, reg_type base)
+            {
+                this->skip_spaces(cur);
+                if (cur.pos == this->source.size())
+                    this->fail(cur.pos, cur.line, "unexpected end of the condition");
+                const string_view_type text(this->source);
+                const CharType c = text[cur.pos];
 
-            // Are the two tupled types in U convertible to string_size_type<T>?
-            template <typename U>
-                requires SPECIALIZATION_OF(U, std::tuple)
-            using convertible_tuple = std::conjunction<
-                std::is_convertible<std::tuple_element_t<0, std::remove_cvref_t<U>>, string_size_type<T>>,
-                std::is_convertible<std::tuple_element_t<1, std::remove_cvref_t<U>>, string_size_type<T>>
-            >;
+                if (SAME(c, '('))
+                {
+                    ++cur.pos;
+                    this->enter(cur);
+                    operand inner = this->compile_or(cur, base);
+                    --cur.depth;
+                    if (!this->accept(cur, ")"))
+                        this->fail(cur.pos, cur.line, "missing `)`");
+                    return inner;
+                }
 
-            static_assert(convertible_tuple<std::tuple<string_size_type<char>, string_size_type<char>>>::value);
-            static_assert(convertible_tuple<std::tuple<int, int>>::value);
-            static_assert(convertible_tuple<std::tuple<int, string_size_type<char>>>::value);
-            static_assert(convertible_tuple<std::tuple<string_size_type<char>, int>>::value);
+                if (SAME(c, '"') || SAME(c, '\''))
+                {
+                    const string_size_type<CharType> end = ConditionProgram::skip_literal(text, cur.pos);
+                    if (end == string_view_type::npos)
+                        this->fail(cur.pos, cur.line, "unterminated literal");
+                    operand res = operand::of(0);
+                    for (string_size_type<CharType> i = cur.pos + 1; i < end - 1; ++i)
+                    {
+                        CharType ch = text[i];
+                        if (SAME(ch, '\\'))
+                        {
+                            ch = text[++i];
+                            if (SAME(ch, 'n'))
+                                ch = CONVERT(CharType, '\n')[0];
+                            else if (SAME(ch, 't'))
+                                ch = CONVERT(CharType, '\t')[0];
+                            else if (SAME(ch, '0'))
+                                ch = CharType(0);
+                        }
+                        res.string += ch;
+                    }
+                    if (SAME(c, '"'))
+                    {
+                        cur.pos = end;
+                        res.is_string = true;
+                        return res;
+                    }
+                    if (res.string.size() != 1)
+                        this->fail(cur.pos, cur.line, "a character literal must hold a single code unit");
+                    cur.pos = end;
+                    return operand::of(static_cast<int64_t>(::SupDef::Util::code_unit_value(res.string[0])));
+                }
 
-            template <typename U>
-                requires SPECIALIZATION_OF(U, std::tuple)
-            static constexpr bool convertible_tuple_v = convertible_tuple<U>::value;
-            
-            enum : uint8_t
-            {
-                START = 1 << 0,
-                END = 1 << 1,
-                BOTH = START | END
-            };
+                if (ConditionProgram::digit_value(c) < 10)
+                {
+                    uint64_t radix = 10;
+                    if (SAME(c, '0') && cur.pos + 1 < text.size() && (SAME(text[cur.pos + 1], 'x') || SAME(text[cur.pos + 1], 'X')))
+                    {
+                        radix = 16;
+                        cur.pos += 2;
+                    }
+                    const string_size_type<CharType> start = cur.pos;
+                    uint64_t res = 0;
+                    for (; cur.pos < text.size() && ConditionProgram::digit_value(text[cur.pos]) < radix; ++cur.pos)
+                    {
+                        const uint64_t digit = ConditionProgram::digit_value(text[cur.pos]);
+                        if (res > (static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) - digit) / radix)
+                            this->fail(cur.pos, cur.line, "integer too large");
+                        res = res * radix + digit;
+                    }
+                    if (cur.pos == start || (cur.pos < text.size() && ConditionProgram::is_ident_char(text[cur.pos])))
+                        this->fail(cur.pos, cur.line, "invalid integer");
+                    return operand::of(static_cast<int64_t>(res));
+                }
 
-            template <typename U>
-                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
-            static constexpr inline bool eq(const U&& lhs, const U&& rhs, uint8_t flags = BOTH) noexcept
-            {
-                if (flags & BOTH)
-                    return std::get<0>(lhs) == std::get<0>(rhs) && std::get<1>(lhs) == std::get<1>(rhs);
-                else if (flags & START)
-                    return std::get<0>(lhs) == std::get<0>(rhs);
-                else if (flags & END)
-                    return std::get<1>(lhs) == std::get<1>(rhs);
-                else
-                    return false;
+                if (!ConditionProgram::is_ident_char(c))
+                    this->fail(cur.pos, cur.line, "unexpected character");
+                const string_size_type<CharType> ident_start = cur.pos;
+                while (cur.pos < text.size() && ConditionProgram::is_ident_char(text[cur.pos]))
+                    ++cur.pos;
+                const string_view_type name = text.substr(ident_start, cur.pos - ident_start);
+                string_size_type<CharType> paren = cur.pos;
+                while (paren < text.size() && (SAME(text[paren], ' ') || SAME(text[paren], '\t')))
+                    ++paren;
+                if (paren == text.size() || DIFFERENT(text[paren], '('))
+                    return operand::of(0);
+
+                size_t depth = 0;
+                string_size_type<CharType> end = paren;
+                for (; end < text.size(); ++end)
+                {
+                    if (SAME(text[end], '"') || SAME(text[end], '\''))
+                    {
+                        end = ConditionProgram::skip_literal(text, end);
+                        if (end == string_view_type::npos)
+                            break;
+                        --end;
+                    }
+                    else if (SAME(text[end], '('))
+                        ++depth;
+                    else if (SAME(text[end], ')') && --depth == 0)
+                        break;
+                }
+                if (end >= text.size())
+                    this->fail(cur.pos, cur.line, "unterminated invocation of `" + CONVERT(std::string, string_type(name)) + "`");
+                cur.pos = end + 1;
+                this->invocations.push_back(invocation{ string_type(name), string_type(text.substr(ident_start, cur.pos - ident_start)) });
+                this->emit(opcode::INVOKE, base, this->invocations.size() - 1, 0, ident_start);
+                return operand::in(base);
             }
 
-            template <typename U>
-                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
-            static constexpr inline bool lt(const U&& lhs, const U&& rhs, uint8_t flags = BOTH) noexcept
+        public:
+            ConditionProgram() = default;
+
+            /**
+             * @brief Compile @p condition (found on the line @p line, for error messages)
+             * @details Throws a syntax error if @p condition isn't a valid expression
+             */
+            ConditionProgram(string_view_type condition, size_t line = 0) : source(condition)
             {
-                if (flags & BOTH)
-                    return std::get<0>(lhs) < std::get<0>(rhs) && std::get<1>(lhs) < std::get<1>(rhs);
-                else if (flags & START)
-                    return std::get<0>(lhs) < std::get<0>(rhs);
-                else if (flags & END)
-                    return std::get<1>(lhs) < std::get<1>(rhs);
-                else
-                    return false;
+                cursor cur{ 0, line, 0 };
+                operand res = this->compile_or(cur, 0);
+                this->skip_spaces(cur);
+                if (cur.pos != this->source.size())
+                    this->fail(cur.pos, line, "unexpected text");
+                this->materialize(res, 0, 0);
+                this->emit(opcode::RETURN, 0, 0, 0, 0);
             }
 
-            template <typename U>
-                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
-            static constexpr inline bool gt(const U&& lhs, const U&& rhs, uint8_t flags = BOTH) noexcept
+            // Whether the value of the condition doesn't depend on any super define
+            inline bool is_constant(void) const noexcept
             {
-                if (flags & BOTH)
-                    return std::get<0>(lhs) > std::get<0>(rhs) && std::get<1>(lhs) > std::get<1>(rhs);
-                else if (flags & START)
-                    return std::get<0>(lhs) > std::get<0>(rhs);
-                else if (flags & END)
-                    return std::get<1>(lhs) > std::get<1>(rhs);
-                else
-                    return false;
+                return this->invocations.empty();
             }
 
-            template <typename U>
-                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
-            static constexpr inline bool le(const U&& lhs, const U&& rhs, uint8_t flags = BOTH) noexcept
+            inline const std::vector<instruction>& get_code(void) const noexcept
             {
-                if (flags & BOTH)
-                    return std::get<0>(lhs) <= std::get<0>(rhs) && std::get<1>(lhs) <= std::get<1>(rhs);
-                else if (flags & START)
-                    return std::get<0>(lhs) <= std::get<0>(rhs);
-                else if (flags & END)
-                    return std::get<1>(lhs) <= std::get<1>(rhs);
-                else
-                    return false;
+                return this->code;
             }
 
-            template <typename U>
-                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
-            static constexpr inline bool ge(const U&& lhs, const U&& rhs, uint8_t flags = BOTH) noexcept
+            /**
+             * @brief Run the program
+             * @details Its registers are pushed on top of @p regs (and popped once done), so that nested programs (run by
+             *          @p invoke) share the same vector.
+             *
+             * @param regs The registers of the programs being run
+             * @param strings Where the strings built by the program go (they must outlive the values returned)
+             * @param invoke Called with an invocation when its `INVOKE` instruction runs, returning its value
+             * @param line The line of the condition, for error messages
+             * @return The value of the condition
+             */
+            template <typename Invoke>
+            value run(std::vector<value>& regs, std::deque<string_type>& strings, Invoke&& invoke, size_t line = 0) const
             {
-                if (flags & BOTH)
-                    return std::get<0>(lhs) >= std::get<0>(rhs) && std::get<1>(lhs) >= std::get<1>(rhs);
-                else if (flags & START)
-                    return std::get<0>(lhs) >= std::get<0>(rhs);
-                else if (flags & END)
-                    return std::get<1>(lhs) >= std::get<1>(rhs);
-                else
-                    return false;
+                const size_t base = regs.size();
+                regs.resize(base + this->registers);
+                size_t pc = 0;
+                while (true)
+                {
+                    const instruction& ins = this->code[pc];
+                    value res;
+                    switch (ins.op)
+                    {
+                        case opcode::LOAD_INT:
+                            res = value::of(this->integers[ins.a]);
+                            break;
+                        case opcode::LOAD_STR:
+                            res = value::of_string(this->strings[ins.a]);
+                            break;
+                        case opcode::INVOKE:
+                            res = invoke(this->invocations[ins.a]);
+                            break;
+                        case opcode::NOT:
+                        case opcode::NEG:
+                        case opcode::POS:
+                        case opcode::TRUTH:
+                            if (const char* error = ConditionProgram::apply(ins.op, regs[base + ins.a], res))
+                                this->fail(this->positions[pc], line, error);
+                            break;
+                        case opcode::JUMP:
+                            pc = ins.a;
+                            continue;
+                        case opcode::JUMP_IF_FALSE:
+                        case opcode::JUMP_IF_TRUE:
+                            pc = regs[base + ins.a].truthy() == (ins.op == opcode::JUMP_IF_TRUE) ? ins.b : pc + 1;
+                            continue;
+                        case opcode::RETURN:
+                            res = regs[base + ins.a];
+                            regs.resize(base);
+                            return res;
+                        default:
+                            if (const char* error = ConditionProgram::apply(ins.op, regs[base + ins.a], regs[base + ins.b], res, strings))
+                                this->fail(this->positions[pc], line, error);
+                            break;
+                    }
+                    regs[base + ins.dst] = res;
+                    ++pc;
+                }
             }
+    };
 
-#if 0
-            template <typename U>
-                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
-            using helper_func_type1 = bool (*)(const U&&, const U&&, uint8_t);
-
-            template <typename U>
-                requires std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>
-            using helper_func_type2 = std::function<bool(const U&&, const U&&, uint8_t)>;
-#endif
+    /**
+     * @class ConditionEvaluator
+     * @brief Evaluate the conditions of `#pragma supdef if`s (see @class ConditionProgram for what they may contain)
+     * @details Each condition is compiled once per evaluator, and then only run. An invocation is expanded (with an
+     *          @class InvocationExpander) when its value is needed only, and its expansion compiled as a condition in turn:
+     *          these programs are kept per super define (and per invocation text), so an invocation found in many
+     *          conditions is expanded and compiled once.
+     *          The results of the constant conditions (without any invocation left once compiled) are kept in a cache
+     *          shared with the other evaluators (the one of an @class Engine lasts as long as the engine, across
+     *          translation units), so they are not even compiled again.
+     * @tparam CharType The character type of the conditions
+     */
+    template <typename CharType>
+        requires CharacterType<CharType>
+    class ConditionEvaluator
+    {
+        public:
+            typedef std::basic_string<CharType> string_type;
+            typedef std::basic_string_view<CharType> string_view_type;
+            typedef typename SymbolTable<CharType>::scope_id scope_id;
+            typedef typename ConditionProgram<CharType>::value value;
 
-            template <typename U, typename Fn>
-                requires (std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>) && std::invocable<Fn, const U&&, const U&&, uint8_t>
-            constexpr inline bool operator()(Fn&& func, const U&& lhs, const U&& rhs, uint8_t flags = BOTH) const
-                noexcept(
-                    noexcept(func(std::forward<const U>(lhs), std::forward<const U>(rhs), flags))
-                )
+        private:
+            struct view_hash
             {
-                return func(std::forward<const U>(lhs), std::forward<const U>(rhs), flags);
-            }
+                using is_transparent = void;
+                inline size_t operator()(string_view_type str) const noexcept
+                {
+                    return std::hash<string_view_type>{}(str);
+                }
+            };
+            typedef std::unordered_map<string_type, ConditionProgram<CharType>, view_hash, std::equal_to<>> program_map;
 
-            template <typename U, typename Fn>
-                requires (std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>) && std::invocable<Fn, const U&&, const U&&, uint8_t>
-            struct Comparator
+        public:
+            // Results of the constant conditions, by their text
+            class constant_cache_type
             {
-                Fn func;
-                uint8_t flags;
+                private:
+                    mutable std::shared_mutex mtx{};
+                    std::unordered_map<string_type, bool, view_hash, std::equal_to<>> results;
 
-                Comparator(Fn&& func, uint8_t flags = BOTH) : func(std::forward<Fn>(func)), flags(flags) {}
-                Comparator(const Fn& func, uint8_t flags = BOTH) : func(func), flags(flags) {}
+                public:
+                    std::optional<bool> find(string_view_type condition) const
+                    {
+                        std::shared_lock<std::shared_mutex> lock(this->mtx);
+                        auto it = this->results.find(condition);
+                        return it == this->results.end() ? std::nullopt : std::optional<bool>(it->second);
+                    }
 
-                constexpr inline bool operator()(const U&& lhs, const U&& rhs) const
-                    noexcept(
-                        noexcept(func(std::forward<const U>(lhs), std::forward<const U>(rhs), flags))
-                    )
-                {
-                    return func(std::forward<const U>(lhs), std::forward<const U>(rhs), flags);
-                }
+                    void insert(string_view_type condition, bool result)
+                    {
+                        std::unique_lock<std::shared_mutex> lock(this->mtx);
+                        this->results.emplace(string_type(condition), result);
+                    }
+
+                    void clear(void)
+                    {
+                        std::unique_lock<std::shared_mutex> lock(this->mtx);
+                        this->results.clear();
+                    }
+
+                    inline size_t size(void) const
+                    {
+                        std::shared_lock<std::shared_mutex> lock(this->mtx);
+                        return this->results.size();
+                    }
             };
 
-            template <typename U, typename Fn>
-                requires (std::same_as<tuple_type, std::remove_cvref_t<U>> || convertible_tuple_v<U>) && std::invocable<Fn, const U&&, const U&&, uint8_t>
-            static constexpr inline Comparator<U, Fn> make_comparator(Fn&& func, uint8_t flags = BOTH)
-            {
-                return Comparator<U, Fn>(std::forward<Fn>(func), flags);
-            }
-    };
+        private:
+            const SymbolTable<CharType>& symbols;
+            scope_id scope;
+            ExpansionCache<CharType>* cache;
+            constant_cache_type* constants;
+            size_t expanded = 0;
+
+            program_map programs;                                                   // By condition
+            std::unordered_map<const PragmaDef<CharType>*, program_map> invoked;    // By super define, then by invocation
+            std::vector<value> registers;
+            std::deque<string_type> strings;
 
-    static_assert(PragmaLocCompare<char>::eq(std::make_tuple(0, 0), std::make_tuple(0, 0)));
-    static_assert(PragmaLocCompare<char>::lt(std::make_tuple(0, 0), std::make_tuple(2, 3)));
-    static_assert(!PragmaLocCompare<char>::gt(std::make_tuple(0, 1), std::make_tuple(0, 0)));
-    static_assert(PragmaLocCompare<char>()([](auto&& lhs, auto&& rhs, uint8_t flags) { return PragmaLocCompare<char>::eq(std::forward<decltype(lhs)>(lhs), std::forward<decltype(rhs)>(rhs), flags); }, std::make_tuple(0, 0), std::make_tuple(0, 0)));
+            // Compile @p text if it isn't in @p map yet
+            static const ConditionProgram<CharType>& program_of(program_map& map, string_view_type text, size_t line)
+            {
+                auto it = map.find(text);
+                if (it == map.end())
+                    it = map.emplace(string_type(text), ConditionProgram<CharType>(text, line)).first;
+                return it->second;
+            }
 
-#ifdef PRAGLOC_COMPARE_REL
-    #undef PRAGLOC_COMPARE_REL
-#endif
-#define PRAGLOC_COMPARE_REL(TP, OP, TUPLE1, TUPLE2, ...) (::SupDef::PragmaLocCompare<TP>::OP((TUPLE1), (TUPLE2) __VA_OPT__(,) __VA_ARGS__))
+            value invoke(const typename ConditionProgram<CharType>::invocation& inv, size_t line)
+            {
+                const PragmaDef<CharType>* def = this->symbols.find(this->scope, inv.name);
+                if (def == nullptr)
+                    throw Exception<CharType, std::filesystem::path>(ExcType::SYNTAX_ERROR, "Invalid condition: `" + CONVERT(std::string, inv.name) + "` is not a super define", line, 1, inv.text);
+                ++this->expanded;
 
-    static_assert(PRAGLOC_COMPARE_REL(char, eq, std::make_tuple(0, 0), std::make_tuple(0, 0)));
-    static_assert(PRAGLOC_COMPARE_REL(char, lt, std::make_tuple(0, 0), std::make_tuple(2, 3)));
-    static_assert(!PRAGLOC_COMPARE_REL(char, gt, std::make_tuple(0, 1), std::make_tuple(0, 0)));
+                program_map& map = this->invoked[def];
+                auto it = map.find(inv.text);
+                if (it == map.end())
+                {
+                    std::basic_ostringstream<CharType> expansion;
+                    InvocationExpander<CharType> expander(this->symbols, this->scope, this->cache);
+                    expander.expand(inv.text, expansion);
+                    it = map.emplace(inv.text, ConditionProgram<CharType>(std::move(expansion).str(), line)).first;
+                }
+                return it->second.run(this->registers, this->strings, [this, line](const auto& nested) { return this->invoke(nested, line); }, line);
+            }
 
-#ifdef PRAGLOC_COMPARE_FN
-    #undef PRAGLOC_COMPARE_FN
-#endif
-#define PRAGLOC_COMPARE_FN(TP, FN, TUPLE1, TUPLE2, ...) (::SupDef::PragmaLocCompare<TP>()((FN), (TUPLE1), (TUPLE2) __VA_OPT__(,) __VA_ARGS__))
-    
-    static_assert(PRAGLOC_COMPARE_FN(char, [](auto&& lhs, auto&& rhs, uint8_t flags) { return PRAGLOC_COMPARE_REL(char, eq, std::forward<decltype(lhs)>(lhs), std::forward<decltype(rhs)>(rhs), flags); }, std::make_tuple(0, 0), std::make_tuple(0, 0)));
+        public:
+            /**
+             * @param symbols The super defines that can be invoked
+             * @param scope The scope the invocations are looked up from
+             * @param cache Where to cache the expansions (none if `nullptr`)
+             * @param constants Where to cache the results of the constant conditions (none if `nullptr`)
+             */
+            ConditionEvaluator(const SymbolTable<CharType>& symbols, scope_id scope, ExpansionCache<CharType>* cache = nullptr, constant_cache_type* constants = nullptr)
+                : symbols(symbols), scope(scope), cache(cache), constants(constants)
+            { }
 
-#ifdef PRAGLOC_COMPARATOR_FN
-    #undef PRAGLOC_COMPARATOR_FN
-#endif
-#define PRAGLOC_COMPARATOR_FN(TP_CHAR, TP_TUPLED, FN, ...) (::SupDef::PragmaLocCompare<TP_CHAR>::template make_comparator<std::tuple<TP_TUPLED, TP_TUPLED>>((FN) __VA_OPT__(,) __VA_ARGS__))
+            /**
+             * @brief Evaluate @p condition (found on the line @p line, for error messages)
+             * @return Whether the `if` branch is taken
+             */
+            bool evaluate(string_view_type condition, size_t line = 0)
+            {
+                if (this->constants != nullptr)
+                {
+                    if (auto cached = this->constants->find(condition); cached.has_value())
+                        return *cached;
+                }
+                const ConditionProgram<CharType>& program = ConditionEvaluator::program_of(this->programs, condition, line);
+                this->registers.clear();
+                this->strings.clear();
+                const bool result = program.run(this->registers, this->strings, [this, line](const auto& inv) { return this->invoke(inv, line); }, line).truthy();
+                if (program.is_constant() && this->constants != nullptr)
+                    this->constants->insert(condition, result);
+                return result;
+            }
 
-#ifdef PRAGLOC_COMPARATOR_REL
-    #undef PRAGLOC_COMPARATOR_REL
-#endif
-#define PRAGLOC_COMPARATOR_REL(TP_CHAR, TP_TUPLED, OP, ...) (PRAGLOC_COMPARATOR_FN(TP_CHAR, TP_TUPLED, [](auto&& lhs, auto&& rhs, uint8_t flags) { return PRAGLOC_COMPARE_REL(TP_CHAR, OP, std::forward<decltype(lhs)>(lhs), std::forward<decltype(rhs)>(rhs), flags); } __VA_OPT__(,) __VA_ARGS__))
+            // The number of invocations evaluated so far
+            inline size_t expansions(void) const noexcept
+            {
+                return this->expanded;
+            }
+    };
 
-#if SUPDEF_WORKAROUND_GCC_INTERNAL_ERROR
-    template <typename T>
-        requires CharacterType<T>
-    Coro<Result<std::shared_ptr<std::basic_string<T>>, Error<T, std::filesystem::path>>> search_imports(Parser<T>& parser);
-#endif
     /**
      * @class Parser
      * @brief A class representing a SupDef parser
      * @tparam T The character type of the parser (char, wchar_t, char8_t, char16_t, char32_t)
      * @details The @class Parser is used to parse a file and extract SupDef pragmas from it
+     * The content being parsed is kept in a single @class ParsedText, and its lines are only spans over it
      * TODO: Keep track of removed lines count to be able to report errors with line numbers properly (DONE)
-     * TODO: Completely remove "raw" `file_content` and `lines` vectors
      */
     template <typename T>
         requires CharacterType<T>
@@ -3914,16 +7018,19 @@ POP_MACRO(DECLARE_FRIENDS3)
             typedef typename std::basic_string<T> string_type;
             typedef typename std::tuple<string_type, string_size_type<T>, string_size_type<T>> pragma_loc_type;
 
-            std::basic_string<T> file_content_raw;
-            std::vector<std::basic_string<T>> lines_raw;
+            // The content of the file, as read from it (either a memory mapping of the file or `file_content_storage`)
+            std::basic_string_view<T> file_content_raw;
 
             Parser();
             Parser(std::filesystem::path file_path); // Initialize this->file with std::basic_ifstream<T>
             Parser(std::filesystem::path file_path, std::basic_ifstream<T>& file_stream); // Initialize this->file with std::reference_wrapper<std::basic_ifstream<T>>
             ~Parser() noexcept = default;
 
-            std::basic_string<T> slurp_file();
+            std::basic_string_view<T> slurp_file();
             Parser& strip_comments(void);
+            // Same as `strip_comments(void)`, but splits the content in chunks of about @p chunk_size code units (at line boundaries)
+            // which are handled by the threads of @p pool, and also lexes the pragmas of the resulting lines on them
+            Parser& strip_comments(ThreadPool& pool, size_t chunk_size = SUPDEF_PARSER_CHUNK_SIZE);
 #if SUPDEF_WORKAROUND_GCC_INTERNAL_ERROR
         private:
             friend Coro<Result<std::shared_ptr<std::basic_string<T>>, Error<T, std::filesystem::path>>> search_imports<T>(Parser& parser);
@@ -3934,6 +7041,25 @@ POP_MACRO(DECLARE_FRIENDS3)
 #endif
             // Search for `#pragma supdef begin ...` and its corresponding `#pragma supdef end` pragmas
             Coro<Result<Parser<T>::pragma_loc_type, Error<T, std::filesystem::path>>> search_super_defines(void);
+
+            // What an edit made with `apply_edit` changed
+            struct edit_result
+            {
+                std::vector<string_type> changed_super_defines;        // Names of the super defines added, removed or modified
+                bool imports_changed = false;                          // Whether an import was added, removed or modified
+                std::vector<Error<T, std::filesystem::path>> errors;   // Errors found while searching the edited region for pragmas
+            };
+            // Replace the @p removed_len code units of `file_content_raw` starting at @p offset with @p inserted_text, and only
+            // strip and search again the lines this edit can change (dropping the expansions of the super defines it changes
+            // from @p cache, if any)
+            edit_result apply_edit(string_size_type<T> offset, string_size_type<T> removed_len, std::basic_string_view<T> inserted_text, ExpansionCache<T>* cache = nullptr);
+
+            inline const std::filesystem::path& get_path(void) const noexcept { return this->file_path; }
+            // The content left once the comments and the pragmas found so far are stripped
+            inline std::basic_string_view<T> get_content(void) const noexcept { return this->file_content.view(); }
+            // The pragmas found so far by `search_imports` and `search_super_defines` (kept up to date by `apply_edit`), in order
+            inline const std::vector<pragma_loc_type>& get_imports(void) const noexcept { return this->imports; }
+            inline const std::vector<pragma_loc_type>& get_super_defines(void) const noexcept { return this->super_defines; }
 #if defined(SUPDEF_DEBUG)
             template <typename Stream = std::ostream>                
             void print_content(Stream& s = std::cout) const;
@@ -3946,9 +7072,85 @@ POP_MACRO(DECLARE_FRIENDS3)
             typedef std::variant<file_stream_type1, file_stream_type2> file_stream_variant_type;
 
             file_stream_variant_type file;
+
+            // Where `file_content_raw` points to: the file mapped in memory if possible (only for byte-sized character types),
+            // and `file_content_storage` otherwise
+            MappedFile file_mapping;
+            std::basic_string<T> file_content_storage;
             
+            // A line of `file_content` (without its `\n`)
+            struct line_span
+            {
+                location_type offset;
+                location_type size;
+                bool removed = false; // Whether the line has been removed (it is only dropped from `file_content` by `reassemble_lines`)
+            };
+
+            // Offsets of the start of each line of `file_content_raw`
+            std::vector<location_type> raw_line_starts;
+
+            // Where the comment stripping scan was at the start of a line of `file_content_raw`
+            enum class line_start_state : uint8_t
+            {
+                IN_COMMENT = 0, // The line starts in a comment, so the scan cannot be resumed from there
+                IN_CODE,
+                IN_STR_LIT
+            };
+            // The state of the scan at the start of each line of `file_content_raw` (empty until the comments are stripped)
+            std::vector<line_start_state> raw_line_states;
+
+            // The pragmas found so far, and whether all the lines have been searched for them
+            std::vector<pragma_loc_type> imports;
+            std::vector<pragma_loc_type> super_defines;
+            bool imports_searched = false;
+            bool super_defines_searched = false;
+            // The start line of the super define left open at the end of the file by the last search reaching it (0 if none),
+            // which swallows all the lines after it
+            location_type open_super_define = 0;
+
+            // Where the comment stripping scan is, between two code units of `file_content_raw`
+            struct strip_state
+            {
+                location_type pos = 0;      // Next code unit to look at
+                bool in_str_lit = false;    // Whether the scan is in a string literal
+                bool unterminated = false;  // Whether the scan stopped on an unterminated comment (starting at `pos`)
+            };
+            // What the comment stripping scan of a part of `file_content_raw` produces
+            struct strip_result
+            {
+                ParsedText<T> out;                   // The kept code units (only filled if `stripped_any`)
+                std::optional<ParsedChar<T>> before; // The last code unit kept before the scanned part, if any
+                bool stripped_any = false;           // Whether a comment was found (otherwise, the whole part is kept as is)
+                bool pops_before = false;            // Whether the whitespaces ending what was kept before `out` must be erased
+                std::vector<location_type> newlines; // Offsets of the kept `\n`s, from the start of the scanned part's output
+            };
+
+            // Pragmas lexed by `strip_comments(ThreadPool&, size_t)`, with the offset of their line in `file_content`
+            // (only used while `has_pragma_candidates` is true)
+            std::vector<std::pair<location_type, PragmaToken<T>>> pragma_candidates;
+            bool has_pragma_candidates = false;
+
             std::basic_ifstream<T>& get_file_stream(void);
             std::basic_string<T> remove_cstr_lit(void);
+            std::basic_string<T> get_raw_line(location_type line) const;
+            location_type raw_line_of(location_type pos) const;
+            ParsedChar<T> raw_char_at(location_type pos) const;
+            void append_raw(ParsedText<T>& out, location_type from, location_type to) const;
+            void record_line_start(location_type& line, const strip_state& state);
+            std::pair<location_type, location_type> raw_lines_of(const pragma_loc_type& loc) const;
+            static void record_pragma(std::vector<pragma_loc_type>& found, const pragma_loc_type& loc);
+            void index_lines(const std::vector<location_type>& newlines);
+            void remove_line(location_type line);
+            void reassemble_lines(void);
+            template <bool Output, typename OnLineStart>
+            strip_state scan_comments(strip_state from, location_type until, strip_result& res, OnLineStart&& on_line_start) const;
+            [[noreturn]] void throw_unterminated_comment(const ParsedText<T>& kept) const;
+            static PragmaToken<T> lex_pragma(std::basic_string_view<T> line);
+            PragmaToken<T> lex_pragma_line(const line_span& span, std::basic_string_view<T> line) const;
+#if !SUPDEF_WORKAROUND_GCC_INTERNAL_ERROR
+            Coro<Result<Parser<T>::pragma_loc_type, Error<T, std::filesystem::path>>> search_imports_in(location_type first_line, location_type end_line);
+#endif
+            Coro<Result<Parser<T>::pragma_loc_type, Error<T, std::filesystem::path>>> search_super_defines_in(location_type first_line, location_type end_line);
 
             // TODO: Implement the following three methods
             bool is_super_define_start(std::vector<ParsedChar<T>>& line);
@@ -3958,17 +7160,499 @@ POP_MACRO(DECLARE_FRIENDS3)
         public:
 #endif
             std::filesystem::path file_path;
-            std::vector<ParsedChar<T>> file_content;
-            std::vector<std::vector<ParsedChar<T>>> lines;
-            //std::shared_ptr<std::basic_string<T>> reassemble_lines(void);
+            ParsedText<T> file_content;
+            // The lines of `file_content`, in order (with the removed ones still there)
+            std::vector<line_span> lines;
+            location_type removed_lines = 0;
     };
 
 #undef NEED_Parser_TEMPLATES
 #define NEED_Parser_TEMPLATES 1
 #include <sup_def/common/parser.cpp>
 
+    /**
+     * @class ImportCache
+     * @brief A process-wide cache of the imported files once parsed, shared by all the engines and their threads
+     * @details A file is looked up by its canonical path and the version of it on disk (its modification time, size and inode), so
+     *          that a file which changed is parsed again, and only its latest version is kept. What the cache hands out is
+     *          never modified afterwards, and its definitions don't depend on the cache (they can outlive their entry).
+     *          Concurrent requests of the same file wait for the first one to parse it instead of parsing it again.
+     *          The parsed files can also be kept in a cache directory, for the next processes (only if asked for, see
+     *          @ref set_cache_dir): a file found there is used if it has the same version, or if it has the same content (its
+     *          hash), and its super defines are made again from the text of their pragmas kept there, without parsing the file
+     *          again. As what it holds is trusted, the directory and its files must be owned by the current user, and not
+     *          writable by anyone else
+     */
+    template <typename CharType>
+        requires CharacterType<CharType>
+    class ImportCache
+    {
+        public:
+            // A version of a file on disk
+            struct file_key
+            {
+                std::filesystem::path path;     // Canonical
+                std::int64_t mtime = 0;         // In nanoseconds
+                std::uintmax_t size = 0;
+                std::uint64_t inode = 0;        // Always 0 where there are no inodes
+
+                auto operator<=>(const file_key&) const = default;
+            };
+
+            struct parsed_file
+            {
+                file_key key;
+                std::uint64_t content_hash = 0;                 // See `ImportCache::content_hash` (of the bytes which were parsed)
+                std::vector<std::filesystem::path> imports;     // As written in the file (resolved by the importer)
+                std::vector<PragmaDef<CharType>> definitions;
+            };
+            using parsed_ptr = std::shared_ptr<const parsed_file>;
+
+        private:
+            using pragma_loc_type = Util::pragma_loc_type<CharType>;
+
+            // What a file is made of, as found by the parser
+            struct parsed_source
+            {
+                std::vector<std::basic_string<CharType>> imports;
+                std::vector<pragma_loc_type> definitions;
+            };
+
+            /*
+             * The files of the cache directory are made of a `disk_header`, then the `disk_string`s of the imports, then the
+             * `disk_definition`s, then the (interned) strings they refer to, so that they are found without parsing anything once
+             * mapped (each definition is still copied out of its pragma, then split and compiled as when it was first found)
+             */
+            struct disk_header
+            {
+                char magic[8];
+                std::uint32_t version;
+                std::uint16_t char_size;
+                std::uint16_t byte_order;
+                std::int64_t mtime;             // The version of the file when it was parsed
+                std::uint64_t size;
+                std::uint64_t inode;
+                std::uint64_t content_hash;
+                std::uint64_t nb_imports;
+                std::uint64_t nb_definitions;
+                std::uint64_t strings_size;     // In code units
+            };
+            struct disk_string
+            {
+                std::uint64_t offset;           // In code units, from the start of the strings
+                std::uint64_t length;
+            };
+            struct disk_definition
+            {
+                disk_string pragma;
+                std::uint64_t start_line;
+                std::uint64_t end_line;
+            };
+            static constexpr char disk_magic[8] = { 'S', 'D', 'I', 'M', 'P', 'O', 'R', 'T' };
+            static constexpr std::uint16_t disk_byte_order = 0x0102;
+
+            mutable std::mutex mtx{};
+            std::map<file_key, std::shared_future<parsed_ptr>> entries{};
+            std::map<std::filesystem::path, file_key> latest{};     // The version of each path in `entries`
+            std::filesystem::path cache_dir;                        // Where the parsed files are kept between processes (nowhere if empty), under the lock
+            size_t hits = 0;
+            size_t misses = 0;
+            size_t disk_hits = 0;
+
+            static parsed_source parse(const std::filesystem::path& path)
+            {
+                parsed_source src;
+                Parser<CharType> parser(path);
+                parser.slurp_file();
+                parser.strip_comments();
+#if !SUPDEF_WORKAROUND_GCC_INTERNAL_ERROR
+                for (auto&& found : parser.search_imports())
+                {
+                    if (found.is_null())
+                        continue;
+                    if (found.is_err())
+                        throw found.error();
+                    src.imports.push_back(std::get<0>(found.unwrap()));
+                }
+#else
+                for (auto&& found : search_imports(parser))
+                {
+                    if (found.is_null())
+                        continue;
+                    if (found.is_err())
+                        throw found.error();
+                    src.imports.push_back(*found.unwrap());
+                }
+#endif
+                for (auto&& found : parser.search_super_defines())
+                {
+                    if (found.is_null())
+                        continue;
+                    if (found.is_err())
+                        throw found.error();
+                    src.definitions.push_back(found.unwrap());
+                }
+                return src;
+            }
+
+            static parsed_ptr build(const file_key& key, std::uint64_t hash, const parsed_source& src)
+            {
+                auto parsed = std::make_shared<parsed_file>();
+                parsed->key = key;
+                parsed->content_hash = hash;
+                for (const auto& name : src.imports)
+                    parsed->imports.emplace_back(name);
+                for (const auto& loc : src.definitions)
+                    parsed->definitions.emplace_back(loc);
+                return parsed;
+            }
+
+            static std::filesystem::path disk_path(const std::filesystem::path& dir, const std::filesystem::path& path)
+            {
+                const std::string native = path.string();
+                return dir / (Util::hex(Util::fnv1a({ native })) + Util::hex(Util::fnv1a({ native }, 0x84222325cbf29ce4ULL)) + ".sdi");
+            }
+
+            // The header of the file mapped in @p mapped, if it is a complete file of this version of the cache
+            static const disk_header* check_disk_file(const MappedFile& mapped) noexcept
+            {
+                const std::string_view bytes = mapped.view<char>();
+                if (bytes.size() < sizeof(disk_header))
+                    return nullptr;
+                const disk_header* header = reinterpret_cast<const disk_header*>(bytes.data());
+                if (std::memcmp(header->magic, disk_magic, sizeof(disk_magic)) != 0 || header->version != SUPDEF_IMPORT_CACHE_VERSION ||
+                    header->char_size != sizeof(CharType) || header->byte_order != disk_byte_order)
+                    return nullptr;
+                // Each count is bounded by what the file could hold before being multiplied, so that the sizes can't overflow
+                if (header->nb_imports > bytes.size() / sizeof(disk_string) || header->nb_definitions > bytes.size() / sizeof(disk_definition) ||
+                    header->strings_size > bytes.size() / sizeof(CharType))
+                    return nullptr;
+                const std::uint64_t tables = header->nb_imports * sizeof(disk_string) + header->nb_definitions * sizeof(disk_definition);
+                if (sizeof(disk_header) + tables + header->strings_size * sizeof(CharType) != bytes.size())
+                    return nullptr;
+                return header;
+            }
+
+            // Read the parsed file from its mapped cache file (checked by `check_disk_file`), or nothing if it is corrupted
+            static parsed_ptr read_disk_file(const MappedFile& mapped, const file_key& key)
+            {
+                const char* base = mapped.view<char>().data();
+                const disk_header* header = reinterpret_cast<const disk_header*>(base);
+                const disk_string* imports = reinterpret_cast<const disk_string*>(base + sizeof(disk_header));
+                const disk_definition* definitions = reinterpret_cast<const disk_definition*>(imports + header->nb_imports);
+                const CharType* strings = reinterpret_cast<const CharType*>(definitions + header->nb_definitions);
+                auto string_at = [&](const disk_string& str) -> std::optional<std::basic_string_view<CharType>>
+                {
+                    if (str.offset > header->strings_size || str.length > header->strings_size - str.offset)
+                        return std::nullopt;
+                    return std::basic_string_view<CharType>(strings + str.offset, str.length);
+                };
+
+                auto parsed = std::make_shared<parsed_file>();
+                parsed->key = key;
+                parsed->content_hash = header->content_hash;
+                for (std::uint64_t i = 0; i < header->nb_imports; ++i)
+                {
+                    const auto name = string_at(imports[i]);
+                    if (!name.has_value())
+                        return nullptr;
+                    parsed->imports.emplace_back(*name);
+                }
+                for (std::uint64_t i = 0; i < header->nb_definitions; ++i)
+                {
+                    const auto pragma = string_at(definitions[i].pragma);
+                    if (!pragma.has_value())
+                        return nullptr;
+                    parsed->definitions.emplace_back(pragma_loc_type(
+                        std::basic_string<CharType>(*pragma),
+                        static_cast<string_size_type<CharType>>(definitions[i].start_line),
+                        static_cast<string_size_type<CharType>>(definitions[i].end_line)
+                    ));
+                }
+                return parsed;
+            }
+
+            // Write @p src to the cache directory @p dir (as another process may be reading the previous file, it is replaced at once)
+            static void write_disk_file(const std::filesystem::path& dir, const file_key& key, std::uint64_t hash, const parsed_source& src)
+            {
+                std::basic_string<CharType> strings;
+                std::unordered_map<std::basic_string_view<CharType>, disk_string> interned;
+                // (the views point into `src`, as `strings` may move while growing)
+                auto intern = [&](const std::basic_string<CharType>& str) -> disk_string
+                {
+                    auto [it, inserted] = interned.try_emplace(std::basic_string_view<CharType>(str), disk_string{ strings.size(), str.size() });
+                    if (inserted)
+                        strings += str;
+                    return it->second;
+                };
+                std::vector<disk_string> imports;
+                for (const auto& name : src.imports)
+                    imports.push_back(intern(name));
+                std::vector<disk_definition> definitions;
+                for (const auto& loc : src.definitions)
+                    definitions.push_back(disk_definition{ intern(std::get<0>(loc)), std::get<1>(loc), std::get<2>(loc) });
+
+                disk_header header{};
+                std::memcpy(header.magic, disk_magic, sizeof(disk_magic));
+                header.version = SUPDEF_IMPORT_CACHE_VERSION;
+                header.char_size = sizeof(CharType);
+                header.byte_order = disk_byte_order;
+                header.mtime = key.mtime;
+                header.size = key.size;
+                header.inode = key.inode;
+                header.content_hash = hash;
+                header.nb_imports = imports.size();
+                header.nb_definitions = definitions.size();
+                header.strings_size = strings.size();
+
+                std::error_code ec;
+                const std::filesystem::path dst = disk_path(dir, key.path);
+                static std::atomic<size_t> writes = 0;
+#if SUPDEF_ON_UNIX
+                const std::string unique = "." + std::to_string(::getpid()) + "." + std::to_string(writes++) + ".tmp";
+#else
+                const std::string unique = "." + std::to_string(writes++) + ".tmp";
+#endif
+                std::filesystem::path tmp = dst;
+                tmp += unique;
+                {
+                    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+                    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                    out.write(reinterpret_cast<const char*>(imports.data()), static_cast<std::streamsize>(imports.size() * sizeof(disk_string)));
+                    out.write(reinterpret_cast<const char*>(definitions.data()), static_cast<std::streamsize>(definitions.size() * sizeof(disk_definition)));
+                    out.write(reinterpret_cast<const char*>(strings.data()), static_cast<std::streamsize>(strings.size() * sizeof(CharType)));
+                    if (!out.good())
+                        ec = std::make_error_code(std::errc::io_error);
+                }
+                // (whatever the umask, as a file others can write to would never be read back)
+                if (!ec)
+                    std::filesystem::permissions(tmp, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write, ec);
+                // The cache is only there to go faster: failing to write it is not an error
+                if (ec)
+                    std::filesystem::remove(tmp, ec);
+                else
+                    std::filesystem::rename(tmp, dst, ec);
+            }
+
+            // Get the parsed file from the cache directory if it has it (even for another version of the file, as long as the
+            // content didn't change), or parse it (and keep it there)
+            parsed_ptr load(const file_key& key)
+            {
+                const std::filesystem::path dir = this->get_cache_dir();
+                // (hashed before being parsed, so that a file changed in between doesn't look like the version which was hashed)
+                if (dir.empty())
+                {
+                    const std::uint64_t hash = content_hash(key.path);
+                    return build(key, hash, parse(key.path));
+                }
+                std::optional<std::uint64_t> hash;
+                if (const std::filesystem::path disk = disk_path(dir, key.path); Util::is_private_path(disk, false))
+                {
+                    const MappedFile mapped(disk);
+                    if (const disk_header* header = check_disk_file(mapped); header != nullptr)
+                    {
+                        const bool same_version = header->mtime == key.mtime && header->size == key.size && header->inode == key.inode;
+                        if (!same_version)
+                            hash = content_hash(key.path);
+                        if (same_version || header->content_hash == *hash)
+                        {
+                            if (parsed_ptr parsed = read_disk_file(mapped, key); parsed != nullptr)
+                            {
+                                std::lock_guard<std::mutex> lock(this->mtx);
+                                ++this->disk_hits;
+                                return parsed;
+                            }
+                        }
+                    }
+                }
+                if (!hash.has_value())
+                    hash = content_hash(key.path);
+                const parsed_source src = parse(key.path);
+                write_disk_file(dir, key, *hash, src);
+                return build(key, *hash, src);
+            }
+
+        public:
+            /**
+             * @param cache_dir Where to keep the parsed files, so that other processes don't have to parse them again (see
+             *                  @ref set_cache_dir)
+             */
+            explicit ImportCache(std::filesystem::path cache_dir = std::filesystem::path())
+            {
+                this->set_cache_dir(std::move(cache_dir));
+            }
+            ImportCache(const ImportCache&) = delete;
+            ImportCache(ImportCache&&) = delete;
+            ImportCache& operator=(const ImportCache&) = delete;
+            ImportCache& operator=(ImportCache&&) = delete;
+
+            // The cache of the process, only in memory until given a cache directory
+            static ImportCache& instance(void)
+            {
+                static ImportCache cache;
+                return cache;
+            }
+
+            // `SUPDEF_IMPORT_CACHE_DIR_NAME` in the cache of the current user (empty if there is no private one)
+            static std::filesystem::path default_cache_dir(void)
+            {
+                return Util::user_cache_dir(SUPDEF_IMPORT_CACHE_DIR_NAME);
+            }
+
+            /**
+             * @brief Keep the parsed files in @p dir from now on (created with mode 0700 if needed), or only in memory if empty
+             * @return Whether @p dir is used, which it isn't (the cache staying in memory) if it isn't a directory owned by the
+             *         current user that no one else can write to
+             */
+            bool set_cache_dir(std::filesystem::path dir)
+            {
+                if (!dir.empty() && !Util::make_private_dir(dir))
+                    dir.clear();
+                std::lock_guard<std::mutex> lock(this->mtx);
+                this->cache_dir = std::move(dir);
+                return !this->cache_dir.empty();
+            }
+
+            inline std::filesystem::path get_cache_dir(void) const
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                return this->cache_dir;
+            }
+
+            // The current version of the file at @p path
+            static file_key key_of(const std::filesystem::path& path)
+            {
+                std::error_code ec;
+                file_key key;
+                key.path = std::filesystem::canonical(path, ec);
+                if (ec)
+                    throw Exception<char, std::filesystem::path>(ExcType::NO_INPUT_FILE_ERROR, "Could not find " + path.string() + ": " + ec.message());
+#if SUPDEF_ON_UNIX
+                struct stat st;
+                if (::stat(key.path.c_str(), &st) != 0)
+                    throw Exception<char, std::filesystem::path>(ExcType::NO_INPUT_FILE_ERROR, "Could not stat " + key.path.string() + ": " + std::error_code(errno, std::generic_category()).message());
+                key.mtime = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+                key.size = static_cast<std::uintmax_t>(st.st_size);
+                key.inode = static_cast<std::uint64_t>(st.st_ino);
+#else
+                key.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::filesystem::last_write_time(key.path).time_since_epoch()).count();
+                key.size = std::filesystem::file_size(key.path);
+#endif
+                return key;
+            }
+
+            // FNV-1a of the bytes of the file at @p path (the same in every process)
+            static std::uint64_t content_hash(const std::filesystem::path& path)
+            {
+                const MappedFile mapped(path);
+                if (mapped.is_mapped())
+                    return Util::fnv1a({ mapped.view<char>() });
+                std::ifstream in(path, std::ios::binary);
+                const std::string content{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+                return Util::fnv1a({ content });
+            }
+
+            /**
+             * @brief Get the file at @p path parsed, parsing it if its current version isn't in the cache yet
+             * @details If another thread is already parsing this version, wait for it instead. A file which fails to be parsed
+             *          isn't kept, and the threads waiting for it get the same exception
+             */
+            parsed_ptr get(const std::filesystem::path& path)
+            {
+                const file_key key = key_of(path);
+                std::promise<parsed_ptr> promise;
+                std::shared_future<parsed_ptr> future;
+                bool inserted;
+                {
+                    std::lock_guard<std::mutex> lock(this->mtx);
+                    typename std::map<file_key, std::shared_future<parsed_ptr>>::iterator it;
+                    std::tie(it, inserted) = this->entries.try_emplace(key);
+                    if (!inserted)
+                    {
+                        ++this->hits;
+                        future = it->second;
+                    }
+                    else
+                    {
+                        ++this->misses;
+                        future = it->second = promise.get_future().share();
+                        // Only the latest version of a file is kept
+                        auto [last, first_version] = this->latest.try_emplace(key.path, key);
+                        if (!first_version)
+                        {
+                            this->entries.erase(last->second);
+                            last->second = key;
+                        }
+                    }
+                }
+                if (!inserted)
+                    return future.get();
+                try
+                {
+                    promise.set_value(this->load(key));
+                }
+                catch (...)
+                {
+                    promise.set_exception(std::current_exception());
+                    std::lock_guard<std::mutex> lock(this->mtx);
+                    if (auto it = this->latest.find(key.path); it != this->latest.end() && it->second == key)
+                    {
+                        this->entries.erase(key);
+                        this->latest.erase(it);
+                    }
+                }
+                return future.get();
+            }
+
+            void clear(void)
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                this->entries.clear();
+                this->latest.clear();
+                this->hits = 0;
+                this->misses = 0;
+                this->disk_hits = 0;
+            }
+
+            // Number of files in the cache
+            inline size_t size(void) const
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                return this->entries.size();
+            }
+
+            // Requests answered from the cache (including the ones waiting for another thread to parse the file)
+            inline size_t get_hits(void) const
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                return this->hits;
+            }
+
+            // Requests which weren't answered from memory (see `get_disk_hits` for how many of them didn't parse the file)
+            inline size_t get_misses(void) const
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                return this->misses;
+            }
+
+            // Requests answered from the cache directory
+            inline size_t get_disk_hits(void) const
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                return this->disk_hits;
+            }
+    };
+
     /**
      * @brief A class representing a SupDef engine
+     * @details The engine preprocesses a number of targets (a source file, and where to write the result) at once, in a
+     *          @class Pipeline of four stages (loading, comment stripping, pragma scanning, and expansion into the output) run on its
+     *          thread pool, so that the different stages of different files overlap. All the targets share the same symbol table,
+     *          each of them in its own scope.
+     *          The files imported by the targets make up an import graph, in which each file is defined once (in its own scope)
+     *          however many files import it, and parsed through the process-wide @class ImportCache. The super defines of a file are defined once all its imports are, on the
+     *          thread pool, so that independent parts of the graph are processed in parallel, and a target is expanded once all
+     *          its imports are. An import cycle makes the targets reaching it fail
      * 
      * @tparam P1 The character type of the manipulated files (char, wchar_t, char8_t, char16_t, char32_t)
      * @tparam P2 The type of the path of the manipulated files (std::filesystem::path, std::basic_string<char>, std::basic_string<wchar_t>, std::basic_string<char8_t>, std::basic_string<char16_t>, std::basic_string<char32_t>)
@@ -3982,12 +7666,128 @@ POP_MACRO(DECLARE_FRIENDS3)
             using dst_file_t = File<std::basic_ofstream<P1>>;
             using tmp_file_t = File<std::basic_fstream<P1>>;
             
-            using target_t = std::tuple<src_file_t, dst_file_t, tmp_file_t, bool>;
+            // A file to preprocess, and where to write the result
+            struct target_t
+            {
+                std::filesystem::path src;
+                std::filesystem::path dst;
+                bool done = false;                  // Whether it went through a `run` (successfully or not)
+                bool skipped = false;               // Whether its output was up to date, and left as is (see `set_build_records`)
+                std::exception_ptr error = nullptr; // Why it could not be written, if it couldn't
+            };
 
         private:
+            // What the pipeline keeps for a target while it goes through it
+            struct unit
+            {
+                std::pmr::monotonic_buffer_resource arena;      // Memory of its `PragmaDef`s (kept until `restart`, as the symbol table refers to them)
+                std::optional<Parser<P1>> parser;               // Dropped once expanded
+                typename SymbolTable<P1>::scope_id scope = SymbolTable<P1>::global_scope;
+                size_t expansions = 0;
+                std::vector<size_t> imports;                    // The nodes of the import graph it imports
+                std::vector<std::filesystem::path> import_names;    // Its imports as written in its source (for its build record)
+                typename ImportCache<P1>::file_key key{};           // The version of its source which was loaded (same)
+                std::uint64_t content_hash = 0;
+            };
+
+            // A file imported (directly or not) by some targets, defined once however many files import it
+            struct import_node
+            {
+                std::filesystem::path path;
+                typename SymbolTable<P1>::scope_id scope;
+                typename ImportCache<P1>::parsed_ptr file{};    // Dropped once its super defines are defined
+                typename ImportCache<P1>::file_key key{};       // What the build records need to know of it, kept after `file` is dropped
+                std::uint64_t content_hash = 0;
+                std::vector<std::filesystem::path> names{};     // Its imports as written in the file
+                std::vector<size_t> imports{};                  // The nodes it imports
+                std::vector<size_t> importers{};                // The nodes importing it
+                size_t waiting = 0;                             // How many of its imports aren't complete yet
+                bool parsed = false;
+                bool defining = false;
+                bool complete = false;                          // Defined after all its imports, or failed
+                std::exception_ptr error = nullptr;             // Why it (or one of its imports) failed
+            };
+
+            // What the output of a target was made from, to know whether it is up to date (see `set_build_records`)
+            struct build_record
+            {
+                // A file the output depends on: the source of the target, or a file it imports (directly or not)
+                struct dependency
+                {
+                    std::filesystem::path path;                 // As the engine found it
+                    typename ImportCache<P1>::file_key key;     // Its version when the output was made
+                    std::uint64_t content_hash = 0;
+                    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> imports{};    // As written in it, and where they were found
+                };
+
+                std::uint64_t options = 0;                      // See `options_hash`
+                typename ImportCache<P1>::file_key output;      // The version of the output which was written
+                std::vector<dependency> dependencies;           // The source first
+            };
+            // What `up_to_date` found out about the files during a `run`, so that a file imported by many targets is checked once
+            struct file_checks
+            {
+                std::map<std::filesystem::path, typename ImportCache<P1>::file_key> keys;
+                std::map<std::filesystem::path, std::uint64_t> hashes;
+            };
+
             std::unordered_map<std::shared_ptr<SrcFile<P1, P2>>, Parser<P1>> parser_pool;
             ThreadPool thread_pool;            
             std::vector<target_t> targets;
+            std::deque<unit> units;                         // One for each of the `targets` which went through a `run`
+            // The import graph of all the targets, kept until `restart` (so that a file is parsed once per engine), and destroyed
+            // after the symbol table which refers to the definitions of its nodes
+            std::mutex imports_mtx{};
+            std::condition_variable imports_cv{};
+            std::deque<import_node> import_nodes;
+            std::map<std::filesystem::path, size_t> import_index;
+            size_t pending_imports = 0;                     // Tasks of the import graph queued on the thread pool and not done yet
+            Pipeline* pipeline = nullptr;                   // The pipeline of the current `run`, woken up when nodes complete
+            size_t concurrency;                             // Maximum number of files each stage of the pipeline runs on at once
+            std::filesystem::path records_dir;              // Where the build records are kept (nowhere, and no target is skipped, if empty)
+            std::vector<Pipeline::stage_stats> stats;       // How each stage of the pipeline went during the last `run`
+            std::pmr::monotonic_buffer_resource arena;      // Upstream of the arena of the symbol table (only used under its lock), released by `restart`
+            ExpansionCache<P1> expansion_cache;
+            SymbolTable<P1> symbol_table;
+            typename ConditionEvaluator<P1>::constant_cache_type constant_conditions;  // Kept by `restart`, as they don't depend on any source
+
+            void load(unit& u, const target_t& target);
+            // Define the super defines of the target of @p u in its scope, and add the files it imports to the import graph
+            void scan(unit& u);
+            // Expand the target of @p u straight into its output (once all its imports are defined), then record what it was made from
+            void write(unit& u, const target_t& target);
+
+            // Whether the output of @p target was made from the current version of all the files it depends on, with the same options
+            bool up_to_date(const target_t& target, file_checks& checked) const;
+            // Keep what the output of @p target was just made from
+            void record(const unit& u, const target_t& target);
+            // What changes the output of a target besides the files it depends on
+            std::uint64_t options_hash(void) const;
+            std::filesystem::path record_path(const std::filesystem::path& dst) const;
+            static std::optional<build_record> read_record(const std::filesystem::path& path);
+            // Write @p record to @p path (as another process may be reading the previous one, it is replaced at once)
+            static void write_record(const std::filesystem::path& path, const build_record& record);
+
+            // The names of the files imported by @p parser, as written
+            std::vector<std::filesystem::path> find_imports(Parser<P1>& parser) const;
+            // The path of the file imported as @p name by @p importer, relative to it or as `Util::get_included_fpath` finds it
+            std::filesystem::path resolve_import(const std::filesystem::path& name, const std::filesystem::path& importer) const;
+            void define_all(Parser<P1>& parser, typename SymbolTable<P1>::scope_id scope, std::pmr::memory_resource* resource);
+            // The node of @p path, added to the graph (and queued to be parsed) if it isn't in it yet
+            // The lock of the import graph must be held
+            size_t import_file(const std::filesystem::path& path);
+            void parse_import(size_t node);
+            void define_import(size_t node);
+            // Queue the definition of @p node once all its imports are complete, or complete it if it failed
+            // The lock of the import graph must be held
+            void settle(size_t node);
+            void complete(size_t node, std::exception_ptr error);
+            // Fail the nodes which can never complete, as they are in an import cycle (or import one)
+            // The lock of the import graph must be held, and no task of the graph be pending
+            void fail_cycles(void);
+            // End a task of the import graph: wake the pipeline up, as some targets may be ready to be expanded
+            void end_import_task(void);
+            size_t expand(const Parser<P1>& parser, typename SymbolTable<P1>::scope_id scope, ExpansionCache<P1>& cache, std::basic_ostream<P1>& dst);
 
         public:
             Engine();
@@ -3997,6 +7797,64 @@ POP_MACRO(DECLARE_FRIENDS3)
 
             ~Engine() noexcept;
 
+            // Add a target, preprocessed by the next `run`
+            template <typename T, typename U>
+                requires FilePath<std::remove_cvref_t<T>> && FilePath<std::remove_cvref_t<U>>
+            void add_target(T&& src, U&& dst);
+
+            /**
+             * @brief Preprocess the targets added since the last run, the stages of different targets running concurrently
+             * @details The targets which are up to date are skipped (see `set_build_records`)
+             * @return The number of targets which could not be written (their `error` says why)
+             */
+            size_t run(void);
+
+            inline const std::vector<target_t>& get_targets(void) const noexcept
+            {
+                return this->targets;
+            }
+
+            // Maximum number of files each stage of the pipeline runs on at once (the size of the thread pool by default)
+            inline void set_concurrency(size_t concurrency) noexcept
+            {
+                this->concurrency = std::max<size_t>(concurrency, 1);
+            }
+
+            /**
+             * @brief Skip the targets whose output is up to date, from now on
+             * @details The engine keeps a record in @p dir of what each output it writes is made from: the version and content
+             *          hash of the source and of all the files it imports (directly or not), where each import was found, and the
+             *          options changing the output (like the include paths). A target is then skipped, its output left untouched
+             *          (so that what depends on it isn't made again), if none of them changed and the output is still the one
+             *          which was written. Nothing is recorded, and no target is skipped, if @p dir is empty
+             * @return Whether @p dir (created with mode 0700 if needed) is used, which it isn't if it isn't a directory owned by
+             *         the current user that no one else can write to
+             */
+            inline bool set_build_records(std::filesystem::path dir)
+            {
+                if (!dir.empty() && !Util::make_private_dir(dir))
+                    dir.clear();
+                this->records_dir = std::move(dir);
+                return !this->records_dir.empty();
+            }
+
+            inline const std::filesystem::path& get_build_records(void) const noexcept
+            {
+                return this->records_dir;
+            }
+
+            // `SUPDEF_BUILD_RECORD_DIR_NAME` in the cache of the current user (empty if there is no private one)
+            static std::filesystem::path default_build_records(void)
+            {
+                return Util::user_cache_dir(SUPDEF_BUILD_RECORD_DIR_NAME);
+            }
+
+            // How each stage of the pipeline (loading, comment stripping, pragma scanning, and expansion into the output) went during the last `run`
+            inline const std::vector<Pipeline::stage_stats>& get_stats(void) const noexcept
+            {
+                return this->stats;
+            }
+
 #ifdef ADD_INC_PATH
     #undef ADD_INC_PATH
 #endif
@@ -4027,6 +7885,31 @@ POP_MACRO(DECLARE_FRIENDS3)
             template <typename T, typename U>
                 requires FilePath<std::remove_cvref_t<T>> && FilePath<std::remove_cvref_t<U>>
             void restart(T&& src, U&& dst);
+
+            inline ExpansionCache<P1>& get_expansion_cache(void) noexcept
+            {
+                return this->expansion_cache;
+            }
+
+            inline SymbolTable<P1>& get_symbol_table(void) noexcept
+            {
+                return this->symbol_table;
+            }
+
+            // Where to allocate what only lives until the next `restart` (e.g. the `PragmaDef`s of the translation units)
+            inline std::pmr::memory_resource* get_arena(void) noexcept
+            {
+                return std::addressof(this->arena);
+            }
+
+            inline typename ConditionEvaluator<P1>::constant_cache_type& get_constant_conditions(void) noexcept
+            {
+                return this->constant_conditions;
+            }
+
+            // Write the content left by @p parser to @p dst, keeping only the branches of its conditional pragmas which are taken,
+            // with the invocations of the super defines visible from @p scope expanded
+            size_t expand(const Parser<P1>& parser, typename SymbolTable<P1>::scope_id scope, std::basic_ostream<P1>& dst);
     };
 
 #undef NEED_Engine_TEMPLATES
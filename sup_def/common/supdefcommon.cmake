@@ -12,6 +12,8 @@ set(
     "${CMAKE_CURRENT_LIST_DIR}/parsed_char.cpp"
     "${CMAKE_CURRENT_LIST_DIR}/parser.cpp"
     "${CMAKE_CURRENT_LIST_DIR}/parser.tpp"
+    "${CMAKE_CURRENT_LIST_DIR}/pragma_lexer.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/pragma_lexer.tpp"
     "${CMAKE_CURRENT_LIST_DIR}/pragmas.cpp"
     "${CMAKE_CURRENT_LIST_DIR}/pragmas.tpp"
     "${CMAKE_CURRENT_LIST_DIR}/start_header.h"
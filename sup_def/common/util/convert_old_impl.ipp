@@ -148,6 +148,9 @@
             requires CharacterType<C1> && CharacterType<C2>
         inline std::basic_string<C1> convert(const C2& c)
         {
+            // No need to go through a `std::codecvt` for ASCII characters
+            if (is_ascii(c))
+                return std::basic_string<C1>(1, static_cast<C1>(c));
             return convert<C1>(std::basic_string<C2>(1, c));
         }
 
@@ -155,6 +158,9 @@
             requires CharacterType<C1> && CharacterType<C2>
         inline std::basic_string<C1> convert(const C2&& c)
         {
+            // No need to go through a `std::codecvt` for ASCII characters
+            if (is_ascii(c))
+                return std::basic_string<C1>(1, static_cast<C1>(c));
             return convert<C1>(std::basic_string<C2>(1, c));
         }
 
@@ -31,13 +31,20 @@
 #include <filesystem>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <algorithm>
+#include <bit>
 #include <type_traits>
 #include <concepts>
 #include <compare>
 #include <utility>
+#include <cstdlib>
+#include <cerrno>
 
 #if SUPDEF_ON_UNIX
     #include <sys/types.h>
+    #include <sys/stat.h>
     #include <sys/syscall.h>
     #include <unistd.h>
 #endif
@@ -699,6 +706,95 @@ namespace SupDef
             return std::filesystem::canonical(file_path);
         }
 
+        // 64-bit FNV-1a, which (unlike `std::hash`) is the same in every process
+        inline uint64_t fnv1a(std::initializer_list<std::string_view> parts, uint64_t hash = 0xcbf29ce484222325ULL) noexcept
+        {
+            for (std::string_view part : parts)
+            {
+                for (char c : part)
+                {
+                    hash ^= static_cast<unsigned char>(c);
+                    hash *= 0x100000001b3ULL;
+                }
+                // Separate the parts, so that moving a character from one to the next changes the hash
+                hash ^= 0xff;
+                hash *= 0x100000001b3ULL;
+            }
+            return hash;
+        }
+
+        // The 16 hexadecimal digits of @p value
+        inline std::string hex(uint64_t value)
+        {
+            static constexpr char digits[] = "0123456789abcdef";
+            std::string res(16, '0');
+            for (size_t i = 16; i > 0; --i, value >>= 4)
+                res[i - 1] = digits[value & 0xf];
+            return res;
+        }
+
+        /**
+         * @brief Whether @p path (not followed if it is a symbolic link) is a directory (or a regular file if @p is_dir is
+         *        false) owned by the current user, that no one else can write to
+         * @details What such a path holds can be trusted as much as what the current user wrote (e.g. loaded as a shared
+         *          library). Always true where there is no such thing as an owner
+         */
+        inline bool is_private_path(const std::filesystem::path& path, bool is_dir)
+        {
+#if SUPDEF_ON_UNIX
+            struct ::stat st;
+            if (::lstat(path.c_str(), &st) != 0)
+                return false;
+            if (is_dir ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode))
+                return false;
+            return st.st_uid == ::geteuid() && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+#else
+            return is_dir ? std::filesystem::is_directory(path) : std::filesystem::is_regular_file(path);
+#endif
+        }
+
+        /**
+         * @brief Create the directory @p dir (and its parents) if needed, only accessible to the current user
+         * @return Whether @p dir is then a private directory (see @ref is_private_path)
+         */
+        inline bool make_private_dir(const std::filesystem::path& dir)
+        {
+            std::error_code ec;
+            if (dir.has_parent_path())
+                std::filesystem::create_directories(dir.parent_path(), ec);
+#if SUPDEF_ON_UNIX
+            // Not `std::filesystem::create_directories`, as there would be a window during which anyone could write to it
+            if (::mkdir(dir.c_str(), S_IRWXU) != 0 && errno != EEXIST)
+                return false;
+#else
+            std::filesystem::create_directory(dir, ec);
+#endif
+            return is_private_path(dir, true);
+        }
+
+        /**
+         * @brief Get the directory named @p name in the cache of the current user, creating it if needed
+         * @details That is, `$XDG_CACHE_HOME/<name>`, or `$HOME/.cache/<name>` if `XDG_CACHE_HOME` isn't set (or isn't an
+         *          absolute path), created with mode 0700 (in the temporary directory, already per user, on other systems)
+         * @return The directory, or an empty path if there is no such private directory (see @ref make_private_dir)
+         */
+        inline std::filesystem::path user_cache_dir(std::string_view name)
+        {
+            std::filesystem::path base;
+#if SUPDEF_ON_UNIX
+            if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && xdg[0] == '/')
+                base = xdg;
+            else if (const char* home = std::getenv("HOME"); home != nullptr && home[0] == '/')
+                base = std::filesystem::path(home) / ".cache";
+            else
+                return std::filesystem::path();
+#else
+            base = std::filesystem::temp_directory_path();
+#endif
+            const std::filesystem::path dir = base / name;
+            return Util::make_private_dir(dir) ? dir : std::filesystem::path();
+        }
+
         // To pass as a deleter to a std::shared_ptr<void> that stores a pointer to a type T
         template <typename T>
         static void shared_deleter(void* ptr)
@@ -1682,6 +1778,132 @@ namespace SupDef
         static_assert(!IsValidCodeCvt<wchar_t, char32_t>);
         static_assert(!IsValidCodeCvt<char32_t, wchar_t>);
 
+        /**
+         * @brief Get the value of the code unit @p c, as an unsigned integer
+         * 
+         * @tparam C The character type of @p c
+         */
+        template <typename C>
+            requires CharacterType<C>
+        constexpr inline std::uint32_t code_unit_value(const C c) noexcept
+        {
+            return static_cast<std::uint32_t>(static_cast<std::make_unsigned_t<std::remove_cvref_t<C>>>(c));
+        }
+
+        /**
+         * @brief Check if the code unit @p c is an ASCII character
+         * @details An ASCII code unit encodes the same character in every encoding used by the character types
+         *          (UTF-8, UTF-16, UTF-32), and is never part of the encoding of a non-ASCII character, so it can be
+         *          compared to a code unit of any other character type without converting any of them
+         * 
+         * @tparam C The character type of @p c
+         */
+        template <typename C>
+            requires CharacterType<C>
+        constexpr inline bool is_ascii(const C c) noexcept
+        {
+            return code_unit_value(c) < 0x80;
+        }
+
+        /**
+         * @brief Find the positions of some ASCII delimiters in a string, a block of code units at a time
+         * @details All the code units of a block are compared to the delimiters at once (with `std::experimental::simd` when
+         *          available), which gives a bitmask of the positions of the delimiters in the block. A scanner can then jump
+         *          from one delimiter to the next one without looking at the code units in between.
+         *          Since the delimiters are ASCII, comparing the code units is enough, whatever the character type (see @ref is_ascii).
+         * 
+         * @tparam C The character type of the string
+         * @tparam Delims The delimiters
+         */
+        template <typename C, char... Delims>
+            requires CharacterType<C> && (sizeof...(Delims) > 0) && ((static_cast<unsigned char>(Delims) < 0x80) && ...)
+        class DelimiterFinder
+        {
+            public:
+                typedef std::uint64_t mask_type;
+                typedef std::make_unsigned_t<std::remove_cvref_t<C>> unit_type;
+
+                // 32 bytes whatever the character type (so one AVX2 register, or two SSE2 ones)
+                static constexpr size_t block_size = 32 / sizeof(C);
+                static_assert(block_size <= sizeof(mask_type) * 8);
+
+            private:
+                std::basic_string_view<C> text;
+                // Start of the last block looked at, and the bitmask of its delimiters
+                size_t block_start = std::basic_string_view<C>::npos;
+                mask_type block_delims = 0;
+
+                static constexpr inline bool is_delim(unit_type c) noexcept
+                {
+                    return ((c == static_cast<unit_type>(Delims)) || ...);
+                }
+
+            public:
+                explicit DelimiterFinder(std::basic_string_view<C> text) noexcept : text(text)
+                { }
+
+                /**
+                 * @brief Get the bitmask of the delimiters among the `block_size` code units starting at @p data
+                 * @details Bit `n` is set if and only if `data[n]` is one of the delimiters
+                 */
+                static inline mask_type block_mask(const C* data) noexcept
+                {
+#if __cpp_lib_experimental_parallel_simd >= 201803L
+                    typedef stdx::fixed_size_simd<unit_type, block_size> block_type;
+                    const block_type units(reinterpret_cast<const unit_type*>(data), stdx::element_aligned);
+                    const auto found = ((units == block_type(static_cast<unit_type>(Delims))) || ...);
+                    // Most blocks have no delimiter at all, and are only tested once
+                    if (stdx::none_of(found))
+                        return 0;
+                    mask_type res = 0;
+                    for (size_t i = 0; i < block_size; ++i)
+                        res |= mask_type(found[i]) << i;
+                    return res;
+#else
+                    mask_type res = 0;
+                    for (size_t i = 0; i < block_size; ++i)
+                        res |= mask_type(is_delim(static_cast<unit_type>(data[i]))) << i;
+                    return res;
+#endif
+                }
+
+                /**
+                 * @brief Same as @ref block_mask, for a block of only @p count (< `block_size`) code units
+                 */
+                static inline mask_type partial_mask(const C* data, size_t count) noexcept
+                {
+                    mask_type res = 0;
+                    for (size_t i = 0; i < count; ++i)
+                        res |= mask_type(is_delim(static_cast<unit_type>(data[i]))) << i;
+                    return res;
+                }
+
+                /**
+                 * @brief Get the position of the first delimiter at or after @p pos, or the size of the text if there is none
+                 * @details The bitmask of the last block is kept, so that going through the delimiters of a block in order
+                 *          only loads and compares it once
+                 */
+                inline size_t next(size_t pos) noexcept
+                {
+                    const size_t size = this->text.size();
+                    while (pos < size)
+                    {
+                        const size_t start = pos - pos % block_size;
+                        if (start != this->block_start)
+                        {
+                            this->block_start = start;
+                            this->block_delims = (start + block_size <= size) ? block_mask(this->text.data() + start)
+                                                                              : partial_mask(this->text.data() + start, size - start);
+                        }
+                        const mask_type remaining = this->block_delims & (~mask_type(0) << (pos - start));
+                        if (remaining != 0)
+                            return start + static_cast<size_t>(std::countr_zero(remaining));
+                        pos = start + block_size;
+                    }
+                    return size;
+                }
+        };
+
 #if 0
 #if 0
         // Base template
@@ -1903,17 +2125,40 @@ namespace SupDef
 #endif
 #define CONVERT_NUM(TYPE, STR_OR_NUM) ::SupDef::Util::convert_num<TYPE>(STR_OR_NUM)
 
+        /**
+         * @brief Compare two sequences of code units, one of them being only made of ASCII characters, without converting them
+         * @details Since an ASCII code unit is never part of the encoding of a non-ASCII character, the two sequences
+         *          represent the same string if and only if they have the same code units
+         */
+        template <typename It1, typename It2>
+        constexpr inline bool same_code_units(It1 first1, It1 last1, It2 first2, It2 last2) noexcept
+        {
+            return std::equal(first1, last1, first2, last2, [](const auto c1, const auto c2) {
+                return code_unit_value(c1) == code_unit_value(c2);
+            });
+        }
+
         template <typename C1, typename C2>
             requires CharacterType<C1> && CharacterType<C2>
         inline bool same(const std::basic_string<C1>& s1, const std::basic_string<C2>& s2)
         {
-            return CONVERT(char8_t, s1) == CONVERT(char8_t, s2);
+            if constexpr (std::same_as<std::remove_cvref_t<C1>, std::remove_cvref_t<C2>>)
+                return s1 == s2;
+            else
+            {
+                if (std::all_of(s1.begin(), s1.end(), is_ascii<C1>) || std::all_of(s2.begin(), s2.end(), is_ascii<C2>))
+                    return same_code_units(s1.begin(), s1.end(), s2.begin(), s2.end());
+                return CONVERT(char8_t, s1) == CONVERT(char8_t, s2);
+            }
         }
 
         template <typename C1, typename C2>
             requires CharacterType<C1> && CharacterType<C2>
         inline bool same(const std::basic_string<C1>& s1, const C2* s2)
         {
+            const std::basic_string_view<C2> sv2(s2);
+            if (std::all_of(sv2.begin(), sv2.end(), is_ascii<C2>))
+                return same_code_units(s1.begin(), s1.end(), sv2.begin(), sv2.end());
             return CONVERT(char8_t, s1) == CONVERT(char8_t, std::basic_string<C2>(s2));
         }
 
@@ -1921,14 +2166,24 @@ namespace SupDef
             requires CharacterType<C1> && CharacterType<C2>
         inline bool same(const C1* s1, const std::basic_string<C2>& s2)
         {
+            const std::basic_string_view<C1> sv1(s1);
+            if (std::all_of(sv1.begin(), sv1.end(), is_ascii<C1>))
+                return same_code_units(sv1.begin(), sv1.end(), s2.begin(), s2.end());
             return CONVERT(char8_t, std::basic_string<C1>(s1)) == CONVERT(char8_t, s2);
         }
 
+        // Called for every code unit read by the parser (mostly as `SAME(c, '\n')` and the like), so it avoids
+        // converting anything (and thus allocating) unless both code units are non-ASCII ones of different types
         template <typename C1, typename C2>
             requires CharacterType<C1> && CharacterType<C2>
         inline bool same(const C1 c1, const C2 c2)
         {
-            return CONVERT(char8_t, c1) == CONVERT(char8_t, c2);
+            if (is_ascii(c1) || is_ascii(c2))
+                return code_unit_value(c1) == code_unit_value(c2);
+            if constexpr (std::same_as<std::remove_cvref_t<C1>, std::remove_cvref_t<C2>>)
+                return c1 == c2;
+            else
+                return CONVERT(char8_t, c1) == CONVERT(char8_t, c2);
         }
 
 #ifdef SAME
@@ -0,0 +1,263 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/conditionals.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE conditionals_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+namespace SupDef
+{
+    namespace Tests
+    {
+        namespace ConditionalsTests
+        {
+            // Walk @p tree, writing the branches taken (with the invocations expanded) to the returned string
+            inline std::string walk(const ::SupDef::ConditionalTree<char>& tree, ::SupDef::SymbolTable<char>& table)
+            {
+                ::SupDef::InvocationExpander<char> expander(table, table.global_scope);
+                ::SupDef::ConditionEvaluator<char> evaluator(table, table.global_scope);
+                std::ostringstream out;
+                tree.walk(
+                    [&](std::string_view text) { expander.expand(text, out); },
+                    [&](std::string_view condition, size_t line) { return evaluator.evaluate(condition, line); }
+                );
+                return out.str();
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(conditionals,
+    * BoostTest::description("Tests for `SupDef::ConditionalTree`, `SupDef::ConditionProgram` and `SupDef::ConditionEvaluator`")
+)
+
+BOOST_AUTO_TEST_CASE(conditional_tree_branches,
+    * BoostTest::description("Check that only the branches taken are written, and that the others are never expanded")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ConditionalsTests;
+
+    ::SupDef::SymbolTable<char> table;
+    define(table, "ONE", "1");
+    define(table, "ID", "$1");
+    // Invoking it is an error, so a branch invoking it must not be expanded
+    define(table, "SELF", "SELF()");
+
+    const std::string content =
+        "a\n"
+        "#pragma supdef if ONE()\n"
+        "b ID(1)\n"
+        "  #pragma supdef if 0\n"
+        "c SELF()\n"
+        "  #pragma supdef else\n"
+        "d\n"
+        "  #pragma supdef end\n"
+        "#pragma supdef else\n"
+        "e SELF()\n"
+        "#pragma supdef end\n"
+        "f\n"
+        "#pragma supdef if 1\n"
+        "#pragma supdef else\n"
+        "g SELF()\n"
+        "#pragma supdef end\n";
+    const ::SupDef::ConditionalTree<char> tree(content);
+    BOOST_TEST(walk(tree, table) == "a\nb 1\nd\nf\n");
+
+    const ::SupDef::ConditionalTree<char> plain("x\ny\nz");
+    BOOST_TEST(plain.get_nodes().size() == 1);
+    BOOST_TEST(walk(plain, table) == "x\ny\nz");
+}
+
+BOOST_AUTO_TEST_CASE(conditional_tree_errors,
+    * BoostTest::description("Check that unbalanced conditional pragmas are syntax errors")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using Tree = ::SupDef::ConditionalTree<char>;
+    using Error = ::SupDef::Exception<char, std::filesystem::path>;
+
+    BOOST_CHECK_THROW(Tree("#pragma supdef else\n"), Error);
+    BOOST_CHECK_THROW(Tree("#pragma supdef end\n"), Error);
+    BOOST_CHECK_THROW(Tree("#pragma supdef if 1\n#pragma supdef else\n#pragma supdef else\n#pragma supdef end\n"), Error);
+    BOOST_CHECK_THROW(Tree("x\n#pragma supdef if 1\ny\n"), Error);
+}
+
+BOOST_AUTO_TEST_CASE(condition_evaluator_operators,
+    * BoostTest::description("Check the operators, their precedence and the values of conditions")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ConditionalsTests;
+    using Error = ::SupDef::Exception<char, std::filesystem::path>;
+
+    ::SupDef::SymbolTable<char> table;
+    define(table, "ONE", "1");
+    define(table, "ID", "$1");
+    define(table, "STR", "\"$1\"");
+    ::SupDef::ConditionEvaluator<char> evaluator(table, table.global_scope);
+
+    BOOST_TEST(evaluator.evaluate("1 + 2 * 3 == 7"));
+    BOOST_TEST(evaluator.evaluate("(1 + 2) * 3 == 9"));
+    BOOST_TEST(evaluator.evaluate("-5 / 2 == -2 && -5 % 2 == -1"));
+    BOOST_TEST(evaluator.evaluate("0x10 == 16 && 'a' == 97"));
+    BOOST_TEST(evaluator.evaluate("\"ab\" + \"c\" == \"abc\" && \"abc\" < \"abd\""));
+    BOOST_TEST(!evaluator.evaluate("\"\""));
+    BOOST_TEST(!evaluator.evaluate("1 != 1 || 2 >= 3"));
+    BOOST_TEST(!evaluator.evaluate("UNDEFINED"));
+    BOOST_TEST(evaluator.evaluate("ID(ONE()) == ONE() && STR(x) == \"x\""));
+    BOOST_TEST(evaluator.evaluate("-9223372036854775807 - 1 == 0x7fffffffffffffff + 1"));
+
+    for (const char* invalid : { "", "1 +", "(1", "1 2", "\"a\" == 1", "1 / 0", "NOPE(1)", "ID(1", "-\"a\"", "99999999999999999999" })
+    {
+        BOOST_TEST_CONTEXT("With condition `" << invalid << "`")
+        {
+            BOOST_CHECK_THROW(evaluator.evaluate(invalid), Error);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(condition_program_folding,
+    * BoostTest::description("Check that the operators on constants are applied when compiling, and that the dead operands are dropped")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using Program = ::SupDef::ConditionProgram<char>;
+    using Op = Program::opcode;
+
+    // `LOAD_INT`, `RETURN`
+    for (const char* constant : { "1 + 2 * 3 == 7", "\"a\" + \"b\" < \"b\"", "0 && (X() || Y())", "1 || X()", "!(2 - 2) && UNDEFINED == 0" })
+    {
+        BOOST_TEST_CONTEXT("With condition `" << constant << "`")
+        {
+            const Program program(constant);
+            BOOST_TEST(program.is_constant());
+            BOOST_TEST(program.get_code().size() == 2);
+        }
+    }
+
+    const Program partial("X() == 2 * 3");
+    BOOST_TEST(!partial.is_constant());
+    BOOST_REQUIRE(partial.get_code().size() == 4);
+    BOOST_TEST((partial.get_code()[0].op == Op::INVOKE && partial.get_code()[1].op == Op::LOAD_INT && partial.get_code()[2].op == Op::EQ));
+
+    // Only an error if reached
+    const Program division("X() && 1 / 0");
+    BOOST_TEST(!division.is_constant());
+}
+
+BOOST_AUTO_TEST_CASE(condition_evaluator_programs,
+    * BoostTest::description("Check that the programs of conditions and invocations are reused, with the same results")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ConditionalsTests;
+    using Error = ::SupDef::Exception<char, std::filesystem::path>;
+
+    ::SupDef::SymbolTable<char> table;
+    define(table, "ONE", "1");
+    define(table, "ID", "$1");
+    define(table, "STR", "\"$1\"");
+    ::SupDef::ConditionEvaluator<char> evaluator(table, table.global_scope);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        BOOST_TEST(evaluator.evaluate("STR(a) + STR(b) == \"ab\" && -ID(3) == -3"));
+        BOOST_TEST(!evaluator.evaluate("ONE() && ID(0)"));
+        BOOST_TEST(evaluator.evaluate("ID(0) || ID(2) < 3 < 2"));
+        BOOST_CHECK_THROW(evaluator.evaluate("ONE() && 1 / 0"), Error);
+        BOOST_CHECK_THROW(evaluator.evaluate("ONE() + STR(a)"), Error);
+    }
+    BOOST_TEST(evaluator.expansions() == 3 * 10);
+}
+
+BOOST_AUTO_TEST_CASE(condition_evaluator_short_circuit,
+    * BoostTest::description("Check that the operands not needed are not expanded, and that only constant conditions are cached")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ConditionalsTests;
+
+    ::SupDef::SymbolTable<char> table;
+    define(table, "ONE", "1");
+    define(table, "SELF", "SELF()");
+    ::SupDef::ConditionEvaluator<char>::constant_cache_type constants;
+    ::SupDef::ConditionEvaluator<char> evaluator(table, table.global_scope, nullptr, std::addressof(constants));
+
+    BOOST_TEST(!evaluator.evaluate("0 && SELF()"));
+    BOOST_TEST(evaluator.evaluate("1 || (SELF() && 1 / 0)"));
+    BOOST_TEST(evaluator.expansions() == 0);
+    BOOST_TEST(constants.size() == 2);
+
+    BOOST_TEST(evaluator.evaluate("ONE() || SELF()"));
+    BOOST_TEST(evaluator.expansions() == 1);
+    BOOST_TEST(constants.size() == 2);
+    BOOST_REQUIRE(constants.find("0 && SELF()").has_value());
+    BOOST_TEST(!*constants.find("0 && SELF()"));
+}
+
+BOOST_AUTO_TEST_CASE(condition_evaluator_throughput,
+    * BoostTest::description("Measure the time taken to evaluate conditions once compiled")
+    * BoostTest::timeout(SUPDEF_TEST_BENCHMARK_TIMEOUT)
+    * BoostTest::enable_if<SUPDEF_TEST_BENCHMARKS>()
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ConditionalsTests;
+
+    ::SupDef::SymbolTable<char> table;
+    define(table, "ONE", "1");
+    define(table, "ID", "$1");
+    define(table, "STR", "\"$1\"");
+    ::SupDef::ConditionEvaluator<char> evaluator(table, table.global_scope);
+
+    for (const char* condition : { "(1 + 2) * 3 == 9 && \"a\" < \"b\"", "(ONE() && !ID(0)) || ID(5) * 2 == 11 && STR(x) == \"x\"" })
+    {
+        constexpr size_t count = 1000000;
+        size_t taken = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i)
+            taken += evaluator.evaluate(condition);
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        BOOST_TEST(taken == count);
+        BOOST_TEST_MESSAGE("Condition `" << condition << "`: " << elapsed.count() / count << " ns per evaluation");
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,166 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/delimiter_finder.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE delimiter_finder_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#include <random>
+
+#line SUPDEF_TEST_FILE_POS
+
+namespace SupDef
+{
+    namespace Tests
+    {
+        namespace DelimiterFinder
+        {
+            // Positions of `/`, `"` and `\n` in @p text, one code unit at a time
+            template <typename T>
+            std::vector<size_t> scalar_positions(const std::basic_string<T>& text)
+            {
+                std::vector<size_t> res;
+                for (size_t i = 0; i < text.size(); ++i)
+                {
+                    if (SAME(text[i], '/') || SAME(text[i], '"') || SAME(text[i], '\n'))
+                        res.push_back(i);
+                }
+                return res;
+            }
+
+            template <typename T>
+            std::vector<size_t> finder_positions(const std::basic_string<T>& text)
+            {
+                std::vector<size_t> res;
+                ::SupDef::Util::DelimiterFinder<T, '/', '"', '\n'> finder(text);
+                for (size_t i = finder.next(0); i < text.size(); i = finder.next(i + 1))
+                    res.push_back(i);
+                return res;
+            }
+
+            // Random text made of delimiters, other ASCII characters, and code units which only match a delimiter on their
+            // low byte (`U+012F` for `/`, ...)
+            template <typename T>
+            std::basic_string<T> random_text(std::mt19937& gen, size_t size)
+            {
+                static constexpr char ascii[] = { '/', '"', '\n', 'a', ' ', '*', '\\', '#' };
+                std::basic_string<T> res;
+                for (size_t i = 0; i < size; ++i)
+                {
+                    const char c = ascii[gen() % sizeof(ascii)];
+                    if constexpr (sizeof(T) > 1)
+                        res.push_back((gen() % 4 == 0) ? static_cast<T>(0x100 | static_cast<unsigned char>(c)) : static_cast<T>(c));
+                    else
+                        res.push_back(static_cast<T>(c));
+                }
+                return res;
+            }
+
+            template <typename T>
+            void check_random_texts(void)
+            {
+                std::mt19937 gen(42);
+                for (size_t size = 0; size < 200; ++size)
+                {
+                    const auto text = random_text<T>(gen, size);
+                    BOOST_TEST((finder_positions(text) == scalar_positions(text)));
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(delimiter_finder,
+    * BoostTest::description("Tests for `SupDef::Util::DelimiterFinder`")
+)
+
+BOOST_AUTO_TEST_CASE(delimiter_finder_positions,
+    * BoostTest::description("Check that the delimiters are found where a scan one code unit at a time finds them, for every character type")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests::DelimiterFinder;
+
+    check_random_texts<char>();
+    check_random_texts<char8_t>();
+    check_random_texts<char16_t>();
+    check_random_texts<char32_t>();
+    check_random_texts<wchar_t>();
+
+    const std::string text = "ab/cd\"\n";
+    ::SupDef::Util::DelimiterFinder<char, '/', '"', '\n'> finder(text);
+    BOOST_TEST(finder.next(0) == 2);
+    BOOST_TEST(finder.next(3) == 5);
+    BOOST_TEST(finder.next(6) == 6);
+    BOOST_TEST(finder.next(7) == text.size());
+    // Going back is allowed too
+    BOOST_TEST(finder.next(1) == 2);
+}
+
+BOOST_AUTO_TEST_CASE(delimiter_finder_throughput,
+    * BoostTest::description("Compare the throughput of finding the delimiters of `Parser::strip_comments` one code unit at a time and a block at a time")
+    * BoostTest::timeout(SUPDEF_TEST_BENCHMARK_TIMEOUT)
+    * BoostTest::enable_if<SUPDEF_TEST_BENCHMARKS>()
+)
+{
+    using namespace ::SupDef::Tests::DelimiterFinder;
+
+    const std::string unit =
+        "int f(int x) { return x + 1; }\n"
+        "const char* s = \"a \\\" string\";\n"
+        "#pragma supdef import \"x.h\"\n"
+        "    for (int i = 0; i < n; ++i) sum += i; // a comment\n";
+    std::string content;
+    while (content.size() < 64 * 1024 * 1024)
+        content += unit;
+
+    size_t scalar_count = 0;
+    size_t finder_count = 0;
+    const double scalar = ::SupDef::Tests::measure_throughput(content.size(), 1, [&]() {
+        for (size_t i = 0; i < content.size(); ++i)
+            scalar_count += (SAME(content[i], '/') || SAME(content[i], '"') || SAME(content[i], '\n'));
+    });
+    const double finder = ::SupDef::Tests::measure_throughput(content.size(), 1, [&]() {
+        ::SupDef::Util::DelimiterFinder<char, '/', '"', '\n'> delimiters(content);
+        for (size_t i = delimiters.next(0); i < content.size(); i = delimiters.next(i + 1))
+            ++finder_count;
+    });
+    BOOST_TEST(scalar_count == finder_count);
+
+    BOOST_TEST_MESSAGE("Delimiters of strip_comments (char): " << scalar << " MB/s one at a time, " << finder << " MB/s a block at a time");
+    BOOST_TEST(finder > scalar);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,320 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/engine.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE engine_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+namespace SupDef
+{
+    namespace Tests
+    {
+        namespace EngineTests
+        {
+            inline std::filesystem::path source(const std::filesystem::path& dir, size_t i)
+            {
+                return dir / "src" / ("f" + std::to_string(i) + ".c");
+            }
+
+            inline std::filesystem::path output(const std::filesystem::path& dir, size_t i)
+            {
+                return dir / "out" / ("f" + std::to_string(i) + ".c");
+            }
+
+            // A fresh tree of @p count sources, all importing `inc/defs.sd` (which imports `inc/more.sd`)
+            inline std::filesystem::path make_tree(const std::string& name, size_t count)
+            {
+                const std::filesystem::path dir = std::filesystem::temp_directory_path() / ("supdef-engine-" + name);
+                std::filesystem::remove_all(dir);
+                write_file(dir / "inc" / "defs.sd",
+                    "#pragma supdef begin WRAP(x)\n<$x>\n#pragma supdef end\n"
+                    "#pragma supdef import \"more.sd\"\n"
+                );
+                write_file(dir / "inc" / "more.sd",
+                    "#pragma supdef begin TWICE(x)\nWRAP($x)WRAP($x)\n#pragma supdef end\n"
+                );
+                for (size_t i = 0; i < count; ++i)
+                    write_file(source(dir, i),
+                        "#pragma supdef import \"../inc/defs.sd\"\n"
+                        "#pragma supdef begin ID\nfile" + std::to_string(i) + "\n#pragma supdef end\n"
+                        "int x = WRAP(ID()); // comment\n"
+                        "TWICE(" + std::to_string(i) + ")\n"
+                    );
+                return dir;
+            }
+
+            // Whether the output of the source @p i of a tree made by `make_tree` has all its invocations expanded
+            inline bool is_expanded(const std::string& out, size_t i)
+            {
+                const std::string n = std::to_string(i);
+                return out.find("int x = <file" + n + ">;") != std::string::npos
+                    && out.find("<" + n + "><" + n + ">") != std::string::npos
+                    && out.find("WRAP") == std::string::npos && out.find("TWICE") == std::string::npos
+                    && out.find("#pragma supdef") == std::string::npos && out.find("comment") == std::string::npos;
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(engine,
+    * BoostTest::description("Tests for `SupDef::Engine`")
+)
+
+BOOST_AUTO_TEST_CASE(engine_targets,
+    * BoostTest::description("Check that the targets of a run are all expanded in their own scope, through shared imports")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::EngineTests;
+
+    constexpr size_t count = 64;
+    const auto dir = make_tree("targets", count);
+    ::SupDef::Engine<char, std::filesystem::path> engine;
+    for (size_t i = 0; i < count; ++i)
+        engine.add_target(source(dir, i), output(dir, i));
+
+    BOOST_TEST(engine.run() == 0);
+    BOOST_REQUIRE(engine.get_targets().size() == count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        BOOST_TEST_CONTEXT("Target " << i)
+        {
+            BOOST_TEST(engine.get_targets()[i].done);
+            BOOST_TEST(!engine.get_targets()[i].error);
+            BOOST_TEST(is_expanded(read_file(output(dir, i)), i));
+        }
+    }
+
+    const auto& stats = engine.get_stats();
+    BOOST_REQUIRE(stats.size() == 4);
+    for (const auto& stage : stats)
+        BOOST_TEST(stage.max_waiting <= SUPDEF_PIPELINE_QUEUE_CAPACITY);
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(engine_errors,
+    * BoostTest::description("Check that a failing target doesn't stop the others, and that a run only processes the new targets")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::EngineTests;
+    using Error = ::SupDef::Exception<char, std::filesystem::path>;
+
+    const auto dir = make_tree("errors", 2);
+    write_file(dir / "src" / "bad.c", "#pragma supdef import \"nowhere.sd\"\nint y;\n");
+    ::SupDef::Engine<char, std::filesystem::path> engine;
+    engine.add_target(source(dir, 0), output(dir, 0));
+    engine.add_target(dir / "src" / "missing.c", dir / "out" / "missing.c");
+    engine.add_target(dir / "src" / "bad.c", dir / "out" / "bad.c");
+
+    BOOST_TEST(engine.run() == 2);
+    BOOST_TEST(is_expanded(read_file(output(dir, 0)), 0));
+    BOOST_TEST(!std::filesystem::exists(dir / "out" / "missing.c"));
+    BOOST_TEST(!std::filesystem::exists(dir / "out" / "bad.c"));
+    for (size_t i : { 1, 2 })
+    {
+        BOOST_TEST(engine.get_targets()[i].done);
+        BOOST_REQUIRE(engine.get_targets()[i].error);
+        BOOST_CHECK_THROW(std::rethrow_exception(engine.get_targets()[i].error), Error);
+    }
+
+    // Only the target added since is processed by the next run
+    std::filesystem::remove(output(dir, 0));
+    engine.add_target(source(dir, 1), output(dir, 1));
+    BOOST_TEST(engine.run() == 0);
+    BOOST_TEST(!std::filesystem::exists(output(dir, 0)));
+    BOOST_TEST(is_expanded(read_file(output(dir, 1)), 1));
+
+    engine.restart();
+    BOOST_TEST(engine.get_targets().empty());
+    BOOST_TEST(engine.get_stats().empty());
+    engine.add_target(source(dir, 0), output(dir, 0));
+    BOOST_TEST(engine.run() == 0);
+    BOOST_TEST(is_expanded(read_file(output(dir, 0)), 0));
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(engine_import_graph,
+    * BoostTest::description("Check that each imported file is parsed once per engine, and that import cycles make the targets reaching them fail")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::EngineTests;
+    using Error = ::SupDef::Exception<char, std::filesystem::path>;
+
+    const auto dir = make_tree("import_graph", 1);
+    // A diamond: `left.sd` and `right.sd` both import `base.sd`
+    write_file(dir / "inc" / "base.sd", "#pragma supdef begin BASE\nbase\n#pragma supdef end\n");
+    write_file(dir / "inc" / "left.sd", "#pragma supdef import \"base.sd\"\n#pragma supdef begin LEFT\nBASE()-left\n#pragma supdef end\n");
+    write_file(dir / "inc" / "right.sd", "#pragma supdef import \"base.sd\"\n#pragma supdef begin RIGHT\nright-BASE()\n#pragma supdef end\n");
+    write_file(dir / "src" / "diamond.c", "#pragma supdef import \"../inc/left.sd\"\n#pragma supdef import \"../inc/right.sd\"\nLEFT() RIGHT()\n");
+    // A cycle: `a.sd` imports `b.sd`, which imports `a.sd`
+    write_file(dir / "inc" / "a.sd", "#pragma supdef import \"b.sd\"\n");
+    write_file(dir / "inc" / "b.sd", "#pragma supdef import \"a.sd\"\n");
+    write_file(dir / "src" / "cycle.c", "#pragma supdef import \"../inc/left.sd\"\n#pragma supdef import \"../inc/a.sd\"\nLEFT()\n");
+
+    ::SupDef::Engine<char, std::filesystem::path> engine;
+    engine.add_target(dir / "src" / "diamond.c", dir / "out" / "diamond.c");
+    engine.add_target(dir / "src" / "cycle.c", dir / "out" / "cycle.c");
+    engine.add_target(source(dir, 0), output(dir, 0));
+
+    BOOST_TEST(engine.run() == 1);
+    BOOST_TEST(read_file(dir / "out" / "diamond.c").find("base-left right-base") != std::string::npos);
+    BOOST_TEST(is_expanded(read_file(output(dir, 0)), 0));
+    BOOST_TEST(!std::filesystem::exists(dir / "out" / "cycle.c"));
+    BOOST_REQUIRE(engine.get_targets()[1].error);
+    auto is_import_cycle = [](const Error& e) -> bool
+    {
+        return e.get_type() == ::SupDef::ExcType::INVALID_PATH_ERROR && std::string(e.what()).find("Import cycle") != std::string::npos;
+    };
+    BOOST_CHECK_EXCEPTION(std::rethrow_exception(engine.get_targets()[1].error), Error, is_import_cycle);
+
+    // The imported files are not parsed again by the next runs, until a restart
+    write_file(dir / "inc" / "base.sd", "#pragma supdef begin BASE\nchanged\n#pragma supdef end\n");
+    engine.add_target(dir / "src" / "diamond.c", dir / "out" / "again.c");
+    BOOST_TEST(engine.run() == 0);
+    BOOST_TEST(read_file(dir / "out" / "again.c").find("base-left right-base") != std::string::npos);
+    engine.restart(dir / "src" / "diamond.c", dir / "out" / "again.c");
+    BOOST_TEST(engine.run() == 0);
+    BOOST_TEST(read_file(dir / "out" / "again.c").find("changed-left right-changed") != std::string::npos);
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(engine_up_to_date,
+    * BoostTest::description("Check that the targets whose output is up to date are skipped, and only them")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::EngineTests;
+
+    constexpr size_t count = 8;
+    const auto dir = make_tree("up-to-date", count);
+    ::SupDef::Engine<char, std::filesystem::path> engine;
+    BOOST_REQUIRE(engine.set_build_records(dir / "records"));
+    // Make all the targets again, returning how many of them were skipped
+    auto run_all = [&engine, &dir]() -> size_t
+    {
+        engine.restart();
+        for (size_t i = 0; i < count; ++i)
+            engine.add_target(source(dir, i), output(dir, i));
+        BOOST_TEST(engine.run() == 0);
+        size_t skipped = 0;
+        for (const auto& target : engine.get_targets())
+        {
+            BOOST_TEST(target.done);
+            skipped += target.skipped ? 1 : 0;
+        }
+        return skipped;
+    };
+
+    BOOST_TEST(run_all() == 0);
+    const auto written = std::filesystem::last_write_time(output(dir, 0));
+    BOOST_TEST(run_all() == count);
+    BOOST_TEST((std::filesystem::last_write_time(output(dir, 0)) == written));
+    BOOST_TEST(is_expanded(read_file(output(dir, 0)), 0));
+
+    // Only the content of the imports matters, not their version
+    const auto more = dir / "inc" / "more.sd";
+    std::filesystem::last_write_time(more, std::filesystem::last_write_time(more) + std::chrono::hours(1));
+    BOOST_TEST(run_all() == count);
+    write_file(more, "#pragma supdef begin TWICE(x)\nWRAP($x) WRAP($x)\n#pragma supdef end\n");
+    BOOST_TEST(run_all() == 0);
+    BOOST_TEST(read_file(output(dir, 3)).find("<3> <3>") != std::string::npos);
+
+    // A changed source, or a changed output, only makes its own target again
+    write_file(source(dir, 1), "#pragma supdef import \"../inc/defs.sd\"\nint y = WRAP(1);\n");
+    write_file(output(dir, 2), "changed by hand\n");
+    BOOST_TEST(run_all() == count - 2);
+    BOOST_TEST(!engine.get_targets()[1].skipped);
+    BOOST_TEST(!engine.get_targets()[2].skipped);
+    BOOST_TEST(read_file(output(dir, 1)).find("int y = <1>;") != std::string::npos);
+    BOOST_TEST(read_file(output(dir, 2)).find("<2> <2>") != std::string::npos);
+
+    // A record others can write to is not trusted
+    BOOST_TEST(run_all() == count);
+    for (const auto& entry : std::filesystem::directory_iterator(dir / "records"))
+        std::filesystem::permissions(entry.path(), std::filesystem::perms::others_write, std::filesystem::perm_options::add);
+    BOOST_TEST(run_all() == 0);
+
+    // Changing the include paths makes all the targets again, as does an import found somewhere else than before
+    write_file(source(dir, 0), "#pragma supdef import \"defs.sd\"\nint z = WRAP(0);\n");
+    ::SupDef::EngineBase::add_include_path(dir / "inc");
+    BOOST_TEST(run_all() == 0);
+    BOOST_TEST(run_all() == count);
+    write_file(dir / "src" / "defs.sd", "#pragma supdef begin WRAP(x)\n[$x]\n#pragma supdef end\n");
+    BOOST_TEST(run_all() == count - 1);
+    BOOST_TEST(read_file(output(dir, 0)).find("int z = [0];") != std::string::npos);
+    ::SupDef::EngineBase::remove_include_path(dir / "inc");
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(engine_concurrency,
+    * BoostTest::description("Measure how a run over many targets scales with the concurrency of the stages of the pipeline")
+    * BoostTest::timeout(SUPDEF_TEST_BENCHMARK_TIMEOUT)
+    * BoostTest::enable_if<SUPDEF_TEST_BENCHMARKS>()
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::EngineTests;
+    using milliseconds = std::chrono::duration<double, std::milli>;
+
+    constexpr size_t count = 1000;
+    const auto dir = make_tree("concurrency", count);
+    ::SupDef::Engine<char, std::filesystem::path> engine;
+    const size_t max_concurrency = std::max<size_t>(2, std::jthread::hardware_concurrency());
+    for (size_t concurrency = 1; concurrency <= max_concurrency; concurrency *= 2)
+    {
+        engine.restart();
+        engine.set_concurrency(concurrency);
+        for (size_t i = 0; i < count; ++i)
+            engine.add_target(source(dir, i), output(dir, i));
+        const auto start = std::chrono::steady_clock::now();
+        BOOST_TEST(engine.run() == 0);
+        const milliseconds elapsed = std::chrono::steady_clock::now() - start;
+        BOOST_TEST_MESSAGE("Engine::run, " << count << " targets, concurrency " << concurrency << ": " << elapsed.count() << " ms");
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,131 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/expansion_cache.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE expansion_cache_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+BOOST_AUTO_TEST_SUITE(expansion_cache,
+    * BoostTest::description("Tests for `SupDef::ExpansionCache`")
+)
+
+BOOST_AUTO_TEST_CASE(expansion_cache_hits_and_invalidation,
+    * BoostTest::description("Check that the same invocation is only expanded once, until its super define is invalidated")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace std::string_literals;
+
+    ::SupDef::PragmaDef<char> foo("FOO"s, "<$1|$2>"s, std::tuple<size_t, size_t>(0, 0));
+    ::SupDef::PragmaDef<char> bar("BAR"s, "[$1]"s, std::tuple<size_t, size_t>(0, 0));
+    ::SupDef::ExpansionCache<char> cache;
+
+    BOOST_TEST(cache.get(foo, "a"s, "b"s) == "<a|b>");
+    BOOST_TEST(cache.get(foo, "a"s, "b"s) == "<a|b>");
+    BOOST_TEST(cache.get(foo, "a"s, "c"s) == "<a|c>");
+    BOOST_TEST(cache.get(bar, "a"s) == "[a]");
+    BOOST_TEST(cache.hits() == 1);
+    BOOST_TEST(cache.misses() == 3);
+    BOOST_TEST(cache.size() == 3);
+
+    // `FOO` is redefined
+    cache.invalidate("FOO"s);
+    BOOST_TEST(cache.size() == 1);
+    foo.set_body("{$2|$1}"s);
+    BOOST_TEST(cache.get(foo, "a"s, "b"s) == "{b|a}");
+    BOOST_TEST(cache.misses() == 4);
+    BOOST_TEST(cache.get(bar, "a"s) == "[a]");
+    BOOST_TEST(cache.hits() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(expansion_cache_scopes,
+    * BoostTest::description("Check that the definitions of a name in different scopes are told apart, and that replacing one drops its expansions")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace std::string_literals;
+
+    ::SupDef::ExpansionCache<char> cache;
+    ::SupDef::SymbolTable<char> table(std::pmr::get_default_resource(), std::addressof(cache));
+    const auto first = table.add_scope();
+    const auto second = table.add_scope();
+    table.define(first, ::SupDef::Tests::make_def("FOO", "<$1>"));
+    table.define(second, ::SupDef::Tests::make_def("FOO", "[$1]"));
+
+    BOOST_TEST(cache.get(*table.find(first, "FOO"), "a"s) == "<a>");
+    BOOST_TEST(cache.get(*table.find(second, "FOO"), "a"s) == "[a]");
+    BOOST_TEST(cache.size() == 2);
+
+    BOOST_TEST(table.define(first, ::SupDef::Tests::make_def("FOO", "{$1}")));
+    BOOST_TEST(cache.size() == 1);
+    BOOST_TEST(cache.get(*table.find(first, "FOO"), "a"s) == "{a}");
+    BOOST_TEST(cache.get(*table.find(second, "FOO"), "a"s) == "[a]");
+    BOOST_TEST(cache.hits() == 1);
+
+    BOOST_TEST(table.undefine(second, "FOO"));
+    BOOST_TEST(cache.size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(expansion_cache_lru_eviction,
+    * BoostTest::description("Check that the least recently used expansions are evicted when the cache is full")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace std::string_literals;
+
+    ::SupDef::PragmaDef<char> foo("FOO"s, "<$1>"s, std::tuple<size_t, size_t>(0, 0));
+    ::SupDef::ExpansionCache<char> cache;
+
+    cache.get(foo, "a"s);
+    const size_t entry_memory = cache.memory_usage();
+    cache.set_max_memory(3 * entry_memory);
+    cache.get(foo, "b"s);
+    cache.get(foo, "c"s);
+    // `a` becomes the most recently used, so `b` is evicted first
+    cache.get(foo, "a"s);
+    cache.get(foo, "d"s);
+    BOOST_TEST(cache.size() == 3);
+    BOOST_TEST(cache.memory_usage() <= 3 * entry_memory);
+
+    const size_t misses = cache.misses();
+    cache.get(foo, "a"s);
+    cache.get(foo, "c"s);
+    cache.get(foo, "d"s);
+    BOOST_TEST(cache.misses() == misses);
+    cache.get(foo, "b"s);
+    BOOST_TEST(cache.misses() == misses + 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,243 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/import_cache.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE import_cache_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+namespace SupDef
+{
+    namespace Tests
+    {
+        namespace ImportCacheTests
+        {
+            using Cache = ::SupDef::ImportCache<char>;
+
+            inline std::string body_of(const Cache::parsed_ptr& parsed, size_t index)
+            {
+                return std::string(*parsed->definitions.at(index).get_body());
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(import_cache,
+    * BoostTest::description("Tests for `SupDef::ImportCache`")
+)
+
+BOOST_AUTO_TEST_CASE(import_cache_versions,
+    * BoostTest::description("Check that a file is parsed once per version, and that only its latest version is kept")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ImportCacheTests;
+
+    Cache cache;
+    const auto path = write_tmp_file("#pragma supdef import \"other.sd\"\n#pragma supdef begin FOO\nfoo\n#pragma supdef end\n");
+    const auto first = cache.get(path);
+    BOOST_REQUIRE(first != nullptr);
+    BOOST_TEST(first->key.path == std::filesystem::canonical(path));
+    BOOST_REQUIRE(first->imports.size() == 1);
+    BOOST_TEST(first->imports.front() == std::filesystem::path("other.sd"));
+    BOOST_REQUIRE(first->definitions.size() == 1);
+    BOOST_TEST(body_of(first, 0) == "foo");
+
+    BOOST_TEST(cache.get(path) == first);
+    BOOST_TEST(cache.get(path.parent_path() / "." / path.filename()) == first);
+    BOOST_TEST(cache.get_hits() == 2);
+    BOOST_TEST(cache.get_misses() == 1);
+
+    // A new version replaces the previous one, which stays valid for whoever still has it
+    write_file(path, "#pragma supdef begin FOO\nchanged foo\n#pragma supdef end\n");
+    const auto second = cache.get(path);
+    BOOST_TEST(second != first);
+    BOOST_TEST(second->imports.empty());
+    BOOST_TEST(body_of(second, 0) == "changed foo");
+    BOOST_TEST(body_of(first, 0) == "foo");
+    BOOST_TEST(cache.size() == 1);
+    BOOST_TEST(cache.get_misses() == 2);
+
+    cache.clear();
+    BOOST_TEST(cache.size() == 0);
+    BOOST_TEST(cache.get(path) != second);
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(import_cache_errors,
+    * BoostTest::description("Check that missing files and files failing to be parsed are reported, and not kept")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ImportCacheTests;
+    using Error = ::SupDef::Exception<char, std::filesystem::path>;
+
+    Cache cache;
+    auto is_no_input_file = [](const Error& e) -> bool
+    {
+        return e.get_type() == ::SupDef::ExcType::NO_INPUT_FILE_ERROR;
+    };
+    BOOST_CHECK_EXCEPTION(cache.get(std::filesystem::temp_directory_path() / "supdef-no-such-import.sd"), Error, is_no_input_file);
+
+    const auto path = write_tmp_file("#pragma supdef begin FOO\nfoo /* never closed\n#pragma supdef end\n");
+    BOOST_CHECK_THROW(cache.get(path), Error);
+    BOOST_TEST(cache.size() == 0);
+    BOOST_CHECK_THROW(cache.get(path), Error);
+    BOOST_TEST(cache.get_misses() == 2);
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(import_cache_concurrent,
+    * BoostTest::description("Check that concurrent requests of the same file share a single parse")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ImportCacheTests;
+
+    Cache cache;
+    std::string content;
+    for (size_t i = 0; i < 2000; ++i)
+        content += "#pragma supdef begin DEF" + std::to_string(i) + "\nbody " + std::to_string(i) + "\n#pragma supdef end\n";
+    const auto path = write_tmp_file(content);
+
+    constexpr size_t nb_threads = 8;
+    std::vector<Cache::parsed_ptr> got(nb_threads);
+    {
+        std::vector<std::jthread> threads;
+        for (size_t i = 0; i < nb_threads; ++i)
+            threads.emplace_back([&cache, &got, &path, i]() { got[i] = cache.get(path); });
+    }
+    BOOST_TEST(cache.get_misses() == 1);
+    BOOST_TEST(cache.get_hits() == nb_threads - 1);
+    BOOST_TEST(std::ranges::all_of(got, [&got](const Cache::parsed_ptr& p) { return p == got.front(); }));
+    BOOST_TEST(got.front()->definitions.size() == 2000);
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(import_cache_disk,
+    * BoostTest::description("Check that the parsed files kept in the cache directory are used by the next caches, as long as the files didn't change")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ImportCacheTests;
+
+    const auto cache_dir = std::filesystem::temp_directory_path() / "supdef-import-cache-tests";
+    std::filesystem::remove_all(cache_dir);
+    const auto path = write_tmp_file(
+        "#pragma supdef import \"other.sd\"\n"
+        "#pragma supdef begin FOO\nfoo\n#pragma supdef end\n"
+        "#pragma supdef begin BAR\nbar\n#pragma supdef end\n"
+    );
+
+    Cache::parsed_ptr parsed;
+    {
+        Cache cache(cache_dir);
+        parsed = cache.get(path);
+        BOOST_TEST(cache.get_disk_hits() == 0);
+    }
+    auto check_same = [&parsed](const Cache::parsed_ptr& other) -> void
+    {
+        BOOST_REQUIRE(other->definitions.size() == parsed->definitions.size());
+        BOOST_TEST(other->imports == parsed->imports);
+        for (size_t i = 0; i < parsed->definitions.size(); ++i)
+        {
+            BOOST_TEST(body_of(other, i) == body_of(parsed, i));
+            BOOST_TEST(other->definitions[i].get_start() == parsed->definitions[i].get_start());
+            BOOST_TEST(other->definitions[i].get_end() == parsed->definitions[i].get_end());
+        }
+    };
+    {
+        Cache cache(cache_dir);
+        check_same(cache.get(path));
+        BOOST_TEST(cache.get_disk_hits() == 1);
+        BOOST_TEST(cache.get_misses() == 1);
+    }
+
+    // Another version of the file with the same content is not parsed again
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::hours(1));
+    {
+        Cache cache(cache_dir);
+        check_same(cache.get(path));
+        BOOST_TEST(cache.get_disk_hits() == 1);
+    }
+
+    // Neither a changed file nor a corrupted cache file is used
+    write_file(path, "#pragma supdef begin FOO\nchanged foo\n#pragma supdef end\n");
+    {
+        Cache cache(cache_dir);
+        BOOST_TEST(body_of(cache.get(path), 0) == "changed foo");
+        BOOST_TEST(cache.get_disk_hits() == 0);
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(cache_dir))
+        std::filesystem::resize_file(entry.path(), 40);
+    {
+        Cache cache(cache_dir);
+        BOOST_TEST(body_of(cache.get(path), 0) == "changed foo");
+        BOOST_TEST(cache.get_disk_hits() == 0);
+    }
+
+    // Nor is a cache file or directory others can write to
+    {
+        Cache cache(cache_dir);
+        cache.get(path);
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(cache_dir))
+        std::filesystem::permissions(entry.path(), std::filesystem::perms::group_write, std::filesystem::perm_options::add);
+    {
+        Cache cache(cache_dir);
+        BOOST_TEST(body_of(cache.get(path), 0) == "changed foo");
+        BOOST_TEST(cache.get_disk_hits() == 0);
+    }
+    std::filesystem::permissions(cache_dir, std::filesystem::perms::others_write, std::filesystem::perm_options::add);
+    {
+        Cache cache;
+        BOOST_TEST(!cache.set_cache_dir(cache_dir));
+        BOOST_TEST(cache.get_cache_dir().empty());
+    }
+
+    // The cache of the process only keeps the parsed files on disk when asked to
+    BOOST_TEST(Cache::instance().get_cache_dir().empty());
+
+    std::filesystem::remove(path);
+    std::filesystem::remove_all(cache_dir);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,160 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/invocation_expander.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE invocation_expander_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+BOOST_AUTO_TEST_SUITE(invocation_expander,
+    * BoostTest::description("Tests for `SupDef::InvocationExpander`")
+)
+
+BOOST_AUTO_TEST_CASE(invocation_expander_arguments,
+    * BoostTest::description("Check that only invocations of known super defines outside of literals are expanded, with balanced arguments")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using Error = ::SupDef::Exception<char, std::filesystem::path>;
+
+    ::SupDef::SymbolTable<char> table;
+    ::SupDef::ExpansionCache<char> cache;
+    define(table, "FOO", "<$1|$2>");
+    define(table, "NOARG", "none");
+    ::SupDef::InvocationExpander<char> expander(table, table.global_scope, &cache);
+
+    std::ostringstream out;
+    const size_t count = expander.expand(
+        "int x = FOO(a, (b, c)) + FOO (\"),\", ')') + NOARG() + NOARG + BAR(1);\n"
+        "const char* s = \"FOO(1, 2)\"; int y = xFOO(1, 2) + FOO(\n  f(1) ,  2 );\n",
+        out
+    );
+    BOOST_TEST(count == 4);
+    BOOST_TEST(out.str() ==
+        "int x = <a|(b, c)> + <\"),\"|')'> + none + NOARG + BAR(1);\n"
+        "const char* s = \"FOO(1, 2)\"; int y = xFOO(1, 2) + <f(1)|2>;\n"
+    );
+
+    std::ostringstream unterminated;
+    BOOST_CHECK_THROW(expander.expand("FOO(1, (2)", unterminated), Error);
+}
+
+BOOST_AUTO_TEST_CASE(invocation_expander_large_content,
+    * BoostTest::description("Check that spans larger than the output buffer are written as is")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+
+    ::SupDef::SymbolTable<char> table;
+    define(table, "FOO", "<$1|$2>");
+    ::SupDef::InvocationExpander<char> expander(table, table.global_scope);
+
+    std::string content;
+    std::string expected;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        const std::string filler(SUPDEF_EXPANDER_BUFFER_SIZE / 3 * (i + 1), 'x');
+        content += filler + " FOO(" + std::to_string(i) + ", y)\n";
+        expected += filler + " <" + std::to_string(i) + "|y>\n";
+    }
+    std::ostringstream out;
+    BOOST_TEST(expander.expand(content, out) == 4);
+    BOOST_TEST(out.str() == expected);
+}
+
+BOOST_AUTO_TEST_CASE(invocation_expander_nested,
+    * BoostTest::description("Check that invocations found in expansions are expanded too, and that cycles and deep nesting are reported")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using Error = ::SupDef::Exception<char, std::filesystem::path>;
+
+    ::SupDef::SymbolTable<char> table;
+    define(table, "endifsupdef", "#endif");
+    define(table, "test", "#if !defined($1)\n    #define $1 $2\nendifsupdef()");
+    define(table, "TEN", "0123456789");
+    ::SupDef::InvocationExpander<char> expander(table, table.global_scope);
+
+    std::ostringstream out;
+    BOOST_TEST(expander.expand("test(HELLO, \"hello world\")\n", out) == 2);
+    BOOST_TEST(out.str() == "#if !defined(HELLO)\n    #define HELLO \"hello world\"\n#endif\n");
+
+    define(table, "PING", "ping PONG()");
+    define(table, "PONG", "pong PING()");
+    std::ostringstream cycle;
+    BOOST_CHECK_THROW(expander.expand("PING()", cycle), Error);
+
+    expander.set_max_depth(1);
+    std::ostringstream too_deep;
+    BOOST_CHECK_THROW(expander.expand("test(A, B)", too_deep), Error);
+
+    expander.set_max_depth(SUPDEF_MAX_EXPANSION_DEPTH);
+    expander.set_max_size(8);
+    std::ostringstream too_large;
+    BOOST_CHECK_THROW(expander.expand("TEN()", too_large), Error);
+}
+
+BOOST_AUTO_TEST_CASE(invocation_expander_deep_nesting,
+    * BoostTest::description("Measure the time taken to expand deeply nested super defines, which should be linear in the size of the output")
+    * BoostTest::timeout(SUPDEF_TEST_BENCHMARK_TIMEOUT)
+    * BoostTest::enable_if<SUPDEF_TEST_BENCHMARKS>()
+)
+{
+    using namespace ::SupDef::Tests;
+
+    for (size_t depth : { 1000, 10000, 100000 })
+    {
+        // `DEF_<i>` invokes `DEF_<i + 1>`
+        ::SupDef::SymbolTable<char> table;
+        for (size_t i = 0; i < depth; ++i)
+        {
+            const std::string next = (i + 1 < depth) ? "DEF_" + std::to_string(i + 1) + "($1)" : "$1";
+            define(table, "DEF_" + std::to_string(i), "line " + std::to_string(i) + " " + next + "\n");
+        }
+        ::SupDef::InvocationExpander<char> expander(table, table.global_scope);
+        expander.set_max_depth(depth);
+
+        std::ostringstream out;
+        const auto start = std::chrono::steady_clock::now();
+        const size_t count = expander.expand("DEF_0(end)", out);
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        BOOST_TEST(count == depth);
+        BOOST_TEST_MESSAGE("Nesting depth " << depth << ": " << elapsed.count() / out.str().size() << " ns per output code unit");
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
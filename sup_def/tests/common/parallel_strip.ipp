@@ -0,0 +1,190 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/parallel_strip.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE parallel_strip_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+namespace SupDef
+{
+    namespace Tests
+    {
+        namespace ParallelStrip
+        {
+            // Some C code with comments (spanning many lines, ending with `\\`, in strings, ...) and SupDef pragmas
+            inline std::string sample_source(size_t min_size)
+            {
+                static const std::string unit =
+                    "#pragma supdef import \"some/file.h\"\n"
+                    "int f(int x) { /* a block\n"
+                    " comment */ return x + 1; } // trailing\n"
+                    "const char* s = \"a // not \\\" a /* comment\";\n"
+                    "char c = '\"'; int y; /* z */\n"
+                    "#pragma supdef begin my_macro\n"
+                    "    // continued \\\n"
+                    "    line comment\n"
+                    "    for (int i = 0; i < n; ++i) sum += i;\t// again\n"
+                    "#pragma supdef end my_macro\n"
+                    "/*\n"
+                    " * #pragma supdef import \"commented/out.h\"\n"
+                    " */\n";
+                std::string res;
+                res.reserve(min_size + unit.size());
+                while (res.size() < min_size)
+                    res += unit;
+                return res;
+            }
+
+            // Everything `search_imports` and `search_super_defines` yield
+            inline std::string parse(const std::filesystem::path& path, ::SupDef::ThreadPool* pool, size_t chunk_size)
+            {
+                ::SupDef::Parser<char> parser(path);
+                parser.slurp_file();
+                if (pool != nullptr)
+                    parser.strip_comments(*pool, chunk_size);
+                else
+                    parser.strip_comments();
+
+                std::ostringstream res;
+                auto record = [&res](auto&& found) -> void
+                {
+                    if (found.is_null())
+                        res << "null\n";
+                    else if (found.is_err())
+                        res << "error\n";
+                    else
+                    {
+                        auto& loc = found.unwrap();
+                        res << std::get<0>(loc) << ' ' << std::get<1>(loc) << ' ' << std::get<2>(loc) << '\n';
+                    }
+                };
+                for (auto&& found : parser.search_imports())
+                    record(found);
+                for (auto&& found : parser.search_super_defines())
+                    record(found);
+                return res.str();
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(parallel_strip,
+    * BoostTest::description("Tests for `SupDef::Parser::strip_comments(ThreadPool&, size_t)`")
+)
+
+BOOST_AUTO_TEST_CASE(parallel_strip_same_as_serial,
+    * BoostTest::description("Check that splitting the content in chunks (cutting comments and string literals) doesn't change what the parser finds")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests::ParallelStrip;
+
+    const auto path = ::SupDef::Tests::write_tmp_file(sample_source(16 * 1024));
+    const std::string serial = parse(path, nullptr, 0);
+    BOOST_TEST(serial.find("commented/out.h") == std::string::npos);
+
+    ::SupDef::ThreadPool pool(4);
+    for (size_t chunk_size : { 1, 7, 64, 333, 4096 })
+        BOOST_TEST(parse(path, &pool, chunk_size) == serial);
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_strip_unterminated_comment,
+    * BoostTest::description("Check that an unterminated comment is reported as with a single thread")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests::ParallelStrip;
+    using Error = ::SupDef::Exception<char, std::filesystem::path>;
+
+    const auto path = ::SupDef::Tests::write_tmp_file(sample_source(4 * 1024) + "int z; /* never closed\nint w;\n");
+    auto is_syntax_error = [](const Error& e) -> bool
+    {
+        return e.get_type() == ::SupDef::ExcType::SYNTAX_ERROR;
+    };
+    {
+        ::SupDef::Parser<char> parser(path);
+        parser.slurp_file();
+        BOOST_CHECK_EXCEPTION(parser.strip_comments(), Error, is_syntax_error);
+    }
+    {
+        ::SupDef::ThreadPool pool(4);
+        ::SupDef::Parser<char> parser(path);
+        parser.slurp_file();
+        BOOST_CHECK_EXCEPTION(parser.strip_comments(pool, 128), Error, is_syntax_error);
+    }
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_strip_throughput,
+    * BoostTest::description("Measure how `Parser::strip_comments` (and the lexing of the pragmas) scales with the number of threads")
+    * BoostTest::timeout(SUPDEF_TEST_BENCHMARK_TIMEOUT)
+    * BoostTest::enable_if<SUPDEF_TEST_BENCHMARKS>()
+)
+{
+    using namespace ::SupDef::Tests::ParallelStrip;
+
+    const std::string content = sample_source(64 * 1024 * 1024);
+    const auto path = ::SupDef::Tests::write_tmp_file(content);
+    auto strip_and_lex = [&path](::SupDef::ThreadPool* pool) -> void
+    {
+        ::SupDef::Parser<char> parser(path);
+        parser.slurp_file();
+        if (pool != nullptr)
+            parser.strip_comments(*pool);
+        else
+            parser.strip_comments();
+        for (auto&& found : parser.search_imports())
+            (void)found;
+    };
+
+    const double serial = ::SupDef::Tests::measure_throughput(content.size(), 1, [&]() { strip_and_lex(nullptr); });
+    BOOST_TEST_MESSAGE("Parser<char>::strip_comments, 1 thread:   " << serial << " MB/s");
+    const size_t max_threads = std::max<size_t>(2, std::jthread::hardware_concurrency());
+    for (size_t nb_threads = 2; nb_threads <= max_threads; nb_threads *= 2)
+    {
+        ::SupDef::ThreadPool pool(nb_threads);
+        const double parallel = ::SupDef::Tests::measure_throughput(content.size(), 1, [&]() { strip_and_lex(&pool); });
+        BOOST_TEST_MESSAGE("Parser<char>::strip_comments, " << nb_threads << " threads: " << parallel << " MB/s");
+    }
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,152 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/parsed_text.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE parsed_text_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+BOOST_AUTO_TEST_SUITE(parsed_text,
+    * BoostTest::description("Tests for `SupDef::ParsedText`")
+)
+
+BOOST_AUTO_TEST_CASE(parsed_text_from_source,
+    * BoostTest::description("Check the original positions of the code units of a freshly loaded text")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    const auto text = ::SupDef::ParsedText<char>::from_source("ab\ncde\n\nf");
+
+    BOOST_TEST(text.size() == 9);
+    BOOST_TEST(text.run_count() == 4);
+    BOOST_TEST(text.is_consistent());
+    BOOST_TEST(text.at(1).line() == 0);
+    BOOST_TEST(text.at(1).col() == 1);
+    // A `\n` belongs to the line it ends
+    BOOST_TEST(text.at(2).line() == 0);
+    BOOST_TEST(text.at(2).col() == 2);
+    BOOST_TEST(text.at(5).line() == 1);
+    BOOST_TEST(text.at(5).col() == 2);
+    BOOST_TEST(text.at(7).line() == 2);
+    BOOST_TEST(text.at(8).line() == 3);
+    BOOST_TEST(text.at(8).col() == 0);
+    BOOST_CHECK_THROW(text.at(9), std::out_of_range);
+
+    size_t i = 0;
+    for (auto&& c : text)
+    {
+        BOOST_TEST((c == text.at(i)));
+        ++i;
+    }
+    BOOST_TEST(i == text.size());
+}
+
+BOOST_AUTO_TEST_CASE(parsed_text_append,
+    * BoostTest::description("Check that appended code units keep their original positions")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    const auto source = ::SupDef::ParsedText<char>::from_source("int x; /* c */ int y;\nint z;\n");
+
+    // What `Parser::strip_comments` does with the block comment
+    ::SupDef::ParsedText<char> stripped;
+    stripped.append(source, 0, 7);
+    stripped.push_back(' ', source.at(14).line(), source.at(14).col());
+    stripped.append(source, 14);
+
+    BOOST_TEST(stripped.view() == "int x;   int y;\nint z;\n");
+    BOOST_TEST(stripped.is_consistent());
+    // One run before the comment, one for the space, one for the rest of the first line and one for the second line
+    BOOST_TEST(stripped.run_count() == 4);
+    BOOST_TEST(stripped.at(7).col() == 14);
+    BOOST_TEST(stripped.at(8).col() == 14);
+    BOOST_TEST(stripped.at(15).line() == 0);
+    BOOST_TEST(stripped.at(15).col() == 21);
+    BOOST_TEST(stripped.at(16).line() == 1);
+    BOOST_TEST(stripped.at(16).col() == 0);
+
+    // Code units appended one by one end up in the same runs
+    ::SupDef::ParsedText<char> copy;
+    for (size_t pos = 0; pos < stripped.size(); ++pos)
+        copy.append(stripped, pos, 1);
+    BOOST_TEST(copy.view() == stripped.view());
+    BOOST_TEST(copy.run_count() == stripped.run_count());
+
+    // Popping the only code unit of a run removes the run
+    copy.append(source, 3, 1);
+    BOOST_TEST(copy.run_count() == stripped.run_count() + 1);
+    copy.pop_back();
+    BOOST_TEST(copy.run_count() == stripped.run_count());
+
+    const auto parsed = stripped.parsed_substr(7, 3);
+    BOOST_TEST(parsed.size() == 3);
+    for (size_t i = 0; i < parsed.size(); ++i)
+        BOOST_TEST((parsed[i] == stripped.at(7 + i)));
+}
+
+BOOST_AUTO_TEST_CASE(parsed_text_borrow,
+    * BoostTest::description("Check that a borrowed text (here from a memory mapped file) is only copied when edited")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    const std::string content = "int x;\nint y;\n";
+    const auto path = ::SupDef::Tests::write_tmp_file(content);
+    ::SupDef::MappedFile mapping(path);
+#if SUPDEF_ON_UNIX
+    BOOST_TEST(mapping.is_mapped());
+#endif
+    const std::string_view source = mapping.is_mapped() ? mapping.view<char>() : std::string_view(content);
+    BOOST_TEST(source == content);
+
+    auto text = ::SupDef::ParsedText<char>::borrow_source(source);
+    BOOST_TEST(text.is_borrowed());
+    BOOST_TEST((text.view().data() == source.data()));
+    BOOST_TEST(text.run_count() == 2);
+    BOOST_TEST(text.at(8).line() == 1);
+
+    // Copies share the borrowed buffer too
+    const auto copy = text;
+    BOOST_TEST(copy.is_borrowed());
+
+    text.pop_back();
+    BOOST_TEST(!text.is_borrowed());
+    BOOST_TEST(text.view() == content.substr(0, content.size() - 1));
+    BOOST_TEST(text.at(8).line() == 1);
+    BOOST_TEST(copy.view() == content);
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
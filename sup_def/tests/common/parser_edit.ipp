@@ -0,0 +1,202 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/parser_edit.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE parser_edit_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+namespace SupDef
+{
+    namespace Tests
+    {
+        namespace ParserEdit
+        {
+            static const std::string source =
+                "int a;\n"
+                "#pragma supdef import \"a.h\"\n"
+                "#pragma supdef begin FOO\n"
+                "    x = 1; // one\n"
+                "#pragma supdef end FOO\n"
+                "#pragma supdef begin BAR\n"
+                "    y = 2; /* two\n"
+                "    */\n"
+                "#pragma supdef end BAR\n"
+                "int b; /* tail */\n";
+
+            // Run everything `apply_edit` keeps up to date on @p parser
+            inline void parse(::SupDef::Parser<char>& parser)
+            {
+                parser.slurp_file();
+                parser.strip_comments();
+                for (auto&& import : parser.search_imports())
+                    BOOST_REQUIRE(import.is_null() || !import.is_err());
+                for (auto&& supdef : parser.search_super_defines())
+                    BOOST_REQUIRE(supdef.is_null() || !supdef.is_err());
+            }
+
+            // Check that @p parser ends up as if @p content was parsed from scratch
+            inline void check_same_as_fresh(const ::SupDef::Parser<char>& parser, const std::string& content)
+            {
+                const auto path = write_tmp_file(content);
+                ::SupDef::Parser<char> fresh(path);
+                parse(fresh);
+                BOOST_TEST(parser.get_content() == fresh.get_content());
+                BOOST_TEST((parser.get_imports() == fresh.get_imports()));
+                BOOST_TEST((parser.get_super_defines() == fresh.get_super_defines()));
+                std::filesystem::remove(path);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(parser_edit,
+    * BoostTest::description("Tests for `SupDef::Parser::apply_edit`")
+)
+
+BOOST_AUTO_TEST_CASE(parser_edit_super_define_body,
+    * BoostTest::description("Check that editing the body of a super define only reports this super define")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ParserEdit;
+
+    const auto path = write_tmp_file(source);
+    ::SupDef::Parser<char> parser(path);
+    parse(parser);
+
+    // The expansions of the edited super define are dropped, not the others
+    using namespace std::string_literals;
+    ::SupDef::PragmaDef<char> foo("FOO"s, "x = 1;"s, std::tuple<size_t, size_t>(2, 4));
+    ::SupDef::PragmaDef<char> bar("BAR"s, "y = 2;"s, std::tuple<size_t, size_t>(5, 8));
+    ::SupDef::ExpansionCache<char> cache;
+    cache.get(foo);
+    cache.get(bar);
+
+    const size_t offset = source.find("1;");
+    auto result = parser.apply_edit(offset, 1, "42", std::addressof(cache));
+    BOOST_TEST(result.errors.empty());
+    BOOST_TEST(!result.imports_changed);
+    BOOST_REQUIRE(result.changed_super_defines.size() == 1);
+    BOOST_TEST(result.changed_super_defines.front() == "FOO");
+    BOOST_TEST(cache.size() == 1);
+    cache.get(bar);
+    BOOST_TEST(cache.hits() == 1);
+
+    std::string edited = source;
+    edited.replace(offset, 1, "42");
+    check_same_as_fresh(parser, edited);
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(parser_edit_comments_and_pragmas,
+    * BoostTest::description("Check that edits opening or closing comments and adding pragmas give the same result as parsing again")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ParserEdit;
+
+    const auto path = write_tmp_file(source);
+    ::SupDef::Parser<char> parser(path);
+    parse(parser);
+
+    std::string edited = source;
+    auto edit = [&](size_t offset, size_t removed_len, const std::string& inserted) -> ::SupDef::Parser<char>::edit_result
+    {
+        auto result = parser.apply_edit(offset, removed_len, inserted);
+        edited.replace(offset, removed_len, inserted);
+        check_same_as_fresh(parser, edited);
+        return result;
+    };
+
+    // Comment out the import, then bring it back
+    auto result = edit(edited.find("#pragma supdef import"), 0, "/* ");
+    BOOST_TEST(result.imports_changed);
+    result = edit(edited.find("/* "), 3, "");
+    BOOST_TEST(result.imports_changed);
+
+    // Close the comment of `BAR` early, which leaves its second line as code
+    result = edit(edited.find(" two"), 0, " */");
+    BOOST_TEST(result.errors.empty());
+    BOOST_TEST((result.changed_super_defines == std::vector<std::string>{ "BAR" }));
+    result = edit(edited.find(" */ two"), 3, "");
+    BOOST_TEST((result.changed_super_defines == std::vector<std::string>{ "BAR" }));
+
+    // Add a new super define at the end of the file
+    result = edit(edited.size(), 0, "#pragma supdef begin BAZ\n    z = 3;\n#pragma supdef end BAZ\n");
+    BOOST_TEST(result.errors.empty());
+    BOOST_TEST(!result.imports_changed);
+    BOOST_TEST((result.changed_super_defines == std::vector<std::string>{ "BAZ" }));
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(parser_edit_super_define_params,
+    * BoostTest::description("Check that the parameters of a super define are kept with its name, and reported by its name only")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace ::SupDef::Tests::ParserEdit;
+
+    const std::string with_params =
+        "#pragma supdef begin MAX ( a,b )\n"
+        "    (($a) > ($b) ? ($a) : ($b))\n"
+        "#pragma supdef end MAX\n"
+        "#pragma supdef begin BAD(a,)\n"
+        "int c;\n";
+    const auto path = write_tmp_file(with_params);
+    ::SupDef::Parser<char> parser(path);
+    parse(parser);
+
+    // `BAD(a,)` isn't a valid `begin` pragma, so is left as is
+    BOOST_REQUIRE(parser.get_super_defines().size() == 1);
+    ::SupDef::PragmaDef<char> def(parser.get_super_defines().front());
+    BOOST_TEST(*def.get_id() == "MAX");
+    BOOST_TEST(def.get_argc() == 2);
+    BOOST_TEST(def.substitute("x", "y") == "((x) > (y) ? (x) : (y))");
+
+    const size_t offset = with_params.find("> ($b)");
+    auto result = parser.apply_edit(offset, 1, "<");
+    BOOST_TEST(result.errors.empty());
+    BOOST_REQUIRE(result.changed_super_defines.size() == 1);
+    BOOST_TEST(result.changed_super_defines.front() == "MAX");
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/parser_lines.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE parser_lines_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+namespace SupDef
+{
+    namespace Tests
+    {
+        namespace ParserLines
+        {
+            // @p count imports, each of them between a line of code and a comment
+            inline std::filesystem::path write_imports(size_t count)
+            {
+                std::ostringstream content;
+                for (size_t i = 0; i < count; ++i)
+                    content << "int a" << i << ";\n#pragma supdef import \"file" << i << ".h\"\n// comment " << i << "\n";
+                return write_tmp_file(content.str());
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(parser_lines,
+    * BoostTest::description("Tests for the line index of `SupDef::Parser`")
+)
+
+BOOST_AUTO_TEST_CASE(parser_lines_removed_imports,
+    * BoostTest::description("Check that removing import lines keeps the original line numbers, and that they are gone afterwards")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests::ParserLines;
+
+    constexpr size_t count = 100;
+    const auto path = write_imports(count);
+    ::SupDef::Parser<char> parser(path);
+    parser.slurp_file();
+    parser.strip_comments();
+
+    size_t found = 0;
+    for (auto&& import : parser.search_imports())
+    {
+        if (import.is_null())
+            continue;
+        BOOST_REQUIRE(!import.is_err());
+        auto& loc = import.unwrap();
+        BOOST_TEST(std::get<0>(loc) == "file" + std::to_string(found) + ".h");
+        BOOST_TEST(std::get<1>(loc) == 3 * found + 2);
+        ++found;
+    }
+    BOOST_TEST(found == count);
+
+    // The removed lines are not searched again
+    for (auto&& import : parser.search_imports())
+        BOOST_TEST(import.is_null());
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(parser_lines_many_imports,
+    * BoostTest::description("Measure the time taken by `search_imports` on a file with many imports, which used to be quadratic")
+    * BoostTest::timeout(SUPDEF_TEST_BENCHMARK_TIMEOUT)
+    * BoostTest::enable_if<SUPDEF_TEST_BENCHMARKS>()
+)
+{
+    using namespace ::SupDef::Tests::ParserLines;
+
+    for (size_t count : { 10000, 100000 })
+    {
+        const auto path = write_imports(count);
+        const size_t file_size = std::filesystem::file_size(path);
+        ::SupDef::Parser<char> parser(path);
+        parser.slurp_file();
+        parser.strip_comments();
+
+        size_t found = 0;
+        const double throughput = ::SupDef::Tests::measure_throughput(file_size, 1, [&]() {
+            for (auto&& import : parser.search_imports())
+                found += (!import.is_null() && !import.is_err());
+        });
+        BOOST_TEST(found == count);
+        BOOST_TEST_MESSAGE("search_imports with " << count << " imports: " << throughput << " MB/s");
+
+        std::filesystem::remove(path);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,177 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/pipeline.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE pipeline_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+BOOST_AUTO_TEST_SUITE(pipeline,
+    * BoostTest::description("Tests for `SupDef::Pipeline`")
+)
+
+BOOST_AUTO_TEST_CASE(pipeline_all_items,
+    * BoostTest::description("Check that every item goes through every stage once, in order for each item")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    constexpr size_t count = 500;
+    ::SupDef::ThreadPool pool(4);
+    std::vector<std::atomic<size_t>> reached(count);
+    std::atomic<size_t> out_of_order = 0;
+    auto stage = [&](size_t index)
+    {
+        return [&, index](size_t item)
+        {
+            if (reached[item].exchange(index + 1) != index)
+                ++out_of_order;
+        };
+    };
+    ::SupDef::Pipeline pipeline(pool, { { stage(0), 2, 4 }, { stage(1), 3, 4 }, { stage(2), 1, 4 } });
+
+    const auto errors = pipeline.run(count);
+    BOOST_TEST(errors.size() == count);
+    BOOST_TEST(std::all_of(errors.begin(), errors.end(), [](const std::exception_ptr& e) { return e == nullptr; }));
+    BOOST_TEST(out_of_order.load() == 0);
+    BOOST_TEST(std::all_of(reached.begin(), reached.end(), [](const std::atomic<size_t>& r) { return r.load() == 3; }));
+
+    BOOST_TEST(pipeline.run(0).empty());
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_errors,
+    * BoostTest::description("Check that an item on which a stage throws is dropped, and its exception returned")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    constexpr size_t count = 100;
+    ::SupDef::ThreadPool pool(3);
+    std::atomic<size_t> sum = 0;
+    ::SupDef::Pipeline pipeline(pool, {
+        { [](size_t item) { if (item % 7 == 3) throw std::runtime_error(std::to_string(item)); }, 2, 2 },
+        { [&sum](size_t item) { sum += item; }, 1, 2 }
+    });
+
+    const auto errors = pipeline.run(count);
+    size_t expected_sum = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i % 7 != 3)
+        {
+            BOOST_TEST((errors[i] == nullptr));
+            expected_sum += i;
+            continue;
+        }
+        BOOST_REQUIRE(errors[i] != nullptr);
+        try
+        {
+            std::rethrow_exception(errors[i]);
+        }
+        catch (const std::runtime_error& e)
+        {
+            BOOST_TEST(e.what() == std::to_string(i));
+        }
+    }
+    BOOST_TEST(sum.load() == expected_sum);
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_backpressure,
+    * BoostTest::description("Check that a slow stage holds back the ones before it, within the capacity and concurrency of each stage")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    ::SupDef::ThreadPool pool(4);
+    ::SupDef::Pipeline pipeline(pool, {
+        { [](size_t) { }, 4, 3 },
+        { [](size_t) { std::this_thread::sleep_for(std::chrono::microseconds(200)); }, 1, 3 }
+    });
+
+    BOOST_TEST(std::ranges::none_of(pipeline.run(200), [](const std::exception_ptr& e) { return e != nullptr; }));
+    const auto stats = pipeline.get_stats();
+    BOOST_REQUIRE(stats.size() == 2);
+    BOOST_TEST(stats[0].max_running <= 4);
+    BOOST_TEST(stats[1].max_running <= 1);
+    BOOST_TEST(stats[1].max_waiting <= 3);
+    BOOST_TEST(stats[1].busy.count() > stats[0].busy.count());
+
+    BOOST_CHECK_THROW(::SupDef::Pipeline(pool, {}), ::SupDef::InternalError);
+    BOOST_CHECK_THROW((::SupDef::Pipeline(pool, { { [](size_t) { }, 0, 1 } })), ::SupDef::InternalError);
+    BOOST_CHECK_THROW((::SupDef::Pipeline(pool, { { [](size_t) { }, 1, 0 } })), ::SupDef::InternalError);
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_ready,
+    * BoostTest::description("Check that the items wait for a stage until they are ready, the ready ones passing the others")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    constexpr size_t count = 20;
+    ::SupDef::ThreadPool pool(2);
+    std::atomic<bool> released = false;
+    std::mutex mtx;
+    std::vector<size_t> order;
+    ::SupDef::Pipeline pipeline(pool, {
+        { [](size_t) { }, 1, count },
+        {
+            [&](size_t item)
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                order.push_back(item);
+            },
+            1, count, [&released](size_t item) { return item % 2 == 1 || released.load(); }
+        }
+    });
+
+    // The even items only get ready once all the odd ones went through
+    std::jthread releaser([&]()
+    {
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (order.size() == count / 2)
+                    break;
+            }
+            std::this_thread::yield();
+        }
+        released = true;
+        pipeline.wake();
+    });
+    BOOST_TEST(std::ranges::none_of(pipeline.run(count), [](const std::exception_ptr& e) { return e != nullptr; }));
+    releaser.join();
+
+    BOOST_REQUIRE(order.size() == count);
+    BOOST_TEST(std::all_of(order.begin(), order.begin() + count / 2, [](size_t item) { return item % 2 == 1; }));
+    BOOST_TEST(std::all_of(order.begin() + count / 2, order.end(), [](size_t item) { return item % 2 == 0; }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
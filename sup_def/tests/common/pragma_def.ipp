@@ -0,0 +1,159 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/pragma_def.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE pragma_def_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+BOOST_AUTO_TEST_SUITE(pragma_def,
+    * BoostTest::description("Tests for `SupDef::PragmaDef`")
+)
+
+BOOST_AUTO_TEST_CASE(pragma_def_substitute,
+    * BoostTest::description("Check that `$0`, `$<n>` and escaped `$` are substituted as expected")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace std::string_literals;
+    using Error = ::SupDef::Exception<char, std::filesystem::path>;
+
+    auto def = make_def("FOO", "#define $1 ($2 + $1) // $0: \\$1 costs $ 2, \\\\$2");
+    BOOST_TEST(def.get_argc() == 2);
+    BOOST_TEST(def.substitute("a"s, "b"s) == "#define a (b + a) // FOO: $1 costs $ 2, \\\\b");
+    BOOST_TEST(def("a"s, "b"s, "unused"s) == def.substitute("a"s, "b"s));
+    BOOST_CHECK_THROW(def.substitute("a"s), Error);
+
+    auto no_args = make_def("BAR", "int bar;");
+    BOOST_TEST(no_args.get_argc() == 0);
+    BOOST_TEST(no_args.substitute() == "int bar;");
+}
+
+BOOST_AUTO_TEST_CASE(pragma_def_many_args,
+    * BoostTest::description("Check that argument numbers don't overflow past 25")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+
+    std::string body;
+    for (size_t i = 30; i > 0; --i)
+        body += "$" + std::to_string(i) + ",";
+    auto def = make_def("MANY", body);
+    BOOST_TEST(def.get_argc() == 30);
+
+    std::vector<std::string> args;
+    std::string expected;
+    for (size_t i = 30; i > 0; --i)
+        expected += "arg" + std::to_string(i) + ",";
+    for (size_t i = 1; i <= 30; ++i)
+        args.push_back("arg" + std::to_string(i));
+    auto result = std::apply([&def](auto&&... a) { return def.substitute(a...); }, [&args]<size_t... I>(std::index_sequence<I...>) {
+        return std::make_tuple(args[I]...);
+    }(std::make_index_sequence<30>{}));
+    BOOST_TEST(result == expected);
+}
+
+BOOST_AUTO_TEST_CASE(pragma_def_from_pragma_loc,
+    * BoostTest::description("Check that the name and the body are split from what the parser found, in the given memory resource")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    std::array<std::byte, 4096> buffer;
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    auto in_arena = [&buffer](const void* p) -> bool
+    {
+        return static_cast<const std::byte*>(p) >= buffer.data() && static_cast<const std::byte*>(p) < buffer.data() + buffer.size();
+    };
+    // Everything is longer than the small string buffer, so that the characters themselves have to come from the arena
+    ::SupDef::PragmaDef<char> def(
+        ::SupDef::PragmaDef<char>::pragma_loc_type("FOO_WITH_A_LONG_NAME(first_parameter, second_parameter) \n  \"$1\"\n  bar($second_parameter)\n", 3, 6),
+        std::addressof(arena)
+    );
+    BOOST_TEST(*def.get_id() == "FOO_WITH_A_LONG_NAME");
+    BOOST_TEST(*def.get_body() == "\"$1\"\n  bar($second_parameter)");
+    BOOST_TEST(def.get_start() == 3);
+    BOOST_TEST(def.get_end() == 6);
+    BOOST_TEST(def.get_argc() == 2);
+    BOOST_TEST(in_arena(def.get_id()->data()));
+    BOOST_TEST(in_arena(def.get_body()->data()));
+    BOOST_REQUIRE(def.get_params() != nullptr);
+    for (const auto& param : *def.get_params())
+        BOOST_TEST(in_arena(param.data()));
+
+    // So do the setters
+    def.set_id(std::string("BAZ_WITH_A_LONG_NAME"));
+    def.set_body("$first_parameter $second_parameter");
+    def.set_params({ "first_parameter", "second_parameter" });
+    BOOST_TEST(in_arena(def.get_id()->data()));
+    BOOST_TEST(in_arena(def.get_body()->data()));
+    for (const auto& param : *def.get_params())
+        BOOST_TEST(in_arena(param.data()));
+    BOOST_TEST(def.get_argc() == 2);
+
+    ::SupDef::PragmaDef<char> empty(::SupDef::PragmaDef<char>::pragma_loc_type("BAR", 0, 1));
+    BOOST_TEST(*empty.get_id() == "BAR");
+    BOOST_TEST(empty.get_body()->empty());
+}
+
+BOOST_AUTO_TEST_CASE(pragma_def_named_params,
+    * BoostTest::description("Check that `$<name>`, `$@` and `$#` are substituted, and that the parameters are split from the first line")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+    using namespace std::string_view_literals;
+
+    ::SupDef::PragmaDef<char> def(::SupDef::PragmaDef<char>::pragma_loc_type("MAX( a , b )\n(($a) > ($b) ? ($a) : ($2)) /* $# $@ $c $0 */\n", 1, 3));
+    BOOST_TEST(*def.get_id() == "MAX");
+    BOOST_REQUIRE(def.get_params() != nullptr);
+    BOOST_TEST((std::vector<std::string>(def.get_params()->begin(), def.get_params()->end()) == std::vector<std::string>{ "a", "b" }));
+    BOOST_TEST(def.get_argc() == 2);
+    BOOST_TEST(def.substitute("x"sv, "y + 1"sv) == "((x) > (y + 1) ? (x) : (y + 1)) /* 2 x, y + 1 $c MAX */");
+
+    // A `$<n>` past the parameters still counts
+    auto variadic = make_def("LOG", "log($1 __VA_OPT__(,) $@) // $#");
+    variadic.set_params({ "fmt" });
+    BOOST_TEST(variadic.get_argc() == 1);
+    const std::array<std::string_view, 3> args{ "\"%d %d\""sv, "1"sv, "2"sv };
+    BOOST_TEST(variadic.substitute(std::span<const std::string_view>(args)) == "log(\"%d %d\" __VA_OPT__(,) \"%d %d\", 1, 2) // 3");
+
+    ::SupDef::PragmaDef<char> no_params(::SupDef::PragmaDef<char>::pragma_loc_type("NONE()\n$#\n", 1, 3));
+    BOOST_REQUIRE(no_params.get_params() != nullptr);
+    BOOST_TEST(no_params.get_params()->empty());
+    BOOST_TEST(no_params.substitute() == "0");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
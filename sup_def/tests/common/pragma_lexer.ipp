@@ -0,0 +1,322 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/pragma_lexer.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE pragma_lexer_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+namespace SupDef
+{
+    namespace Tests
+    {
+        namespace PragmaLexer
+        {
+            template <typename T>
+            struct Regexes
+            {
+                // The kind, the regex, and the capture groups of the argument and of the language (if any)
+                std::vector<std::tuple<::SupDef::PragmaKind, std::basic_regex<T>, size_t, size_t>> regexes;
+
+                Regexes()
+                {
+                    auto add = [this](::SupDef::PragmaKind kind, const T* re, size_t arg_group = 1, size_t lang_group = 0)
+                    {
+                        this->regexes.emplace_back(kind, std::basic_regex<T>(re, std::regex_constants::ECMAScript), arg_group, lang_group);
+                    };
+                    // Same order as the one `Parser` used to try them in
+                    add(::SupDef::PragmaKind::DEF_BEGIN, ANY_STRING(T, SUPDEF_PRAGMA_DEF_BEG_REGEX).data());
+                    add(::SupDef::PragmaKind::DEF_BEGIN, ANY_STRING(T, SUPDEF_PRAGMA_RUNNABLE_DEF_BEG_REGEX).data(), 2, 1);
+                    add(::SupDef::PragmaKind::DEF_END, ANY_STRING(T, SUPDEF_PRAGMA_DEF_END_REGEX).data());
+                    add(::SupDef::PragmaKind::IMPORT, ANY_STRING(T, SUPDEF_PRAGMA_IMPORT_REGEX).data());
+                    add(::SupDef::PragmaKind::IMPORT_ANGLE_BRACKETS, ANY_STRING(T, SUPDEF_PRAGMA_IMPORT_REGEX_ANGLE_BRACKETS).data());
+                    add(::SupDef::PragmaKind::IMPORT_NO_QUOTES, ANY_STRING(T, SUPDEF_PRAGMA_IMPORT_REGEX_NO_QUOTES).data());
+                    add(::SupDef::PragmaKind::IMPORT_NO_PATH, ANY_STRING(T, SUPDEF_PRAGMA_IMPORT_REGEX_NO_PATH).data());
+                    add(::SupDef::PragmaKind::IMPORT_WITH_ANYTHING, ANY_STRING(T, SUPDEF_PRAGMA_IMPORT_REGEX_WITH_ANYTHING).data());
+                    add(::SupDef::PragmaKind::IF, ANY_STRING(T, SUPDEF_PRAGMA_IF_REGEX).data());
+                    add(::SupDef::PragmaKind::ELSE, ANY_STRING(T, SUPDEF_PRAGMA_ELSE_REGEX).data());
+                    add(::SupDef::PragmaKind::IF_END, ANY_STRING(T, SUPDEF_PRAGMA_IF_END_REGEX).data());
+                }
+
+                ::SupDef::PragmaToken<T> lex_line(const std::basic_string<T>& line) const
+                {
+                    std::match_results<typename std::basic_string<T>::const_iterator> match_res;
+                    for (auto&& [kind, regex, arg_group, lang_group] : this->regexes)
+                    {
+                        if (!std::regex_match(line, match_res, regex))
+                            continue;
+                        ::SupDef::PragmaToken<T> res{};
+                        res.kind = kind;
+                        if (match_res.size() > arg_group)
+                        {
+                            res.arg_pos = match_res.position(arg_group);
+                            res.arg_len = match_res.length(arg_group);
+                        }
+                        if (lang_group != 0)
+                        {
+                            res.lang_pos = match_res.position(lang_group);
+                            res.lang_len = match_res.length(lang_group);
+                        }
+                        return res;
+                    }
+                    return ::SupDef::PragmaToken<T>{};
+                }
+            };
+
+            template <typename T>
+            bool same_as_regex(const std::basic_string<T>& line)
+            {
+                static const Regexes<T> regexes;
+                const auto expected = regexes.lex_line(line);
+                const auto got = ::SupDef::PragmaLexer<T>::lex_line(line);
+                if (expected.kind != got.kind)
+                    return false;
+                // `SUPDEF_PRAGMA_IMPORT_REGEX_WITH_ANYTHING` has no capture group
+                if (expected.kind == ::SupDef::PragmaKind::NONE || expected.kind == ::SupDef::PragmaKind::IMPORT_WITH_ANYTHING)
+                    return true;
+                return expected.arg_pos == got.arg_pos && expected.arg_len == got.arg_len &&
+                       expected.lang_pos == got.lang_pos && expected.lang_len == got.lang_len;
+            }
+
+            inline const std::vector<std::string>& sample_lines()
+            {
+                static const std::vector<std::string> lines = {
+                    "",
+                    "#",
+                    "#pragma once",
+                    "int main(void) { return 0; }",
+                    "#pragma supdef begin FOO",
+                    "  #  pragma   supdef\tbegin  FOO_1  ",
+                    "#pragma supdef begin FOO\r",
+                    "#pragma supdef begin",
+                    "#pragma supdef begin ",
+                    "#pragma supdef beginFOO",
+                    "#pragma supdef begin FOO BAR",
+                    "#pragma supdef begin FOO-BAR",
+                    "#pragma supdef end FOO",
+                    "#pragma supdef end  FOO   ",
+                    "#pragma supdef end",
+                    "#pragma supdef import \"a/b.sd\"",
+                    "# pragma supdef import \"\"",
+                    "#pragma supdef import <\"a.sd\">",
+                    "#pragma supdef import \"<a.sd>\"",
+                    "#pragma supdef import \"a.sd\" \"b.sd\"",
+                    "#pragma supdef import <a.sd>",
+                    "#pragma supdef import \"<a.sd>",
+                    "#pragma supdef import <>",
+                    "#pragma supdef import <a.sd> <b.sd>",
+                    "#pragma supdef import a.sd",
+                    "#pragma supdef import a.sd  \r",
+                    "#pragma supdef import a.sd b.sd",
+                    "#pragma supdef import a.sd b.sd\r",
+                    "#pragma supdef import   ",
+                    "#pragma supdef import",
+                    "#pragma supdef importx",
+                    "#pragma supdef_import a.sd",
+                    "#pragmasupdef import a.sd",
+                    "#pragma supdefimport a.sd",
+                    "int x = 0; #pragma supdef import a.sd",
+                    "\v#\fpragma supdef import a.sd",
+                    "#pragma supdef begin FOO(a, b)",
+                    "#pragma supdef begin FOO ( a,b ) ",
+                    "#pragma supdef begin FOO()",
+                    "#pragma supdef begin FOO(a,)",
+                    "#pragma supdef begin FOO(a) b",
+                    "#pragma supdef end FOO(a)",
+                    "#pragma supdef runnable C begin FOO",
+                    "#pragma supdef runnable   CXX\tbegin FOO(a, b)  ",
+                    "#pragma supdef runnable C++ begin FOO",
+                    "#pragma supdef runnable CX begin FOO",
+                    "#pragma supdef runnable CXXX begin FOO",
+                    "#pragma supdef runnable Cbegin FOO",
+                    "#pragma supdef runnable C begin",
+                    "#pragma supdef runnable C end FOO",
+                    "#pragma supdef runnable begin FOO",
+                    "#pragma supdef runnableC begin FOO",
+                    "#pragma supdef if FOO(0) != 0",
+                    "#pragma supdef if   1  \r",
+                    "#pragma supdef if",
+                    "#pragma supdef if ",
+                    "#pragma supdef ifdef FOO",
+                    "#pragma supdef if a\rb",
+                    "#pragma supdef else",
+                    "#pragma supdef else \t",
+                    "#pragma supdef else 1",
+                    "#pragma supdef elsewhere",
+                    "#pragma supdef end  ",
+                    "#pragma supdef endx"
+                };
+                return lines;
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(pragma_lexer,
+    * BoostTest::description("Tests for `SupDef::PragmaLexer`")
+)
+
+BOOST_AUTO_TEST_CASE(pragma_lexer_kinds,
+    * BoostTest::description("Check the kind and argument of some well-known pragmas")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using ::SupDef::PragmaKind;
+    using Lexer = ::SupDef::PragmaLexer<char>;
+
+    auto kind_of = [](std::string_view line) { return Lexer::lex_line(line).kind; };
+    auto arg_of = [](std::string_view line) { return Lexer::lex_line(line).arg(line); };
+
+    BOOST_TEST((kind_of("int x = 0;") == PragmaKind::NONE));
+    BOOST_TEST((kind_of("#pragma supdef begin FOO") == PragmaKind::DEF_BEGIN));
+    BOOST_TEST((arg_of("#pragma supdef begin FOO") == "FOO"));
+    BOOST_TEST((kind_of("  #pragma supdef end  FOO  ") == PragmaKind::DEF_END));
+    BOOST_TEST((arg_of("  #pragma supdef end  FOO  ") == "FOO"));
+    BOOST_TEST((kind_of("#pragma supdef import \"a.sd\"") == PragmaKind::IMPORT));
+    BOOST_TEST((arg_of("#pragma supdef import \"a.sd\"") == "a.sd"));
+    BOOST_TEST((kind_of("#pragma supdef import <a.sd>") == PragmaKind::IMPORT_ANGLE_BRACKETS));
+    BOOST_TEST((arg_of("#pragma supdef import <a.sd>") == "a.sd"));
+    BOOST_TEST((kind_of("#pragma supdef import a.sd") == PragmaKind::IMPORT_NO_QUOTES));
+    BOOST_TEST((arg_of("#pragma supdef import a.sd") == "a.sd"));
+    BOOST_TEST((kind_of("#pragma supdef import ") == PragmaKind::IMPORT_NO_PATH));
+    BOOST_TEST((kind_of("#pragma supdef import a b") == PragmaKind::IMPORT_WITH_ANYTHING));
+    BOOST_TEST((kind_of("#pragma supdef import a b\r") == PragmaKind::NONE));
+    BOOST_TEST((Lexer::lex_line("  #pragma supdef import a b").keyword_pos == 17));
+    BOOST_TEST((kind_of("#pragma supdef if FOO(0) != 0 ") == PragmaKind::IF));
+    BOOST_TEST((arg_of("#pragma supdef if FOO(0) != 0 ") == "FOO(0) != 0"));
+    BOOST_TEST((kind_of("#pragma supdef else") == PragmaKind::ELSE));
+    BOOST_TEST((kind_of("#pragma supdef end") == PragmaKind::IF_END));
+    BOOST_TEST((kind_of("#pragma supdef end FOO") == PragmaKind::DEF_END));
+    BOOST_TEST((kind_of("#pragma supdef runnable CXX begin FOO(a)") == PragmaKind::DEF_BEGIN));
+    BOOST_TEST((arg_of("#pragma supdef runnable CXX begin FOO(a)") == "FOO(a)"));
+    BOOST_TEST((Lexer::lex_line("#pragma supdef runnable CXX begin FOO(a)").lang("#pragma supdef runnable CXX begin FOO(a)") == "CXX"));
+    BOOST_TEST((Lexer::lex_line("#pragma supdef begin FOO").lang_len == 0));
+}
+
+BOOST_AUTO_TEST_CASE(pragma_lexer_same_as_regex,
+    * BoostTest::description("Check that `SupDef::PragmaLexer` recognizes the same lines as the `SUPDEF_PRAGMA_*_REGEX` regexes")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests::PragmaLexer;
+
+    for (auto&& line : sample_lines())
+    {
+        BOOST_TEST_CONTEXT("With line `" << line << "`")
+        {
+            BOOST_TEST(same_as_regex<char>(line));
+            BOOST_TEST(same_as_regex<wchar_t>(CONVERT(wchar_t, line)));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pragma_grammar_shared,
+    * BoostTest::description("Check that `SupDef::PragmaGrammar` is built once per character type and lexes like `SupDef::PragmaLexer`")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests::PragmaLexer;
+    using Grammar = ::SupDef::PragmaGrammar<char>;
+
+    std::vector<std::future<const Grammar*>> instances;
+    for (size_t i = 0; i < 4; ++i)
+        instances.push_back(std::async(std::launch::async, []() { return &Grammar::get(); }));
+    for (auto&& instance : instances)
+        BOOST_TEST(instance.get() == &Grammar::get());
+
+    for (auto&& line : sample_lines())
+    {
+        BOOST_TEST_CONTEXT("With line `" << line << "`")
+        {
+            const auto expected = ::SupDef::PragmaLexer<char>::lex_line(line);
+            const auto got = Grammar::get().lex_line(line);
+            BOOST_TEST((got.kind == expected.kind));
+            if (expected && expected.kind != ::SupDef::PragmaKind::IMPORT_WITH_ANYTHING)
+            {
+                BOOST_TEST(got.keyword_pos == expected.keyword_pos);
+                BOOST_TEST(got.arg(line) == expected.arg(line));
+                BOOST_TEST(got.lang(line) == expected.lang(line));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pragma_lexer_throughput,
+    * BoostTest::description("Compare the throughput of `SupDef::PragmaLexer` with the one of the regexes it replaces")
+    * BoostTest::timeout(SUPDEF_TEST_BENCHMARK_TIMEOUT)
+    * BoostTest::enable_if<SUPDEF_TEST_BENCHMARKS>()
+)
+{
+    using namespace ::SupDef::Tests::PragmaLexer;
+
+    // Mostly C code, with a few pragmas, as in a generated header
+    std::vector<std::string> lines;
+    size_t bytes = 0;
+    for (size_t i = 0; bytes < 1024 * 1024; ++i)
+    {
+        const auto& sample = sample_lines()[i % sample_lines().size()];
+        std::string line = (i % 4 == 0) ? sample : "    static inline int function_" + std::to_string(i) + "(int x) { return x * 2; }";
+        bytes += line.size() + 1;
+        lines.push_back(std::move(line));
+    }
+
+    size_t found = 0;
+    const double lexer_mbps = ::SupDef::Tests::measure_throughput(bytes, 10, [&]() {
+        for (auto&& line : lines)
+            found += bool(::SupDef::PragmaLexer<char>::lex_line(line));
+    });
+    const Regexes<char> prebuilt;
+    const double prebuilt_regex_mbps = ::SupDef::Tests::measure_throughput(bytes, 1, [&]() {
+        for (auto&& line : lines)
+            found += bool(prebuilt.lex_line(line));
+    });
+    // What `Parser` used to do: build every regex again for each line
+    const size_t per_line_count = lines.size() / 16;
+    const size_t per_line_bytes = std::accumulate(lines.begin(), lines.begin() + per_line_count, size_t(0), [](size_t acc, const std::string& line) {
+        return acc + line.size() + 1;
+    });
+    const double per_line_regex_mbps = ::SupDef::Tests::measure_throughput(per_line_bytes, 1, [&]() {
+        for (size_t i = 0; i < per_line_count; ++i)
+            found += bool(Regexes<char>().lex_line(lines[i]));
+    });
+    BOOST_TEST(found > 0);
+
+    BOOST_TEST_MESSAGE("PragmaLexer:                    " << lexer_mbps << " MB/s");
+    BOOST_TEST_MESSAGE("Prebuilt regexes:               " << prebuilt_regex_mbps << " MB/s");
+    BOOST_TEST_MESSAGE("Regexes rebuilt for each line:  " << per_line_regex_mbps << " MB/s");
+    BOOST_TEST(lexer_mbps > prebuilt_regex_mbps);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
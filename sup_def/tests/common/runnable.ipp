@@ -0,0 +1,236 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/runnable.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE runnable_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+namespace SupDef
+{
+    namespace Tests
+    {
+        namespace RunnableTests
+        {
+            using Runnable = ::SupDef::RunnableLibrary<char>;
+
+            static inline ::SupDef::PragmaDef<char> runnable_def(const std::string& pragma)
+            {
+                return ::SupDef::PragmaDef<char>(::SupDef::PragmaDef<char>::pragma_loc_type(pragma, 1, 3));
+            }
+
+            // Runnable super defines can only be tested where their compiler is found
+            static inline bool has_compiler(const std::string& language)
+            {
+                const std::string command = Runnable::toolchain::of(language).compiler + " --version > /dev/null 2>&1";
+                return std::system(command.c_str()) == 0;
+            }
+
+            // A fresh cache directory, so that the first load of a library always compiles it
+            static inline std::filesystem::path fresh_cache_dir(const std::string& name)
+            {
+                const std::filesystem::path dir = Runnable::default_cache_dir() / ("tests-" + name);
+                std::filesystem::remove_all(dir);
+                return dir;
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(runnable,
+    * BoostTest::description("Tests for runnable super defines and `SupDef::RunnableLibrary`")
+)
+
+BOOST_AUTO_TEST_CASE(runnable_pragma_def,
+    * BoostTest::description("Check that the language of a runnable super define is parsed with its name and parameters")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests::RunnableTests;
+
+    const auto echo = runnable_def("ECHO(x) C\nSUPDEF_RETURN($x);\n");
+    BOOST_TEST(echo.is_runnable());
+    BOOST_TEST(*echo.get_id() == "ECHO");
+    BOOST_TEST(*echo.get_language() == "C");
+    BOOST_TEST(echo.get_params()->size() == 1);
+    BOOST_TEST(echo.get_runnable()->get_source().find("#line 2 \"ECHO\"\nSUPDEF_RETURN(SUPDEF_ARG(1));") != std::string::npos);
+    const auto copy = echo;
+    BOOST_TEST(copy.get_runnable() == echo.get_runnable());
+
+    const auto lone = runnable_def("LONE CXX\nSUPDEF_INCLUDE(<string>)\nSUPDEF_RETURN(std::string(\"lone\"));\n");
+    BOOST_TEST(lone.is_runnable());
+    BOOST_TEST(*lone.get_id() == "LONE");
+    BOOST_TEST(*lone.get_language() == "CXX");
+    BOOST_TEST(lone.get_params() == nullptr);
+    BOOST_TEST(lone.get_runnable()->get_source().find("#include <string>\n") != std::string::npos);
+
+    const auto classic = runnable_def("FOO(a, b)\n$a $b\n");
+    BOOST_TEST(!classic.is_runnable());
+    BOOST_TEST(*classic.get_id() == "FOO");
+    BOOST_TEST(classic.get_runnable() == nullptr);
+
+    BOOST_CHECK_THROW(runnable_def("BAD(x) RUST\nx\n"), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(runnable_run,
+    * BoostTest::description("Check that runnable super defines are compiled, cached and run")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests::RunnableTests;
+    using namespace std::string_view_literals;
+
+    if (!has_compiler("C") || !has_compiler("CXX"))
+    {
+        BOOST_TEST_MESSAGE("No C or C++ compiler found, skipping");
+        return;
+    }
+    const auto dir = fresh_cache_dir("run");
+
+    const auto add = runnable_def("ADD(a, b) C\nSUPDEF_INCLUDE(<stdlib.h>)\nSUPDEF_WRITE(\"sum=\");\nSUPDEF_RETURN(atoi($a) + atoi($b));\n");
+    Runnable cold(add, {}, dir);
+    BOOST_TEST(cold.run(std::array{ "40"sv, "2"sv }) == "sum=42");
+    BOOST_TEST(cold.get_timings().compiled);
+    BOOST_CHECK_THROW(cold.run(std::array{ "40"sv }), std::exception);
+
+    // Same source, compiler and flags: the cached library is reused
+    Runnable warm(add, {}, dir);
+    const std::array first{ "1"sv, "2"sv };
+    const std::array second{ "3"sv, "4"sv };
+    const auto outputs = warm.run_batch(std::array{ Runnable::args_type(first), Runnable::args_type(second) });
+    BOOST_TEST(!warm.get_timings().compiled);
+    BOOST_TEST(warm.get_timings().compile_time.count() == 0);
+    BOOST_TEST(warm.get_library_path() == cold.get_library_path());
+    BOOST_REQUIRE(outputs.size() == 2);
+    BOOST_TEST(outputs[0] == "sum=3");
+    BOOST_TEST(outputs[1] == "sum=7");
+
+    const auto str = runnable_def("STR CXX\nSUPDEF_INCLUDE(<string>)\nstd::string returned_str = \"constant string\";\nSUPDEF_RETURN(returned_str + \" returned from a runnable\");\n");
+    BOOST_TEST(Runnable(str, {}, dir).run({}) == "constant string returned from a runnable");
+
+    // Compilation errors are reported with the name of the super define
+    const auto bad = runnable_def("BAD C\nthis is not C;\n");
+    BOOST_CHECK_THROW(Runnable(bad, {}, dir).run({}), std::exception);
+
+    // Neither a library nor a cache directory others can write to is trusted
+    std::filesystem::permissions(cold.get_library_path(), std::filesystem::perms::group_write, std::filesystem::perm_options::add);
+    BOOST_CHECK_THROW(Runnable(add, {}, dir).run(std::array{ "1"sv, "2"sv }), std::exception);
+    std::filesystem::permissions(cold.get_library_path(), std::filesystem::perms::group_write, std::filesystem::perm_options::remove);
+    std::filesystem::permissions(dir, std::filesystem::perms::others_write, std::filesystem::perm_options::add);
+    BOOST_CHECK_THROW(Runnable(add, {}, dir).run(std::array{ "1"sv, "2"sv }), std::exception);
+    std::filesystem::permissions(dir, std::filesystem::perms::others_write, std::filesystem::perm_options::remove);
+    BOOST_TEST(Runnable(add, {}, dir).run(std::array{ "1"sv, "2"sv }) == "sum=3");
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(runnable_expansion,
+    * BoostTest::description("Check that invocations of runnable super defines are expanded by running them")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests::RunnableTests;
+    using namespace std::string_literals;
+
+    if (!has_compiler("C"))
+    {
+        BOOST_TEST_MESSAGE("No C compiler found, skipping");
+        return;
+    }
+
+    ::SupDef::SymbolTable<char> table;
+    table.define(table.global_scope, runnable_def("ECHO(x) C\nSUPDEF_RETURN($x);\n"));
+    ::SupDef::Tests::define(table, "ID", "$1");
+    ::SupDef::InvocationExpander<char> expander(table, table.global_scope);
+
+    std::ostringstream out;
+    expander.expand("x ECHO(ID(abc)) y ECHO( 1 + 2 )\n", out);
+    BOOST_TEST(out.str() == "x abc y 1 + 2\n");
+
+    ::SupDef::ConditionEvaluator<char> evaluator(table, table.global_scope);
+    BOOST_TEST(evaluator.evaluate("ECHO(3) == 3"));
+    BOOST_TEST(!evaluator.evaluate("ECHO(0)"));
+}
+
+BOOST_AUTO_TEST_CASE(runnable_timings,
+    * BoostTest::description("Measure cold and warm load times of runnable super defines, and the time taken to run them")
+    * BoostTest::timeout(SUPDEF_TEST_BENCHMARK_TIMEOUT)
+    * BoostTest::enable_if<SUPDEF_TEST_BENCHMARKS>()
+)
+{
+    using namespace ::SupDef::Tests::RunnableTests;
+    using namespace std::string_view_literals;
+
+    if (!has_compiler("C"))
+    {
+        BOOST_TEST_MESSAGE("No C compiler found, skipping");
+        return;
+    }
+    const auto dir = fresh_cache_dir("timings");
+    const auto echo = runnable_def("ECHO(x) C\nSUPDEF_RETURN($x);\n");
+
+    Runnable cold(echo, {}, dir);
+    cold.load();
+    Runnable warm(echo, {}, dir);
+    warm.load();
+    for (const auto& [name, library] : { std::pair{ "Cold", &cold }, std::pair{ "Warm", &warm } })
+    {
+        using milliseconds = std::chrono::duration<double, std::milli>;
+        const auto& timings = library->get_timings();
+        BOOST_TEST_MESSAGE(name << " load: " << milliseconds(timings.compile_time).count() << " ms compiling, "
+                                << milliseconds(timings.load_time).count() << " ms loading");
+    }
+    BOOST_TEST(cold.get_timings().compiled);
+    BOOST_TEST(!warm.get_timings().compiled);
+
+    constexpr size_t count = 100000;
+    const std::array args{ "abc"sv };
+    size_t size = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+        size += warm.run(args).size();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    BOOST_TEST(size == 3 * count);
+    BOOST_TEST_MESSAGE("One by one: " << elapsed.count() / count << " ns per invocation");
+
+    const std::vector<Runnable::args_type> batch(count, Runnable::args_type(args));
+    start = std::chrono::steady_clock::now();
+    const auto outputs = warm.run_batch(batch);
+    elapsed = std::chrono::steady_clock::now() - start;
+    BOOST_TEST(outputs.size() == count);
+    BOOST_TEST_MESSAGE("Batched: " << elapsed.count() / count << " ns per invocation");
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
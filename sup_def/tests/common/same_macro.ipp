@@ -0,0 +1,195 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/same_macro.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE same_macro_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+namespace SupDef
+{
+    namespace Tests
+    {
+        namespace SameMacro
+        {
+            // What `SAME` used to do for every comparison: convert both code units to UTF-8 strings
+            struct LegacySame
+            {
+                template <typename C1, typename C2>
+                bool operator()(const C1 c1, const C2 c2) const
+                {
+                    return CONVERT(char8_t, std::basic_string<C1>(1, c1)) == CONVERT(char8_t, std::basic_string<C2>(1, c2));
+                }
+            };
+
+            struct FastSame
+            {
+                template <typename C1, typename C2>
+                bool operator()(const C1 c1, const C2 c2) const
+                {
+                    return SAME(c1, c2);
+                }
+            };
+
+            // Same comparisons as `Parser::remove_cstr_lit`
+            template <typename Same, typename T>
+            std::basic_string<T> remove_cstr_lit(const std::basic_string<T>& content)
+            {
+                const Same same{};
+                std::basic_string<T> res;
+                res.reserve(content.size());
+                bool in_str_lit = false;
+                for (size_t i = 0; i < content.size(); ++i)
+                {
+                    if (same(content[i], '"'))
+                    {
+                        if (i > 0 && !same(content[i - 1], '\\'))
+                            in_str_lit = !in_str_lit;
+                    }
+                    else if (!in_str_lit)
+                        res += content[i];
+                }
+                return res;
+            }
+
+            // Same comparisons as the main loop of `Parser::strip_comments`, only counting the comments
+            template <typename Same, typename T>
+            size_t count_comments(const std::basic_string<T>& content)
+            {
+                const Same same{};
+                size_t count = 0;
+                bool in_str_lit = false;
+                for (size_t i = 0; i < content.size(); ++i)
+                {
+                    if (same(content[i], '"'))
+                    {
+                        if (i > 0 && !same(content[i - 1], '\\'))
+                            in_str_lit = !in_str_lit;
+                    }
+                    else if (!in_str_lit && same(content[i], '/') && i + 1 < content.size() && (same(content[i + 1], '/') || same(content[i + 1], '*')))
+                    {
+                        ++count;
+                        const bool line_comment = same(content[i + 1], '/');
+                        for (i += 2; i < content.size(); ++i)
+                        {
+                            if (line_comment ? same(content[i], '\n') : (same(content[i], '/') && same(content[i - 1], '*')))
+                                break;
+                        }
+                    }
+                }
+                return count;
+            }
+
+            inline std::string sample_source(size_t min_size)
+            {
+                std::string res;
+                for (size_t i = 0; res.size() < min_size; ++i)
+                {
+                    res += "/**\n * @brief Doxygen comment for function_" + std::to_string(i) + "\n */\n";
+                    res += "static inline int function_" + std::to_string(i) + "(int x) // Trailing comment\n";
+                    res += "{\n    puts(\"Hello \\\"world\\\" /* not a comment */\");\n    return x * 2;\n}\n";
+                }
+                return res;
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(same_macro,
+    * BoostTest::description("Tests for `SAME` and `DIFFERENT` macros")
+)
+
+BOOST_AUTO_TEST_CASE(same_macro_code_units,
+    * BoostTest::description("Check `SAME` on code units of different character types")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    BOOST_TEST(SAME('a', u8'a'));
+    BOOST_TEST(SAME(L'\n', '\n'));
+    BOOST_TEST(SAME(U'"', u'"'));
+    BOOST_TEST(DIFFERENT('a', U'b'));
+    // Lead byte of "é" in UTF-8, which must not be mistaken for an ASCII character
+    BOOST_TEST(DIFFERENT(char(0xC3), 'C'));
+    BOOST_TEST(DIFFERENT(char(0xC3), char8_t(0xA9)));
+    BOOST_TEST(SAME(char(0xC3), char8_t(0xC3)));
+    BOOST_TEST(SAME(char(0xC3), char(0xC3)));
+    BOOST_TEST(SAME(U'é', U'é'));
+    BOOST_TEST(DIFFERENT(U'é', U'è'));
+
+    BOOST_TEST(SAME(std::string("abc"), "abc"));
+    BOOST_TEST(SAME(std::u32string(U"abc"), std::string("abc")));
+    BOOST_TEST(DIFFERENT(std::u32string(U"abé"), "abc"));
+    BOOST_TEST(DIFFERENT(std::string("ab"), std::u16string(u"abc")));
+    BOOST_TEST(SAME(std::u8string(u8"été"), std::u8string(u8"été")));
+
+    BOOST_TEST(CONVERT(char32_t, 'x') == U"x");
+    BOOST_TEST(CONVERT(wchar_t, '\n') == L"\n");
+}
+
+BOOST_AUTO_TEST_CASE(same_macro_throughput,
+    * BoostTest::description("Compare the throughput of the comparisons made by `Parser::strip_comments` and `Parser::remove_cstr_lit` before and after the ASCII fast path of `SAME`")
+    * BoostTest::timeout(SUPDEF_TEST_BENCHMARK_TIMEOUT)
+    * BoostTest::enable_if<SUPDEF_TEST_BENCHMARKS>()
+)
+{
+    using namespace ::SupDef::Tests::SameMacro;
+
+    const std::string content = sample_source(256 * 1024);
+
+    size_t sink = 0;
+    const double strip_before = ::SupDef::Tests::measure_throughput(content.size(), 1, [&]() { sink += count_comments<LegacySame>(content); });
+    const double strip_after = ::SupDef::Tests::measure_throughput(content.size(), 10, [&]() { sink += count_comments<FastSame>(content); });
+    const double remove_before = ::SupDef::Tests::measure_throughput(content.size(), 1, [&]() { sink += remove_cstr_lit<LegacySame>(content).size(); });
+    const double remove_after = ::SupDef::Tests::measure_throughput(content.size(), 10, [&]() { sink += remove_cstr_lit<FastSame>(content).size(); });
+    BOOST_TEST(sink > 0);
+    BOOST_TEST((count_comments<LegacySame>(content) == count_comments<FastSame>(content)));
+    BOOST_TEST((remove_cstr_lit<LegacySame>(content) == remove_cstr_lit<FastSame>(content)));
+
+    // The real thing, for reference
+    const auto path = std::filesystem::temp_directory_path() / "supdef_same_macro_throughput.c";
+    ::SupDef::Tests::write_file(path, content);
+    ::SupDef::Parser<char> parser(path);
+    parser.slurp_file();
+    const double parser_strip = ::SupDef::Tests::measure_throughput(content.size(), 1, [&]() { parser.strip_comments(); });
+    std::filesystem::remove(path);
+
+    BOOST_TEST_MESSAGE("strip_comments comparisons (char):   " << strip_before << " MB/s before, " << strip_after << " MB/s after");
+    BOOST_TEST_MESSAGE("remove_cstr_lit comparisons (char):  " << remove_before << " MB/s before, " << remove_after << " MB/s after");
+    BOOST_TEST_MESSAGE("Parser<char>::strip_comments:        " << parser_strip << " MB/s");
+    BOOST_TEST(strip_after > strip_before);
+    BOOST_TEST(remove_after > remove_before);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,126 @@
+/* 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Axel PASCON
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifdef TESTFILE_NAME
+    #undef TESTFILE_NAME
+#endif
+#define TESTFILE_NAME supdef/tests/common/symbol_table.ipp
+
+#if !BOOST_TEST_ALREADY_INCLUDED
+    #undef BOOST_TEST_MODULE
+    #define BOOST_TEST_MODULE symbol_table_tests
+    #include <boost/test/included/unit_test.hpp>
+#endif
+
+#include <sup_def/common/sup_def.hpp>
+#include <sup_def/tests/tests.h>
+
+#line SUPDEF_TEST_FILE_POS
+
+BOOST_AUTO_TEST_SUITE(symbol_table,
+    * BoostTest::description("Tests for `SupDef::SymbolTable`")
+)
+
+BOOST_AUTO_TEST_CASE(symbol_table_interning,
+    * BoostTest::description("Check that equal names are interned once, and that lookups still work after the table grows")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+
+    ::SupDef::SymbolTable<char> table;
+    const auto foo = table.intern("FOO");
+    BOOST_TEST(table.intern(std::string("FOO")).data() == foo.data());
+
+    for (size_t i = 0; i < 10000; ++i)
+        table.define(table.global_scope, make_def("DEF_" + std::to_string(i), std::to_string(i)));
+    BOOST_TEST(table.size() == 10001);
+    BOOST_TEST(table.intern("FOO").data() == foo.data());
+    for (size_t i = 0; i < 10000; ++i)
+    {
+        const auto* def = table.find(table.global_scope, "DEF_" + std::to_string(i));
+        BOOST_REQUIRE(def != nullptr);
+        BOOST_TEST(std::string(*def->get_body()) == std::to_string(i));
+    }
+    BOOST_TEST(table.find(table.global_scope, "FOO") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(symbol_table_scopes,
+    * BoostTest::description("Check that names are looked up in the scope, then in its imports in order, then in the global scope")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+
+    ::SupDef::SymbolTable<char> table;
+    const auto main_file = table.add_scope();
+    const auto first = table.add_scope();
+    const auto second = table.add_scope();
+    table.add_import(main_file, first);
+    table.add_import(main_file, second);
+    // Import cycle
+    table.add_import(first, main_file);
+
+    BOOST_TEST(!table.define(second, make_def("X", "second")));
+    BOOST_TEST(*table.find(main_file, "X")->get_body() == "second");
+    table.define(first, make_def("X", "first"));
+    BOOST_TEST(*table.find(main_file, "X")->get_body() == "first");
+    BOOST_TEST(table.define(first, make_def("X", "first again")));
+    BOOST_TEST(*table.find(main_file, "X")->get_body() == "first again");
+    BOOST_TEST(*table.find(second, "X")->get_body() == "second");
+
+    table.define(table.global_scope, make_def("G", "global"));
+    BOOST_TEST(*table.find(second, "G")->get_body() == "global");
+    table.define(main_file, make_def("G", "main"));
+    BOOST_TEST(*table.find(first, "G")->get_body() == "main");
+    BOOST_TEST(*table.find(second, "G")->get_body() == "global");
+
+    BOOST_TEST(table.undefine(first, "X"));
+    BOOST_TEST(!table.undefine(first, "X"));
+    BOOST_TEST(*table.find(main_file, "X")->get_body() == "second");
+    BOOST_TEST(table.find(main_file, "Y") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(symbol_table_clear,
+    * BoostTest::description("Check that the table can be used again once its arena is released")
+    * BoostTest::timeout(SUPDEF_TEST_DEFAULT_TIMEOUT)
+)
+{
+    using namespace ::SupDef::Tests;
+
+    std::pmr::monotonic_buffer_resource upstream;
+    ::SupDef::SymbolTable<char> table(std::addressof(upstream));
+    for (size_t round = 0; round < 3; ++round)
+    {
+        const auto scope = table.add_scope();
+        for (size_t i = 0; i < 1000; ++i)
+            table.define(scope, make_def("DEF_" + std::to_string(i), std::to_string(round)));
+        BOOST_TEST(table.size() == 1000);
+        BOOST_TEST(std::string(*table.find(scope, "DEF_999")->get_body()) == std::to_string(round));
+        table.clear();
+        BOOST_TEST(table.size() == 0);
+        BOOST_TEST(table.find(scope, "DEF_999") == nullptr);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -35,5 +35,21 @@
 #include <sup_def/tests/common/unistreams_std_basic_string.ipp>
 #include <sup_def/tests/common/unistreams_string.ipp>
 #include <sup_def/tests/common/convert_macro.ipp>
+#include <sup_def/tests/common/pragma_lexer.ipp>
+#include <sup_def/tests/common/parsed_text.ipp>
+#include <sup_def/tests/common/same_macro.ipp>
+#include <sup_def/tests/common/parallel_strip.ipp>
+#include <sup_def/tests/common/delimiter_finder.ipp>
+#include <sup_def/tests/common/parser_lines.ipp>
+#include <sup_def/tests/common/parser_edit.ipp>
+#include <sup_def/tests/common/pragma_def.ipp>
+#include <sup_def/tests/common/expansion_cache.ipp>
+#include <sup_def/tests/common/symbol_table.ipp>
+#include <sup_def/tests/common/invocation_expander.ipp>
+#include <sup_def/tests/common/conditionals.ipp>
+#include <sup_def/tests/common/runnable.ipp>
+#include <sup_def/tests/common/pipeline.ipp>
+#include <sup_def/tests/common/import_cache.ipp>
+#include <sup_def/tests/common/engine.ipp>
 
 #endif
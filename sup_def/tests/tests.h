@@ -35,8 +35,93 @@
 #endif
 #define SUPDEF_TEST_DEFAULT_TIMEOUT 5 // seconds
 
+#ifdef SUPDEF_TEST_BENCHMARK_TIMEOUT
+    #undef SUPDEF_TEST_BENCHMARK_TIMEOUT
+#endif
+#define SUPDEF_TEST_BENCHMARK_TIMEOUT 600 // seconds
+
+// Benchmarks are only run when explicitly asked for
+#ifndef SUPDEF_TEST_BENCHMARKS
+    #define SUPDEF_TEST_BENCHMARKS 0
+#endif
+
 namespace BoostTest = ::boost::unit_test;
 
 #include <bits/stdc++.h>
 
+#include <sup_def/common/sup_def.hpp>
+
+namespace SupDef
+{
+    namespace Tests
+    {
+        /**
+         * @brief Run @p fn @p iterations times and compute its throughput
+         * 
+         * @param bytes The number of bytes processed by one call to @p fn
+         * @param iterations The number of times @p fn is called
+         * @param fn The benchmarked function
+         * @return The throughput of @p fn, in MB/s
+         */
+        template <typename Fn>
+        inline double measure_throughput(size_t bytes, size_t iterations, Fn&& fn)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; ++i)
+                fn();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            return (static_cast<double>(bytes) * static_cast<double>(iterations)) / (1024.0 * 1024.0) / elapsed.count();
+        }
+
+        /**
+         * @brief Write @p content to @p path, creating its parent directories if needed
+         */
+        inline void write_file(const std::filesystem::path& path, const std::string& content)
+        {
+            std::filesystem::create_directories(path.parent_path());
+            std::ofstream out(path, std::ios::binary);
+            out << content;
+        }
+
+        /**
+         * @brief Write @p content to a new temporary file
+         * 
+         * @return The path of the file, to be removed by the caller
+         */
+        inline std::filesystem::path write_tmp_file(const std::string& content)
+        {
+            const auto path = ::SupDef::TmpFile::get_tmp_file();
+            write_file(path, content);
+            return path;
+        }
+
+        /**
+         * @brief Read the whole content of @p path
+         */
+        inline std::string read_file(const std::filesystem::path& path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            std::ostringstream content;
+            content << in.rdbuf();
+            return content.str();
+        }
+
+        /**
+         * @brief Make a super define named @p id, with @p body as its body
+         */
+        inline ::SupDef::PragmaDef<char> make_def(const std::string& id, const std::string& body)
+        {
+            return ::SupDef::PragmaDef<char>(id, body, std::tuple<size_t, size_t>(0, 0));
+        }
+
+        /**
+         * @brief Define the super define @p id in the global scope of @p table
+         */
+        inline void define(::SupDef::SymbolTable<char>& table, const std::string& id, const std::string& body)
+        {
+            table.define(table.global_scope, make_def(id, body));
+        }
+    }
+}
+
 #endif